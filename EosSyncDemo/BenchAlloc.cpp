@@ -0,0 +1,206 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "BenchAlloc.h"
+#include "QtInclude.h"
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <new>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#include <mach/mach.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+static volatile bool sCounting = false;
+static QAtomicInt sCount;
+
+static inline void CountAlloc()
+{
+	if( sCounting )
+		sCount.ref();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__GLIBC__)
+
+extern "C"
+{
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void *p, size_t size);
+
+void* malloc(size_t size) __THROW
+{
+	CountAlloc();
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) __THROW
+{
+	CountAlloc();
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void *p, size_t size) __THROW
+{
+	CountAlloc();
+	return __libc_realloc(p, size);
+}
+}
+
+static bool InstallHooks()
+{
+	return true;
+}
+
+#define BENCH_ALLOC_SCOPE	"malloc"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#elif defined(__APPLE__)
+
+static void* (*sZoneMalloc)(malloc_zone_t *zone, size_t size) = 0;
+static void* (*sZoneCalloc)(malloc_zone_t *zone, size_t count, size_t size) = 0;
+static void* (*sZoneRealloc)(malloc_zone_t *zone, void *p, size_t size) = 0;
+
+static void* ZoneMalloc(malloc_zone_t *zone, size_t size)
+{
+	CountAlloc();
+	return sZoneMalloc(zone, size);
+}
+
+static void* ZoneCalloc(malloc_zone_t *zone, size_t count, size_t size)
+{
+	CountAlloc();
+	return sZoneCalloc(zone, count, size);
+}
+
+static void* ZoneRealloc(malloc_zone_t *zone, void *p, size_t size)
+{
+	CountAlloc();
+	return sZoneRealloc(zone, p, size);
+}
+
+static bool InstallHooks()
+{
+	malloc_zone_t *zone = malloc_default_zone();
+	if( !zone )
+		return false;
+
+	// newer zones are read only once set up
+	bool isProtected = (zone->version >= 8);
+	if(isProtected && vm_protect(mach_task_self(),reinterpret_cast<vm_address_t>(zone),sizeof(malloc_zone_t),0,VM_PROT_READ|VM_PROT_WRITE) != KERN_SUCCESS)
+		return false;
+
+	sZoneMalloc = zone->malloc;
+	sZoneCalloc = zone->calloc;
+	sZoneRealloc = zone->realloc;
+	zone->malloc = ZoneMalloc;
+	zone->calloc = ZoneCalloc;
+	zone->realloc = ZoneRealloc;
+
+	if( isProtected )
+		vm_protect(mach_task_self(), reinterpret_cast<vm_address_t>(zone), sizeof(malloc_zone_t), 0, VM_PROT_READ);
+	return true;
+}
+
+#define BENCH_ALLOC_SCOPE	"malloc"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#elif defined(_WIN32)
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+	CountAlloc();
+	void *p = malloc(size ? size : 1);
+	if( !p )
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc)
+{
+	return operator new(size);
+}
+
+void operator delete(void *p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+	free(p);
+}
+
+static bool InstallHooks()
+{
+	return true;
+}
+
+#define BENCH_ALLOC_SCOPE	"operator new"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#else
+
+static bool InstallHooks()
+{
+	return false;
+}
+
+#define BENCH_ALLOC_SCOPE	"none"
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool BenchAlloc::Install()
+{
+	if( sCounting )
+		return true;
+
+	if( !InstallHooks() )
+		return false;
+
+	sCounting = true;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* BenchAlloc::GetScope()
+{
+	return (sCounting ? BENCH_ALLOC_SCOPE : "none");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int BenchAlloc::GetCount()
+{
+	return static_cast<unsigned int>( static_cast<int>(sCount) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
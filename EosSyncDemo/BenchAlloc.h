@@ -0,0 +1,47 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef BENCH_ALLOC_H
+#define BENCH_ALLOC_H
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Allocation counter for the benchmark build only. BenchAlloc.cpp hooks the
+// allocator for the whole process, so it is compiled into EosSyncDemoBench
+// and never into the app. GetCount() is the running total of allocations on
+// every thread since Install(); callers diff it around what they time.
+//
+// glibc: malloc, calloc and realloc are defined here and take precedence
+// over libc's for Qt and every other library, then call on to libc's own.
+// Mac: the default malloc zone's entry points are wrapped.
+// Windows: operator new is replaced, which covers this program's C++
+// allocations but not Qt's, since Qt's DLLs allocate through their own CRT.
+class BenchAlloc
+{
+public:
+	static bool Install();
+	static const char* GetScope();
+	static unsigned int GetCount();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,145 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "ChangeHub.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+ChangeHub::ChangeHub(size_t capacity)
+	: m_Capacity((capacity==0) ? 1 : capacity)
+	, m_FirstSeq(0)
+	, m_NextId(1)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int ChangeHub::Subscribe()
+{
+	QMutexLocker locker(&m_Mutex);
+
+	// starts from the next batch published
+	sSubscriber &subscriber = m_Subscribers[m_NextId];
+	subscriber.cursor = (m_FirstSeq + m_Batches.size());
+	subscriber.missed = false;
+	return m_NextId++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeHub::Unsubscribe(int id)
+{
+	QMutexLocker locker(&m_Mutex);
+	m_Subscribers.erase(id);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ChangeHub::Take(int id, BATCHES &batches)
+{
+	batches.clear();
+
+	QMutexLocker locker(&m_Mutex);
+
+	SUBSCRIBERS::iterator i = m_Subscribers.find(id);
+	if(i == m_Subscribers.end())
+		return false;
+
+	sSubscriber &subscriber = i->second;
+	quint64 nextSeq = (m_FirstSeq + m_Batches.size());
+	bool missed = (subscriber.missed || subscriber.cursor<m_FirstSeq);
+	if( !missed )
+	{
+		batches.reserve( static_cast<size_t>(nextSeq - subscriber.cursor) );
+		for(quint64 seq=subscriber.cursor; seq<nextSeq; seq++)
+			batches.push_back( m_Batches[static_cast<size_t>(seq - m_FirstSeq)] );
+	}
+
+	subscriber.cursor = nextSeq;
+	subscriber.missed = false;
+	return !missed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeHub::GetStats(size_t &subscribers, quint64 &published) const
+{
+	QMutexLocker locker(&m_Mutex);
+	subscribers = m_Subscribers.size();
+	published = (m_FirstSeq + m_Batches.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeHub::Publish(sBatch *batch)
+{
+	BATCH_PTR ptr(batch);
+
+	QMutexLocker locker(&m_Mutex);
+
+	// nobody to read it, so don't hold on to it either
+	if( m_Subscribers.empty() )
+	{
+		m_FirstSeq += (m_Batches.size() + 1);
+		m_Batches.clear();
+		return;
+	}
+
+	m_Batches.push_back(ptr);
+	while(m_Batches.size() > m_Capacity)
+	{
+		m_Batches.pop_front();
+		m_FirstSeq++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeHub::Reset()
+{
+	QMutexLocker locker(&m_Mutex);
+
+	// everything before this is about a show that's gone, so every subscriber rescans
+	m_FirstSeq += m_Batches.size();
+	m_Batches.clear();
+	for(SUBSCRIBERS::iterator i=m_Subscribers.begin(); i!=m_Subscribers.end(); i++)
+	{
+		i->second.cursor = m_FirstSeq;
+		i->second.missed = true;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeHub::GetChangedLists(const BATCHES &batches, LIST_IDS *lists)
+{
+	for(BATCHES::const_iterator i=batches.begin(); i!=batches.end(); i++)
+	{
+		const LIST_CHANGES &changes = (*i)->lists;
+		for(LIST_CHANGES::const_iterator j=changes.begin(); j!=changes.end(); j++)
+		{
+			if(j->type>=0 && j->type<EosTarget::EOS_TARGET_COUNT)
+				lists[j->type].insert(j->listId);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,128 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef CHANGE_HUB_H
+#define CHANGE_HUB_H
+
+#ifndef EOS_SYNC_LIB_H
+#include "EosSyncLib.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fans out what changed in each ShowSnapshot generation to any number of
+// in-process consumers.
+//
+// EosSyncLib's dirty flags can only be observed once, by whoever looks before
+// ClearDirty(). ShowSnapshot::Update() is that one observer; it turns the flags
+// into a batch naming the lists and targets that changed and publishes it
+// here. Batches are immutable and shared, kept in a bounded ring, and every
+// subscriber has its own cursor into it, so consumers read at their own pace
+// and only look at what changed. A subscriber that falls further behind than
+// the ring holds is told to rescan the snapshot instead.
+class ChangeHub
+{
+public:
+	enum EnumTargetChange
+	{
+		TARGET_ADDED,
+		TARGET_CHANGED,
+		TARGET_REMOVED
+	};
+
+	struct sTargetChange
+	{
+		std::string			number;
+		double				numberValue;
+		int					part;
+		EnumTargetChange	kind;
+	};
+
+	typedef std::vector<sTargetChange> TARGET_CHANGES;	// in number/part order
+
+	struct sListChange
+	{
+		EosTarget::EnumEosTargetType	type;
+		int								listId;
+		bool							removed;	// the whole list went away
+		TARGET_CHANGES					targets;
+	};
+
+	typedef std::vector<sListChange> LIST_CHANGES;
+
+	struct sBatch
+	{
+		unsigned int	generation;		// ShowSnapshot generation these changes produced
+		LIST_CHANGES	lists;
+	};
+
+	typedef QSharedPointer<const sBatch> BATCH_PTR;
+	typedef std::vector<BATCH_PTR> BATCHES;
+	typedef std::set<int> LIST_IDS;
+
+	ChangeHub(size_t capacity);
+	virtual ~ChangeHub() {}
+
+	// any thread
+	virtual int Subscribe();
+	virtual void Unsubscribe(int id);
+	virtual bool Take(int id, BATCHES &batches);	// false if batches were missed
+	virtual void GetStats(size_t &subscribers, quint64 &published) const;
+
+	// ShowSnapshot, takes ownership
+	virtual void Publish(sBatch *batch);
+	virtual void Reset();
+
+	// every list the batches touched, lists[type] for each target type
+	static void GetChangedLists(const BATCHES &batches, LIST_IDS *lists);
+
+protected:
+	struct sSubscriber
+	{
+		quint64	cursor;		// sequence number of the next batch to take
+		bool	missed;
+	};
+
+	typedef std::deque<BATCH_PTR> BATCH_Q;
+	typedef std::map<int, sSubscriber> SUBSCRIBERS;
+
+	mutable QMutex	m_Mutex;
+	size_t			m_Capacity;
+	BATCH_Q			m_Batches;
+	quint64			m_FirstSeq;		// sequence number of m_Batches.front()
+	SUBSCRIBERS		m_Subscribers;
+	int				m_NextId;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
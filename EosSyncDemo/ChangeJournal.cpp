@@ -0,0 +1,539 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ChangeJournal.h"
+#include "ChangeStats.h"
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define VIEW_MAX_ROWS		2000
+#define VIEW_UPDATE_MS		250
+#define VIEW_SLIDE_MS		5000
+#define NS_PER_MINUTE		Q_INT64_C(60000000000)
+
+////////////////////////////////////////////////////////////////////////////////
+
+// finds a target by number and part in a list's number/part order
+static const ShowSnapshot::sTarget* FindTarget(const ShowSnapshot::sTargetList *list, const ChangeHub::sTargetChange &change)
+{
+	if( !list )
+		return 0;
+
+	ShowSnapshot::sTarget key;
+	key.numberValue = change.numberValue;
+	key.part = change.part;
+	ShowSnapshot::TARGETS::const_iterator i = std::lower_bound(list->targets.begin(), list->targets.end(), key, &ShowSnapshot::TargetLess);
+	if(i==list->targets.end() || ShowSnapshot::TargetLess(key,*i))
+		return 0;
+	return &(*i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a list of a type that may have been spilled, loading it at most once
+static const ShowSnapshot::sTargetList* FindList(const ShowSnapshot &snapshot, const ShowSnapshot::TARGET_TYPE_PTR &targetType, ShowSnapshot::TARGET_TYPE_PTR &loaded, int listId)
+{
+	if( !targetType )
+		return 0;
+
+	if( !loaded )
+		loaded = snapshot.LoadTargetType(targetType);
+
+	ShowSnapshot::TARGET_LISTS::const_iterator i = loaded->lists.find(listId);
+	return ((i == loaded->lists.end()) ? 0 : i->second.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ChangeJournal::sQuery::sQuery()
+	: allTypes(true)
+	, type(EosTarget::EOS_TARGET_COUNT)
+	, fromNS(0)
+	, toNS(Q_INT64_C(0x7fffffffffffffff))
+	, max(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ChangeJournal::ChangeJournal(size_t capacity)
+	: m_Head(0)
+	, m_Count(0)
+	, m_FirstSeq(0)
+	, m_Generation(0)
+{
+	m_Changes.resize((capacity==0) ? 1 : capacity);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournal::Record(const ShowSnapshot::TARGET_TYPE_PTR *prev, const ShowSnapshot &snapshot, const bool *ready, const ChangeHub::sBatch *batch, qint64 ns)
+{
+	if( batch )
+	{
+		DiffBatch(prev, snapshot, ready, *batch, ns);
+		return;
+	}
+
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		// types still in their initial sync would journal every target as added
+		if( !ready[i] )
+			continue;
+
+		ShowSnapshot::TARGET_TYPE_PTR next = snapshot.GetTargetType( static_cast<EosTarget::EnumEosTargetType>(i) );
+		if(next==prev[i] || !prev[i] || !next || next->generation==prev[i]->generation)
+			continue;
+
+		// a type spilled by the memory budget is read back just for the diff
+		ShowSnapshot::TARGET_TYPE_PTR prevLoaded = snapshot.LoadTargetType(prev[i]);
+		ShowSnapshot::TARGET_TYPE_PTR nextLoaded = snapshot.LoadTargetType(next);
+		if(prevLoaded->spilled || nextLoaded->spilled)
+			continue;
+
+		DiffTargetType(*prevLoaded, *nextLoaded, ns);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournal::Clear()
+{
+	m_Head = 0;
+	m_Count = 0;
+	m_FirstSeq = 0;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		m_TypeSeqs[i].clear();
+	m_Generation++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournal::Query(const sQuery &query, CHANGES &changes) const
+{
+	changes.clear();
+
+	const SEQS *seqs = 0;
+	if( !query.allTypes )
+	{
+		if(query.type<0 || query.type>=EosTarget::EOS_TARGET_COUNT)
+			return;
+		seqs = &m_TypeSeqs[query.type];
+	}
+
+	// entries are in time order, so find the newest one inside the window...
+	size_t n = (seqs ? seqs->size() : m_Count);
+	size_t lo = 0;
+	size_t hi = n;
+	while(lo < hi)
+	{
+		size_t mid = (lo + (hi - lo)/2);
+		quint64 seq = (seqs ? (*seqs)[mid] : (m_FirstSeq + mid));
+		if(GetBySeq(seq).ns <= query.toNS)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	// ...and walk back to the oldest
+	for(size_t i=lo; i>0; i--)
+	{
+		quint64 seq = (seqs ? (*seqs)[i-1] : (m_FirstSeq + i - 1));
+		const sChange &change = GetBySeq(seq);
+		if(change.ns < query.fromNS)
+			break;
+
+		changes.push_back(change);
+		if(query.max!=0 && changes.size()>=query.max)
+			break;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* ChangeJournal::GetChangeKindName(EnumChangeKind kind)
+{
+	switch( kind )
+	{
+		case CHANGE_ADDED:		return "added";
+		case CHANGE_REMOVED:	return "removed";
+		case CHANGE_VALUE:		return "changed";
+	}
+
+	return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ChangeJournal::sChange& ChangeJournal::Add(EosTarget::EnumEosTargetType type, EnumChangeKind kind, qint64 ns)
+{
+	size_t capacity = m_Changes.size();
+	if(m_Count == capacity)
+	{
+		// overwrite the oldest, which is also the oldest of its type
+		m_TypeSeqs[ m_Changes[m_Head].type ].pop_front();
+		m_Head = ((m_Head + 1) % capacity);
+		m_Count--;
+		m_FirstSeq++;
+	}
+
+	quint64 seq = (m_FirstSeq + m_Count);
+	sChange &change = m_Changes[(m_Head + m_Count) % capacity];
+	m_Count++;
+	m_TypeSeqs[type].push_back(seq);
+	m_Generation++;
+
+	change.ns = ns;
+	change.type = type;
+	change.kind = kind;
+	change.listId = 0;
+	change.number.clear();
+	change.part = 0;
+	change.group.clear();
+	change.prop = -1;
+	change.oldValue.clear();
+	change.newValue.clear();
+	return change;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const ChangeJournal::sChange& ChangeJournal::GetBySeq(quint64 seq) const
+{
+	return m_Changes[(m_Head + static_cast<size_t>(seq - m_FirstSeq)) % m_Changes.size()];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournal::DiffBatch(const ShowSnapshot::TARGET_TYPE_PTR *prev, const ShowSnapshot &snapshot, const bool *ready, const ChangeHub::sBatch &batch, qint64 ns)
+{
+	ShowSnapshot::TARGET_TYPE_PTR next[EosTarget::EOS_TARGET_COUNT];
+	ShowSnapshot::TARGET_TYPE_PTR prevLoaded[EosTarget::EOS_TARGET_COUNT];
+	ShowSnapshot::TARGET_TYPE_PTR nextLoaded[EosTarget::EOS_TARGET_COUNT];
+
+	for(ChangeHub::LIST_CHANGES::const_iterator i=batch.lists.begin(); i!=batch.lists.end(); i++)
+	{
+		const ChangeHub::sListChange &listChange = *i;
+		int t = static_cast<int>(listChange.type);
+		if(!ready[t] || !prev[t])
+			continue;
+
+		if( !next[t] )
+			next[t] = snapshot.GetTargetType(listChange.type);
+
+		const ShowSnapshot::sTargetList *prevList = FindList(snapshot, prev[t], prevLoaded[t], listChange.listId);
+		if(prevLoaded[t] && prevLoaded[t]->spilled)
+			continue;	// couldn't read it back
+
+		if( listChange.removed )
+		{
+			DiffTargetList(listChange.type, listChange.listId, prevList, 0, ns);
+			continue;
+		}
+
+		const ShowSnapshot::sTargetList *nextList = FindList(snapshot, next[t], nextLoaded[t], listChange.listId);
+		for(ChangeHub::TARGET_CHANGES::const_iterator j=listChange.targets.begin(); j!=listChange.targets.end(); j++)
+		{
+			const ShowSnapshot::sTarget *prevTarget = FindTarget(prevList, *j);
+			const ShowSnapshot::sTarget *nextTarget = FindTarget(nextList, *j);
+			if(prevTarget && nextTarget)
+				DiffTarget(listChange.type, listChange.listId, *prevTarget, *nextTarget, ns);
+			else if( prevTarget )
+				AddTarget(listChange.type, CHANGE_REMOVED, listChange.listId, *prevTarget, ns);
+			else if( nextTarget )
+				AddTarget(listChange.type, CHANGE_ADDED, listChange.listId, *nextTarget, ns);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournal::DiffTargetType(const ShowSnapshot::sTargetType &prev, const ShowSnapshot::sTargetType &next, qint64 ns)
+{
+	// lists are shared between generations unless they changed, so most of
+	// these are pointer compares
+	ShowSnapshot::TARGET_LISTS::const_iterator i = prev.lists.begin();
+	ShowSnapshot::TARGET_LISTS::const_iterator j = next.lists.begin();
+	while(i!=prev.lists.end() || j!=next.lists.end())
+	{
+		if(j==next.lists.end() || (i!=prev.lists.end() && i->first<j->first))
+		{
+			DiffTargetList(prev.type, i->first, i->second.data(), 0, ns);
+			i++;
+		}
+		else if(i==prev.lists.end() || j->first<i->first)
+		{
+			DiffTargetList(next.type, j->first, 0, j->second.data(), ns);
+			j++;
+		}
+		else
+		{
+			if(i->second != j->second)
+				DiffTargetList(next.type, j->first, i->second.data(), j->second.data(), ns);
+			i++;
+			j++;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournal::DiffTargetList(EosTarget::EnumEosTargetType type, int listId, const ShowSnapshot::sTargetList *prev, const ShowSnapshot::sTargetList *next, qint64 ns)
+{
+	static const ShowSnapshot::TARGETS sNone;
+	const ShowSnapshot::TARGETS &prevTargets = (prev ? prev->targets : sNone);
+	const ShowSnapshot::TARGETS &nextTargets = (next ? next->targets : sNone);
+
+	ShowSnapshot::TARGETS::const_iterator i = prevTargets.begin();
+	ShowSnapshot::TARGETS::const_iterator j = nextTargets.begin();
+	while(i!=prevTargets.end() || j!=nextTargets.end())
+	{
+		if(j==nextTargets.end() || (i!=prevTargets.end() && ShowSnapshot::TargetLess(*i,*j)))
+		{
+			AddTarget(type, CHANGE_REMOVED, listId, *i, ns);
+			i++;
+		}
+		else if(i==prevTargets.end() || ShowSnapshot::TargetLess(*j,*i))
+		{
+			AddTarget(type, CHANGE_ADDED, listId, *j, ns);
+			j++;
+		}
+		else
+		{
+			DiffTarget(type, listId, *i, *j, ns);
+			i++;
+			j++;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournal::DiffTarget(EosTarget::EnumEosTargetType type, int listId, const ShowSnapshot::sTarget &prev, const ShowSnapshot::sTarget &next, qint64 ns)
+{
+	static const std::vector<std::string> sNone;
+
+	// groups are in name order on both sides
+	ShowSnapshot::PROP_GROUPS::const_iterator i = prev.propGroups.begin();
+	ShowSnapshot::PROP_GROUPS::const_iterator j = next.propGroups.begin();
+	while(i!=prev.propGroups.end() || j!=next.propGroups.end())
+	{
+		const std::string *name;
+		const std::vector<std::string> *prevValues;
+		const std::vector<std::string> *nextValues;
+		if(j==next.propGroups.end() || (i!=prev.propGroups.end() && i->name<j->name))
+		{
+			name = &i->name;
+			prevValues = &i->values;
+			nextValues = &sNone;
+			i++;
+		}
+		else if(i==prev.propGroups.end() || j->name<i->name)
+		{
+			name = &j->name;
+			prevValues = &sNone;
+			nextValues = &j->values;
+			j++;
+		}
+		else
+		{
+			name = &j->name;
+			prevValues = &i->values;
+			nextValues = &j->values;
+			i++;
+			j++;
+		}
+
+		size_t count = qMax(prevValues->size(), nextValues->size());
+		for(size_t k=0; k<count; k++)
+		{
+			const std::string *prevValue = ((k < prevValues->size()) ? &(*prevValues)[k] : 0);
+			const std::string *nextValue = ((k < nextValues->size()) ? &(*nextValues)[k] : 0);
+			if(prevValue && nextValue && *prevValue==*nextValue)
+				continue;
+
+			sChange &change = Add(type, CHANGE_VALUE, ns);
+			change.listId = listId;
+			change.number = next.number;
+			change.part = next.part;
+			change.group = *name;
+			change.prop = static_cast<int>(k);
+			if( prevValue )
+				change.oldValue = *prevValue;
+			if( nextValue )
+				change.newValue = *nextValue;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournal::AddTarget(EosTarget::EnumEosTargetType type, EnumChangeKind kind, int listId, const ShowSnapshot::sTarget &target, qint64 ns)
+{
+	sChange &change = Add(type, kind, ns);
+	change.listId = listId;
+	change.number = target.number;
+	change.part = target.part;
+
+	// the target's label, when it has one, says which one it was
+	if(!target.propGroups.empty() && !target.propGroups.front().values.empty())
+	{
+		const std::string &value = target.propGroups.front().values.front();
+		if(kind == CHANGE_REMOVED)
+			change.oldValue = value;
+		else
+			change.newValue = value;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ChangeJournalView::ChangeJournalView(const ChangeJournal &journal, const ChangeStats &changeStats, QWidget *parent)
+	: QWidget(parent, Qt::Window)
+	, m_Journal(journal)
+	, m_ChangeStats(changeStats)
+	, m_Generation(0)
+	, m_Dirty(true)
+{
+	setWindowTitle("Recent Changes");
+
+	QGridLayout *layout = new QGridLayout(this);
+
+	m_Type = new QComboBox(this);
+	m_Type->addItem("All");
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		m_Type->addItem( EosTarget::GetNameForTargetType(static_cast<EosTarget::EnumEosTargetType>(i)) );
+	connect(m_Type, SIGNAL(currentIndexChanged(int)), this, SLOT(onFilterChanged(int)));
+	layout->addWidget(m_Type, 0, 0);
+
+	layout->addWidget(new QLabel("Last",this), 0, 1);
+
+	m_Minutes = new QSpinBox(this);
+	m_Minutes->setMinimum(1);
+	m_Minutes->setMaximum(24*60);
+	m_Minutes->setValue(10);
+	m_Minutes->setSuffix(" min");
+	connect(m_Minutes, SIGNAL(valueChanged(int)), this, SLOT(onFilterChanged(int)));
+	layout->addWidget(m_Minutes, 0, 2);
+
+	m_Summary = new QLabel(this);
+	QPalette summaryPal( m_Summary->palette() );
+	summaryPal.setColor(QPalette::WindowText, MUTED_COLOR);
+	m_Summary->setPalette(summaryPal);
+	layout->addWidget(m_Summary, 0, 3);
+	layout->setColumnStretch(3, 1);
+
+	m_Text = new QTextEdit(this);
+	m_Text->setAcceptRichText(false);
+	m_Text->setReadOnly(true);
+	m_Text->setWordWrapMode(QTextOption::NoWrap);
+	QFont fnt("Monospace");
+	fnt.setStyleHint(QFont::TypeWriter);
+	m_Text->setFont(fnt);
+	layout->addWidget(m_Text, 1, 0, 1, 4);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournalView::Update()
+{
+	if( !isVisible() )
+		return;
+
+	if(!m_Dirty && m_UpdateTimer.isValid())
+	{
+		if( !m_UpdateTimer.hasExpired(VIEW_UPDATE_MS) )
+			return;
+
+		// the window slides even when nothing new is journaled, so redraw now and then regardless
+		if(m_Generation==m_Journal.GetGeneration() && !m_UpdateTimer.hasExpired(VIEW_SLIDE_MS))
+			return;
+	}
+
+	m_UpdateTimer.start();
+	m_Generation = m_Journal.GetGeneration();
+	m_Dirty = false;
+
+	ChangeJournal::sQuery query;
+	int typeIndex = m_Type->currentIndex();
+	query.allTypes = (typeIndex <= 0);
+	if( !query.allTypes )
+		query.type = static_cast<EosTarget::EnumEosTargetType>(typeIndex - 1);
+	query.toNS = m_ChangeStats.Now();
+	query.fromNS = (query.toNS - m_Minutes->value()*NS_PER_MINUTE);
+	query.max = VIEW_MAX_ROWS;
+	m_Journal.Query(query, m_Results);
+
+	QString text;
+	for(ChangeJournal::CHANGES::const_iterator i=m_Results.begin(); i!=m_Results.end(); i++)
+	{
+		const ChangeJournal::sChange &change = *i;
+		text.append( m_ChangeStats.ToDateTime(change.ns).toString("hh:mm:ss.zzz") );
+		text.append("  ");
+		text.append( EosTarget::GetNameForTargetType(change.type) );
+		if(change.type==EosTarget::EOS_TARGET_CUE && change.listId>0)
+			text.append( QString(" %1/").arg(change.listId) );
+		else
+			text.append(" ");
+		text.append( QString::fromUtf8(change.number.c_str()) );
+		if(change.part > 0)
+			text.append( QString(" part %1").arg(change.part) );
+
+		switch( change.kind )
+		{
+			case ChangeJournal::CHANGE_ADDED:
+				text.append( QString(" added \"%1\"").arg(QString::fromUtf8(change.newValue.c_str())) );
+				break;
+
+			case ChangeJournal::CHANGE_REMOVED:
+				text.append( QString(" removed \"%1\"").arg(QString::fromUtf8(change.oldValue.c_str())) );
+				break;
+
+			case ChangeJournal::CHANGE_VALUE:
+				if( !change.group.empty() )
+					text.append( QString(" [%1]").arg(QString::fromUtf8(change.group.c_str())) );
+				text.append( QString(" #%1 \"%2\" -> \"%3\"")
+					.arg(change.prop)
+					.arg(QString::fromUtf8(change.oldValue.c_str()))
+					.arg(QString::fromUtf8(change.newValue.c_str())) );
+				break;
+		}
+
+		text.append("\n");
+	}
+
+	m_Text->setPlainText(text);
+
+	QString summary( QString("%1 shown, %2 journaled").arg(m_Results.size()).arg(m_Journal.GetCount()) );
+	if(m_Journal.GetOverwritten() != 0)
+		summary.append( QString(", %1 older changes overwritten").arg(m_Journal.GetOverwritten()) );
+	m_Summary->setText(summary);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeJournalView::onFilterChanged(int /*value*/)
+{
+	m_Dirty = true;
+	Update();
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,156 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef CHANGE_JOURNAL_H
+#define CHANGE_JOURNAL_H
+
+#ifndef SHOW_SNAPSHOT_H
+#include "ShowSnapshot.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <deque>
+#include <string>
+#include <vector>
+
+class ChangeStats;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Bounded history of target and property changes for one connection.
+//
+// Changes are found by diffing each new ShowSnapshot generation against the
+// previous one on the UI thread, after the EosSyncLib lock is released, so
+// the sync thread and EosSyncLib::Tick() never see the journal. Given the
+// generation's ChangeHub batch, only the targets it names are compared. Entries live
+// in a fixed size ring in time order; when it is full the oldest entries are
+// overwritten. Each target type also keeps the sequence numbers of its own
+// entries, so a query by type and time window is two binary searches rather
+// than a scan of the whole ring.
+class ChangeJournal
+{
+public:
+	enum EnumChangeKind
+	{
+		CHANGE_ADDED,		// target appeared
+		CHANGE_REMOVED,		// target went away
+		CHANGE_VALUE		// one property value changed
+	};
+
+	struct sChange
+	{
+		qint64							ns;			// ChangeStats clock
+		EosTarget::EnumEosTargetType	type;
+		EnumChangeKind					kind;
+		int								listId;
+		std::string						number;
+		int								part;
+		std::string						group;
+		int								prop;		// index within the group, -1 if n/a
+		std::string						oldValue;
+		std::string						newValue;
+	};
+
+	typedef std::vector<sChange> CHANGES;
+
+	struct sQuery
+	{
+		sQuery();
+		bool							allTypes;
+		EosTarget::EnumEosTargetType	type;
+		qint64							fromNS;		// inclusive
+		qint64							toNS;		// inclusive
+		size_t							max;
+	};
+
+	ChangeJournal(size_t capacity);
+	virtual ~ChangeJournal() {}
+
+	// UI thread; prev holds the target types from before ShowSnapshot::Update(),
+	// and batch its changes, or 0 to diff every type that moved
+	virtual void Record(const ShowSnapshot::TARGET_TYPE_PTR *prev, const ShowSnapshot &snapshot, const bool *ready, const ChangeHub::sBatch *batch, qint64 ns);
+	virtual void Clear();
+
+	// newest first
+	virtual void Query(const sQuery &query, CHANGES &changes) const;
+
+	virtual unsigned int GetGeneration() const {return m_Generation;}
+	virtual size_t GetCount() const {return m_Count;}
+	virtual size_t GetCapacity() const {return m_Changes.size();}
+	virtual quint64 GetOverwritten() const {return m_FirstSeq;}
+
+	static const char* GetChangeKindName(EnumChangeKind kind);
+
+protected:
+	typedef std::deque<quint64> SEQS;
+
+	CHANGES			m_Changes;
+	size_t			m_Head;		// oldest
+	size_t			m_Count;
+	quint64			m_FirstSeq;	// sequence number of the oldest entry
+	SEQS			m_TypeSeqs[EosTarget::EOS_TARGET_COUNT];
+	unsigned int	m_Generation;
+
+	virtual sChange& Add(EosTarget::EnumEosTargetType type, EnumChangeKind kind, qint64 ns);
+	virtual const sChange& GetBySeq(quint64 seq) const;
+	virtual void DiffBatch(const ShowSnapshot::TARGET_TYPE_PTR *prev, const ShowSnapshot &snapshot, const bool *ready, const ChangeHub::sBatch &batch, qint64 ns);
+	virtual void DiffTargetType(const ShowSnapshot::sTargetType &prev, const ShowSnapshot::sTargetType &next, qint64 ns);
+	virtual void DiffTargetList(EosTarget::EnumEosTargetType type, int listId, const ShowSnapshot::sTargetList *prev, const ShowSnapshot::sTargetList *next, qint64 ns);
+	virtual void DiffTarget(EosTarget::EnumEosTargetType type, int listId, const ShowSnapshot::sTarget &prev, const ShowSnapshot::sTarget &next, qint64 ns);
+	virtual void AddTarget(EosTarget::EnumEosTargetType type, EnumChangeKind kind, int listId, const ShowSnapshot::sTarget &target, qint64 ns);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ChangeJournalView
+	: public QWidget
+{
+	Q_OBJECT
+
+public:
+	ChangeJournalView(const ChangeJournal &journal, const ChangeStats &changeStats, QWidget *parent);
+
+	virtual void Update();
+
+	virtual QSize sizeHint() const {return QSize(700,480);}
+
+private slots:
+	void onFilterChanged(int);
+
+protected:
+	const ChangeJournal	&m_Journal;
+	const ChangeStats	&m_ChangeStats;
+	QComboBox			*m_Type;
+	QSpinBox			*m_Minutes;
+	QLabel				*m_Summary;
+	QTextEdit			*m_Text;
+	unsigned int		m_Generation;
+	bool				m_Dirty;
+	QElapsedTimer		m_UpdateTimer;
+	ChangeJournal::CHANGES	m_Results;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
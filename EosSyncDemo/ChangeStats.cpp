@@ -0,0 +1,179 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ChangeStats.h"
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define NS_PER_SECOND	Q_INT64_C(1000000000)
+
+////////////////////////////////////////////////////////////////////////////////
+
+ChangeStats::sTypeStats::sTypeStats()
+	: lastArrivalNS(0)
+	, lastAppliedNS(0)
+	, lastLatencyNS(-1)
+	, maxLatencyNS(-1)
+	, ratePerSecond(0)
+	, rateFromArrivals(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ChangeStats::ChangeStats()
+{
+	m_WallStart = QDateTime::currentDateTime();
+	m_Clock.start();
+	Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 ChangeStats::Now() const
+{
+	// never 0, which means "never" everywhere else
+	return (m_Clock.nsecsElapsed() + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QDateTime ChangeStats::ToDateTime(qint64 ns) const
+{
+	return m_WallStart.addMSecs(ns / 1000000);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeStats::OnArrival(EosTarget::EnumEosTargetType type, qint64 ns)
+{
+	if(type<0 || type>=EosTarget::EOS_TARGET_COUNT)
+		return;
+
+	m_Mutex.lock();
+	sType &t = m_Types[type];
+	t.lastArrivalNS = ns;
+	if(t.pendingArrivalNS == 0)
+		t.pendingArrivalNS = ns;
+	AddRate(t.arrivals, ns, 1);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeStats::OnApplied(EosTarget::EnumEosTargetType type, qint64 ns, unsigned int changes)
+{
+	if(type<0 || type>=EosTarget::EOS_TARGET_COUNT)
+		return;
+
+	m_Mutex.lock();
+	sType &t = m_Types[type];
+	t.lastAppliedNS = ns;
+	if(t.pendingArrivalNS != 0)
+	{
+		t.lastLatencyNS = (ns - t.pendingArrivalNS);
+		if(t.lastLatencyNS > t.maxLatencyNS)
+			t.maxLatencyNS = t.lastLatencyNS;
+		t.pendingArrivalNS = 0;
+	}
+	AddRate(t.applies, ns, changes);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeStats::GetTypeStats(EosTarget::EnumEosTargetType type, sTypeStats &stats) const
+{
+	stats = sTypeStats();
+	if(type<0 || type>=EosTarget::EOS_TARGET_COUNT)
+		return;
+
+	qint64 now = Now();
+
+	m_Mutex.lock();
+	const sType &t = m_Types[type];
+	stats.lastArrivalNS = t.lastArrivalNS;
+	stats.lastAppliedNS = t.lastAppliedNS;
+	stats.lastLatencyNS = t.lastLatencyNS;
+	stats.maxLatencyNS = t.maxLatencyNS;
+	stats.rateFromArrivals = (t.lastArrivalNS != 0);
+	stats.ratePerSecond = GetRate(stats.rateFromArrivals ? t.arrivals : t.applies, now);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeStats::Clear()
+{
+	m_Mutex.lock();
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		sType &t = m_Types[i];
+		memset(&t, 0, sizeof(t));
+		t.lastLatencyNS = -1;
+		t.maxLatencyNS = -1;
+	}
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeStats::FormatLatency(qint64 ns, QString &str)
+{
+	if(ns < 0)
+		str = "-";
+	else if(ns < 1000000)
+		str = QString("%1 us").arg(ns/1000.0, 0, 'f', 0);
+	else
+		str = QString("%1 ms").arg(ns/1000000.0, 0, 'f', 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeStats::AddRate(sRate &rate, qint64 ns, unsigned int n)
+{
+	qint64 second = (ns / NS_PER_SECOND);
+	int bucket = static_cast<int>(second % RATE_WINDOW_SECONDS);
+	if(rate.second[bucket] != second)
+	{
+		rate.second[bucket] = second;
+		rate.count[bucket] = 0;
+	}
+	rate.count[bucket] += n;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+double ChangeStats::GetRate(const sRate &rate, qint64 ns)
+{
+	// the full seconds before this one
+	qint64 second = (ns / NS_PER_SECOND);
+	unsigned int total = 0;
+	for(int i=0; i<RATE_WINDOW_SECONDS; i++)
+	{
+		if(rate.second[i]<second && rate.second[i]>=second-(RATE_WINDOW_SECONDS-1))
+			total += rate.count[i];
+	}
+
+	return (total / static_cast<double>(RATE_WINDOW_SECONDS-1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,105 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef CHANGE_STATS_H
+#define CHANGE_STATS_H
+
+#ifndef EOS_SYNC_LIB_H
+#include "EosSyncLib.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Monotonic, nanosecond resolution change times and rates per target type.
+//
+// Arrivals are recorded by the OSC proxy tap as console packets come in, and
+// applies when the UI finds the type's lists dirty in EosSyncData. The UI
+// only looks once per tick, so an apply time is the tick that first saw the
+// change, up to one tick interval after EosSyncLib applied it. The time from
+// the first arrival after an apply to the next apply is the latency for that
+// update, with the same tick granularity. Rates are counted in one second buckets over a rolling window,
+// from arrivals when the tap is running and from dirty lists otherwise.
+class ChangeStats
+{
+public:
+	enum EnumConstants
+	{
+		RATE_WINDOW_SECONDS	= 5
+	};
+
+	struct sTypeStats
+	{
+		sTypeStats();
+		qint64		lastArrivalNS;		// 0 if never
+		qint64		lastAppliedNS;		// 0 if never
+		qint64		lastLatencyNS;		// -1 if unknown
+		qint64		maxLatencyNS;		// -1 if unknown
+		double		ratePerSecond;
+		bool		rateFromArrivals;
+	};
+
+	ChangeStats();
+	virtual ~ChangeStats() {}
+
+	// any thread
+	virtual qint64 Now() const;
+	virtual QDateTime ToDateTime(qint64 ns) const;
+	virtual void OnArrival(EosTarget::EnumEosTargetType type, qint64 ns);
+	virtual void OnApplied(EosTarget::EnumEosTargetType type, qint64 ns, unsigned int changes);
+	virtual void GetTypeStats(EosTarget::EnumEosTargetType type, sTypeStats &stats) const;
+	virtual void Clear();
+
+	static void FormatLatency(qint64 ns, QString &str);
+
+protected:
+	struct sRate
+	{
+		qint64			second[RATE_WINDOW_SECONDS];
+		unsigned int	count[RATE_WINDOW_SECONDS];
+	};
+
+	struct sType
+	{
+		qint64	lastArrivalNS;
+		qint64	pendingArrivalNS;	// first arrival not yet applied, 0 if none
+		qint64	lastAppliedNS;
+		qint64	lastLatencyNS;
+		qint64	maxLatencyNS;
+		sRate	arrivals;
+		sRate	applies;
+	};
+
+	QElapsedTimer	m_Clock;
+	QDateTime		m_WallStart;
+	mutable QMutex	m_Mutex;
+	sType			m_Types[EosTarget::EOS_TARGET_COUNT];
+
+	static void AddRate(sRate &rate, qint64 ns, unsigned int n);
+	static double GetRate(const sRate &rate, qint64 ns);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,608 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifdef WIN32
+	// room for every probe in flight; must come before anything pulls in winsock
+	#define FD_SETSIZE	1024
+	#include <winsock2.h>
+#endif
+
+#include "ConsoleDiscovery.h"
+#include "StandInConsole.h"
+#include "EosSyncLib.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#ifndef WIN32
+	#include <sys/types.h>
+	#include <sys/socket.h>
+	#include <poll.h>
+	#include <netinet/in.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <errno.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define DISCOVERY_POLL_MS		20		// longest wait, so Stop() is noticed
+#define DISCOVERY_MAX_IN_FLIGHT	512		// well inside the usual 1024 descriptor limit, and Windows' FD_SETSIZE
+#define NS_PER_MS				Q_INT64_C(1000000)
+
+#ifdef WIN32
+	typedef SOCKET DISCOVERY_SOCKET;
+	typedef int DISCOVERY_SOCKLEN;
+	#define DISCOVERY_INVALID_SOCKET	INVALID_SOCKET
+#else
+	typedef int DISCOVERY_SOCKET;
+	typedef socklen_t DISCOVERY_SOCKLEN;
+	#define DISCOVERY_INVALID_SOCKET	(-1)
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+enum EnumConnectResult
+{
+	CONNECT_RESULT_CONNECTED,
+	CONNECT_RESULT_PENDING,
+	CONNECT_RESULT_REFUSED,
+	CONNECT_RESULT_ERROR
+};
+
+enum EnumProbeEvent
+{
+	PROBE_EVENT_NONE,
+	PROBE_EVENT_DONE,		// connected or failed, SO_ERROR says which
+	PROBE_EVENT_FAILED
+};
+
+struct sDiscoveryProbe
+{
+	DISCOVERY_SOCKET	s;
+	quint32				ip;
+	unsigned short		port;
+	qint64				startNS;
+};
+
+typedef std::vector<sDiscoveryProbe> DISCOVERY_PROBES;
+typedef std::vector<EnumProbeEvent> PROBE_EVENTS;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void CloseSocket(DISCOVERY_SOCKET s)
+{
+#ifdef WIN32
+	closesocket(s);
+#else
+	close(s);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void RunBenchmarkPass(const ConsoleDiscovery::sSettings &settings, ConsoleDiscovery::CONSOLES &found, ConsoleDiscovery::sStats &stats)
+{
+	ConsoleDiscovery discovery;
+	discovery.Start(settings);
+	discovery.wait();
+	discovery.GetConsoles(found);
+	discovery.GetStats(stats);
+
+	printf("  %u probes in %lld ms: %u found, %u refused, %u timed out, %u errors\n",
+		stats.probes,
+		static_cast<long long>(stats.elapsedMS),
+		static_cast<unsigned int>(found.size()),
+		stats.refused,
+		stats.timedOut,
+		stats.errors);
+	fflush(stdout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static EnumConnectResult StartConnect(quint32 ip, unsigned short port, DISCOVERY_SOCKET &s)
+{
+	s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(s == DISCOVERY_INVALID_SOCKET)
+		return CONNECT_RESULT_ERROR;
+
+#ifdef WIN32
+	u_long nonBlocking = 1;
+	if(ioctlsocket(s,FIONBIO,&nonBlocking) != 0)
+#else
+	int flags = fcntl(s, F_GETFL, 0);
+	if(flags<0 || fcntl(s,F_SETFL,flags|O_NONBLOCK)<0)
+#endif
+	{
+		CloseSocket(s);
+		s = DISCOVERY_INVALID_SOCKET;
+		return CONNECT_RESULT_ERROR;
+	}
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(ip);
+	if(connect(s,reinterpret_cast<const sockaddr*>(&addr),sizeof(addr)) == 0)
+		return CONNECT_RESULT_CONNECTED;
+
+#ifdef WIN32
+	if(WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+	if(errno == EINPROGRESS)
+#endif
+		return CONNECT_RESULT_PENDING;
+
+	CloseSocket(s);
+	s = DISCOVERY_INVALID_SOCKET;
+	return CONNECT_RESULT_REFUSED;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void WaitProbes(const DISCOVERY_PROBES &inFlight, qint64 waitNS, PROBE_EVENTS &events)
+{
+	events.assign(inFlight.size(), PROBE_EVENT_NONE);
+
+#ifdef WIN32
+	// a Windows fd_set is a list of up to FD_SETSIZE sockets, whatever their
+	// handles; a connect finishes as writable, or a failure lands in the except set
+	fd_set writeFds;
+	fd_set exceptFds;
+	FD_ZERO(&writeFds);
+	FD_ZERO(&exceptFds);
+	for(DISCOVERY_PROBES::const_iterator i=inFlight.begin(); i!=inFlight.end(); i++)
+	{
+		FD_SET(i->s, &writeFds);
+		FD_SET(i->s, &exceptFds);
+	}
+
+	timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = static_cast<long>(waitNS / 1000);
+	if(select(0,0,&writeFds,&exceptFds,&tv) <= 0)
+		return;
+
+	for(size_t i=0; i<inFlight.size(); i++)
+	{
+		if( FD_ISSET(inFlight[i].s,&writeFds) )
+			events[i] = PROBE_EVENT_DONE;
+		else if( FD_ISSET(inFlight[i].s,&exceptFds) )
+			events[i] = PROBE_EVENT_FAILED;
+	}
+#else
+	// poll() rather than select(), which can't take a descriptor at or past
+	// FD_SETSIZE, and a busy app can be handed one however few are in flight;
+	// a finished connect is writable, and an error or hangup is reported too
+	std::vector<pollfd> fds( inFlight.size() );
+	for(size_t i=0; i<inFlight.size(); i++)
+	{
+		fds[i].fd = inFlight[i].s;
+		fds[i].events = POLLOUT;
+		fds[i].revents = 0;
+	}
+
+	int timeoutMS = static_cast<int>((waitNS + NS_PER_MS - 1) / NS_PER_MS);
+	if(fds.empty() || poll(&fds[0],static_cast<nfds_t>(fds.size()),timeoutMS)<=0)
+		return;
+
+	for(size_t i=0; i<fds.size(); i++)
+	{
+		if(fds[i].revents != 0)
+			events[i] = PROBE_EVENT_DONE;
+	}
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleDiscovery::sSettings::sSettings()
+	: timeoutMS(250)
+	, maxInFlight(512)
+	, minPrefixLength(22)
+	, localSubnets(true)
+{
+	ports.push_back(EosSyncLib::DEFAULT_PORT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleDiscovery::sStats::sStats()
+	: probes(0)
+	, refused(0)
+	, timedOut(0)
+	, errors(0)
+	, elapsedMS(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleDiscovery::ConsoleDiscovery()
+	: m_Run(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleDiscovery::~ConsoleDiscovery()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleDiscovery::Start(const sSettings &settings)
+{
+	Stop();
+
+	m_Settings = settings;
+	m_Consoles.clear();
+	m_Stats = sStats();
+	m_Run = true;
+	start();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleDiscovery::Stop()
+{
+	m_Run = false;
+	wait();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleDiscovery::GetConsoles(CONSOLES &consoles) const
+{
+	m_Mutex.lock();
+	consoles = m_Consoles;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleDiscovery::GetStats(sStats &stats) const
+{
+	m_Mutex.lock();
+	stats = m_Stats;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleDiscovery::AddConsole(quint32 ip, unsigned short port, qint64 connectNS)
+{
+	sConsole console;
+	console.ip = ip;
+	console.port = port;
+	console.connectMS = static_cast<unsigned int>(connectNS / NS_PER_MS);
+	m_Mutex.lock();
+	m_Consoles.push_back(console);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleDiscovery::GetLocalHosts(unsigned int minPrefixLength, std::vector<quint32> &hosts)
+{
+	QList<QNetworkInterface> nics = QNetworkInterface::allInterfaces();
+	for(QList<QNetworkInterface>::const_iterator i=nics.begin(); i!=nics.end(); i++)
+	{
+		const QNetworkInterface &net = *i;
+		if(!net.isValid() ||
+			!net.flags().testFlag(QNetworkInterface::IsUp) ||
+			!net.flags().testFlag(QNetworkInterface::IsRunning) ||
+			net.flags().testFlag(QNetworkInterface::IsLoopBack) )
+		{
+			continue;
+		}
+
+		QList<QNetworkAddressEntry> addrs = net.addressEntries();
+		for(QList<QNetworkAddressEntry>::const_iterator j=addrs.begin(); j!=addrs.end(); j++)
+		{
+			QHostAddress addr = j->ip();
+			if(addr.isNull() || addr.protocol()!=QAbstractSocket::IPv4Protocol)
+				continue;
+
+			// point to point links have no neighbors to find
+			int prefixLength = j->prefixLength();
+			if(prefixLength<0 || prefixLength>30)
+				continue;
+			prefixLength = qMax(prefixLength, static_cast<int>(qMin(minPrefixLength,30u)));
+
+			quint32 ip = addr.toIPv4Address();
+			quint32 mask = ((prefixLength == 0) ? 0 : (0xffffffffu << (32 - prefixLength)));
+			quint32 network = (ip & mask);
+			quint32 broadcast = (network | ~mask);
+			for(quint32 host=network+1; host<broadcast; host++)
+			{
+				if(host != ip)
+					hosts.push_back(host);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QString ConsoleDiscovery::GetConsoleName(const sConsole &console)
+{
+	QString name( QHostAddress(console.ip).toString() );
+	if(console.port != EosSyncLib::DEFAULT_PORT)
+		name.append( QString(":%1").arg(console.port) );
+	return name;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleDiscovery::run()
+{
+	QElapsedTimer clock;
+	clock.start();
+
+#ifdef WIN32
+	WSADATA wsaData;
+	bool wsa = (WSAStartup(MAKEWORD(2,2),&wsaData) == 0);
+#endif
+
+	std::vector<quint32> hosts( m_Settings.hosts );
+	if( m_Settings.localSubnets )
+		GetLocalHosts(m_Settings.minPrefixLength, hosts);
+	std::sort(hosts.begin(), hosts.end());
+	hosts.erase(std::unique(hosts.begin(),hosts.end()), hosts.end());
+
+	const std::vector<unsigned short> &ports = m_Settings.ports;
+	size_t total = (hosts.size() * ports.size());
+	size_t maxInFlight = qBound(static_cast<size_t>(1), static_cast<size_t>(m_Settings.maxInFlight), static_cast<size_t>(DISCOVERY_MAX_IN_FLIGHT));
+	qint64 timeoutNS = (m_Settings.timeoutMS * NS_PER_MS);
+
+	sStats stats;
+	DISCOVERY_PROBES inFlight;
+	inFlight.reserve(maxInFlight);
+	PROBE_EVENTS events;
+	size_t next = 0;
+	while(m_Run && (next<total || !inFlight.empty()))
+	{
+		// top up, host by host so each subnet gets its answers early
+		while(next<total && inFlight.size()<maxInFlight)
+		{
+			sDiscoveryProbe probe;
+			probe.ip = hosts[next / ports.size()];
+			probe.port = ports[next % ports.size()];
+			probe.startNS = clock.nsecsElapsed();
+			next++;
+			stats.probes++;
+
+			switch( StartConnect(probe.ip,probe.port,probe.s) )
+			{
+				case CONNECT_RESULT_CONNECTED:
+					AddConsole(probe.ip, probe.port, clock.nsecsElapsed()-probe.startNS);
+					CloseSocket(probe.s);
+					break;
+
+				case CONNECT_RESULT_PENDING:
+					inFlight.push_back(probe);
+					break;
+
+				case CONNECT_RESULT_REFUSED:
+					stats.refused++;
+					break;
+
+				case CONNECT_RESULT_ERROR:
+					stats.errors++;
+					break;
+			}
+		}
+
+		if( !inFlight.empty() )
+		{
+			qint64 firstNS = inFlight.front().startNS;
+			for(DISCOVERY_PROBES::const_iterator i=inFlight.begin(); i!=inFlight.end(); i++)
+				firstNS = qMin(firstNS, i->startNS);
+
+			qint64 waitNS = qBound(Q_INT64_C(0), firstNS+timeoutNS-clock.nsecsElapsed(), DISCOVERY_POLL_MS*NS_PER_MS);
+			WaitProbes(inFlight, waitNS, events);
+
+			// events stay in step with inFlight as finished probes are swapped out
+			qint64 now = clock.nsecsElapsed();
+			for(size_t i=0; i<inFlight.size(); )
+			{
+				const sDiscoveryProbe &probe = inFlight[i];
+				bool done = true;
+				if(events[i] == PROBE_EVENT_DONE)
+				{
+					int err = 0;
+					DISCOVERY_SOCKLEN len = sizeof(err);
+					if(getsockopt(probe.s,SOL_SOCKET,SO_ERROR,reinterpret_cast<char*>(&err),&len)==0 && err==0)
+						AddConsole(probe.ip, probe.port, now-probe.startNS);
+					else
+						stats.refused++;
+				}
+				else if(events[i] == PROBE_EVENT_FAILED)
+					stats.refused++;
+				else if(now-probe.startNS >= timeoutNS)
+					stats.timedOut++;
+				else
+					done = false;
+
+				if( done )
+				{
+					CloseSocket(probe.s);
+					inFlight[i] = inFlight.back();
+					inFlight.pop_back();
+					events[i] = events.back();
+					events.pop_back();
+				}
+				else
+					i++;
+			}
+		}
+
+		stats.elapsedMS = clock.elapsed();
+		m_Mutex.lock();
+		m_Stats = stats;
+		m_Mutex.unlock();
+	}
+
+	for(DISCOVERY_PROBES::const_iterator i=inFlight.begin(); i!=inFlight.end(); i++)
+		CloseSocket(i->s);
+
+#ifdef WIN32
+	if( wsa )
+		WSACleanup();
+#endif
+
+	m_Mutex.lock();
+	std::sort(m_Consoles.begin(), m_Consoles.end());
+	m_Stats = stats;
+	m_Stats.elapsedMS = clock.elapsed();
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int ConsoleDiscovery::Benchmark(unsigned int listeners)
+{
+	// stand-in listeners on 127.0.0.1, and as many ports just closed again
+	StandInConsole::sSettings consoleSettings;
+	consoleSettings.targetsPerType = 0;
+	std::vector<StandInConsole*> consoles;
+	sSettings settings;
+	settings.localSubnets = false;
+	settings.ports.clear();
+	CONSOLES expected;
+	bool ok = true;
+	for(unsigned int i=0; ok && i<listeners; i++)
+	{
+		StandInConsole *console = new StandInConsole(consoleSettings);
+		consoles.push_back(console);
+		unsigned short port = 0;
+		ok = console->Listen(port);
+		if( ok )
+		{
+			settings.ports.push_back(port);
+			sConsole found;
+			found.ip = QHostAddress(QHostAddress::LocalHost).toIPv4Address();
+			found.port = port;
+			found.connectMS = 0;
+			expected.push_back(found);
+		}
+
+		QTcpServer closed;
+		if( closed.listen(QHostAddress::LocalHost,0) )
+		{
+			settings.ports.push_back( closed.serverPort() );
+			closed.close();
+		}
+	}
+
+	if( !ok )
+	{
+		printf("stand-in console unable to listen on loopback\n");
+		for(size_t i=0; i<consoles.size(); i++)
+			delete consoles[i];
+		return 1;
+	}
+
+	// a /22 of loopback addresses; only 127.0.0.1 has anything listening
+	quint32 network = (QHostAddress(QHostAddress::LocalHost).toIPv4Address() & 0xfffffc00u);
+	for(quint32 host=network+1; host<network+0x3ff; host++)
+		settings.hosts.push_back(host);
+
+	printf("Probing %u ports on %u loopback addresses, %u listening, %u in flight, %u ms timeout\n",
+		static_cast<unsigned int>(settings.ports.size()),
+		static_cast<unsigned int>(settings.hosts.size()),
+		listeners,
+		settings.maxInFlight,
+		settings.timeoutMS);
+	fflush(stdout);
+
+	CONSOLES found;
+	sStats stats;
+	RunBenchmarkPass(settings, found, stats);
+
+	for(size_t i=0; i<consoles.size(); i++)
+		delete consoles[i];
+
+	std::sort(expected.begin(), expected.end());
+	bool match = (found.size() == expected.size());
+	for(size_t i=0; match && i<found.size(); i++)
+		match = (found[i].ip==expected[i].ip && found[i].port==expected[i].port);
+	for(size_t i=0; i<found.size(); i++)
+		printf("  %s in %u ms\n", GetConsoleName(found[i]).toUtf8().constData(), found[i].connectMS);
+	if( !match )
+		printf("FAIL: expected exactly the stand-in listeners\n");
+
+	// loopback refuses closed ports at once, so the above never waits out a
+	// timeout; the RFC 5737 documentation blocks are never routed, so probes
+	// there are dropped on the way, like hosts on a LAN that aren't up
+	sSettings unreachable;
+	unreachable.localSubnets = false;
+	const quint32 testNets[] = {0xc0000200u, 0xc6336400u, 0xcb007100u};	// 192.0.2.0, 198.51.100.0, 203.0.113.0
+	for(size_t i=0; i<sizeof(testNets)/sizeof(testNets[0]); i++)
+	{
+		for(quint32 host=testNets[i]+1; host<testNets[i]+0xff; host++)
+			unreachable.hosts.push_back(host);
+	}
+
+	printf("Probing port %u on %u unreachable TEST-NET addresses, %u in flight, %u ms timeout\n",
+		static_cast<unsigned int>(unreachable.ports.front()),
+		static_cast<unsigned int>(unreachable.hosts.size()),
+		unreachable.maxInFlight,
+		unreachable.timeoutMS);
+	fflush(stdout);
+
+	CONSOLES unreachableFound;
+	sStats unreachableStats;
+	RunBenchmarkPass(unreachable, unreachableFound, unreachableStats);
+
+	bool timeoutsOk = unreachableFound.empty();
+	if( !timeoutsOk )
+		printf("FAIL: found something on a TEST-NET address\n");
+	if(unreachableStats.timedOut == 0)
+	{
+		// e.g. no default route, so every connect fails on the spot
+		printf("  nothing timed out, so the timeout path wasn't exercised on this host\n");
+	}
+	else
+	{
+		// every probe is in flight at once up to maxInFlight, so each batch costs one timeout
+		unsigned int inFlight = qBound(1u, unreachable.maxInFlight, static_cast<unsigned int>(DISCOVERY_MAX_IN_FLIGHT));
+		unsigned int batches = ((unreachableStats.probes + inFlight - 1) / inFlight);
+		qint64 limitMS = static_cast<qint64>(batches+1) * unreachable.timeoutMS;
+		printf("  %u timeout batches, expected within %lld ms\n", batches, static_cast<long long>(limitMS));
+		if(unreachableStats.elapsedMS > limitMS)
+		{
+			printf("FAIL: timed out probes were waited out one after another\n");
+			timeoutsOk = false;
+		}
+	}
+
+	bool pass = (match && timeoutsOk);
+	if( pass )
+		printf("PASS\n");
+	return (pass ? 0 : 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,110 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef CONSOLE_DISCOVERY_H
+#define CONSOLE_DISCOVERY_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Finds consoles by probing the OSC TCP port across the local subnets.
+//
+// Every IPv4 address on every running interface contributes its subnet;
+// subnets wider than minPrefixLength are narrowed to the block of that size
+// around the local address, so a /16 office network doesn't mean 65k probes.
+// One thread keeps up to maxInFlight non-blocking connects outstanding and
+// waits on all of them at once with poll(), or select() on Windows, so a
+// /22 takes a handful of timeouts rather than a thousand of them. A
+// completed connect is a find; the socket is closed straight away without
+// sending anything.
+class ConsoleDiscovery
+	: public QThread
+{
+public:
+	struct sSettings
+	{
+		sSettings();
+		std::vector<unsigned short>	ports;			// probed on every host
+		unsigned int				timeoutMS;		// per connect
+		unsigned int				maxInFlight;
+		unsigned int				minPrefixLength;
+		bool						localSubnets;
+		std::vector<quint32>		hosts;			// probed as well, IPv4 in host order
+	};
+
+	struct sConsole
+	{
+		quint32			ip;			// host order
+		unsigned short	port;
+		unsigned int	connectMS;
+
+		bool operator<(const sConsole &other) const {return ((ip==other.ip) ? (port<other.port) : (ip<other.ip));}
+	};
+
+	typedef std::vector<sConsole> CONSOLES;
+
+	struct sStats
+	{
+		sStats();
+		unsigned int	probes;
+		unsigned int	refused;
+		unsigned int	timedOut;
+		unsigned int	errors;		// no socket, or it couldn't be made non-blocking
+		qint64			elapsedMS;
+	};
+
+	ConsoleDiscovery();
+	virtual ~ConsoleDiscovery();
+
+	virtual void Start(const sSettings &settings);
+	virtual void Stop();
+
+	// any thread; sorted by address once finished
+	virtual void GetConsoles(CONSOLES &consoles) const;
+	virtual void GetStats(sStats &stats) const;
+
+	static void GetLocalHosts(unsigned int minPrefixLength, std::vector<quint32> &hosts);
+	static QString GetConsoleName(const sConsole &console);
+
+	// headless: probe stand-in listeners on loopback among closed ports and addresses,
+	// then the TEST-NET blocks, which nothing answers for, so every probe times out
+	static int Benchmark(unsigned int listeners);
+
+protected:
+	sSettings		m_Settings;
+	volatile bool	m_Run;
+	mutable QMutex	m_Mutex;
+	CONSOLES		m_Consoles;
+	sStats			m_Stats;
+
+	virtual void run();
+	virtual void AddConsole(quint32 ip, unsigned short port, qint64 connectNS);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
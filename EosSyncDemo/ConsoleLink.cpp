@@ -0,0 +1,463 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ConsoleLink.h"
+#include "EosSyncLib.h"
+#include <time.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleLink::ConsoleLink(LatencyProbe &probe, LogQueue &logQueue)
+	: m_Probe(probe)
+	, m_LogQueue(logQueue)
+	, m_Port(0)
+	, m_UdpPort(0)
+	, m_Connected(false)
+	, m_Worker(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleLink::~ConsoleLink()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLink::Start(const QString &ip, unsigned short port, const QString &udpIp, unsigned short udpPort)
+{
+	Stop();
+
+	m_Ip = ip;
+	m_Port = port;
+	m_UdpIp = udpIp;
+	m_UdpPort = udpPort;
+	start();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLink::Stop()
+{
+	// quit() is lost if it lands before exec() has started, so keep asking
+	while( isRunning() )
+	{
+		quit();
+		wait(50);
+	}
+
+	m_Mutex.lock();
+	m_Connected = false;
+	m_TcpQ.clear();
+	m_UdpQ.clear();
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ConsoleLink::SendTcp(const QByteArray &data, size_t count/*=1*/, bool bundle/*=false*/)
+{
+	// checked under the lock, so nothing is queued once the link thread has
+	// seen the connection go
+	m_Mutex.lock();
+	bool connected = m_Connected;
+	if( connected )
+		Queue(m_TcpQ, data, count, bundle);
+	m_Mutex.unlock();
+
+	return connected;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLink::SendUdp(const QByteArray &data, size_t count/*=1*/, bool bundle/*=false*/)
+{
+	m_Mutex.lock();
+	Queue(m_UdpQ, data, count, bundle);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLink::Queue(PACKET_Q &q, const QByteArray &data, size_t count, bool bundle)
+{
+	// call with m_Mutex held; the link thread takes both queues whole, so
+	// it only needs waking for the first packet after that
+	bool wake = (m_TcpQ.empty() && m_UdpQ.empty());
+
+	q.push_back( sPacket() );
+	sPacket &packet = q.back();
+	packet.data = data;
+	packet.count = count;
+	packet.bundle = bundle;
+	packet.queued.start();
+
+	if(wake && m_Worker)
+		QMetaObject::invokeMethod(m_Worker, "onSend", Qt::QueuedConnection);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLink::SetConnected(bool connected)
+{
+	m_Mutex.lock();
+	m_Connected = connected;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLink::TakeQueued(PACKET_Q &tcpQ, PACKET_Q &udpQ)
+{
+	m_Mutex.lock();
+	tcpQ.swap(m_TcpQ);
+	udpQ.swap(m_UdpQ);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLink::run()
+{
+	ConsoleLinkWorker worker(*this, m_Probe, m_LogQueue, m_Ip, m_Port, m_UdpIp, m_UdpPort);
+	worker.Open();
+
+	m_Mutex.lock();
+	m_Worker = &worker;
+	m_Mutex.unlock();
+
+	// anything queued before there was a worker to wake
+	worker.onSend();
+
+	exec();
+
+	m_Mutex.lock();
+	m_Worker = 0;
+	m_Connected = false;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleLinkWorker::ConsoleLinkWorker(ConsoleLink &link, LatencyProbe &probe, LogQueue &logQueue, const QString &ip, unsigned short port, const QString &udpIp, unsigned short udpPort)
+	: m_Link(link)
+	, m_Probe(probe)
+	, m_LogQueue(logQueue)
+	, m_Ip(ip)
+	, m_Port(port)
+	, m_UdpAddr(udpIp)
+	, m_UdpPort(udpPort)
+	, m_Tcp(0)
+	, m_Udp(0)
+	, m_RetryTimer(0)
+	, m_ProbeTimer(0)
+	, m_LoggedFailure(false)
+	, m_UdpErrors(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleLinkWorker::~ConsoleLinkWorker()
+{
+	CloseTcp();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::Open()
+{
+	m_RetryTimer = new QTimer(this);
+	m_RetryTimer->setSingleShot(true);
+	m_RetryTimer->setInterval(ConsoleLink::RETRY_MS);
+	connect(m_RetryTimer, SIGNAL(timeout()), this, SLOT(onConnect()));
+
+	m_ProbeTimer = new QTimer(this);
+	connect(m_ProbeTimer, SIGNAL(timeout()), this, SLOT(onProbe()));
+	m_ProbeTimer->start(ConsoleLink::PROBE_CHECK_MS);
+
+	if(m_UdpPort != 0)
+		m_Udp = new QUdpSocket(this);
+
+	onConnect();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::Log(const QString &text)
+{
+	EosLog::sLogMsg msg;
+	msg.type = EosLog::LOG_MSG_TYPE_INFO;
+	msg.timestamp = time(0);
+	msg.text = text.toUtf8().constData();
+	m_LogQueue.Push(msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::onConnect()
+{
+	CloseTcp();
+
+	m_Stream.Clear();
+	m_Tcp = new QTcpSocket(this);
+	m_Tcp->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+	connect(m_Tcp, SIGNAL(connected()), this, SLOT(onConnected()));
+	connect(m_Tcp, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+	connect(m_Tcp, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+	connect(m_Tcp, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(onDisconnected()));
+	m_Tcp->connectToHost(m_Ip, m_Port);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::onConnected()
+{
+	Log( QString("Console link %1:%2 connected").arg(m_Ip).arg(m_Port) );
+	m_LoggedFailure = false;
+	m_Link.SetConnected(true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::onDisconnected()
+{
+	// error() and disconnected() can both arrive for the one socket
+	if( !m_Tcp )
+		return;
+
+	if( m_Link.IsConnected() )
+	{
+		Log( QString("Console link %1:%2 closed").arg(m_Ip).arg(m_Port) );
+		m_Link.SetConnected(false);
+	}
+	else if( !m_LoggedFailure )
+	{
+		// once, the rest would only be noise
+		Log( QString("Console link %1:%2 unavailable, commands go over EosSyncLib's connection and there are no round trip times: %3").arg(m_Ip).arg(m_Port).arg(m_Tcp->errorString()) );
+		m_LoggedFailure = true;
+	}
+
+	CloseTcp();
+
+	// whatever was queued before the link was marked down is reported lost
+	onSend();
+
+	m_RetryTimer->start();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::CloseTcp()
+{
+	if( m_Tcp )
+	{
+		m_Tcp->disconnect(this);
+		m_Tcp->abort();
+		m_Tcp->deleteLater();
+		m_Tcp = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::onReadyRead()
+{
+	if( !m_Tcp )
+		return;
+
+	QByteArray data( m_Tcp->readAll() );
+	m_Stream.Append(data.constData(), data.size());
+	while( m_Stream.Next(m_Packet) )
+	{
+		// replies to operator commands are EosSyncLib's to track, so only
+		// the probes are read here
+		const char *address = 0;
+		int addressLen = 0;
+		if(OscPacket::GetAddress(m_Packet.constData(),m_Packet.size(),address,addressLen) && LatencyProbe::IsReplyAddress(address,addressLen))
+			m_Probe.OnReply(m_Packet.constData(), m_Packet.size());
+	}
+
+	if( m_Stream.IsCorrupt() )
+		onDisconnected();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::onProbe()
+{
+	if(!m_Tcp || m_Tcp->state()!=QAbstractSocket::ConnectedState || !m_Probe.IsDue(m_ProbeStr))
+		return;
+
+	OSCPacketWriter *writer = OSCPacketWriter::CreatePacketWriterForString( m_ProbeStr.c_str() );
+	if( writer )
+	{
+		size_t size = 0;
+		char *data = writer->Create(size);
+		if( data )
+		{
+			m_Out.clear();
+			OscPacket::AppendFrame(data, static_cast<int>(size), m_Out);
+			m_Probe.OnSent();
+			m_Tcp->write(m_Out);
+			m_Tcp->flush();
+			delete[] data;
+		}
+		delete writer;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::onSend()
+{
+	m_Link.TakeQueued(m_TcpQ, m_UdpQ);
+	WriteTcp();
+	WriteUdp();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::WriteTcp()
+{
+	if( m_TcpQ.empty() )
+		return;
+
+	size_t commands = 0;
+	qint64 maxWaitNS = 0;
+	m_Out.clear();
+	for(ConsoleLink::PACKET_Q::const_iterator i=m_TcpQ.begin(); i!=m_TcpQ.end(); i++)
+	{
+		OscPacket::AppendFrame(i->data.constData(), i->data.size(), m_Out);
+		commands += i->count;
+		maxWaitNS = qMax(maxWaitNS, i->queued.nsecsElapsed());
+	}
+	m_TcpQ.clear();
+
+	if(!m_Tcp || m_Tcp->state()!=QAbstractSocket::ConnectedState)
+	{
+		Log( QString("Console link %1:%2 closed with %3 commands unsent").arg(m_Ip).arg(m_Port).arg(commands) );
+		return;
+	}
+
+	// everything waiting goes out in one write; the wait is from the send
+	// call to here, which is what operator commands saw of the app
+	QElapsedTimer write;
+	write.start();
+	m_Tcp->write(m_Out);
+	m_Tcp->flush();
+	qint64 ns = write.nsecsElapsed();
+
+	// a block from SendOscBlock(), or commands that queued up together;
+	// single commands aren't logged
+	if(commands > 1)
+	{
+		Log( QString("Sent %1 commands on the console link, %2 bytes written in %3 us, longest queued %4 us")
+			.arg(commands)
+			.arg(m_Out.size())
+			.arg(ns/1000.0, 0, 'f', 1)
+			.arg(maxWaitNS/1000.0, 0, 'f', 1) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleLinkWorker::WriteUdp()
+{
+	if( m_UdpQ.empty() )
+		return;
+
+	if( !m_Udp )
+	{
+		m_UdpQ.clear();
+		return;
+	}
+
+	// each write timed, though only bundles are logged, not every keypress
+	QElapsedTimer elapsed;
+	elapsed.start();
+	EosLog::LOG_Q logQ;
+	size_t bundles = 0;
+	size_t commands = 0;
+	qint64 bytes = 0;
+	qint64 maxNS = 0;
+	qint64 maxWaitNS = 0;
+	for(size_t i=0; i<m_UdpQ.size(); i++)
+	{
+		const ConsoleLink::sPacket &datagram = m_UdpQ[i];
+		if( datagram.bundle )
+			bundles++;
+
+		maxWaitNS = qMax(maxWaitNS, datagram.queued.nsecsElapsed());
+
+		QElapsedTimer write;
+		write.start();
+		bool ok = (!datagram.data.isEmpty() && m_Udp->writeDatagram(datagram.data,m_UdpAddr,m_UdpPort)>=0);
+		qint64 ns = write.nsecsElapsed();
+		if( !ok )
+		{
+			// once per connection, the rest would only be noise
+			if(m_UdpErrors++ == 0)
+				Log( QString("UDP command send to %1:%2 failed: %3").arg(m_UdpAddr.toString()).arg(m_UdpPort).arg(m_Udp->errorString()) );
+			continue;
+		}
+
+		commands += datagram.count;
+		bytes += datagram.data.size();
+		maxNS = qMax(maxNS, ns);
+
+		if( datagram.bundle )
+		{
+			EosLog::sLogMsg msg;
+			msg.type = EosLog::LOG_MSG_TYPE_DEBUG;
+			msg.timestamp = time(0);
+			msg.text = QString("UDP datagram %1/%2: bundle of %3 commands, %4 bytes, written in %5 us")
+				.arg(i+1)
+				.arg(m_UdpQ.size())
+				.arg(datagram.count)
+				.arg(datagram.data.size())
+				.arg(ns/1000.0, 0, 'f', 1).toUtf8().constData();
+			logQ.push_back(msg);
+		}
+	}
+
+	if(bundles != 0)
+	{
+		EosLog::sLogMsg msg;
+		msg.type = EosLog::LOG_MSG_TYPE_INFO;
+		msg.timestamp = time(0);
+		msg.text = QString("Sent %1 commands in %2 UDP datagrams (%3 bundles), %4 bytes in %5 ms, slowest write %6 us, longest queued %7 us")
+			.arg(commands)
+			.arg(m_UdpQ.size())
+			.arg(bundles)
+			.arg(bytes)
+			.arg(elapsed.nsecsElapsed()/1000000.0, 0, 'f', 2)
+			.arg(maxNS/1000.0, 0, 'f', 1)
+			.arg(maxWaitNS/1000.0, 0, 'f', 1).toUtf8().constData();
+		logQ.push_back(msg);
+		m_LogQueue.Push(logQ);
+	}
+
+	m_UdpQ.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,170 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef CONSOLE_LINK_H
+#define CONSOLE_LINK_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#ifndef LOG_QUEUE_H
+#include "LogQueue.h"
+#endif
+
+#ifndef LATENCY_PROBE_H
+#include "LatencyProbe.h"
+#endif
+
+#ifndef OSC_PACKET_H
+#include "OscPacket.h"
+#endif
+
+#include <deque>
+
+class ConsoleLinkWorker;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The app's own way to the console, alongside EosSyncLib's connection and
+// never behind its lock, run by its own thread:
+//
+// - A TCP connection straight to the console, even when EosSyncLib's runs
+//   through the OSC relay. Operator commands go out on it, so they never
+//   wait for EosSyncLib::Tick() or a UI lock hold, and neither for the
+//   requests of a large initial sync that Tick() makes. EosSyncLib reads
+//   its connection itself and hands back nothing it doesn't handle, so
+//   round trip probes go out and come back on this one too. Reconnects
+//   every RETRY_MS while down.
+// - The console's OSC UDP receive port, when one is set, for operator
+//   commands as datagrams.
+//
+// Sends from any thread only queue under a short lock and wake the link
+// thread, which writes them as soon as its event loop gets to them. A TCP
+// send while the link is down is refused, so the caller can fall back to
+// EosSyncLib's connection. There is no ordering between the two TCP
+// connections.
+class ConsoleLink
+	: public QThread
+{
+public:
+	enum EnumConstants
+	{
+		PROBE_CHECK_MS	= 10,
+		RETRY_MS		= 2000
+	};
+
+	struct sPacket
+	{
+		QByteArray		data;		// unframed
+		size_t			count;		// messages
+		bool			bundle;		// from SendOscBlock(), otherwise one message
+		QElapsedTimer	queued;
+	};
+
+	typedef std::deque<sPacket> PACKET_Q;
+
+	ConsoleLink(LatencyProbe &probe, LogQueue &logQueue);
+	virtual ~ConsoleLink();
+
+	// udpPort 0 for no UDP
+	virtual void Start(const QString &ip, unsigned short port, const QString &udpIp, unsigned short udpPort);
+	virtual void Stop();
+
+	// any thread
+	virtual bool SendTcp(const QByteArray &data, size_t count=1, bool bundle=false);
+	virtual void SendUdp(const QByteArray &data, size_t count=1, bool bundle=false);
+	virtual bool IsConnected() const {return m_Connected;}
+
+	// link thread
+	virtual void SetConnected(bool connected);
+	virtual void TakeQueued(PACKET_Q &tcpQ, PACKET_Q &udpQ);
+
+protected:
+	LatencyProbe		&m_Probe;
+	LogQueue			&m_LogQueue;
+	QString				m_Ip;
+	unsigned short		m_Port;
+	QString				m_UdpIp;
+	unsigned short		m_UdpPort;
+	volatile bool		m_Connected;
+	QMutex				m_Mutex;
+	ConsoleLinkWorker	*m_Worker;		// while the event loop runs
+	PACKET_Q			m_TcpQ;
+	PACKET_Q			m_UdpQ;
+
+	virtual void run();
+	virtual void Queue(PACKET_Q &q, const QByteArray &data, size_t count, bool bundle);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ConsoleLinkWorker
+	: public QObject
+{
+	Q_OBJECT
+
+public:
+	ConsoleLinkWorker(ConsoleLink &link, LatencyProbe &probe, LogQueue &logQueue, const QString &ip, unsigned short port, const QString &udpIp, unsigned short udpPort);
+	virtual ~ConsoleLinkWorker();
+
+	virtual void Open();
+
+public slots:
+	void onSend();
+
+private slots:
+	void onConnect();
+	void onConnected();
+	void onDisconnected();
+	void onReadyRead();
+	void onProbe();
+
+private:
+	ConsoleLink				&m_Link;
+	LatencyProbe			&m_Probe;
+	LogQueue				&m_LogQueue;
+	QString					m_Ip;
+	unsigned short			m_Port;
+	QHostAddress			m_UdpAddr;
+	unsigned short			m_UdpPort;
+	QTcpSocket				*m_Tcp;
+	QUdpSocket				*m_Udp;
+	QTimer					*m_RetryTimer;
+	QTimer					*m_ProbeTimer;
+	OscPacket::Stream		m_Stream;
+	QByteArray				m_Packet;
+	QByteArray				m_Out;
+	std::string				m_ProbeStr;
+	ConsoleLink::PACKET_Q	m_TcpQ;
+	ConsoleLink::PACKET_Q	m_UdpQ;
+	bool					m_LoggedFailure;
+	unsigned int			m_UdpErrors;
+
+	virtual void CloseTcp();
+	virtual void WriteTcp();
+	virtual void WriteUdp();
+	virtual void Log(const QString &text);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
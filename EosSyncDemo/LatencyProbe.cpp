@@ -0,0 +1,245 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "LatencyProbe.h"
+#include "OscPacket.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define PING_ADDRESS		"/eos/ping"
+#define REPLY_ADDRESS		"/eos/out/ping"
+#define REPLY_ADDRESS_LEN	13
+#define PROBE_TAG			"EosSyncDemoProbe"
+#define PROBE_TAG_LEN		16
+#define NS_PER_MS			Q_INT64_C(1000000)
+
+////////////////////////////////////////////////////////////////////////////////
+
+LatencyProbe::sStats::sStats()
+	: count(0)
+	, lost(0)
+	, p50NS(-1)
+	, p99NS(-1)
+	, maxNS(-1)
+	, lastNS(-1)
+	, meanNS(-1)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LatencyProbe::LatencyProbe()
+	: m_IntervalMS(0)
+	, m_Seq(0)
+{
+	m_Clock.start();
+	Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyProbe::SetInterval(unsigned int ms)
+{
+	m_Mutex.lock();
+	m_IntervalMS = ms;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyProbe::Clear()
+{
+	m_Mutex.lock();
+	m_NextNS = 0;
+	m_PendingSeq = 0;
+	m_PendingNS = 0;
+	memset(m_Buckets, 0, sizeof(m_Buckets));
+	m_Count = 0;
+	m_Lost = 0;
+	m_MaxNS = -1;
+	m_LastNS = -1;
+	m_TotalNS = 0;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LatencyProbe::IsDue(std::string &str)
+{
+	qint64 now = m_Clock.nsecsElapsed();
+
+	m_Mutex.lock();
+
+	bool due = false;
+	if(m_IntervalMS != 0)
+	{
+		// one probe in flight at a time, so a stalled console isn't piled up on
+		if(m_PendingSeq!=0 && now-m_PendingNS>TIMEOUT_MS*NS_PER_MS)
+		{
+			m_Lost++;
+			m_PendingSeq = 0;
+		}
+
+		if(m_PendingSeq==0 && now>=m_NextNS)
+		{
+			if(++m_Seq == 0)
+				m_Seq = 1;
+			m_PendingSeq = m_Seq;
+			m_PendingNS = now;
+			m_NextNS = (now + m_IntervalMS*NS_PER_MS);
+
+			char buf[64];
+			sprintf(buf, "%s=%s%u", PING_ADDRESS, PROBE_TAG, m_Seq);
+			str = buf;
+			due = true;
+		}
+	}
+
+	m_Mutex.unlock();
+
+	return due;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyProbe::OnSent()
+{
+	qint64 now = m_Clock.nsecsElapsed();
+
+	m_Mutex.lock();
+	if(m_PendingSeq != 0)
+		m_PendingNS = now;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LatencyProbe::IsReplyAddress(const char *address, int addressLen)
+{
+	return (addressLen==REPLY_ADDRESS_LEN && strncmp(address,REPLY_ADDRESS,REPLY_ADDRESS_LEN)==0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyProbe::OnReply(const char *packet, int size)
+{
+	qint64 now = m_Clock.nsecsElapsed();
+
+	// the console echoes the probe's argument, anything else pinging is ignored
+	if(!OscPacket::GetArgsText(packet,size,m_Reply) || m_Reply.compare(0,PROBE_TAG_LEN,PROBE_TAG)!=0)
+		return;
+
+	unsigned int seq = static_cast<unsigned int>( strtoul(m_Reply.c_str()+PROBE_TAG_LEN,0,10) );
+
+	m_Mutex.lock();
+	if(seq!=0 && seq==m_PendingSeq)
+	{
+		qint64 ns = (now - m_PendingNS);
+		m_Buckets[GetBucket(ns)]++;
+		m_Count++;
+		m_LastNS = ns;
+		m_TotalNS += ns;
+		if(ns > m_MaxNS)
+			m_MaxNS = ns;
+		m_PendingSeq = 0;
+	}
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyProbe::GetStats(sStats &stats) const
+{
+	m_Mutex.lock();
+	stats.count = m_Count;
+	stats.lost = m_Lost;
+	stats.p50NS = GetPercentile(0.5);
+	stats.p99NS = GetPercentile(0.99);
+	stats.maxNS = m_MaxNS;
+	stats.lastNS = m_LastNS;
+	stats.meanNS = ((m_Count == 0) ? -1 : (m_TotalNS / m_Count));
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 LatencyProbe::GetPercentile(double p) const
+{
+	if(m_Count == 0)
+		return -1;
+
+	// upper edge of the bucket holding the p'th sample, never beyond the true max
+	unsigned int rank = static_cast<unsigned int>( ceil(p*m_Count) );
+	if(rank == 0)
+		rank = 1;
+	unsigned int total = 0;
+	for(int i=0; i<BUCKET_COUNT; i++)
+	{
+		total += m_Buckets[i];
+		if(total >= rank)
+			return qMin(GetBucketLimit(i), m_MaxNS);
+	}
+
+	return m_MaxNS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int LatencyProbe::GetBucket(qint64 ns)
+{
+	double us = (ns / 1000.0);
+	if(us <= 1.0)
+		return 0;
+
+	int bucket = static_cast<int>( 4.0*log(us)/log(2.0) );
+	return ((bucket < BUCKET_COUNT) ? bucket : (BUCKET_COUNT-1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 LatencyProbe::GetBucketLimit(int bucket)
+{
+	return static_cast<qint64>( pow(2.0,(bucket+1)/4.0) * 1000.0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyProbe::FormatStats(const sStats &stats, QString &str)
+{
+	if(stats.count == 0)
+	{
+		str = ((stats.lost == 0) ? "RTT -" : QString("RTT -, %1 lost").arg(stats.lost));
+		return;
+	}
+
+	str = QString("RTT %1/%2/%3 ms")
+		.arg(stats.p50NS/1000000.0, 0, 'f', 1)
+		.arg(stats.p99NS/1000000.0, 0, 'f', 1)
+		.arg(stats.maxNS/1000000.0, 0, 'f', 1);
+	if(stats.lost != 0)
+		str.append( QString(", %1 lost").arg(stats.lost) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
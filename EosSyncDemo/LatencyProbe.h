@@ -0,0 +1,107 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Console round trip times from /eos/ping probes.
+//
+// Whoever owns the connection sends a probe when one is due, and the console
+// echoes the probe's argument back as /eos/out/ping, to be handed to
+// OnReply() by whatever reads that connection: ConsoleLink for the direct
+// console round trip, the OSC relay tap for the same trip through the relay.
+// Times go into a histogram of quarter octave buckets, so p50/p99 cost a
+// fixed few hundred bytes however long the connection runs. A probe with no
+// reply after TIMEOUT_MS is counted as lost.
+class LatencyProbe
+{
+public:
+	enum EnumConstants
+	{
+		TIMEOUT_MS		= 5000,
+		BUCKET_COUNT	= 112		// 1 us to ~4 minutes
+	};
+
+	struct sStats
+	{
+		sStats();
+		unsigned int	count;
+		unsigned int	lost;
+		qint64			p50NS;		// -1 if no samples
+		qint64			p99NS;
+		qint64			maxNS;
+		qint64			lastNS;
+		qint64			meanNS;
+	};
+
+	LatencyProbe();
+	virtual ~LatencyProbe() {}
+
+	// UI thread, 0 to disable
+	virtual void SetInterval(unsigned int ms);
+	virtual void Clear();
+	virtual void GetStats(sStats &stats) const;
+
+	// sending thread; returns the OSC string to send if a probe is due, and
+	// OnSent() is called as it goes out
+	virtual bool IsDue(std::string &str);
+	virtual void OnSent();
+
+	// receiving thread, for /eos/out/ping packets
+	virtual void OnReply(const char *packet, int size);
+
+	static bool IsReplyAddress(const char *address, int addressLen);
+	static void FormatStats(const sStats &stats, QString &str);
+
+protected:
+	QElapsedTimer	m_Clock;
+	mutable QMutex	m_Mutex;
+	unsigned int	m_IntervalMS;
+	unsigned int	m_Seq;
+	qint64			m_NextNS;
+	unsigned int	m_PendingSeq;	// 0 if none
+	qint64			m_PendingNS;
+	std::string		m_Reply;		// relay thread scratch
+	unsigned int	m_Buckets[BUCKET_COUNT];
+	unsigned int	m_Count;
+	unsigned int	m_Lost;
+	qint64			m_MaxNS;
+	qint64			m_LastNS;
+	qint64			m_TotalNS;
+
+	virtual qint64 GetPercentile(double p) const;
+
+	static int GetBucket(qint64 ns);
+	static qint64 GetBucketLimit(int bucket);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
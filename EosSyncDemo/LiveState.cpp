@@ -0,0 +1,284 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "LiveState.h"
+#include "ChangeStats.h"
+#include "OscPacket.h"
+#include <string.h>
+#include <iterator>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define FRAME_MS		16
+#define RATE_REPORT_MS	1000
+
+struct sLivePrefix
+{
+	const char	*str;
+	int			len;
+};
+
+static const sLivePrefix sLivePrefixes[] = {
+	{"/eos/out/active/",	16},
+	{"/eos/out/pending/",	17},
+	{"/eos/out/fader/",		15},
+	{"/eos/out/wheel/",		15}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+LiveState::LiveState()
+	: m_Enabled(0)
+	, m_Received(0)
+	, m_Dropped(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LiveState::SetEnabled(bool b)
+{
+	m_Enabled.fetchAndStoreOrdered(b ? 1 : 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LiveState::Clear()
+{
+	m_Mutex.lock();
+	m_Entries.clear();
+	m_Dirty.clear();
+	m_Received = 0;
+	m_Dropped = 0;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LiveState::IsLiveAddress(const char *address, int addressLen)
+{
+	for(size_t i=0; i<sizeof(sLivePrefixes)/sizeof(sLivePrefixes[0]); i++)
+	{
+		const sLivePrefix &prefix = sLivePrefixes[i];
+		if(addressLen>=prefix.len && strncmp(address,prefix.str,prefix.len)==0)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LiveState::OnMessage(const char *address, int addressLen, const char *packet, int size, qint64 ns)
+{
+	if(!IsEnabled() || !IsLiveAddress(address,addressLen))
+		return;
+
+	// decoded before taking the lock, the UI only ever waits on a copy
+	if( !OscPacket::GetArgsText(packet,size,m_Text) )
+		return;
+
+	m_Mutex.lock();
+
+	m_Received++;
+
+	ENTRIES::iterator i = m_Entries.find( QByteArray::fromRawData(address,addressLen) );
+	if(i == m_Entries.end())
+	{
+		if(m_Entries.size() >= MAX_ADDRESSES)
+		{
+			m_Dropped++;
+			m_Mutex.unlock();
+			return;
+		}
+
+		sEntry entry;
+		entry.updates = 0;
+		entry.dirty = false;
+		i = m_Entries.insert(QByteArray(address,addressLen), entry);
+	}
+
+	sEntry &entry = i.value();
+	entry.text.swap(m_Text);
+	entry.ns = ns;
+	entry.updates++;
+	if( !entry.dirty )
+	{
+		entry.dirty = true;
+		m_Dirty.push_back( i.key() );
+	}
+
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LiveState::TakeBatch(VALUES &batch, unsigned int &received, unsigned int &dropped)
+{
+	batch.clear();
+
+	m_Mutex.lock();
+
+	batch.reserve( m_Dirty.size() );
+	for(size_t i=0; i<m_Dirty.size(); i++)
+	{
+		ENTRIES::iterator j = m_Entries.find( m_Dirty[i] );
+		if(j == m_Entries.end())
+			continue;
+
+		sEntry &entry = j.value();
+		entry.dirty = false;
+
+		batch.push_back( sValue() );
+		sValue &value = batch.back();
+		value.address = j.key();
+		value.text = entry.text;
+		value.ns = entry.ns;
+		value.updates = entry.updates;
+	}
+	m_Dirty.clear();
+
+	received = m_Received;
+	m_Received = 0;
+	dropped = m_Dropped;
+
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LiveStatePanel::LiveStatePanel(LiveState &liveState, const ChangeStats &changeStats, QWidget *parent)
+	: QWidget(parent, Qt::Window)
+	, m_LiveState(liveState)
+	, m_ChangeStats(changeStats)
+	, m_RateReceived(0)
+	, m_RateDrawn(0)
+	, m_Dropped(0)
+{
+	setWindowTitle("Live");
+
+	QGridLayout *layout = new QGridLayout(this);
+
+	m_Summary = new QLabel(this);
+	QPalette summaryPal( m_Summary->palette() );
+	summaryPal.setColor(QPalette::WindowText, MUTED_COLOR);
+	m_Summary->setPalette(summaryPal);
+	layout->addWidget(m_Summary, 0, 0);
+
+	m_Table = new QTableWidget(0, 4, this);
+	QStringList labels;
+	labels << "Address" << "Value" << "Updates" << "Time";
+	m_Table->setHorizontalHeaderLabels(labels);
+	m_Table->verticalHeader()->hide();
+	m_Table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	m_Table->setSelectionMode(QAbstractItemView::NoSelection);
+	m_Table->horizontalHeader()->setStretchLastSection(true);
+	m_Table->setColumnWidth(0, 240);
+	m_Table->setColumnWidth(1, 200);
+	layout->addWidget(m_Table, 1, 0);
+
+	m_FrameTimer = new QTimer(this);
+	connect(m_FrameTimer, SIGNAL(timeout()), this, SLOT(onFrame()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LiveStatePanel::showEvent(QShowEvent *event)
+{
+	QWidget::showEvent(event);
+
+	m_LiveState.SetEnabled(true);
+	m_RateTimer.start();
+	m_RateReceived = m_RateDrawn = 0;
+	m_FrameTimer->start(FRAME_MS);
+	emit visibilityChanged(true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LiveStatePanel::hideEvent(QHideEvent *event)
+{
+	QWidget::hideEvent(event);
+
+	m_FrameTimer->stop();
+	m_LiveState.SetEnabled(false);
+	emit visibilityChanged(false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LiveStatePanel::sRow& LiveStatePanel::AddRow(const QByteArray &address)
+{
+	// rows stay sorted by address, so related values sit together
+	ROWS::iterator i = m_Rows.insert( ROWS::value_type(address,sRow()) ).first;
+	int row = static_cast<int>( std::distance(m_Rows.begin(),i) );
+	m_Table->insertRow(row);
+	m_Table->setItem(row, 0, new QTableWidgetItem(QString::fromUtf8(address.constData(),address.size())));
+
+	sRow &r = i->second;
+	r.value = new QTableWidgetItem;
+	m_Table->setItem(row, 1, r.value);
+	r.updates = new QTableWidgetItem;
+	m_Table->setItem(row, 2, r.updates);
+	r.time = new QTableWidgetItem;
+	m_Table->setItem(row, 3, r.time);
+	return r;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LiveStatePanel::onFrame()
+{
+	unsigned int received = 0;
+	m_LiveState.TakeBatch(m_Batch, received, m_Dropped);
+	m_RateReceived += received;
+	m_RateDrawn += static_cast<unsigned int>( m_Batch.size() );
+
+	if( !m_Batch.empty() )
+	{
+		m_Table->setUpdatesEnabled(false);
+		for(LiveState::VALUES::const_iterator i=m_Batch.begin(); i!=m_Batch.end(); i++)
+		{
+			const LiveState::sValue &value = *i;
+			ROWS::iterator j = m_Rows.find(value.address);
+			sRow &row = ((j == m_Rows.end()) ? AddRow(value.address) : j->second);
+			row.value->setText( QString::fromUtf8(value.text.c_str()) );
+			row.updates->setText( QString::number(value.updates) );
+			row.time->setText( m_ChangeStats.ToDateTime(value.ns).toString("h:mm:ss.zzz") );
+		}
+		m_Table->setUpdatesEnabled(true);
+	}
+
+	if( m_RateTimer.hasExpired(RATE_REPORT_MS) )
+	{
+		double seconds = (m_RateTimer.restart() / 1000.0);
+		QString summary( QString("%1 updates/s received, %2 values/s drawn, %3 addresses")
+			.arg(m_RateReceived/seconds, 0, 'f', 0)
+			.arg(m_RateDrawn/seconds, 0, 'f', 0)
+			.arg(m_Rows.size()) );
+		if(m_Dropped != 0)
+			summary.append( QString(", %1 updates for untracked addresses dropped").arg(m_Dropped) );
+		m_Summary->setText(summary);
+		m_RateReceived = m_RateDrawn = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,149 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef LIVE_STATE_H
+#define LIVE_STATE_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+class ChangeStats;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Latest value of each high rate console address: active and pending cue,
+// faders and wheels.
+//
+// The console sends these far faster than anyone can read them during a busy
+// playback, so the relay thread only overwrites the one value kept per
+// address and notes the address as dirty. Once a frame the UI takes the
+// dirty addresses as a single batch, so intermediate values are never queued
+// and the cost of a frame depends on how many addresses moved, not on how
+// many packets arrived. Tracking is off unless the live panel is open.
+class LiveState
+{
+public:
+	enum EnumConstants
+	{
+		MAX_ADDRESSES	= 4096
+	};
+
+	struct sValue
+	{
+		QByteArray		address;
+		std::string		text;
+		qint64			ns;			// ChangeStats clock
+		unsigned int	updates;	// total since tracking started
+	};
+
+	typedef std::vector<sValue> VALUES;
+
+	LiveState();
+	virtual ~LiveState() {}
+
+	// any thread
+	virtual void SetEnabled(bool b);
+	virtual bool IsEnabled() const {return (m_Enabled != 0);}
+	virtual void Clear();
+
+	static bool IsLiveAddress(const char *address, int addressLen);
+
+	// relay thread, address points into packet
+	virtual void OnMessage(const char *address, int addressLen, const char *packet, int size, qint64 ns);
+
+	// UI thread, the addresses that changed since the last call with their latest values
+	virtual void TakeBatch(VALUES &batch, unsigned int &received, unsigned int &dropped);
+
+protected:
+	struct sEntry
+	{
+		std::string		text;
+		qint64			ns;
+		unsigned int	updates;
+		bool			dirty;
+	};
+
+	typedef QHash<QByteArray,sEntry> ENTRIES;
+	typedef std::vector<QByteArray> DIRTY;
+
+	QAtomicInt		m_Enabled;
+	QMutex			m_Mutex;
+	ENTRIES			m_Entries;
+	DIRTY			m_Dirty;
+	unsigned int	m_Received;
+	unsigned int	m_Dropped;	// new addresses past MAX_ADDRESSES
+	std::string		m_Text;		// relay thread scratch
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class LiveStatePanel
+	: public QWidget
+{
+	Q_OBJECT
+
+public:
+	LiveStatePanel(LiveState &liveState, const ChangeStats &changeStats, QWidget *parent);
+
+	virtual QSize sizeHint() const {return QSize(640,480);}
+
+signals:
+	void visibilityChanged(bool visible);
+
+private slots:
+	void onFrame();
+
+protected:
+	struct sRow
+	{
+		QTableWidgetItem	*value;
+		QTableWidgetItem	*updates;
+		QTableWidgetItem	*time;
+	};
+
+	typedef std::map<QByteArray,sRow> ROWS;
+
+	LiveState			&m_LiveState;
+	const ChangeStats	&m_ChangeStats;
+	QTableWidget		*m_Table;
+	QLabel				*m_Summary;
+	QTimer				*m_FrameTimer;
+	ROWS				m_Rows;
+	LiveState::VALUES	m_Batch;
+	QElapsedTimer		m_RateTimer;
+	unsigned int		m_RateReceived;
+	unsigned int		m_RateDrawn;
+	unsigned int		m_Dropped;
+
+	virtual void showEvent(QShowEvent *event);
+	virtual void hideEvent(QHideEvent *event);
+	virtual sRow& AddRow(const QByteArray &address);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,193 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "LockBench.h"
+#include "MainWindow.h"
+#include "StandInConsole.h"
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define LOCK_BENCH_TICK_MS			60		// like the UI timer
+#define LOCK_BENCH_SYNC_TIMEOUT_MS	30000
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct sLockBenchResult
+{
+	sLockBenchResult() : ticks(0), maxWaitUS(0), totalWaitUS(0) {}
+	EosSyncLibThread::sLockStats	stats[EosSyncLibThread::LOCK_HOLDER_COUNT];
+	unsigned int					ticks;
+	qint64							maxWaitUS;		// UI waiting for the lock
+	qint64							totalWaitUS;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool RunLockBench(const LockBench::sSettings &settings, unsigned short port, bool sliced, sLockBenchResult &result)
+{
+	EosSyncLibThread syncThread;
+	syncThread.SetSendSliced(sliced);
+	syncThread.Start("127.0.0.1", port);
+
+	// the initial sync isn't measured
+	QElapsedTimer timer;
+	timer.start();
+	bool synced = false;
+	while(!synced && syncThread.isRunning() && !timer.hasExpired(LOCK_BENCH_SYNC_TIMEOUT_MS))
+	{
+		EosSyncLib *eosSyncLib = syncThread.LockEosSyncLib();
+		synced = (eosSyncLib->GetData().GetStatus().GetValue() == EosSyncStatus::SYNC_STATUS_COMPLETE);
+		eosSyncLib->ClearDirty();
+		syncThread.UnlockEosSyncLib();
+
+		EosLog::LOG_Q logQ;
+		syncThread.GetLogQueue().Pop(logQ, LogQueue::DEFAULT_CAPACITY);
+		QThread::msleep(LOCK_BENCH_TICK_MS);
+	}
+
+	if( !synced )
+	{
+		syncThread.Stop();
+		return false;
+	}
+
+	EosSyncLibThread::sLockStats ignored[EosSyncLibThread::LOCK_HOLDER_COUNT];
+	syncThread.LockEosSyncLib();
+	syncThread.GetLockStats(ignored, /*reset*/true);
+	syncThread.UnlockEosSyncLib();
+
+	timer.start();
+	while( !timer.hasExpired(settings.seconds*1000) )
+	{
+		for(unsigned int i=0; i<settings.refreshPerTick; i++)
+			syncThread.SendOscString("/eos/ping", EosSyncLibThread::SEND_PRIORITY_REFRESH);
+
+		QElapsedTimer wait;
+		wait.start();
+		EosSyncLib *eosSyncLib = syncThread.LockEosSyncLib();
+		qint64 waitUS = (wait.nsecsElapsed() / 1000);
+		eosSyncLib->ClearDirty();
+		syncThread.UnlockEosSyncLib();
+
+		result.ticks++;
+		result.totalWaitUS += waitUS;
+		if(waitUS > result.maxWaitUS)
+			result.maxWaitUS = waitUS;
+
+		EosLog::LOG_Q logQ;
+		syncThread.GetLogQueue().Pop(logQ, LogQueue::DEFAULT_CAPACITY);
+		QThread::msleep(LOCK_BENCH_TICK_MS);
+	}
+
+	syncThread.LockEosSyncLib();
+	syncThread.GetLockStats(result.stats, /*reset*/true);
+	syncThread.UnlockEosSyncLib();
+
+	syncThread.Stop();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void PrintLockBenchResult(const char *name, const sLockBenchResult &result)
+{
+	for(int i=0; i<EosSyncLibThread::LOCK_HOLDER_COUNT; i++)
+	{
+		const EosSyncLibThread::sLockStats &stats = result.stats[i];
+		double avgMS = ((stats.count==0) ? 0 : (stats.totalUS/static_cast<double>(stats.count))/1000.0);
+		printf("  %-9s %-5s %8u holds, max %8.3f ms, avg %6.3f ms\n",
+			name,
+			EosSyncLibThread::GetLockHolderName( static_cast<EosSyncLibThread::EnumLockHolder>(i) ),
+			stats.count,
+			stats.maxUS/1000.0,
+			avgMS);
+	}
+
+	double avgWaitMS = ((result.ticks==0) ? 0 : (result.totalWaitUS/static_cast<double>(result.ticks))/1000.0);
+	printf("  %-9s ui waited for the lock: max %.3f ms, avg %.3f ms over %u ticks\n", name, result.maxWaitUS/1000.0, avgWaitMS, result.ticks);
+	fflush(stdout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LockBench::sSettings::sSettings()
+	: seconds(20)
+	, targetsPerType(2000)
+	, burstMS(100)
+	, burstSize(64)
+	, refreshPerTick(400)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int LockBench::Run(const sSettings &settings)
+{
+	StandInConsole::sSettings consoleSettings;
+	consoleSettings.targetsPerType = settings.targetsPerType;
+	consoleSettings.burstMS = settings.burstMS;
+	consoleSettings.burstSize = settings.burstSize;
+	StandInConsole console(consoleSettings);
+	unsigned short port = 0;
+	if( !console.Listen(port) )
+	{
+		printf("stand-in console unable to listen on loopback\n");
+		return 1;
+	}
+
+	printf("Lock hold times over %u s per run, %u targets per type, %u changes every %u ms, %u refresh packets per %u ms tick\n",
+		settings.seconds, settings.targetsPerType, settings.burstSize, settings.burstMS, settings.refreshPerTick, LOCK_BENCH_TICK_MS);
+	fflush(stdout);
+
+	static const char *names[] = {"unsliced", "sliced"};
+	sLockBenchResult runResults[2];
+	int result = 0;
+	for(int i=0; i<2; i++)
+	{
+		if( RunLockBench(settings,port,/*sliced*/i==1,runResults[i]) )
+			PrintLockBenchResult(names[i], runResults[i]);
+		else
+		{
+			printf("  %-9s initial sync did not complete, the stand-in console may not match this EosSyncLib\n", names[i]);
+			result = 1;
+		}
+	}
+
+	if(result == 0)
+	{
+		// the budget only slices the app's send queue, so the tick hold is
+		// expected to stay put; it is the floor under the UI's worst wait
+		printf("Worst tick hold %.3f -> %.3f ms (EosSyncLib::Tick(), not budgeted), send hold %.3f -> %.3f ms, ui wait %.3f -> %.3f ms\n",
+			runResults[0].stats[EosSyncLibThread::LOCK_HOLDER_TICK].maxUS/1000.0,
+			runResults[1].stats[EosSyncLibThread::LOCK_HOLDER_TICK].maxUS/1000.0,
+			runResults[0].stats[EosSyncLibThread::LOCK_HOLDER_SEND].maxUS/1000.0,
+			runResults[1].stats[EosSyncLibThread::LOCK_HOLDER_SEND].maxUS/1000.0,
+			runResults[0].maxWaitUS/1000.0,
+			runResults[1].maxWaitUS/1000.0);
+		fflush(stdout);
+	}
+
+	console.Stop();
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
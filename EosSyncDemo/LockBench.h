@@ -0,0 +1,59 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef LOCK_BENCH_H
+#define LOCK_BENCH_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Headless measurement of how long the EosSyncLib lock is held.
+//
+// EosSyncLibThread syncs from a loopback stand-in console that keeps
+// changing the show, while the refresh queue is kept loaded and a UI stand-in
+// takes the lock every tick like MainWindow. The run is done twice, with the
+// send queue handed over in one lock hold and then time-sliced, and prints
+// the worst and average hold for each holder plus the longest the UI waited,
+// then the worst cases side by side. Slicing only shortens the send holds;
+// EosSyncLib::Tick() parses whatever has arrived in one hold either way.
+class LockBench
+{
+public:
+	struct sSettings
+	{
+		sSettings();
+		unsigned int	seconds;			// measured per run, after the initial sync
+		unsigned int	targetsPerType;
+		unsigned int	burstMS;
+		unsigned int	burstSize;
+		unsigned int	refreshPerTick;		// refresh packets queued per UI tick
+	};
+
+	static int Run(const sSettings &settings);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
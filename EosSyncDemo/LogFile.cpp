@@ -0,0 +1,667 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "LogFile.h"
+#include <string.h>
+#include <climits>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define LOG_FILE_POLL_MS		250
+#define LOG_FILE_INDEX_CHUNK	(16*1024*1024)	// bytes scanned between filter passes
+#define LOG_FILE_WINDOW			Q_INT64_C(64*1024*1024)	// mapped at once, whatever the file size
+#define LOG_FILE_FILTER_CHUNK	65536			// lines filtered per lock
+#define LOG_FILE_TAG_SEARCH		24				// bytes from the line start to look for the level tag
+#define LOG_FILE_FILTER_MS		200
+#define LOG_FILE_TICK_MS		250
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogFileIndex::sStatus::sStatus()
+	: lines(0)
+	, rows(0)
+	, bytes(0)
+	, filtering(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogFileIndex::LogFileIndex()
+	: m_Run(false)
+	, m_Size(0)
+	, m_Scanned(0)
+	, m_Filtered(false)
+	, m_FilterGeneration(0)
+	, m_FilteredLines(0)
+{
+	m_Lines.push_back(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogFileIndex::~LogFileIndex()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LogFileIndex::Start(const QString &path, QString &error)
+{
+	Stop();
+
+	m_File.setFileName(path);
+	m_RowFile.setFileName(path);
+	if(!m_File.open(QIODevice::ReadOnly) || !m_RowFile.open(QIODevice::ReadOnly))
+	{
+		error = (m_File.isOpen() ? m_RowFile.errorString() : m_File.errorString());
+		m_File.close();
+		return false;
+	}
+
+	m_Run = true;
+	start();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileIndex::Stop()
+{
+	m_Mutex.lock();
+	m_Run = false;
+	m_Wait.wakeAll();
+	m_Mutex.unlock();
+	wait();
+
+	Reset();
+	m_File.close();
+	m_RowFile.close();
+	m_Size = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileIndex::SetFilter(const sFilter &filter)
+{
+	QByteArray text = filter.text.toUtf8();
+	for(int i=0; i<text.size(); i++)
+	{
+		char c = text[i];
+		if(c>='A' && c<='Z')
+			text[i] = c - 'A' + 'a';
+	}
+
+	m_Mutex.lock();
+	m_Filter = filter;
+	m_FilterText = text;
+	m_Filtered = (filter.level!=LEVEL_DEBUG || !text.isEmpty());
+	m_FilterGeneration++;
+	ROWS().swap(m_Rows);
+	m_FilteredLines = 0;
+	m_Wait.wakeAll();
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileIndex::GetStatus(sStatus &status)
+{
+	m_Mutex.lock();
+	status.lines = (m_Lines.size() - 1);
+	status.rows = (m_Filtered ? m_Rows.size() : status.lines);
+	status.bytes = m_Lines.back();
+	status.filtering = (m_Filtered && m_FilteredLines<status.lines);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileIndex::GetRows(size_t &rows, unsigned int &generation)
+{
+	m_Mutex.lock();
+	rows = (m_Filtered ? m_Rows.size() : (m_Lines.size() - 1));
+	generation = m_FilterGeneration;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LogFileIndex::GetRow(size_t row, QString &text, EnumLevel &level)
+{
+	bool ok = false;
+
+	m_Mutex.lock();
+	size_t line = row;
+	if( m_Filtered )
+		line = ((row < m_Rows.size()) ? m_Rows[row] : m_Lines.size());
+	if(line+1 < m_Lines.size())
+	{
+		// read rather than mapped, so a row read as the file is truncated
+		// comes back short instead of faulting
+		qint64 start = m_Lines[line];
+		qint64 end = m_Lines[line+1];
+		QByteArray data;
+		if( m_RowFile.seek(start) )
+			data = m_RowFile.read(end - start);
+		int skip = ((start==0 && data.startsWith("\xEF\xBB\xBF")) ? 3 : 0);
+		int size = data.size();
+		while(size>skip && (data[size-1]=='\n' || data[size-1]=='\r'))
+			size--;
+		level = GetLevel(data.constData()+skip, static_cast<size_t>(size-skip));
+		text = QString::fromUtf8(data.constData()+skip, size-skip);
+		ok = true;
+	}
+	m_Mutex.unlock();
+
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* LogFileIndex::GetLevelTag(EnumLevel level)
+{
+	switch( level )
+	{
+		case LEVEL_DEBUG:	return "DBG";
+		case LEVEL_INFO:	return "INF";
+		case LEVEL_WARNING:	return "WRN";
+		case LEVEL_ERROR:	return "ERR";
+		default:			break;
+	}
+
+	return "INF";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* LogFileIndex::GetLevelName(EnumLevel level)
+{
+	switch( level )
+	{
+		case LEVEL_DEBUG:	return "Debug";
+		case LEVEL_INFO:	return "Info";
+		case LEVEL_WARNING:	return "Warning";
+		case LEVEL_ERROR:	return "Error";
+		default:			break;
+	}
+
+	return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QColor LogFileIndex::GetLevelColor(EnumLevel level)
+{
+	switch( level )
+	{
+		case LEVEL_DEBUG:	return MUTED_COLOR;
+		case LEVEL_WARNING:	return WARNING_COLOR;
+		case LEVEL_ERROR:	return ERROR_COLOR;
+		default:			break;
+	}
+
+	// the palette's text color
+	return QColor();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogFileIndex::EnumLevel LogFileIndex::GetLevel(const char *line, size_t size)
+{
+	// [ hh:mm:ss ] TAG text
+	size_t n = qMin(size, static_cast<size_t>(LOG_FILE_TAG_SEARCH));
+	for(size_t i=0; i+5<=n; i++)
+	{
+		if(line[i]==']' && line[i+1]==' ')
+		{
+			for(int level=0; level<LEVEL_COUNT; level++)
+			{
+				if(memcmp(line+i+2,GetLevelTag(static_cast<EnumLevel>(level)),3) == 0)
+					return static_cast<EnumLevel>(level);
+			}
+			break;
+		}
+	}
+
+	return LEVEL_INFO;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileIndex::run()
+{
+	while( m_Run )
+	{
+		FollowFile();
+		bool more = IndexLines();
+		if( FilterLines() )
+			more = true;
+
+		m_Mutex.lock();
+		if(m_Run && !more && !(m_Filtered && m_FilteredLines+1<m_Lines.size()))
+			m_Wait.wait(&m_Mutex, LOG_FILE_POLL_MS);
+		m_Mutex.unlock();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileIndex::FollowFile()
+{
+	// MainWindow truncates the log on every launch, so a shorter file is a new one
+	qint64 size = m_File.size();
+	if(size < m_Size)
+	{
+		Reset();
+
+		// the filter generation moves on, so the model resets too
+		m_Mutex.lock();
+		m_FilterGeneration++;
+		m_Mutex.unlock();
+	}
+	m_Size = size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileIndex::Reset()
+{
+	Unmap();
+	m_Scanned = 0;
+
+	m_Mutex.lock();
+	m_Lines.clear();
+	m_Lines.push_back(0);
+	ROWS().swap(m_Rows);
+	m_FilteredLines = 0;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* LogFileIndex::Map(qint64 start, qint64 end)
+{
+	if(!m_Window.data || start<m_Window.offset || end>m_Window.offset+m_Window.size)
+	{
+		// slide the window up to start, with at least the requested range in it
+		Unmap();
+		qint64 size = qMin(m_Size-start, qMax(end-start,LOG_FILE_WINDOW));
+		if(size <= 0)
+			return 0;
+
+		m_Window.data = m_File.map(start, size);
+		if( !m_Window.data )
+			return 0;
+
+		m_Window.offset = start;
+		m_Window.size = size;
+	}
+
+	return reinterpret_cast<const char*>(m_Window.data + (start - m_Window.offset));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileIndex::Unmap()
+{
+	if( m_Window.data )
+		m_File.unmap(m_Window.data);
+	m_Window = sWindow();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LogFileIndex::IndexLines()
+{
+	// only this thread maps or appends, so reading here needs no lock
+	qint64 end = qMin(m_Size, m_Scanned+LOG_FILE_INDEX_CHUNK);
+	if(end <= m_Scanned)
+		return false;
+
+	const char *first = Map(m_Scanned, end);
+	if( !first )
+		return false;
+
+	OFFSETS lines;
+	const char *p = first;
+	const char *last = (first + (end - m_Scanned));
+	while(p < last)
+	{
+		const char *eol = static_cast<const char*>( memchr(p,'\n',last-p) );
+		if( !eol )
+			break;
+
+		p = (eol + 1);
+		lines.push_back(m_Scanned + (p - first));
+	}
+
+	// a partial last line starts at m_Lines.back(), so only its newline is still to be found
+	m_Scanned = end;
+
+	if( !lines.empty() )
+	{
+		m_Mutex.lock();
+		m_Lines.insert(m_Lines.end(), lines.begin(), lines.end());
+		m_Mutex.unlock();
+	}
+
+	return (end < m_Size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LogFileIndex::FilterLines()
+{
+	m_Mutex.lock();
+	bool filtered = m_Filtered;
+	unsigned int generation = m_FilterGeneration;
+	sFilter filter = m_Filter;
+	QByteArray text = m_FilterText;
+	size_t from = m_FilteredLines;
+	m_Mutex.unlock();
+
+	size_t lines = (m_Lines.size() - 1);
+	if(!filtered || from>=lines)
+		return false;
+
+	size_t to = qMin(lines, from+LOG_FILE_FILTER_CHUNK);
+	ROWS rows;
+	for(size_t i=from; i<to; i++)
+	{
+		const char *data = 0;
+		size_t size = 0;
+		if(GetLine(i,data,size) && GetLevel(data,size)>=filter.level && ContainsNoCase(data,size,text))
+			rows.push_back( static_cast<quint32>(i) );
+	}
+
+	m_Mutex.lock();
+	if(generation == m_FilterGeneration)
+	{
+		m_Rows.insert(m_Rows.end(), rows.begin(), rows.end());
+		m_FilteredLines = to;
+	}
+	m_Mutex.unlock();
+
+	return (to < lines);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LogFileIndex::GetLine(size_t line, const char *&data, size_t &size)
+{
+	qint64 start = m_Lines[line];
+	qint64 end = m_Lines[line+1];
+	data = Map(start, end);
+	if( !data )
+		return false;
+
+	// byte order mark
+	if(start==0 && end>=3 && memcmp(data,"\xEF\xBB\xBF",3)==0)
+	{
+		data += 3;
+		start = 3;
+	}
+
+	size = static_cast<size_t>(end - start);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LogFileIndex::ContainsNoCase(const char *data, size_t size, const QByteArray &lowerText)
+{
+	size_t n = static_cast<size_t>( lowerText.size() );
+	if(n == 0)
+		return true;
+	if(n > size)
+		return false;
+
+	const char *text = lowerText.constData();
+	char first = text[0];
+	char firstUpper = ((first>='a' && first<='z') ? (first - 'a' + 'A') : first);
+	for(size_t i=0; i+n<=size; i++)
+	{
+		if(data[i]!=first && data[i]!=firstUpper)
+			continue;
+
+		size_t j = 1;
+		for(; j<n; j++)
+		{
+			char c = data[i+j];
+			if(c>='A' && c<='Z')
+				c = c - 'A' + 'a';
+			if(c != text[j])
+				break;
+		}
+
+		if(j == n)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogFileModel::LogFileModel(LogFileIndex &index, QObject *parent)
+	: QAbstractListModel(parent)
+	, m_Index(index)
+	, m_Rows(0)
+	, m_Generation(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LogFileModel::Update()
+{
+	size_t rows = 0;
+	unsigned int generation = 0;
+	m_Index.GetRows(rows, generation);
+	int count = static_cast<int>( qMin(rows,static_cast<size_t>(INT_MAX)) );
+
+	if(generation != m_Generation)
+	{
+		beginResetModel();
+		m_Rows = count;
+		m_Generation = generation;
+		endResetModel();
+		return true;
+	}
+
+	if(count > m_Rows)
+	{
+		beginInsertRows(QModelIndex(), m_Rows, count-1);
+		m_Rows = count;
+		endInsertRows();
+		return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int LogFileModel::rowCount(const QModelIndex &parent) const
+{
+	return (parent.isValid() ? 0 : m_Rows);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QVariant LogFileModel::data(const QModelIndex &index, int role) const
+{
+	if(!index.isValid() || index.row()>=m_Rows)
+		return QVariant();
+
+	if(role==Qt::DisplayRole || role==Qt::ForegroundRole)
+	{
+		QString text;
+		LogFileIndex::EnumLevel level = LogFileIndex::LEVEL_INFO;
+		if( m_Index.GetRow(static_cast<size_t>(index.row()),text,level) )
+		{
+			if(role == Qt::DisplayRole)
+				return text;
+
+			QColor color = LogFileIndex::GetLevelColor(level);
+			if( color.isValid() )
+				return QBrush(color);
+		}
+	}
+
+	return QVariant();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogFileView::LogFileView(const QString &path, QWidget *parent)
+	: QWidget(parent, Qt::Window)
+	, m_Path(path)
+{
+	setWindowTitle( QString("Log - %1").arg(QDir::toNativeSeparators(path)) );
+
+	QGridLayout *layout = new QGridLayout(this);
+
+	m_Level = new QComboBox(this);
+	for(int i=0; i<LogFileIndex::LEVEL_COUNT; i++)
+		m_Level->addItem( LogFileIndex::GetLevelName(static_cast<LogFileIndex::EnumLevel>(i)) );
+	m_Level->setToolTip("Lowest level shown");
+	connect(m_Level, SIGNAL(currentIndexChanged(int)), this, SLOT(onLevelChanged(int)));
+	layout->addWidget(m_Level, 0, 0);
+
+	m_Text = new QLineEdit(this);
+	m_Text->setPlaceholderText("Filter");
+	connect(m_Text, SIGNAL(textChanged(const QString&)), this, SLOT(onTextChanged(const QString&)));
+	layout->addWidget(m_Text, 0, 1);
+	layout->setColumnStretch(1, 1);
+
+	m_Model = new LogFileModel(m_Index, this);
+
+	m_List = new QListView(this);
+	QPalette listPal( m_List->palette() );
+	listPal.setColor(QPalette::Base, BG_COLOR);
+	m_List->setPalette(listPal);
+	m_List->setSelectionMode(QAbstractItemView::NoSelection);
+	m_List->setMovement(QListView::Static);
+	// row heights are never measured, so millions of rows cost nothing until drawn
+	m_List->setUniformItemSizes(true);
+	QFont fnt("Monospace");
+	fnt.setStyleHint(QFont::TypeWriter);
+	m_List->setFont(fnt);
+	m_List->setModel(m_Model);
+	layout->addWidget(m_List, 1, 0, 1, 3);
+
+	m_Status = new QLabel(this);
+	QPalette statusPal( m_Status->palette() );
+	statusPal.setColor(QPalette::WindowText, MUTED_COLOR);
+	m_Status->setPalette(statusPal);
+	layout->addWidget(m_Status, 2, 0, 1, 2);
+
+	QPushButton *button = new QPushButton("Open in Editor", this);
+	connect(button, SIGNAL(clicked(bool)), this, SLOT(onOpenClicked(bool)));
+	layout->addWidget(button, 2, 2);
+
+	m_FilterTimer = new QTimer(this);
+	m_FilterTimer->setSingleShot(true);
+	m_FilterTimer->setInterval(LOG_FILE_FILTER_MS);
+	connect(m_FilterTimer, SIGNAL(timeout()), this, SLOT(onApplyFilter()));
+
+	QString error;
+	if( !m_Index.Start(path,error) )
+		m_Status->setText( QString("Unable to open log, %1").arg(error) );
+
+	QTimer *timer = new QTimer(this);
+	connect(timer, SIGNAL(timeout()), this, SLOT(onTick()));
+	timer->start(LOG_FILE_TICK_MS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogFileView::~LogFileView()
+{
+	m_Index.Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileView::onTick()
+{
+	if( !isVisible() )
+		return;
+
+	QScrollBar *vs = m_List->verticalScrollBar();
+	bool dontAutoScroll = (vs && vs->isEnabled() && vs->isVisible() && vs->value()<vs->maximum());
+
+	if(m_Model->Update() && !dontAutoScroll)
+		m_List->scrollToBottom();
+
+	LogFileIndex::sStatus status;
+	m_Index.GetStatus(status);
+	QString text = QString("%1 lines, %2 shown, %3 MB")
+		.arg(status.lines)
+		.arg(status.rows)
+		.arg(status.bytes/(1024.0*1024.0), 0, 'f', 1);
+	if( status.filtering )
+		text.append(", filtering...");
+	m_Status->setText(text);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileView::onLevelChanged(int /*index*/)
+{
+	onApplyFilter();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileView::onTextChanged(const QString& /*text*/)
+{
+	// wait for a pause in typing, as each change starts the scan over
+	m_FilterTimer->start();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileView::onApplyFilter()
+{
+	m_FilterTimer->stop();
+
+	LogFileIndex::sFilter filter;
+	filter.level = static_cast<LogFileIndex::EnumLevel>( qMax(0,m_Level->currentIndex()) );
+	filter.text = m_Text->text();
+	m_Index.SetFilter(filter);
+
+	m_Model->Update();
+	m_List->scrollToBottom();
+	onTick();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogFileView::onOpenClicked(bool /*checked*/)
+{
+	QDesktopServices::openUrl( QUrl::fromLocalFile(m_Path) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
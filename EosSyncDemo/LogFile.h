@@ -0,0 +1,186 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef LOG_FILE_H
+#define LOG_FILE_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Line index over the text log file, for browsing a whole session without
+// loading it.
+//
+// A background thread maps the file a window at a time and records the
+// offset of every complete line, following the file as it grows and
+// starting over if it shrinks. Only the window has to fit in the address
+// space, but the index is held in memory at 8 bytes a line, about 80 MB for
+// ten million lines, plus 4 bytes for each line a filter matches. Filtering by level and case insensitive substring also
+// runs on that thread, producing the line numbers that match, so the UI
+// only ever reads and decodes the rows on screen, through a handle of its own.
+// Lines carry a level tag after the timestamp; lines without one count as
+// info.
+class LogFileIndex
+	: public QThread
+{
+public:
+	enum EnumLevel
+	{
+		LEVEL_DEBUG,
+		LEVEL_INFO,
+		LEVEL_WARNING,
+		LEVEL_ERROR,
+
+		LEVEL_COUNT
+	};
+
+	struct sFilter
+	{
+		sFilter() : level(LEVEL_DEBUG) {}
+		EnumLevel	level;		// minimum
+		QString		text;		// empty for none
+	};
+
+	struct sStatus
+	{
+		sStatus();
+		size_t		lines;
+		size_t		rows;
+		qint64		bytes;		// indexed
+		bool		filtering;	// rows still being found for the current filter
+	};
+
+	LogFileIndex();
+	virtual ~LogFileIndex();
+
+	virtual bool Start(const QString &path, QString &error);
+	virtual void Stop();
+	virtual void SetFilter(const sFilter &filter);
+	virtual void GetStatus(sStatus &status);
+
+	// UI thread; rows only grow until the filter generation changes
+	virtual void GetRows(size_t &rows, unsigned int &generation);
+	virtual bool GetRow(size_t row, QString &text, EnumLevel &level);
+
+	static const char* GetLevelTag(EnumLevel level);
+	static const char* GetLevelName(EnumLevel level);
+	static QColor GetLevelColor(EnumLevel level);
+	static EnumLevel GetLevel(const char *line, size_t size);
+
+protected:
+	typedef std::vector<qint64> OFFSETS;
+	typedef std::vector<quint32> ROWS;
+
+	struct sWindow
+	{
+		sWindow() : data(0), offset(0), size(0) {}
+		uchar	*data;
+		qint64	offset;
+		qint64	size;
+	};
+
+	QFile			m_File;			// index thread, once started
+	QFile			m_RowFile;		// GetRow(), under m_Mutex
+	bool			m_Run;
+	QMutex			m_Mutex;
+	QWaitCondition	m_Wait;
+	sWindow			m_Window;		// index thread only
+	qint64			m_Size;			// index thread only, as last seen
+	qint64			m_Scanned;		// index thread only
+	OFFSETS			m_Lines;		// line starts, plus the end of the last complete line
+	sFilter			m_Filter;
+	QByteArray		m_FilterText;	// UTF-8, ASCII lower case
+	bool			m_Filtered;
+	unsigned int	m_FilterGeneration;
+	ROWS			m_Rows;			// line numbers, when filtered
+	size_t			m_FilteredLines;
+
+	virtual void run();
+	virtual void FollowFile();
+	virtual void Reset();
+	virtual const char* Map(qint64 start, qint64 end);
+	virtual void Unmap();
+	virtual bool IndexLines();
+	virtual bool FilterLines();
+	virtual bool GetLine(size_t line, const char *&data, size_t &size);
+
+	static bool ContainsNoCase(const char *data, size_t size, const QByteArray &lowerText);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class LogFileModel
+	: public QAbstractListModel
+{
+public:
+	LogFileModel(LogFileIndex &index, QObject *parent);
+
+	// UI thread; picks up new rows, or resets after a filter change
+	virtual bool Update();
+
+	virtual int rowCount(const QModelIndex &parent=QModelIndex()) const;
+	virtual QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const;
+
+protected:
+	LogFileIndex	&m_Index;
+	int				m_Rows;
+	unsigned int	m_Generation;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class LogFileView
+	: public QWidget
+{
+	Q_OBJECT
+
+public:
+	LogFileView(const QString &path, QWidget *parent);
+	virtual ~LogFileView();
+
+	virtual QSize sizeHint() const {return QSize(800,600);}
+
+private slots:
+	void onTick();
+	void onLevelChanged(int);
+	void onTextChanged(const QString&);
+	void onApplyFilter();
+	void onOpenClicked(bool checked);
+
+protected:
+	QString			m_Path;
+	LogFileIndex	m_Index;
+	LogFileModel	*m_Model;
+	QComboBox		*m_Level;
+	QLineEdit		*m_Text;
+	QListView		*m_List;
+	QLabel			*m_Status;
+	QTimer			*m_FilterTimer;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
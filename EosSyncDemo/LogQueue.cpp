@@ -0,0 +1,328 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "LogQueue.h"
+#include <string.h>
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// assigns a stored int back to EosLog's message type enum
+template<typename T>
+static void SetType(T &dst, int src)
+{
+	dst = static_cast<T>(src);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogQueue::sStats::sStats()
+	: collapsed(0)
+{
+	for(int i=0; i<LOG_LEVEL_COUNT; i++)
+	{
+		overwritten[i] = 0;
+		rateLimited[i] = 0;
+		filtered[i] = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int LogQueue::sStats::GetDropped() const
+{
+	unsigned int dropped = 0;
+	for(int i=0; i<LOG_LEVEL_COUNT; i++)
+		dropped += (overwritten[i] + rateLimited[i]);
+	return dropped;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogQueue::LogQueue(size_t capacity/*=DEFAULT_CAPACITY*/)
+	: m_Head(0)
+	, m_Count(0)
+	, m_MinLevel(LOG_LEVEL_DEBUG)
+	, m_HasLast(false)
+	, m_PendingRepeat(0)
+{
+	if(capacity < 1)
+		capacity = 1;
+	m_Entries.resize(capacity);
+
+	for(int i=0; i<LOG_LEVEL_COUNT; i++)
+	{
+		sRate &rate = m_Rates[i];
+		rate.perSecond = UNLIMITED_RATE;
+		rate.second = 0;
+		rate.count = 0;
+	}
+
+	memset(&m_Last, 0, sizeof(m_Last));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogQueue::SetMinLevel(EnumLogLevel level)
+{
+	m_Mutex.lock();
+	m_MinLevel = level;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogQueue::SetRateLimit(EnumLogLevel level, unsigned int perSecond)
+{
+	if(level<0 || level>=LOG_LEVEL_COUNT)
+		return;
+
+	m_Mutex.lock();
+	m_Rates[level].perSecond = perSecond;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogQueue::Push(const EosLog::sLogMsg &logMsg)
+{
+	EnumLogLevel level = GetLevelForType(logMsg.type);
+
+	size_t len = logMsg.text.size();
+	if(len > MAX_TEXT_LEN)
+		len = MAX_TEXT_LEN;
+	const char *text = logMsg.text.c_str();
+
+	m_Mutex.lock();
+
+	if(level < m_MinLevel)
+	{
+		m_Stats.filtered[level]++;
+		m_Mutex.unlock();
+		return;
+	}
+
+	// identical to the previous message, just count it
+	if(	m_HasLast &&
+		m_Last.type==logMsg.type &&
+		m_Last.len==len &&
+		memcmp(m_Last.text,text,len)==0 )
+	{
+		m_Stats.collapsed++;
+		sEntry *tail = GetTail();
+		if(tail && tail->type==m_Last.type && tail->len==len && memcmp(tail->text,text,len)==0)
+			tail->repeat++;
+		else
+			m_PendingRepeat++;
+		m_Mutex.unlock();
+		return;
+	}
+
+	sRate &rate = m_Rates[level];
+	if(rate.perSecond != UNLIMITED_RATE)
+	{
+		if(rate.second != logMsg.timestamp)
+		{
+			rate.second = logMsg.timestamp;
+			rate.count = 0;
+		}
+
+		if(rate.count >= rate.perSecond)
+		{
+			m_Stats.rateLimited[level]++;
+			m_Mutex.unlock();
+			return;
+		}
+
+		rate.count++;
+	}
+
+	FlushPendingRepeatLocked(logMsg.timestamp);
+	PushLocked(logMsg.type, logMsg.timestamp, 0, text, len);
+
+	m_Last.type = logMsg.type;
+	m_Last.timestamp = logMsg.timestamp;
+	m_Last.len = len;
+	memcpy(m_Last.text, text, len);
+	m_Last.text[len] = 0;
+	m_HasLast = true;
+
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogQueue::Push(const EosLog::LOG_Q &logQ)
+{
+	for(EosLog::LOG_Q::const_iterator i=logQ.begin(); i!=logQ.end(); i++)
+		Push(*i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t LogQueue::Pop(EosLog::LOG_Q &logQ, size_t max)
+{
+	size_t count = 0;
+
+	m_Mutex.lock();
+
+	// a run of repeats still going gets reported at least once per pop
+	FlushPendingRepeatLocked( time(0) );
+
+	char repeatText[64];
+	while(m_Count!=0 && count<max)
+	{
+		const sEntry &entry = m_Entries[m_Head];
+
+		logQ.push_back( EosLog::sLogMsg() );
+		EosLog::sLogMsg &msg = logQ.back();
+		SetType(msg.type, entry.type);
+		msg.timestamp = entry.timestamp;
+		msg.text.assign(entry.text, entry.len);
+		if(entry.repeat != 0)
+		{
+			std::string num;
+			FormatCount(entry.repeat, num);
+			sprintf(repeatText, " (repeated %s times)", num.c_str());
+			msg.text.append(repeatText);
+		}
+
+		m_Head = ((m_Head+1) % m_Entries.size());
+		m_Count--;
+		count++;
+	}
+
+	m_Mutex.unlock();
+
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogQueue::GetStats(sStats &stats) const
+{
+	m_Mutex.lock();
+	stats = m_Stats;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogQueue::Clear()
+{
+	m_Mutex.lock();
+	m_Head = m_Count = 0;
+	m_HasLast = false;
+	m_PendingRepeat = 0;
+	m_Stats = sStats();
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogQueue::PushLocked(int type, time_t timestamp, unsigned int repeat, const char *text, size_t len)
+{
+	size_t capacity = m_Entries.size();
+	if(m_Count >= capacity)
+	{
+		// full, the oldest message makes room
+		m_Stats.overwritten[ GetLevelForType(m_Entries[m_Head].type) ]++;
+		m_Head = ((m_Head+1) % capacity);
+		m_Count--;
+	}
+
+	sEntry &entry = m_Entries[(m_Head+m_Count) % capacity];
+	entry.type = type;
+	entry.timestamp = timestamp;
+	entry.repeat = repeat;
+	entry.len = len;
+	memcpy(entry.text, text, len);
+	entry.text[len] = 0;
+	m_Count++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogQueue::sEntry* LogQueue::GetTail()
+{
+	if(m_Count == 0)
+		return 0;
+
+	return &m_Entries[(m_Head+m_Count-1) % m_Entries.size()];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogQueue::FlushPendingRepeatLocked(time_t timestamp)
+{
+	if(m_PendingRepeat != 0)
+	{
+		PushLocked(m_Last.type, timestamp, m_PendingRepeat, m_Last.text, m_Last.len);
+		m_PendingRepeat = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogQueue::FormatCount(unsigned int n, std::string &str)
+{
+	// 3412 -> "3,412"
+	char buf[32];
+	sprintf(buf, "%u", n);
+	str.clear();
+	size_t len = strlen(buf);
+	for(size_t i=0; i<len; i++)
+	{
+		if(i!=0 && ((len-i)%3)==0)
+			str.push_back(',');
+		str.push_back(buf[i]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogQueue::EnumLogLevel LogQueue::GetLevelForType(int type)
+{
+	switch( type )
+	{
+		case EosLog::LOG_MSG_TYPE_DEBUG:	return LOG_LEVEL_DEBUG;
+		case EosLog::LOG_MSG_TYPE_WARNING:	return LOG_LEVEL_WARNING;
+		case EosLog::LOG_MSG_TYPE_ERROR:	return LOG_LEVEL_ERROR;
+	}
+
+	return LOG_LEVEL_INFO;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* LogQueue::GetLevelName(EnumLogLevel level)
+{
+	switch( level )
+	{
+		case LOG_LEVEL_DEBUG:	return "debug";
+		case LOG_LEVEL_INFO:	return "info";
+		case LOG_LEVEL_WARNING:	return "warning";
+		case LOG_LEVEL_ERROR:	return "error";
+	}
+
+	return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,124 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef LOG_QUEUE_H
+#define LOG_QUEUE_H
+
+#ifndef EOS_LOG_H
+#include "EosLog.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <vector>
+#include <string>
+#include <time.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fixed size hand-off between the sync thread and the UI for EosLog messages.
+// All storage is allocated up front; when the UI falls behind the oldest
+// messages are overwritten and counted, so memory stays flat.
+class LogQueue
+{
+public:
+	enum EnumLogLevel
+	{
+		LOG_LEVEL_DEBUG,
+		LOG_LEVEL_INFO,
+		LOG_LEVEL_WARNING,
+		LOG_LEVEL_ERROR,
+
+		LOG_LEVEL_COUNT
+	};
+
+	enum EnumConstants
+	{
+		DEFAULT_CAPACITY	= 1024,
+		MAX_TEXT_LEN		= 255,
+		UNLIMITED_RATE		= 0
+	};
+
+	struct sEntry
+	{
+		int				type;		// EosLog message type
+		time_t			timestamp;
+		unsigned int	repeat;		// additional identical messages collapsed into this one
+		size_t			len;
+		char			text[MAX_TEXT_LEN+1];
+	};
+
+	struct sStats
+	{
+		sStats();
+		unsigned int	overwritten[LOG_LEVEL_COUNT];	// lost because the UI fell behind
+		unsigned int	rateLimited[LOG_LEVEL_COUNT];	// over the per second limit for their level
+		unsigned int	filtered[LOG_LEVEL_COUNT];		// below the minimum level
+		unsigned int	collapsed;						// folded into a repeat count
+		unsigned int	GetDropped() const;
+	};
+
+	LogQueue(size_t capacity=DEFAULT_CAPACITY);
+	virtual ~LogQueue() {}
+
+	virtual void SetMinLevel(EnumLogLevel level);
+	virtual void SetRateLimit(EnumLogLevel level, unsigned int perSecond);
+	virtual void Push(const EosLog::sLogMsg &logMsg);
+	virtual void Push(const EosLog::LOG_Q &logQ);
+	virtual size_t Pop(EosLog::LOG_Q &logQ, size_t max);
+	virtual void GetStats(sStats &stats) const;
+	virtual void Clear();
+
+	static EnumLogLevel GetLevelForType(int type);
+	static const char* GetLevelName(EnumLogLevel level);
+	static void FormatCount(unsigned int n, std::string &str);
+
+protected:
+	struct sRate
+	{
+		unsigned int	perSecond;
+		time_t			second;
+		unsigned int	count;
+	};
+
+	typedef std::vector<sEntry> ENTRIES;
+
+	mutable QMutex	m_Mutex;
+	ENTRIES			m_Entries;
+	size_t			m_Head;		// oldest entry
+	size_t			m_Count;
+	EnumLogLevel	m_MinLevel;
+	sRate			m_Rates[LOG_LEVEL_COUNT];
+	sStats			m_Stats;
+	sEntry			m_Last;				// most recent message accepted, for collapsing repeats
+	bool			m_HasLast;
+	unsigned int	m_PendingRepeat;	// repeats of m_Last not yet attached to a queued entry
+
+	virtual void PushLocked(int type, time_t timestamp, unsigned int repeat, const char *text, size_t len);
+	virtual sEntry* GetTail();
+	virtual void FlushPendingRepeatLocked(time_t timestamp);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
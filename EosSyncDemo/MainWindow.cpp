@@ -22,8 +22,21 @@
 #include "EosSyncLib.h"
 #include "EosTimer.h"
 #include "ShowDataGrid.h"
+#include "QueryServer.h"
+#include "SharedSnapshot.h"
+#include "OscRelay.h"
+#include "ChangeJournal.h"
+#include "OscScheduler.h"
+#include "OscBlockView.h"
+#include "LogFile.h"
+#include "OscPacket.h"
+#include "ShowIndex.h"
+#include "SnapshotStore.h"
+#include "ShowExport.h"
+#include "ConsoleDiscovery.h"
 #include "EosTcp.h"
 #include <time.h>
+#include <string.h>
 
 #ifdef WIN32
 	#include <windows.h>
@@ -37,12 +50,47 @@
 #define SETTING_PORT		"Port"
 #define SETTING_SEND_TEXT	"SendText"
 #define SETTING_LOG_DEPTH	"LogDepth"
+#define SETTING_LOG_LEVEL	"LogLevel"
+#define SETTING_LOG_RATE_DEBUG	"LogRateDebug"
+#define SETTING_LOG_RATE_INFO	"LogRateInfo"
+#define SETTING_QUERY_SERVER	"QueryServer"
+#define SETTING_QUERY_BUFFER_KB	"QueryClientBufferKB"
+#define SETTING_SHARED_SNAPSHOT	"SharedSnapshot"
+#define SETTING_SHARED_SNAPSHOT_MB	"SharedSnapshotMB"
+#define SETTING_PROXY_TCP_PORT	"ProxyTcpPort"
+#define SETTING_PROXY_UDP_PORT	"ProxyUdpPort"
+#define SETTING_PROXY_BUFFER_KB	"ProxyClientBufferKB"
+#define SETTING_CONSOLE_TAP		"TapConsoleTraffic"
+#define SETTING_JOURNAL_CAPACITY	"JournalCapacity"
+#define SETTING_LIVE_FADER_COUNT	"LiveFaderCount"
+#define SETTING_SCRIPT_PATH		"ScriptPath"
+#define SETTING_PING_INTERVAL	"PingIntervalMS"
+#define SETTING_UDP_COMMAND_PORT	"UdpCommandPort"
+#define SETTING_SNAPSHOT_BUDGET_MB	"SnapshotBudgetMB"
+#define SETTING_EXPORT_PATH		"ExportPath"
+#define SETTING_LOG_FILE		"LogFile"		// empty for no log file
+#define SETTING_COMMAND_LINK	"CommandsOnConsoleLink"
+
+// max packets of each priority handed to EosSyncLib per pass of the sync thread,
+// so lower priority traffic can never build up ahead of a later operator command
+#define SEND_Q_USER_PER_PASS	0		// unlimited
+#define SEND_Q_REFRESH_PER_PASS	32
+#define SEND_Q_IDLE_MS			10
+#define SEND_Q_BUDGET_MS		4		// refresh traffic handed over per lock hold; EosSyncLib::Tick() itself is not bounded
+#define LOCK_REPORT_MS			30000
+#define UI_TICK_MS				60		// also the resolution of "applied" change times
+#define UDP_BUNDLE_SIZE			1400	// one Ethernet frame with room for tunnels, so never fragmented
 
 ////////////////////////////////////////////////////////////////////////////////
 
 EosSyncLibThread::EosSyncLibThread()
 	: m_Port(0)
 	, m_Run(false)
+	, m_UdpPort(0)
+	, m_CommandsOnLink(true)
+	, m_SendSliced(true)
+	, m_ConsolePort(0)
+	, m_ConsoleLink(m_LatencyProbe, m_LogQueue)
 {
 }
 
@@ -51,6 +99,7 @@ EosSyncLibThread::EosSyncLibThread()
 EosSyncLibThread::~EosSyncLibThread()
 {
 	Stop();
+	ClearSendQ();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -63,13 +112,45 @@ void EosSyncLibThread::Start(const QString &ip, unsigned short port)
 	m_Port = port;
 	m_Run = true;
 	start();
+
+	if( m_ConsoleIp.isEmpty() )
+		m_ConsoleLink.Start(ip, port, m_UdpIp, m_UdpPort);
+	else
+		m_ConsoleLink.Start(m_ConsoleIp, m_ConsolePort, m_UdpIp, m_UdpPort);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosSyncLibThread::SetUdpTarget(const QString &ip, unsigned short port)
+{
+	// before Start(); operator commands then go out as UDP datagrams from
+	// the console link's thread, in the order sent, but may reach the
+	// console out of order with what still goes over TCP
+	m_UdpIp = ip;
+	m_UdpPort = port;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosSyncLibThread::SetConsoleTarget(const QString &ip, unsigned short port)
+{
+	// before Start(), for when EosSyncLib connects to the relay rather than
+	// the console; the console link always goes straight to the console
+	m_ConsoleIp = ip;
+	m_ConsolePort = port;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void EosSyncLibThread::Stop()
 {
+	m_ConsoleLink.Stop();
+
+	m_SendMutex.lock();
 	m_Run = false;
+	m_SendWait.wakeAll();
+	m_SendMutex.unlock();
+
 	wait();
 }
 
@@ -77,7 +158,7 @@ void EosSyncLibThread::Stop()
 
 EosSyncLib* EosSyncLibThread::LockEosSyncLib()
 {
-	m_Mutex.lock();
+	Lock(LOCK_HOLDER_UI);
 	return &m_EosSyncLib;
 }
 
@@ -85,22 +166,350 @@ EosSyncLib* EosSyncLibThread::LockEosSyncLib()
 
 void EosSyncLibThread::UnlockEosSyncLib()
 {
+	Unlock(LOCK_HOLDER_UI);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosSyncLibThread::Lock(EnumLockHolder /*holder*/)
+{
+	m_Mutex.lock();
+	m_LockTimer.start();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosSyncLibThread::Unlock(EnumLockHolder holder)
+{
+	// stats are only touched while m_Mutex is held
+	qint64 us = (m_LockTimer.nsecsElapsed() / 1000);
+	sLockStats &stats = m_LockStats[holder];
+	stats.count++;
+	stats.totalUS += us;
+	if(us > stats.maxUS)
+		stats.maxUS = us;
+
 	m_Mutex.unlock();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void EosSyncLibThread::SendOscString(const std::string &str)
+void EosSyncLibThread::GetLockStats(sLockStats *stats, bool reset)
+{
+	for(int i=0; i<LOCK_HOLDER_COUNT; i++)
+	{
+		stats[i] = m_LockStats[i];
+		if( reset )
+			m_LockStats[i] = sLockStats();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosSyncLibThread::SendOscString(const std::string &str, EnumSendPriority priority/*=SEND_PRIORITY_USER*/)
 {
+	if(priority<0 || priority>=SEND_PRIORITY_COUNT)
+		return;
+
+	// packets are queued rather than sent here, so the caller never waits on
+	// m_Mutex while the sync thread is busy inside EosSyncLib::Tick()
 	OSCPacketWriter *packet = OSCPacketWriter::CreatePacketWriterForString( str.c_str() );
 	if( packet )
 	{
-		m_Mutex.lock();
-		m_EosSyncLib.Send(*packet, /*immediate*/true);
-		m_Mutex.unlock();
-		
-		delete packet;
+		// with a UDP target, operator commands skip TCP so a lost segment
+		// holding up the connection can't hold them up too; they share one
+		// queue with SendOscBlock()'s bundles, so they are written in order,
+		// but there is no ordering between them and anything sent over TCP,
+		// including SendNow() and refresh traffic, nor between datagrams on
+		// the wire
+		if(priority==SEND_PRIORITY_USER && m_UdpPort!=0)
+		{
+			size_t size = 0;
+			char *data = packet->Create(size);
+			if( data )
+				m_ConsoleLink.SendUdp( QByteArray(data,static_cast<int>(size)) );
+			delete[] data;
+			delete packet;
+		}
+		else if(priority==SEND_PRIORITY_USER && SendOnLink(*packet))
+			delete packet;
+		else
+		{
+			m_SendMutex.lock();
+			m_SendQ[priority].push_back(packet);
+			m_SendWait.wakeAll();
+			m_SendMutex.unlock();
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t EosSyncLibThread::SendOscBlock(const QStringList &lines, QStringList &errors)
+{
+	// one command per line, in the Send box's format; blank lines and '#' comments skipped
+	SEND_Q packets;
+	for(int i=0; i<lines.size(); i++)
+	{
+		QString line( lines[i].trimmed() );
+		if(line.isEmpty() || line.startsWith('#'))
+			continue;
+
+		OSCPacketWriter *packet = OSCPacketWriter::CreatePacketWriterForString( line.toUtf8().constData() );
+		if( packet )
+			packets.push_back(packet);
+		else
+			errors.push_back( QString("Line %1 is not an OSC command: %2").arg(i+1).arg(line) );
+	}
+
+	if( packets.empty() )
+		return 0;
+
+	// built into bundles here, so the link thread only writes them
+	std::vector<QByteArray> messages;
+	messages.reserve( packets.size() );
+	for(SEND_Q::const_iterator i=packets.begin(); i!=packets.end(); i++)
+	{
+		size_t size = 0;
+		char *data = (*i)->Create(size);
+		if( data )
+			messages.push_back( QByteArray(data,static_cast<int>(size)) );
+		delete[] data;
+		delete *i;
+	}
+
+	size_t count = messages.size();
+	if(count == 0)
+		return 0;
+
+	if(m_UdpPort != 0)
+	{
+		// as many datagrams as it takes, each bundle applied as a whole
+		std::vector<QByteArray> bundles;
+		std::vector<size_t> counts;
+		OscPacket::BuildBundles(messages, UDP_BUNDLE_SIZE, bundles, counts);
+
+		for(size_t i=0; i<bundles.size(); i++)
+			m_ConsoleLink.SendUdp(bundles[i], counts[i], /*bundle*/true);
+	}
+	else
+	{
+		// one bundle for the whole block, which only the console link can
+		// carry; EosSyncLib's connection takes one message at a time, so the
+		// block is refused rather than sent there piecemeal
+		QByteArray bundle;
+		OscPacket::BuildBundle(messages, bundle);
+		if(!m_CommandsOnLink || !m_ConsoleLink.SendTcp(bundle,count,/*bundle*/true))
+		{
+			errors.push_back( m_CommandsOnLink
+				? QString("Block of %1 commands not sent, the console link is down and EosSyncLib's connection can't send it as one bundle").arg(count)
+				: QString("Block of %1 commands not sent, %2 is off and EosSyncLib's connection can't send it as one bundle").arg(count).arg(SETTING_COMMAND_LINK) );
+			return 0;
+		}
 	}
+
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosSyncLibThread::SendNow(OSCPacketWriter &packet)
+{
+	// for timed sends from other threads, which can't sit in the queue until
+	// the sync thread's next pass; only with the console link down does this
+	// wait for the EosSyncLib lock, and so for a whole EosSyncLib::Tick() or
+	// UI tick
+	if( SendOnLink(packet) )
+		return;
+
+	Lock(LOCK_HOLDER_SEND);
+	m_EosSyncLib.Send(packet, /*immediate*/true);
+	Unlock(LOCK_HOLDER_SEND);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* EosSyncLibThread::GetLockHolderName(EnumLockHolder holder)
+{
+	switch( holder )
+	{
+		case LOCK_HOLDER_TICK:	return "tick";
+		case LOCK_HOLDER_SEND:	return "send";
+		case LOCK_HOLDER_UI:	return "ui";
+	}
+
+	return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool EosSyncLibThread::FlushSendQ(unsigned int budgetMS)
+{
+	static const size_t maxPerPass[SEND_PRIORITY_COUNT] = {
+		SEND_Q_USER_PER_PASS,
+		SEND_Q_REFRESH_PER_PASS };
+
+	// take a slice of each queue, highest priority first
+	SEND_Q sendQ[SEND_PRIORITY_COUNT];
+	bool any = false;
+	m_SendMutex.lock();
+	for(int i=0; i<SEND_PRIORITY_COUNT; i++)
+	{
+		SEND_Q &q = m_SendQ[i];
+		if(!m_SendSliced || maxPerPass[i]==0 || q.size()<=maxPerPass[i])
+			sendQ[i].swap(q);
+		else
+		{
+			sendQ[i].assign(q.begin(), q.begin()+maxPerPass[i]);
+			q.erase(q.begin(), q.begin()+maxPerPass[i]);
+		}
+		if( !sendQ[i].empty() )
+			any = true;
+	}
+	m_SendMutex.unlock();
+
+	if( any )
+	{
+		QElapsedTimer elapsed;
+		elapsed.start();
+
+		Lock(LOCK_HOLDER_SEND);
+		qint64 lockWaitNS = elapsed.nsecsElapsed();
+		size_t userCommands = 0;
+		qint64 userNS = 0;
+		qint64 maxNS = 0;
+		for(int i=0; i<SEND_PRIORITY_COUNT; i++)
+		{
+			// operator commands go out on the wire right away regardless of budget,
+			// everything else is left to EosSyncLib's own queue behind them
+			bool immediate = (i == SEND_PRIORITY_USER);
+			SEND_Q &q = sendQ[i];
+			while(!q.empty() && (immediate || !m_SendSliced || elapsed.elapsed()<budgetMS))
+			{
+				OSCPacketWriter *packet = q.front();
+				q.pop_front();
+				if( immediate )
+				{
+					QElapsedTimer send;
+					send.start();
+					m_EosSyncLib.Send(*packet, immediate);
+					qint64 ns = send.nsecsElapsed();
+					userCommands++;
+					userNS += ns;
+					maxNS = qMax(maxNS, ns);
+				}
+				else
+					m_EosSyncLib.Send(*packet, immediate);
+				delete packet;
+			}
+		}
+		Unlock(LOCK_HOLDER_SEND);
+
+		// commands that queued up together while the console link was down,
+		// timed like the bundles; single commands aren't logged
+		if(userCommands > 1)
+		{
+			EosLog::sLogMsg msg;
+			msg.type = EosLog::LOG_MSG_TYPE_INFO;
+			msg.timestamp = time(0);
+			msg.text = QString("Sent %1 commands over TCP in %2 ms after waiting %3 ms for the lock, slowest send %4 us")
+				.arg(userCommands)
+				.arg(userNS/1000000.0, 0, 'f', 2)
+				.arg(lockWaitNS/1000000.0, 0, 'f', 2)
+				.arg(maxNS/1000.0, 0, 'f', 1).toUtf8().constData();
+			m_LogQueue.Push(msg);
+		}
+	}
+
+	// anything over budget goes back to the front of its queue
+	bool more = false;
+	m_SendMutex.lock();
+	for(int i=0; i<SEND_PRIORITY_COUNT; i++)
+	{
+		SEND_Q &q = m_SendQ[i];
+		if( !sendQ[i].empty() )
+			q.insert(q.begin(), sendQ[i].begin(), sendQ[i].end());
+		if( !q.empty() )
+			more = true;
+	}
+	m_SendMutex.unlock();
+
+	return more;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosSyncLibThread::ClearSendQ()
+{
+	m_SendMutex.lock();
+	for(int i=0; i<SEND_PRIORITY_COUNT; i++)
+	{
+		SEND_Q &q = m_SendQ[i];
+		for(SEND_Q::const_iterator j=q.begin(); j!=q.end(); j++)
+			delete *j;
+		q.clear();
+	}
+	m_SendMutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool EosSyncLibThread::SendOnLink(OSCPacketWriter &packet)
+{
+	// false with the link down or turned off, for the caller to send over
+	// EosSyncLib's connection instead
+	if(!m_CommandsOnLink || !m_ConsoleLink.IsConnected())
+		return false;
+
+	size_t size = 0;
+	char *data = packet.Create(size);
+	if( !data )
+		return false;
+
+	bool sent = m_ConsoleLink.SendTcp( QByteArray(data,static_cast<int>(size)) );
+	delete[] data;
+	return sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool EosSyncLibThread::Tick(unsigned int sendBudgetMS)
+{
+	// The budget time-slices the app's own send queue only: queued refresh
+	// traffic is handed to EosSyncLib a few milliseconds at a time, with the
+	// lock given up in between. EosSyncLib::Tick() runs to completion under
+	// the lock however long it takes, so this does not cap the worst case
+	// lock hold; --bench-lock measures both.
+	QElapsedTimer elapsed;
+	elapsed.start();
+
+	// anything queued while the last slice held the lock goes out first
+	FlushSendQ(sendBudgetMS);
+
+	Lock(LOCK_HOLDER_TICK);
+	m_EosSyncLib.Tick();
+	if( !m_EosSyncLib.IsRunning() )
+		m_Run = false;
+
+	// relay round trip probes go out from here rather than the queue, so
+	// their times never include waiting behind other traffic
+	if(m_EosSyncLib.IsConnected() && m_RelayProbe.IsDue(m_ProbeStr))
+	{
+		OSCPacketWriter *packet = OSCPacketWriter::CreatePacketWriterForString( m_ProbeStr.c_str() );
+		if( packet )
+		{
+			m_RelayProbe.OnSent();
+			m_EosSyncLib.Send(*packet, /*immediate*/true);
+			delete packet;
+		}
+	}
+	Unlock(LOCK_HOLDER_TICK);
+
+	FlushLog();
+
+	qint64 ms = elapsed.elapsed();
+	unsigned int remainingMS = (ms<sendBudgetMS) ? static_cast<unsigned int>(sendBudgetMS-ms) : 0;
+	return FlushSendQ(remainingMS);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -108,37 +517,90 @@ void EosSyncLibThread::SendOscString(const std::string &str)
 void EosSyncLibThread::run()
 {
 	// initialize
-	m_Mutex.lock();
+	Lock(LOCK_HOLDER_TICK);
 	if( !m_EosSyncLib.Initialize(m_Ip.toAscii().constData(), m_Port) )
 		m_Run = false;
-	m_Mutex.unlock();
+	Unlock(LOCK_HOLDER_TICK);
 
 	// run
 	while( m_Run )
 	{
-		m_Mutex.lock();
-		m_EosSyncLib.Tick();
-		if( !m_EosSyncLib.IsRunning() )
-			m_Run = false;
-		m_Mutex.unlock();
-		EosTimer::SleepMS(10);
+		if( Tick(SEND_Q_BUDGET_MS) )
+		{
+			// more queued, give the lock up between slices and go again
+			yieldCurrentThread();
+			continue;
+		}
+
+		// sleep until the next pass, or until an operator command arrives
+		m_SendMutex.lock();
+		if(m_Run && m_SendQ[SEND_PRIORITY_USER].empty())
+			m_SendWait.wait(&m_SendMutex, SEND_Q_IDLE_MS);
+		m_SendMutex.unlock();
 	}
 
 	// destroy
-	m_Mutex.lock();
+	Lock(LOCK_HOLDER_TICK);
 	m_EosSyncLib.Shutdown();
-	m_Mutex.unlock();
+	Unlock(LOCK_HOLDER_TICK);
+
+	FlushLog();
+	ClearSendQ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosSyncLibThread::FlushLog()
+{
+	// drained here rather than by the UI, so EosSyncLib's own log queue can't
+	// grow while the UI is busy; m_LogQueue drops what the UI doesn't get to
+	Lock(LOCK_HOLDER_TICK);
+	m_EosSyncLib.GetLog().Flush(m_LogQ);
+	Unlock(LOCK_HOLDER_TICK);
+
+	if( !m_LogQ.empty() )
+	{
+		m_LogQueue.Push(m_LogQ);
+		m_LogQ.clear();
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-MainWindow::MainWindow(QWidget* parent/*=0*/, Qt::WindowFlags f/*=0*/)
+MainWindow::MainWindow(QWidget* parent/*=0*/, Qt::WindowFlags f/*=0*/, QSettings::Format settingsFormat/*=QSettings::NativeFormat*/)
 	: QWidget(parent, f)
+	, m_LogDroppedCount(0)
+	, m_ScriptButton(0)
+	, m_OscScheduler(0)
 	, m_EosSyncLibThread(0)
-	, m_Settings("ETC", "EosSyncDemo")
+	, m_Settings(settingsFormat, QSettings::UserScope, "ETC", "EosSyncDemo")
 	, m_LogDepth(200)
 	, m_LogFile("EosSyncDemo.XXXXXX.log.txt")
+	, m_QueryServer(0)
+	, m_QueryServerDropped(0)
+	, m_SharedSnapshot(0)
+	, m_SharedSnapshotOverflow(0)
+	, m_OscRelay(0)
+	, m_ChangeHub(64)
+	, m_ChangeJournal(0)
+	, m_ChangeJournalView(0)
+	, m_JournalSubscription(0)
+	, m_LiveStatePanel(0)
+	, m_LiveSubscribed(false)
+	, m_ShowSearchView(0)
+	, m_SnapshotStore(0)
+	, m_SnapshotBudget(0)
+	, m_ShowExport(0)
+	, m_ExportButton(0)
+	, m_Discovery(0)
+	, m_FindButton(0)
+	, m_BlockButton(0)
+	, m_OscBlockView(0)
+	, m_LogFileView(0)
 {
+	memset(m_JournalReady, 0, sizeof(m_JournalReady));
+	m_ShowSnapshot.SetChangeHub(&m_ChangeHub);
+
 #ifdef WIN32
 	HICON hIcon = static_cast<HICON>( LoadImage(GetModuleHandle(0),MAKEINTRESOURCE(IDI_ICON1),IMAGE_ICON,128,128,LR_LOADTRANSPARENT) );
 	if( hIcon )
@@ -148,8 +610,10 @@ MainWindow::MainWindow(QWidget* parent/*=0*/, Qt::WindowFlags f/*=0*/)
 	}
 #endif
 
-	m_LogFile.setFileName( QDir(QDir::tempPath()).absoluteFilePath("EosSyncDemoLog.txt") );
-	if( m_LogFile.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Text) )
+	QString logPath = m_Settings.value(SETTING_LOG_FILE, QDir(QDir::tempPath()).absoluteFilePath("EosSyncDemoLog.txt")).toString();
+	m_Settings.setValue(SETTING_LOG_FILE, logPath);
+	m_LogFile.setFileName(logPath);
+	if(!logPath.isEmpty() && m_LogFile.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Text))
 	{
 		m_LogStream.setDevice( &m_LogFile );
 		m_LogStream.setCodec("UTF-8");
@@ -157,6 +621,7 @@ MainWindow::MainWindow(QWidget* parent/*=0*/, Qt::WindowFlags f/*=0*/)
 	}
 
 	m_EosSyncLibThread = new EosSyncLibThread();
+	InitLogQueue();
 
 	QGridLayout *layout = new QGridLayout(this);
 
@@ -168,8 +633,15 @@ MainWindow::MainWindow(QWidget* parent/*=0*/, Qt::WindowFlags f/*=0*/)
 	GetDefaultIP(ip);
 	ip = m_Settings.value(SETTING_IP,ip).toString();
 
+	QHBoxLayout *ipLayout = new QHBoxLayout();
+	ipLayout->setContentsMargins(0, 0, 0, 0);
 	m_Ip = new QLineEdit(ip, this);
-	layout->addWidget(m_Ip, row, 1);
+	ipLayout->addWidget(m_Ip, 1);
+	m_FindButton = new QPushButton("Find", this);
+	m_FindButton->setToolTip("Look for consoles on the local subnets");
+	connect(m_FindButton, SIGNAL(clicked(bool)), this, SLOT(onFindClicked(bool)));
+	ipLayout->addWidget(m_FindButton);
+	layout->addLayout(ipLayout, row, 1);
 
 	layout->addWidget(new QLabel("Port",this), row, 2);
 
@@ -183,16 +655,24 @@ MainWindow::MainWindow(QWidget* parent/*=0*/, Qt::WindowFlags f/*=0*/)
 	connect(m_StartStopButton, SIGNAL(clicked(bool)), this, SLOT(onStartStopClicked(bool)));
 	layout->addWidget(m_StartStopButton, row, 4);
 
+	m_Latency = new QLabel(this);
+	QPalette latencyPal( m_Latency->palette() );
+	latencyPal.setColor(QPalette::WindowText, MUTED_COLOR);
+	m_Latency->setPalette(latencyPal);
+	m_Latency->setToolTip("Console round trip p50/p99/max, and the mean added by the OSC relay when it runs");
+	layout->addWidget(m_Latency, row, 5);
+
 	row++;
 	
 	QSplitter *splitter = new QSplitter(this);
-	layout->addWidget(splitter, row, 0, 1, 5);
+	layout->addWidget(splitter, row, 0, 1, 6);
 
 	QScrollArea *scrollArea = new QScrollArea(splitter);
 	scrollArea->setWidgetResizable(true);
 	splitter->addWidget(scrollArea);
 	
 	m_ShowDataGrid = new ShowDataGrid(scrollArea);
+	m_ShowDataGrid->SetChangeStats(&m_ChangeStats, UI_TICK_MS);
 	scrollArea->setWidget(m_ShowDataGrid);
 	
 	QWidget *logBase = new QWidget(splitter);
@@ -213,16 +693,46 @@ MainWindow::MainWindow(QWidget* parent/*=0*/, Qt::WindowFlags f/*=0*/)
 	QFont fnt("Monospace");
 	fnt.setStyleHint(QFont::TypeWriter);
 	m_Log->setFont(fnt);
-	logLayout->addWidget(m_Log, 0, 0, 1, 2);
+	logLayout->addWidget(m_Log, 0, 0, 1, 7);
 
 	QPushButton *button = new QPushButton("Clear Log", logBase);
 	connect(button, SIGNAL(clicked(bool)), this, SLOT(onClearLogClicked(bool)));
 	logLayout->addWidget(button, 1, 0);
 
 	button = new QPushButton("Open Log", logBase);
+	button->setToolTip("Open the log file in the system's editor");
 	button->setEnabled( m_LogFile.isOpen() );
 	connect(button, SIGNAL(clicked(bool)), this, SLOT(onOpenLogClicked(bool)));
 	logLayout->addWidget(button, 1, 1);
+
+	button = new QPushButton("View Log", logBase);
+	button->setToolTip("Browse and filter the whole log file");
+	button->setEnabled( m_LogFile.isOpen() );
+	connect(button, SIGNAL(clicked(bool)), this, SLOT(onViewLogClicked(bool)));
+	logLayout->addWidget(button, 1, 2);
+
+	button = new QPushButton("Changes", logBase);
+	connect(button, SIGNAL(clicked(bool)), this, SLOT(onChangesClicked(bool)));
+	logLayout->addWidget(button, 1, 3);
+
+	button = new QPushButton("Live", logBase);
+	connect(button, SIGNAL(clicked(bool)), this, SLOT(onLiveClicked(bool)));
+	logLayout->addWidget(button, 1, 4);
+
+	button = new QPushButton("Search", logBase);
+	connect(button, SIGNAL(clicked(bool)), this, SLOT(onSearchClicked(bool)));
+	logLayout->addWidget(button, 1, 5);
+
+	m_ExportButton = new QPushButton("Export...", logBase);
+	connect(m_ExportButton, SIGNAL(clicked(bool)), this, SLOT(onExportClicked(bool)));
+	logLayout->addWidget(m_ExportButton, 1, 6);
+
+	m_LogDropped = new QLabel(logBase);
+	QPalette droppedPal( m_LogDropped->palette() );
+	droppedPal.setColor(QPalette::WindowText, WARNING_COLOR);
+	m_LogDropped->setPalette(droppedPal);
+	m_LogDropped->hide();
+	logLayout->addWidget(m_LogDropped, 2, 0, 1, 7);
 	
 	row++;
 	
@@ -233,12 +743,25 @@ MainWindow::MainWindow(QWidget* parent/*=0*/, Qt::WindowFlags f/*=0*/)
 	
 	m_SendButton = new QPushButton("Send", this);
 	connect(m_SendButton, SIGNAL(clicked(bool)), this, SLOT(onSendClicked(bool)));
-	layout->addWidget(m_SendButton, row, 2, 1, 3);
+	layout->addWidget(m_SendButton, row, 2);
+
+	m_BlockButton = new QPushButton("Block...", this);
+	m_BlockButton->setToolTip("Send many commands at once");
+	connect(m_BlockButton, SIGNAL(clicked(bool)), this, SLOT(onBlockClicked(bool)));
+	layout->addWidget(m_BlockButton, row, 3);
+
+	m_ScriptButton = new QPushButton("Run Script...", this);
+	connect(m_ScriptButton, SIGNAL(clicked(bool)), this, SLOT(onScriptClicked(bool)));
+	layout->addWidget(m_ScriptButton, row, 4, 1, 2);
 
 	m_EosSyncLibThreadTimer = new QTimer(this);
 	connect(m_EosSyncLibThreadTimer, SIGNAL(timeout()), this, SLOT(onTick()));	
 
 	AddLogInfo( QString("Version %1").arg(APP_VERSION) );
+	InitQueryServer();
+	InitSharedSnapshot();
+	InitSnapshotBudget();
+	InitChangeJournal();
 	m_StartStopButton->setFocus();
 	UpdateUI();
 }
@@ -247,6 +770,56 @@ MainWindow::MainWindow(QWidget* parent/*=0*/, Qt::WindowFlags f/*=0*/)
 
 MainWindow::~MainWindow()
 {
+	StopScript();
+
+	if( m_Discovery )
+	{
+		delete m_Discovery;
+		m_Discovery = 0;
+	}
+
+	// before the sync thread goes, the export locks it for each slice
+	if( m_ShowExport )
+	{
+		delete m_ShowExport;
+		m_ShowExport = 0;
+	}
+
+	if( m_QueryServer )
+	{
+		delete m_QueryServer;
+		m_QueryServer = 0;
+	}
+
+	StopOscRelay();
+
+	// after the query server, whose thread may be reading spilled types
+	m_ShowSnapshot.SetStore(0);
+	if( m_SnapshotStore )
+	{
+		delete m_SnapshotStore;
+		m_SnapshotStore = 0;
+	}
+
+	if( m_ChangeJournal )
+	{
+		delete m_ChangeJournal;
+		m_ChangeJournal = 0;
+	}
+
+	if( m_SharedSnapshot )
+	{
+		delete m_SharedSnapshot;
+		m_SharedSnapshot = 0;
+	}
+
+	// its index is subscribed to m_ChangeHub, which goes before child widgets would
+	if( m_ShowSearchView )
+	{
+		delete m_ShowSearchView;
+		m_ShowSearchView = 0;
+	}
+
 	if( m_LogFile.isOpen() )
 	{
 		m_LogStream.flush();
@@ -269,8 +842,321 @@ void MainWindow::UpdateUI()
 	m_StartStopButton->setPalette( palette() );
 	m_Ip->setEnabled( !running );
 	m_Port->setEnabled( !running );
+	m_FindButton->setEnabled(!running && !m_Discovery);
 	m_SendText->setEnabled(false);
 	m_SendButton->setEnabled(false);
+	m_BlockButton->setEnabled(false);
+	if( m_OscBlockView )
+		m_OscBlockView->SetSendEnabled(false);
+	m_ScriptButton->setEnabled(false);
+	m_ScriptButton->setText(m_OscScheduler ? "Stop Script" : "Run Script...");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::InitLogQueue()
+{
+	int level = m_Settings.value(SETTING_LOG_LEVEL, LogQueue::LOG_LEVEL_DEBUG).toInt();
+	if(level < LogQueue::LOG_LEVEL_DEBUG)
+		level = LogQueue::LOG_LEVEL_DEBUG;
+	else if(level > LogQueue::LOG_LEVEL_ERROR)
+		level = LogQueue::LOG_LEVEL_ERROR;
+	m_Settings.setValue(SETTING_LOG_LEVEL, level);
+
+	// messages per second, 0 for no limit
+	unsigned int debugRate = m_Settings.value(SETTING_LOG_RATE_DEBUG, 50).toUInt();
+	m_Settings.setValue(SETTING_LOG_RATE_DEBUG, debugRate);
+	unsigned int infoRate = m_Settings.value(SETTING_LOG_RATE_INFO, 200).toUInt();
+	m_Settings.setValue(SETTING_LOG_RATE_INFO, infoRate);
+
+	LogQueue &logQueue = m_EosSyncLibThread->GetLogQueue();
+	logQueue.SetMinLevel( static_cast<LogQueue::EnumLogLevel>(level) );
+	logQueue.SetRateLimit(LogQueue::LOG_LEVEL_DEBUG, debugRate);
+	logQueue.SetRateLimit(LogQueue::LOG_LEVEL_INFO, infoRate);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::InitQueryServer()
+{
+	// local socket name other processes query show data on, empty to disable; off
+	// by default, since serving queries keeps a copy of the whole show in memory
+	QString name = m_Settings.value(SETTING_QUERY_SERVER, QString()).toString();
+	m_Settings.setValue(SETTING_QUERY_SERVER, name);
+	if( name.isEmpty() )
+		return;
+
+	// unread answers held per client before it is disconnected; the largest
+	// query, 100000 rows, is typically well under that
+	unsigned int bufferKB = m_Settings.value(SETTING_QUERY_BUFFER_KB, 16*1024).toUInt();
+	m_Settings.setValue(SETTING_QUERY_BUFFER_KB, bufferKB);
+
+	m_QueryServer = new QueryServer(m_ShowSnapshot);
+	m_QueryServerDropped = 0;
+	QString error;
+	if( m_QueryServer->Start(name,bufferKB*1024,error) )
+		AddLogInfo( QString("Query server listening on \"%1\"").arg(name) );
+	else
+	{
+		AddLogInfo( QString("Query server unable to listen on \"%1\": %2").arg(name).arg(error) );
+		delete m_QueryServer;
+		m_QueryServer = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::InitSharedSnapshot()
+{
+	// shared memory key other processes read show data from, empty to disable; off
+	// by default, as it needs the whole show copied as well as the segment itself
+	QString key = m_Settings.value(SETTING_SHARED_SNAPSHOT, QString()).toString();
+	m_Settings.setValue(SETTING_SHARED_SNAPSHOT, key);
+	unsigned int sizeMB = m_Settings.value(SETTING_SHARED_SNAPSHOT_MB, 16).toUInt();
+	m_Settings.setValue(SETTING_SHARED_SNAPSHOT_MB, sizeMB);
+	if( key.isEmpty() )
+		return;
+
+	m_SharedSnapshot = new SharedSnapshot();
+	QString error;
+	if( m_SharedSnapshot->Create(key,sizeMB,error) )
+	{
+		m_SharedSnapshot->Subscribe(m_ChangeHub);
+		AddLogInfo( QString("Publishing show data to shared memory \"%1\" (%2 MB)").arg(key).arg(sizeMB) );
+	}
+	else
+	{
+		AddLogInfo( QString("Unable to create shared memory \"%1\": %2").arg(key).arg(error) );
+		delete m_SharedSnapshot;
+		m_SharedSnapshot = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::InitSnapshotBudget()
+{
+	// memory for the show snapshot before unviewed target types go to disk, 0 for no limit;
+	// this bounds the app's own copy only, EosSyncLib keeps every property of
+	// every target whatever it is set to, so resident memory never goes below
+	// what the library alone takes (--bench-memory's "library" figure)
+	unsigned int budgetMB = m_Settings.value(SETTING_SNAPSHOT_BUDGET_MB, 0).toUInt();
+	m_Settings.setValue(SETTING_SNAPSHOT_BUDGET_MB, budgetMB);
+	if(budgetMB == 0)
+		return;
+
+	m_SnapshotStore = new SnapshotStore();
+	QString error;
+	if( m_SnapshotStore->Open(error) )
+	{
+		m_ShowSnapshot.SetStore(m_SnapshotStore);
+		m_SnapshotBudget = (static_cast<size_t>(budgetMB) * 1024 * 1024);
+		AddLogInfo( QString("Show snapshot budget %1 MB, for the app's copy on top of EosSyncLib's").arg(budgetMB) );
+	}
+	else
+	{
+		AddLogInfo( QString("Unable to open snapshot store: %1").arg(error) );
+		delete m_SnapshotStore;
+		m_SnapshotStore = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::EnforceSnapshotBudget()
+{
+	// the type open in the details window always stays resident
+	unsigned int viewed = EosTarget::EOS_TARGET_COUNT;
+	if( m_ShowDataGrid->GetDetailsTargetType(viewed) )
+	{
+		EosTarget::EnumEosTargetType type = static_cast<EosTarget::EnumEosTargetType>(viewed);
+		if( m_ShowSnapshot.Restore(type) )
+			AddLogDebug( QString("Restored %1 from disk").arg(EosTarget::GetNameForTargetType(type)) );
+	}
+
+	// then shed the largest of the rest until under budget
+	ShowSnapshot::SPILLS spills;
+	m_ShowSnapshot.SpillToBudget(m_SnapshotBudget, viewed, spills);
+	for(ShowSnapshot::SPILLS::const_iterator i=spills.begin(); i!=spills.end(); i++)
+	{
+		if( !i->ok )
+		{
+			AddLogInfo( QString("Unable to spill %1, show snapshot over budget").arg(EosTarget::GetNameForTargetType(i->type)) );
+			continue;
+		}
+
+		AddLogDebug( QString("Spilled %1 to disk, %2 KB resident -> %3 KB stored")
+			.arg( EosTarget::GetNameForTargetType(i->type) )
+			.arg( i->residentBytes/1024 )
+			.arg( i->storedBytes/1024 ) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::PublishSharedSnapshot()
+{
+	if( !m_SharedSnapshot )
+		return;
+
+	unsigned int overflow = m_SharedSnapshot->Publish(m_ShowSnapshot);
+	if(overflow != m_SharedSnapshotOverflow)
+	{
+		m_SharedSnapshotOverflow = overflow;
+		if(overflow != 0)
+			AddLogInfo( QString("Shared memory full, %1 target types not published; raise %2").arg(overflow).arg(SETTING_SHARED_SNAPSHOT_MB) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool MainWindow::StartOscRelay(const QString &ip, unsigned short port, unsigned short &relayPort)
+{
+	// ports local OSC tools connect to for a share of the console connection, 0 for none
+	OscRelay::sSettings settings;
+	settings.consoleIp = ip;
+	settings.consolePort = port;
+	settings.clientTcpPort = static_cast<unsigned short>( m_Settings.value(SETTING_PROXY_TCP_PORT,0).toUInt() );
+	m_Settings.setValue(SETTING_PROXY_TCP_PORT, settings.clientTcpPort);
+	settings.clientUdpPort = static_cast<unsigned short>( m_Settings.value(SETTING_PROXY_UDP_PORT,0).toUInt() );
+	m_Settings.setValue(SETTING_PROXY_UDP_PORT, settings.clientUdpPort);
+	unsigned int bufferKB = m_Settings.value(SETTING_PROXY_BUFFER_KB, settings.clientBufferSize/1024).toUInt();
+	m_Settings.setValue(SETTING_PROXY_BUFFER_KB, bufferKB);
+	settings.clientBufferSize = (bufferKB * 1024);
+
+	// the relay can also time console traffic as it arrives, for the grid's change
+	// rates; off by default, since it puts a loopback hop on the console link
+	bool tap = m_Settings.value(SETTING_CONSOLE_TAP, false).toBool();
+	m_Settings.setValue(SETTING_CONSOLE_TAP, tap);
+
+	if(!tap && settings.clientTcpPort==0 && settings.clientUdpPort==0)
+		return false;
+
+	if( !m_OscRelay )
+		m_OscRelay = new OscRelay();
+
+	QString error;
+	if( !m_OscRelay->Start(*m_EosSyncLibThread,m_ChangeStats,m_LiveState,settings,relayPort,error) )
+	{
+		AddLogInfo( QString("OSC proxy unavailable, connecting directly: %1").arg(error) );
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::StopOscRelay()
+{
+	if( m_OscRelay )
+	{
+		delete m_OscRelay;
+		m_OscRelay = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool MainWindow::IsShowSnapshotEnabled() const
+{
+	// the search window only needs the whole show while it's open
+	return (m_QueryServer!=0 || m_SharedSnapshot!=0 || m_ChangeJournal!=0 || (m_ShowSearchView && m_ShowSearchView->isVisible()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::UpdateSnapshotTracking()
+{
+	// whole show consumers need every type, otherwise just the one in the details window
+	bool all = IsShowSnapshotEnabled();
+	unsigned int viewed = EosTarget::EOS_TARGET_COUNT;
+	m_ShowDataGrid->GetDetailsTargetType(viewed);
+	for(unsigned int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		m_ShowSnapshot.SetTracked(static_cast<EosTarget::EnumEosTargetType>(i), all || i==viewed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::InitChangeJournal()
+{
+	// changes kept for the recent changes view, 0 to disable; off by default, since
+	// diffing generations keeps a copy of the whole show in memory
+	unsigned int capacity = m_Settings.value(SETTING_JOURNAL_CAPACITY, 0).toUInt();
+	m_Settings.setValue(SETTING_JOURNAL_CAPACITY, capacity);
+	if(capacity != 0)
+	{
+		m_ChangeJournal = new ChangeJournal(capacity);
+		m_JournalSubscription = m_ChangeHub.Subscribe();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::UpdateJournalReady(const EosSyncData &syncData, bool *ready)
+{
+	// a type is journaled from the generation after its initial sync completed
+	const EosSyncData::SHOW_DATA &showData = syncData.GetShowData();
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		ready[i] = m_JournalReady[i];
+
+		bool complete = false;
+		EosSyncData::SHOW_DATA::const_iterator j = showData.find( static_cast<EosTarget::EnumEosTargetType>(i) );
+		if(j != showData.end())
+		{
+			complete = true;
+			const EosSyncData::TARGETLIST_DATA &targetListData = j->second;
+			for(EosSyncData::TARGETLIST_DATA::const_iterator k=targetListData.begin(); complete && k!=targetListData.end(); k++)
+				complete = k->second->GetInitialSync().complete;
+		}
+		m_JournalReady[i] = complete;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::FlushLog()
+{
+	EosLog::LOG_Q logQ;
+	m_EosSyncLibThread->GetLogQueue().Pop(logQ, LogQueue::DEFAULT_CAPACITY);
+	AddLogQ(logQ);
+	UpdateLogDropped();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::UpdateLogDropped()
+{
+	LogQueue::sStats stats;
+	m_EosSyncLibThread->GetLogQueue().GetStats(stats);
+	unsigned int dropped = stats.GetDropped();
+	if(dropped == m_LogDroppedCount)
+		return;
+
+	m_LogDroppedCount = dropped;
+
+	QString str( QString("Dropped %L1 log messages (").arg(dropped) );
+	bool first = true;
+	for(int i=0; i<LogQueue::LOG_LEVEL_COUNT; i++)
+	{
+		unsigned int overwritten = stats.overwritten[i];
+		unsigned int rateLimited = stats.rateLimited[i];
+		if(overwritten!=0 || rateLimited!=0)
+		{
+			if( !first )
+				str.append(", ");
+			first = false;
+			str.append( QString("%1: %L2 rate, %L3 overflow")
+				.arg( LogQueue::GetLevelName(static_cast<LogQueue::EnumLogLevel>(i)) )
+				.arg(rateLimited)
+				.arg(overwritten) );
+		}
+	}
+	str.append(")");
+
+	m_LogDropped->setText(str);
+	m_LogDropped->setVisible(dropped != 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -289,6 +1175,20 @@ void MainWindow::AddLogInfo(const QString &text)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void MainWindow::AddLogDebug(const QString &text)
+{
+	EosLog::sLogMsg logMsg;
+	logMsg.type = EosLog::LOG_MSG_TYPE_DEBUG;
+	logMsg.timestamp = time(0);
+	logMsg.text = text.toStdString();
+
+	EosLog::LOG_Q logQ;
+	logQ.push_back(logMsg);
+	AddLogQ(logQ);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void MainWindow::AddLogQ(EosLog::LOG_Q &logQ)
 {
 	if( !logQ.empty() )
@@ -308,34 +1208,40 @@ void MainWindow::AddLogQ(EosLog::LOG_Q &logQ)
 			if( logMsg.text.c_str() )
 				msgText = QString::fromUtf8( logMsg.text.c_str() );
 
-			QString itemText = QString("[ %1:%2:%3 ]  %4")
+			QString timeText = QString("[ %1:%2:%3 ]")
 				.arg(t->tm_hour, 2)
 				.arg(t->tm_min, 2, 10, QChar('0'))
-				.arg(t->tm_sec, 2, 10, QChar('0'))
-				.arg( msgText );
-
-			if( m_LogFile.isOpen() )
-			{
-				m_LogStream << itemText;
-				m_LogStream << "\n";
-			}
+				.arg(t->tm_sec, 2, 10, QChar('0'));
 
-			QListWidgetItem *item = new QListWidgetItem(itemText);
+			LogFileIndex::EnumLevel level = LogFileIndex::LEVEL_INFO;
 			switch( logMsg.type )
 			{
 				case EosLog::LOG_MSG_TYPE_DEBUG:
-					item->setForeground(MUTED_COLOR);
+					level = LogFileIndex::LEVEL_DEBUG;
 					break;
 
 				case EosLog::LOG_MSG_TYPE_WARNING:
-					item->setForeground(WARNING_COLOR);
+					level = LogFileIndex::LEVEL_WARNING;
 					break;
 
 				case EosLog::LOG_MSG_TYPE_ERROR:
-					item->setForeground(ERROR_COLOR);
+					level = LogFileIndex::LEVEL_ERROR;
 					break;
 			}
 
+			// the file gets a level tag, for filtering in LogFileView, so its lines
+			// read "[ hh:mm:ss ] INF text" where they used to be "[ hh:mm:ss ]  text"
+			if( m_LogFile.isOpen() )
+			{
+				m_LogStream << timeText << ' ' << LogFileIndex::GetLevelTag(level) << ' ' << msgText;
+				m_LogStream << "\n";
+			}
+
+			QListWidgetItem *item = new QListWidgetItem(timeText + "  " + msgText);
+			QColor color = LogFileIndex::GetLevelColor(level);
+			if( color.isValid() )
+				item->setForeground(color);
+
 			m_Log->addItem(item);
 
 			while(m_Log->count() > m_LogDepth)
@@ -350,6 +1256,10 @@ void MainWindow::AddLogQ(EosLog::LOG_Q &logQ)
 	
 		if(	!dontAutoScroll )
 			m_Log->setCurrentRow(m_Log->count() - 1);
+
+		// LogFileView only sees what has reached the file
+		if(m_LogFileView && m_LogFileView->isVisible() && m_LogFile.isOpen())
+			m_LogStream.flush();
 	}
 }
 
@@ -400,39 +1310,193 @@ void MainWindow::SendText()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void MainWindow::onBlockClicked(bool /*checked*/)
+{
+	if( !m_OscBlockView )
+	{
+		m_OscBlockView = new OscBlockView(this);
+		connect(m_OscBlockView, SIGNAL(sendRequested(const QStringList&)), this, SLOT(onSendBlock(const QStringList&)));
+	}
+
+	m_OscBlockView->SetSendEnabled( m_SendButton->isEnabled() );
+	m_OscBlockView->show();
+	m_OscBlockView->raise();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onSendBlock(const QStringList &lines)
+{
+	if(!m_EosSyncLibThread || !m_EosSyncLibThread->isRunning())
+		return;
+
+	QElapsedTimer timer;
+	timer.start();
+	QStringList errors;
+	size_t count = m_EosSyncLibThread->SendOscBlock(lines, errors);
+	double ms = (timer.nsecsElapsed() / 1000000.0);
+
+	for(QStringList::const_iterator i=errors.begin(); i!=errors.end(); i++)
+		AddLogInfo(*i);
+
+	// the transport the thread was started with, not what the settings say now
+	QString result;
+	if(count == 0)
+		result = (errors.isEmpty() ? QString("Nothing to send") : errors.back());
+	else
+	{
+		result = QString("%1 commands parsed and queued in %2 ms").arg(count).arg(ms, 0, 'f', 2);
+		if( !errors.isEmpty() )
+			result.append( QString(", %1 lines skipped").arg(errors.size()) );
+		result.append( m_EosSyncLibThread->HasUdpTarget()
+			? "; sent as UDP bundles, see the log for per bundle timing"
+			: "; sent as one bundle on the console link, see the log for timing" );
+	}
+	AddLogInfo(result);
+	if( m_OscBlockView )
+		m_OscBlockView->SetResult(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void MainWindow::onTick()
 {
 	EosSyncLib *eosSyncLib = m_EosSyncLibThread->LockEosSyncLib();
 	if( eosSyncLib )
 	{
 		// update UI
-		if( eosSyncLib->IsConnected() )
+		bool connected = eosSyncLib->IsConnected();
+		if( connected )
 		{
 			m_SendText->setEnabled(true);
 			m_SendButton->setEnabled(true);
+			m_BlockButton->setEnabled(true);
+			if( m_OscBlockView )
+				m_OscBlockView->SetSendEnabled(true);
+			m_ScriptButton->setEnabled(true);
 		}
 		m_ShowDataGrid->Update( *eosSyncLib );
+		m_ShowDataGrid->UpdateRates();
 		const EosSyncStatus &status = eosSyncLib->GetData().GetStatus();
 		if( status.GetDirty() )
 		{
+			bool complete = (status.GetValue()==EosSyncStatus::SYNC_STATUS_COMPLETE);
 			QPalette pal( palette() );
 			pal.setColor(QPalette::ButtonText, Qt::white);
-			pal.setColor(QPalette::Button, (status.GetValue()==EosSyncStatus::SYNC_STATUS_COMPLETE) ? SUCCESS_COLOR : ERROR_COLOR);
+			pal.setColor(QPalette::Button, complete ? SUCCESS_COLOR : ERROR_COLOR);
 			m_StartStopButton->setPalette(pal);
 		}
+		bool snapshotChanged = false;
+		ShowSnapshot::TARGET_TYPE_PTR journalPrev[EosTarget::EOS_TARGET_COUNT];
+		bool journalReady[EosTarget::EOS_TARGET_COUNT];
+		if( m_ChangeJournal )
+		{
+			for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+				journalPrev[i] = m_ShowSnapshot.GetTargetType( static_cast<EosTarget::EnumEosTargetType>(i) );
+		}
+
+		// untracked types cost nothing here, and are dropped once nobody needs them
+		UpdateSnapshotTracking();
+		snapshotChanged = m_ShowSnapshot.Update( eosSyncLib->GetData() );
+
+		if(snapshotChanged && m_ChangeJournal)
+			UpdateJournalReady(eosSyncLib->GetData(), journalReady);
 		eosSyncLib->ClearDirty();
 
-		// flush log messages
-		EosLog::LOG_Q logQ;
-		eosSyncLib->GetLog().Flush(logQ);
-		AddLogQ(logQ);
+		// worst case lock hold times since the last report
+		bool reportLockStats = (m_LockReportTimer.isValid() && m_LockReportTimer.hasExpired(LOCK_REPORT_MS));
+		EosSyncLibThread::sLockStats lockStats[EosSyncLibThread::LOCK_HOLDER_COUNT];
+		if( reportLockStats )
+		{
+			m_EosSyncLibThread->GetLockStats(lockStats, /*reset*/true);
+			m_LockReportTimer.start();
+		}
 
 		m_EosSyncLibThread->UnlockEosSyncLib();
+
+		if( snapshotChanged )
+		{
+			PublishSharedSnapshot();
+			if( m_ChangeJournal )
+			{
+				// one batch pairs up with journalPrev; after a gap, diff whole types instead
+				ChangeHub::BATCHES batches;
+				bool complete = m_ChangeHub.Take(m_JournalSubscription, batches);
+				const ChangeHub::sBatch *batch = ((complete && batches.size()==1) ? batches.front().data() : 0);
+				m_ChangeJournal->Record(journalPrev, m_ShowSnapshot, journalReady, batch, m_ChangeStats.Now());
+			}
+		}
+
+		if( m_ChangeJournalView )
+			m_ChangeJournalView->Update();
+
+		if(snapshotChanged && m_ShowSearchView && m_ShowSearchView->isVisible())
+			m_ShowSearchView->Update(m_ShowSnapshot);
+
+		if( m_SnapshotStore )
+			EnforceSnapshotBudget();
+
+		if( m_QueryServer )
+		{
+			unsigned int dropped = m_QueryServer->GetDroppedClients();
+			if(dropped != m_QueryServerDropped)
+			{
+				AddLogInfo( QString("Query server disconnected %1 clients that weren't reading their answers; raise %2 for larger queries").arg(dropped-m_QueryServerDropped).arg(SETTING_QUERY_BUFFER_KB) );
+				m_QueryServerDropped = dropped;
+			}
+		}
+
+		m_ShowDataGrid->UpdateDetails(m_ShowSnapshot);
+
+		if(m_OscScheduler && m_OscScheduler->isFinished())
+			StopScript();
+
+		LatencyProbe::sStats latency;
+		m_EosSyncLibThread->GetLatencyProbe().GetStats(latency);
+		QString latencyText;
+		LatencyProbe::FormatStats(latency, latencyText);
+
+		// what the relay's loopback hop adds, by the mean of each, since
+		// the histogram buckets are coarser than the difference
+		LatencyProbe::sStats relayLatency;
+		m_EosSyncLibThread->GetRelayProbe().GetStats(relayLatency);
+		if(latency.count!=0 && relayLatency.count!=0)
+			latencyText.append( QString(", relay +%1 ms").arg((relayLatency.meanNS - latency.meanNS)/1000000.0, 0, 'f', 2) );
+		m_Latency->setText(latencyText);
+
+		// the console forgets subscriptions when the connection drops
+		if( !connected )
+			m_LiveSubscribed = false;
+		else if(!m_LiveSubscribed && m_LiveState.IsEnabled())
+			SubscribeLiveState();
+
+		FlushLog();
+
+		if( reportLockStats )
+		{
+			QString str("Lock hold max/avg");
+			for(int i=0; i<EosSyncLibThread::LOCK_HOLDER_COUNT; i++)
+			{
+				const EosSyncLibThread::sLockStats &stats = lockStats[i];
+				double avgMS = (stats.count==0) ? 0 : (stats.totalUS/static_cast<double>(stats.count))/1000.0;
+				str.append( QString(", %1 %2/%3 ms")
+					.arg( EosSyncLibThread::GetLockHolderName(static_cast<EosSyncLibThread::EnumLockHolder>(i)) )
+					.arg(stats.maxUS/1000.0, 0, 'f', 2)
+					.arg(avgMS, 0, 'f', 2) );
+			}
+			AddLogDebug(str);
+
+			if(latency.count!=0 || latency.lost!=0)
+				AddLogDebug( QString("Console %1 over %2 probes").arg(latencyText).arg(latency.count) );
+		}
 	}
 
 	if( !m_EosSyncLibThread->isRunning() )
 	{
 		m_EosSyncLibThreadTimer->stop();
+		StopScript();
+		StopOscRelay();
+		FlushLog();
 		UpdateUI();
 	}
 }
@@ -442,21 +1506,91 @@ void MainWindow::onTick()
 void MainWindow::onStartStopClicked(bool /*checked*/)
 {
 	if( m_EosSyncLibThread->isRunning() )
-	{
-		m_EosSyncLibThreadTimer->stop();
-		m_EosSyncLibThread->Stop();
-	}
+		Disconnect();
 	else
 	{
 		QString ip( m_Ip->text() );
 		unsigned short port = static_cast<unsigned short>( m_Port->value() );
 		m_Settings.setValue(SETTING_IP, ip);
 		m_Settings.setValue(SETTING_PORT, port);
+		Connect(ip, port);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-		m_EosSyncLibThread = new EosSyncLibThread();
+void MainWindow::Disconnect()
+{
+	if( m_EosSyncLibThread->isRunning() )
+	{
+		m_EosSyncLibThreadTimer->stop();
+		StopScript();
+		m_EosSyncLibThread->Stop();
+		StopOscRelay();
+		FlushLog();
+	}
+
+	UpdateUI();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::Connect(const QString &ip, unsigned short port)
+{
+	// a fresh EosSyncLib per connection; the relay, a script and an export
+	// hold on to the old thread, so they go first, even if it stopped on its own
+	StopScript();
+	StopOscRelay();
+	CancelExport();
+	delete m_EosSyncLibThread;
+	m_EosSyncLibThread = new EosSyncLibThread();
+	InitLogQueue();
+	m_LogDroppedCount = 0;
+	m_LogDropped->hide();
+
+	m_ChangeStats.Clear();
+	if( m_ChangeJournal )
+		m_ChangeJournal->Clear();
+	memset(m_JournalReady, 0, sizeof(m_JournalReady));
+	m_LiveState.Clear();
+	m_LiveSubscribed = false;
+	// round trips straight to the console over the console link, and through
+	// the relay as well when there is one, to show what the relay adds
+	unsigned int pingMS = m_Settings.value(SETTING_PING_INTERVAL, 1000).toUInt();
+	m_Settings.setValue(SETTING_PING_INTERVAL, pingMS);
+	m_Latency->clear();
+	m_EosSyncLibThread->GetLatencyProbe().Clear();
+	m_EosSyncLibThread->GetLatencyProbe().SetInterval(pingMS);
+	m_EosSyncLibThread->GetRelayProbe().Clear();
+	m_EosSyncLibThread->SetConsoleTarget(ip, port);
+
+	// console's OSC UDP receive port for operator commands, 0 to send them over TCP;
+	// scripted sends stay on TCP, so with both in use they are not ordered
+	// with the commands typed in the Send box
+	unsigned short udpPort = static_cast<unsigned short>( m_Settings.value(SETTING_UDP_COMMAND_PORT,0).toUInt() );
+	m_Settings.setValue(SETTING_UDP_COMMAND_PORT, udpPort);
+	m_EosSyncLibThread->SetUdpTarget(ip, udpPort);
+
+	// TCP operator commands on the console link, clear of EosSyncLib::Tick()
+	// and the initial sync; off puts them back on EosSyncLib's connection, in
+	// order with its own traffic
+	bool commandsOnLink = m_Settings.value(SETTING_COMMAND_LINK, true).toBool();
+	m_Settings.setValue(SETTING_COMMAND_LINK, commandsOnLink);
+	m_EosSyncLibThread->SetCommandsOnLink(commandsOnLink);
+
+	unsigned short relayPort = 0;
+	if( StartOscRelay(ip,port,relayPort) )
+	{
+		m_EosSyncLibThread->GetRelayProbe().SetInterval(pingMS);
+		m_EosSyncLibThread->Start("127.0.0.1", relayPort);
+	}
+	else
+	{
+		m_EosSyncLibThread->GetRelayProbe().SetInterval(0);
 		m_EosSyncLibThread->Start(ip, port);
-		m_EosSyncLibThreadTimer->start(60);
 	}
+	m_EosSyncLibThreadTimer->start(UI_TICK_MS);
+	m_LockReportTimer.start();
 
 	UpdateUI();
 }
@@ -479,6 +1613,289 @@ void MainWindow::onOpenLogClicked(bool /*checked*/)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void MainWindow::onViewLogClicked(bool /*checked*/)
+{
+	if( !m_LogFile.isOpen() )
+	{
+		AddLogInfo( QString("Log file %1 could not be opened").arg(QDir::toNativeSeparators(m_LogFile.fileName())) );
+		return;
+	}
+
+	m_LogStream.flush();
+
+	if( !m_LogFileView )
+		m_LogFileView = new LogFileView(m_LogFile.fileName(), this);
+
+	m_LogFileView->show();
+	m_LogFileView->raise();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onChangesClicked(bool /*checked*/)
+{
+	if( !m_ChangeJournal )
+	{
+		AddLogInfo( QString("Change journal is disabled, set %1 to enable it").arg(SETTING_JOURNAL_CAPACITY) );
+		return;
+	}
+
+	if( !m_ChangeJournalView )
+		m_ChangeJournalView = new ChangeJournalView(*m_ChangeJournal, m_ChangeStats, this);
+
+	m_ChangeJournalView->show();
+	m_ChangeJournalView->raise();
+	m_ChangeJournalView->Update();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onLiveClicked(bool /*checked*/)
+{
+	if( !m_LiveStatePanel )
+	{
+		m_LiveStatePanel = new LiveStatePanel(m_LiveState, m_ChangeStats, this);
+		connect(m_LiveStatePanel, SIGNAL(visibilityChanged(bool)), this, SLOT(onLiveVisibilityChanged(bool)));
+	}
+
+	m_LiveStatePanel->show();
+	m_LiveStatePanel->raise();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onLiveVisibilityChanged(bool visible)
+{
+	if(visible && m_EosSyncLibThread->isRunning() && !m_OscRelay)
+		AddLogInfo( QString("Live values need the console traffic tap, set %1 and reconnect").arg(SETTING_CONSOLE_TAP) );
+
+	// subscribed on the next tick once connected
+	if( !visible )
+		m_LiveSubscribed = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onSearchClicked(bool /*checked*/)
+{
+	if( !m_ShowSearchView )
+	{
+		m_ShowSearchView = new ShowSearchView(this, m_ChangeHub);
+		connect(m_ShowSearchView, SIGNAL(targetSelected(unsigned int,int,const QString&,int)), this, SLOT(onSearchTargetSelected(unsigned int,int,const QString&,int)));
+	}
+
+	m_ShowSearchView->show();
+	m_ShowSearchView->raise();
+	m_ShowSearchView->Update(m_ShowSnapshot);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onSearchTargetSelected(unsigned int targetType, int listId, const QString &number, int part)
+{
+	m_ShowDataGrid->ShowTarget(targetType, listId, number, part);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::CancelExport()
+{
+	if( m_ShowExport )
+	{
+		AddLogInfo( QString("Export to %1 cancelled").arg(m_ShowExport->GetPath()) );
+		delete m_ShowExport;
+		m_ShowExport = 0;
+		m_ExportButton->setText("Export...");
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onExportClicked(bool /*checked*/)
+{
+	if( m_ShowExport )
+	{
+		CancelExport();
+		return;
+	}
+
+	if( !m_EosSyncLibThread )
+		return;
+
+	QString path = QFileDialog::getSaveFileName(this, "Export Show Data", m_Settings.value(SETTING_EXPORT_PATH).toString(), "JSON Lines (*.jsonl);;CSV (*.csv)");
+	if( path.isEmpty() )
+		return;
+	m_Settings.setValue(SETTING_EXPORT_PATH, path);
+
+	m_ShowExport = new ShowExport();
+	connect(m_ShowExport, SIGNAL(finished()), this, SLOT(onExportFinished()));
+	QString error;
+	if( !m_ShowExport->Start(*m_EosSyncLibThread,path,ShowExport::GetFormatForPath(path),error) )
+	{
+		AddLogInfo( QString("Unable to export to %1: %2").arg(path).arg(error) );
+		delete m_ShowExport;
+		m_ShowExport = 0;
+		return;
+	}
+
+	AddLogInfo( QString("Exporting show data to %1").arg(path) );
+	m_ExportButton->setText("Cancel Export");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onExportFinished()
+{
+	// may be queued from an export that was cancelled since
+	if(!m_ShowExport || !m_ShowExport->isFinished())
+		return;
+
+	ShowExport::sProgress progress;
+	m_ShowExport->GetProgress(progress);
+	if( progress.error.isEmpty() )
+	{
+		AddLogInfo( QString("Exported %1 targets to %2, %3 MB in %4 s")
+			.arg(progress.targets)
+			.arg(m_ShowExport->GetPath())
+			.arg(progress.bytes/(1024.0*1024.0), 0, 'f', 1)
+			.arg(progress.elapsedMS/1000.0, 0, 'f', 2) );
+	}
+	else
+		AddLogInfo( QString("Export to %1 failed: %2").arg(m_ShowExport->GetPath()).arg(progress.error) );
+
+	delete m_ShowExport;
+	m_ShowExport = 0;
+	m_ExportButton->setText("Export...");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onFindClicked(bool /*checked*/)
+{
+	if( m_Discovery )
+		return;
+
+	ConsoleDiscovery::sSettings settings;
+	settings.ports.clear();
+	settings.ports.push_back( static_cast<unsigned short>(m_Port->value()) );
+
+	m_Discovery = new ConsoleDiscovery();
+	connect(m_Discovery, SIGNAL(finished()), this, SLOT(onDiscoveryFinished()));
+	m_Discovery->Start(settings);
+	m_FindButton->setEnabled(false);
+	m_FindButton->setText("Finding...");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onDiscoveryFinished()
+{
+	if(!m_Discovery || !m_Discovery->isFinished())
+		return;
+
+	ConsoleDiscovery::CONSOLES consoles;
+	m_Discovery->GetConsoles(consoles);
+	ConsoleDiscovery::sStats stats;
+	m_Discovery->GetStats(stats);
+	delete m_Discovery;
+	m_Discovery = 0;
+
+	m_FindButton->setText("Find");
+	UpdateUI();
+
+	AddLogInfo( QString("Found %1 consoles, %2 addresses probed in %3 ms").arg(consoles.size()).arg(stats.probes).arg(stats.elapsedMS) );
+	if( consoles.empty() )
+		return;
+
+	QMenu menu(this);
+	for(ConsoleDiscovery::CONSOLES::const_iterator i=consoles.begin(); i!=consoles.end(); i++)
+	{
+		QAction *action = menu.addAction( ConsoleDiscovery::GetConsoleName(*i) );
+		action->setData( static_cast<int>(i - consoles.begin()) );
+		AddLogDebug( QString("Console at %1, connected in %2 ms").arg(action->text()).arg(i->connectMS) );
+	}
+
+	QAction *action = menu.exec( m_FindButton->mapToGlobal(QPoint(0,m_FindButton->height())) );
+	if(action && m_Ip->isEnabled())
+	{
+		const ConsoleDiscovery::sConsole &console = consoles[action->data().toInt()];
+		m_Ip->setText( QHostAddress(console.ip).toString() );
+		m_Port->setValue(console.port);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::SubscribeLiveState()
+{
+	// active/pending cue and wheels are sent unasked, faders only for a configured bank
+	int faderCount = m_Settings.value(SETTING_LIVE_FADER_COUNT, 10).toInt();
+	m_Settings.setValue(SETTING_LIVE_FADER_COUNT, faderCount);
+	if(faderCount > 0)
+		m_EosSyncLibThread->SendOscString( QString("/eos/fader/1/config/%1").arg(faderCount).toStdString(), EosSyncLibThread::SEND_PRIORITY_REFRESH );
+
+	m_LiveSubscribed = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onScriptClicked(bool /*checked*/)
+{
+	if( m_OscScheduler )
+	{
+		StopScript();
+		return;
+	}
+
+	if(!m_EosSyncLibThread || !m_EosSyncLibThread->isRunning())
+		return;
+
+	QString path = QFileDialog::getOpenFileName(this, "Run Script", m_Settings.value(SETTING_SCRIPT_PATH).toString());
+	if( path.isEmpty() )
+		return;
+	m_Settings.setValue(SETTING_SCRIPT_PATH, path);
+
+	m_OscScheduler = new OscScheduler();
+	QString error;
+	if( !m_OscScheduler->Load(path,error) )
+	{
+		AddLogInfo( QString("Unable to load script %1: %2").arg(path).arg(error) );
+		delete m_OscScheduler;
+		m_OscScheduler = 0;
+		return;
+	}
+
+	AddLogInfo( QString("Running script %1, %2 commands").arg(path).arg(m_OscScheduler->GetCommandCount()) );
+	m_OscScheduler->Start(*m_EosSyncLibThread);
+	m_ScriptButton->setText("Stop Script");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::StopScript()
+{
+	if( !m_OscScheduler )
+		return;
+
+	m_OscScheduler->Stop();
+
+	QStringList summary;
+	QStringList details;
+	m_OscScheduler->GetReport(summary, details);
+	for(QStringList::const_iterator i=details.begin(); i!=details.end(); i++)
+		AddLogDebug(*i);
+	for(QStringList::const_iterator i=summary.begin(); i!=summary.end(); i++)
+		AddLogInfo(*i);
+
+	delete m_OscScheduler;
+	m_OscScheduler = 0;
+
+	if( m_ScriptButton )
+		m_ScriptButton->setText("Run Script...");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void MainWindow::onSendClicked(bool /*checked*/)
 {
 	SendText();
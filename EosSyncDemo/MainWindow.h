@@ -30,7 +30,45 @@
 #include "QtInclude.h"
 #endif
 
+#ifndef LOG_QUEUE_H
+#include "LogQueue.h"
+#endif
+
+#ifndef SHOW_SNAPSHOT_H
+#include "ShowSnapshot.h"
+#endif
+
+#ifndef CHANGE_STATS_H
+#include "ChangeStats.h"
+#endif
+
+#ifndef LIVE_STATE_H
+#include "LiveState.h"
+#endif
+
+#ifndef LATENCY_PROBE_H
+#include "LatencyProbe.h"
+#endif
+
+#ifndef CONSOLE_LINK_H
+#include "ConsoleLink.h"
+#endif
+
+#include <deque>
+
 class ShowDataGrid;
+class QueryServer;
+class SharedSnapshot;
+class OscRelay;
+class ChangeJournal;
+class ChangeJournalView;
+class OscScheduler;
+class ShowSearchView;
+class SnapshotStore;
+class ShowExport;
+class ConsoleDiscovery;
+class OscBlockView;
+class LogFileView;
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -38,23 +76,96 @@ class EosSyncLibThread
 	: public QThread
 {
 public:
+	// Operator commands go out on the console link when it is up, so they
+	// never wait on the EosSyncLib lock; the queue's user priority is only
+	// for when they fall back to EosSyncLib's connection. There is no class
+	// for the initial sync's bulk requests: EosSyncLib makes those itself
+	// inside Tick() and they never pass through this queue, so there is
+	// nothing here to hold back behind operator commands.
+	enum EnumSendPriority
+	{
+		SEND_PRIORITY_USER,		// operator commands, sent ahead of everything else
+		SEND_PRIORITY_REFRESH,	// change-driven refresh requests
+
+		SEND_PRIORITY_COUNT
+	};
+
+	enum EnumLockHolder
+	{
+		LOCK_HOLDER_TICK,	// EosSyncLib::Tick() on the sync thread
+		LOCK_HOLDER_SEND,	// handing queued packets to EosSyncLib
+		LOCK_HOLDER_UI,		// LockEosSyncLib() callers
+
+		LOCK_HOLDER_COUNT
+	};
+
+	struct sLockStats
+	{
+		sLockStats() : count(0), totalUS(0), maxUS(0) {}
+		unsigned int	count;
+		qint64			totalUS;
+		qint64			maxUS;
+	};
+
 	EosSyncLibThread();
 	virtual ~EosSyncLibThread();
 
 	virtual void Start(const QString &ip, unsigned short port);
 	virtual void Stop();
+	virtual void SetUdpTarget(const QString &ip, unsigned short port);
+	virtual void SetConsoleTarget(const QString &ip, unsigned short port);
+	virtual void SetCommandsOnLink(bool onLink) {m_CommandsOnLink = onLink;}
+	virtual bool IsConsoleLinkConnected() const {return m_ConsoleLink.IsConnected();}
+	virtual bool HasUdpTarget() const {return (m_UdpPort != 0);}
 	virtual EosSyncLib* LockEosSyncLib();
 	virtual void UnlockEosSyncLib();
-	virtual void SendOscString(const std::string &str);
+	virtual void SendOscString(const std::string &str, EnumSendPriority priority=SEND_PRIORITY_USER);
+	virtual size_t SendOscBlock(const QStringList &lines, QStringList &errors);
+	virtual void SendNow(OSCPacketWriter &packet);
+	virtual void SetSendSliced(bool sliced) {m_SendSliced = sliced;}
+	virtual bool Tick(unsigned int sendBudgetMS);
+	virtual LogQueue& GetLogQueue() {return m_LogQueue;}
+	virtual LatencyProbe& GetLatencyProbe() {return m_LatencyProbe;}
+	virtual LatencyProbe& GetRelayProbe() {return m_RelayProbe;}
+
+	// call with the lock held
+	virtual void GetLockStats(sLockStats *stats, bool reset);
+
+	static const char* GetLockHolderName(EnumLockHolder holder);
 
 protected:
+	typedef std::deque<OSCPacketWriter*> SEND_Q;
+
 	QString			m_Ip;
 	unsigned short	m_Port;
 	bool			m_Run;
 	EosSyncLib		m_EosSyncLib;
 	QMutex			m_Mutex;
+	SEND_Q			m_SendQ[SEND_PRIORITY_COUNT];
+	QString			m_UdpIp;
+	unsigned short	m_UdpPort;		// 0 for none
+	bool			m_CommandsOnLink;	// false keeps TCP operator commands on EosSyncLib's connection
+	bool			m_SendSliced;	// false hands every queued packet over in one lock hold
+	QMutex			m_SendMutex;
+	QWaitCondition	m_SendWait;
+	QElapsedTimer	m_LockTimer;
+	sLockStats		m_LockStats[LOCK_HOLDER_COUNT];
+	LogQueue		m_LogQueue;
+	EosLog::LOG_Q	m_LogQ;
+	QString			m_ConsoleIp;	// empty for the one EosSyncLib connects to
+	unsigned short	m_ConsolePort;
+	LatencyProbe	m_LatencyProbe;	// straight to the console, over m_ConsoleLink
+	ConsoleLink		m_ConsoleLink;	// operator commands and m_LatencyProbe's probes
+	LatencyProbe	m_RelayProbe;	// over EosSyncLib's connection, through the relay when there is one
+	std::string		m_ProbeStr;
 
 	virtual void run();
+	virtual void FlushLog();
+	virtual bool FlushSendQ(unsigned int budgetMS);
+	virtual void ClearSendQ();
+	virtual bool SendOnLink(OSCPacketWriter &packet);
+	virtual void Lock(EnumLockHolder holder);
+	virtual void Unlock(EnumLockHolder holder);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -65,38 +176,106 @@ class MainWindow
 	Q_OBJECT
 
 public:
-	MainWindow(QWidget *parent=0, Qt::WindowFlags f=0);
+	MainWindow(QWidget *parent=0, Qt::WindowFlags f=0, QSettings::Format settingsFormat=QSettings::NativeFormat);
 	virtual ~MainWindow();
 	
 	virtual QSize sizeHint() const {return QSize(640,480);}
 	virtual void AddLogInfo(const QString &text);
+	virtual void AddLogDebug(const QString &text);
 	virtual void AddLogQ(EosLog::LOG_Q &logQ);
 
+	// what the Sync button does, for headless callers like the soak too
+	virtual void Connect(const QString &ip, unsigned short port);
+	virtual void Disconnect();
+	virtual const ShowSnapshot& GetShowSnapshot() const {return m_ShowSnapshot;}
+	virtual const ChangeJournal* GetChangeJournal() const {return m_ChangeJournal;}
+
 private slots:
 	void onTick();
 	void onStartStopClicked(bool checked);
 	void onClearLogClicked(bool checked);
 	void onOpenLogClicked(bool checked);
+	void onViewLogClicked(bool checked);
+	void onChangesClicked(bool checked);
+	void onLiveClicked(bool checked);
+	void onLiveVisibilityChanged(bool visible);
+	void onSearchClicked(bool checked);
+	void onSearchTargetSelected(unsigned int targetType, int listId, const QString &number, int part);
 	void onSendClicked(bool checked);
 	void onSendReturnPressed();
+	void onScriptClicked(bool checked);
+	void onExportClicked(bool checked);
+	void onExportFinished();
+	void onFindClicked(bool checked);
+	void onDiscoveryFinished();
+	void onBlockClicked(bool checked);
+	void onSendBlock(const QStringList &lines);
 
 private:
 	QLineEdit			*m_Ip;
 	QSpinBox			*m_Port;
 	QPushButton			*m_StartStopButton;
+	QLabel				*m_Latency;
 	ShowDataGrid		*m_ShowDataGrid;
 	QListWidget			*m_Log;
+	QLabel				*m_LogDropped;
+	unsigned int		m_LogDroppedCount;
 	QLineEdit			*m_SendText;
 	QPushButton			*m_SendButton;
+	QPushButton			*m_ScriptButton;
+	OscScheduler		*m_OscScheduler;
 	EosSyncLibThread	*m_EosSyncLibThread;
 	QTimer				*m_EosSyncLibThreadTimer;
 	QSettings			m_Settings;
 	int					m_LogDepth;
 	QFile				m_LogFile;
 	QTextStream			m_LogStream;
+	QElapsedTimer		m_LockReportTimer;
+	ShowSnapshot		m_ShowSnapshot;
+	QueryServer			*m_QueryServer;
+	unsigned int		m_QueryServerDropped;
+	SharedSnapshot		*m_SharedSnapshot;
+	unsigned int		m_SharedSnapshotOverflow;
+	OscRelay			*m_OscRelay;
+	ChangeStats			m_ChangeStats;
+	ChangeHub			m_ChangeHub;
+	ChangeJournal		*m_ChangeJournal;
+	ChangeJournalView	*m_ChangeJournalView;
+	int					m_JournalSubscription;
+	bool				m_JournalReady[EosTarget::EOS_TARGET_COUNT];
+	LiveState			m_LiveState;
+	LiveStatePanel		*m_LiveStatePanel;
+	bool				m_LiveSubscribed;
+	ShowSearchView		*m_ShowSearchView;
+	SnapshotStore		*m_SnapshotStore;
+	size_t				m_SnapshotBudget;	// bytes, 0 for none
+	ShowExport			*m_ShowExport;
+	QPushButton			*m_ExportButton;
+	ConsoleDiscovery	*m_Discovery;
+	QPushButton			*m_FindButton;
+	QPushButton			*m_BlockButton;
+	OscBlockView		*m_OscBlockView;
+	LogFileView			*m_LogFileView;
 
 	virtual void UpdateUI();
+	virtual void FlushLog();
+	virtual void UpdateLogDropped();
 	virtual void SendText();
+	virtual void InitLogQueue();
+	virtual void InitQueryServer();
+	virtual void InitSharedSnapshot();
+	virtual void InitSnapshotBudget();
+	virtual void EnforceSnapshotBudget();
+	virtual void PublishSharedSnapshot();
+	virtual bool StartOscRelay(const QString &ip, unsigned short port, unsigned short &relayPort);
+	virtual void StopOscRelay();
+	virtual bool IsShowSnapshotEnabled() const;
+	virtual void UpdateSnapshotTracking();
+	virtual void InitChangeJournal();
+	virtual void UpdateJournalReady(const EosSyncData &syncData, bool *ready);
+	virtual void SubscribeLiveState();
+	virtual void StopScript();
+	virtual void CancelExport();
 
 	static void GetDefaultIP(QString &ip);
 };
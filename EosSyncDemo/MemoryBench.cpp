@@ -0,0 +1,252 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+#include "MemoryBench.h"
+#include "MainWindow.h"
+#include "StandInConsole.h"
+#include "ShowSnapshot.h"
+#include "SnapshotStore.h"
+#include "SoakTest.h"
+#include <stdio.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define MEMORY_BENCH_SYNC_TIMEOUT_MS	300000
+#define MEMORY_BENCH_SETTLE_MS			1000	// after the sync, for the last replies to land
+#define MEMORY_BENCH_SAMPLE_PREFIX		"sample "
+#define BYTES_PER_MB					(1024.0 * 1024.0)
+
+////////////////////////////////////////////////////////////////////////////////
+
+MemoryBench::sSettings::sSettings()
+	: targetsPerType(20000)
+	, patchParts(2)
+	, budgetMB(16)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* MemoryBench::GetModeName(EnumMode mode)
+{
+	switch( mode )
+	{
+		case MODE_LIBRARY:	return "library";
+		case MODE_VIEWED:	return "viewed";
+		case MODE_WHOLE:	return "whole";
+		case MODE_BUDGET:	return "budget";
+		default:			break;
+	}
+
+	return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool MemoryBench::GetModeForName(const char *name, EnumMode &mode)
+{
+	for(int i=0; i<MODE_COUNT; i++)
+	{
+		if(strcmp(name,GetModeName(static_cast<EnumMode>(i))) == 0)
+		{
+			mode = static_cast<EnumMode>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int MemoryBench::RunMode(const sSettings &settings, EnumMode mode)
+{
+	StandInConsole::sSettings consoleSettings;
+	consoleSettings.targetsPerType = settings.targetsPerType;
+	consoleSettings.patchParts = settings.patchParts;
+	StandInConsole console(consoleSettings);
+	unsigned short port = 0;
+	if( !console.Listen(port) )
+	{
+		printf("stand-in console unable to listen on loopback\n");
+		return 1;
+	}
+
+	EosSyncLibThread syncThread;
+	syncThread.Start("127.0.0.1", port);
+
+	QElapsedTimer timer;
+	timer.start();
+	bool synced = false;
+	while(!synced && syncThread.isRunning() && !timer.hasExpired(MEMORY_BENCH_SYNC_TIMEOUT_MS))
+	{
+		EosSyncLib *eosSyncLib = syncThread.LockEosSyncLib();
+		synced = (eosSyncLib->IsConnected() && eosSyncLib->GetData().GetStatus().GetValue()==EosSyncStatus::SYNC_STATUS_COMPLETE);
+		syncThread.UnlockEosSyncLib();
+
+		EosLog::LOG_Q logQ;
+		syncThread.GetLogQueue().Pop(logQ, LogQueue::DEFAULT_CAPACITY);
+		QThread::msleep(100);
+	}
+
+	if( !synced )
+	{
+		printf("initial sync did not complete, the stand-in console may not match this EosSyncLib\n");
+		syncThread.Stop();
+		return 1;
+	}
+
+	QThread::msleep(MEMORY_BENCH_SETTLE_MS);
+
+	// built the way MainWindow's tick builds it, the first type standing in for
+	// the one open in the details window
+	ShowSnapshot snapshot;
+	SnapshotStore store;
+	EosTarget::EnumEosTargetType viewed = static_cast<EosTarget::EnumEosTargetType>(0);
+	if(mode != MODE_LIBRARY)
+	{
+		for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+			snapshot.SetTracked(static_cast<EosTarget::EnumEosTargetType>(i), mode!=MODE_VIEWED || i==viewed);
+
+		EosSyncLib *eosSyncLib = syncThread.LockEosSyncLib();
+		snapshot.Update( eosSyncLib->GetData() );
+		eosSyncLib->ClearDirty();
+		syncThread.UnlockEosSyncLib();
+	}
+
+	if(mode == MODE_BUDGET)
+	{
+		QString error;
+		if( !store.Open(error) )
+		{
+			printf("unable to open snapshot store: %s\n", error.toUtf8().constData());
+			syncThread.Stop();
+			return 1;
+		}
+
+		snapshot.SetStore(&store);
+		ShowSnapshot::SPILLS spills;
+		snapshot.SpillToBudget(static_cast<size_t>(settings.budgetMB)*1024*1024, viewed, spills);
+	}
+
+	size_t snapshotBytes = 0;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		snapshotBytes += snapshot.GetResidentBytes( static_cast<EosTarget::EnumEosTargetType>(i) );
+
+	// sampled while still connected, as the app would be
+	SoakTest::sSample sample;
+	SoakTest::GetSample(sample);
+	printf(MEMORY_BENCH_SAMPLE_PREFIX "%lld %lld %lld\n",
+		static_cast<long long>(sample.rssBytes),
+		static_cast<long long>(sample.heapBytes),
+		static_cast<long long>(snapshotBytes));
+	fflush(stdout);
+
+	syncThread.Stop();
+	console.Stop();
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void PrintMB(const char *name, qint64 bytes, qint64 floorBytes)
+{
+	if(bytes < 0)
+		printf("  %s n/a", name);
+	else if(floorBytes < 0)
+		printf("  %s %.1f MB", name, bytes/BYTES_PER_MB);
+	else
+		printf("  %s %.1f MB (%+.1f)", name, bytes/BYTES_PER_MB, (bytes-floorBytes)/BYTES_PER_MB);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int MemoryBench::Run(const sSettings &settings, const QString &program)
+{
+	printf("Memory once synced, %u targets per type, %u patch parts per channel, %u MB snapshot budget; one process per mode, change from library in brackets\n",
+		settings.targetsPerType, settings.patchParts, settings.budgetMB);
+	fflush(stdout);
+
+	int result = 0;
+	qint64 floorRss = -1;
+	qint64 floorHeap = -1;
+	for(int i=0; i<MODE_COUNT; i++)
+	{
+		EnumMode mode = static_cast<EnumMode>(i);
+		QStringList args;
+		args << "--bench-memory-mode"
+			<< GetModeName(mode)
+			<< QString::number(settings.targetsPerType)
+			<< QString::number(settings.patchParts)
+			<< QString::number(settings.budgetMB);
+
+		QProcess process;
+		process.setProcessChannelMode(QProcess::MergedChannels);
+		process.start(program, args);
+		bool finished = process.waitForFinished(MEMORY_BENCH_SYNC_TIMEOUT_MS + 60000);
+		QList<QByteArray> lines( process.readAll().split('\n') );
+
+		qint64 values[3] = {-1, -1, -1};
+		bool sampled = false;
+		for(int j=0; j<lines.size(); j++)
+		{
+			const QByteArray &line = lines[j];
+			if( !line.startsWith(MEMORY_BENCH_SAMPLE_PREFIX) )
+				continue;
+
+			QList<QByteArray> fields( line.mid(sizeof(MEMORY_BENCH_SAMPLE_PREFIX)-1).trimmed().split(' ') );
+			for(int k=0; k<fields.size() && k<3; k++)
+				values[k] = fields[k].toLongLong();
+			sampled = true;
+		}
+
+		if(!finished || !sampled || process.exitCode()!=0)
+		{
+			printf("  %-8s failed:", GetModeName(mode));
+			for(int j=0; j<lines.size(); j++)
+			{
+				if( !lines[j].trimmed().isEmpty() )
+					printf(" %s", lines[j].trimmed().constData());
+			}
+			printf("\n");
+			if( !finished )
+				process.kill();
+			result = 1;
+			continue;
+		}
+
+		if(mode == MODE_LIBRARY)
+		{
+			floorRss = values[0];
+			floorHeap = values[1];
+		}
+
+		printf("  %-8s", GetModeName(mode));
+		PrintMB("rss", values[0], (mode==MODE_LIBRARY) ? -1 : floorRss);
+		PrintMB("heap", values[1], (mode==MODE_LIBRARY) ? -1 : floorHeap);
+		PrintMB("snapshot resident", values[2], -1);
+		printf("\n");
+		fflush(stdout);
+	}
+
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,72 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+#pragma once
+#ifndef MEMORY_BENCH_H
+#define MEMORY_BENCH_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Headless measure of what the app's own copy of the show costs in memory.
+//
+// A stand-in console on loopback serves a large synthetic show to an
+// EosSyncLibThread, and once the initial sync completes the process is
+// sampled for resident memory and heap in use. Each mode runs in a child
+// process of its own, since memory freed by one would rarely go back to
+// the system before the next was sampled:
+//	library		EosSyncLib alone, the floor the app can't go below
+//	viewed		plus a ShowSnapshot of one type, as with no whole show consumers
+//	whole		plus a ShowSnapshot of every type, as with any of them enabled
+//	budget		the same, spilled to a SnapshotStore down to SnapshotBudgetMB
+class MemoryBench
+{
+public:
+	enum EnumMode
+	{
+		MODE_LIBRARY,
+		MODE_VIEWED,
+		MODE_WHOLE,
+		MODE_BUDGET,
+
+		MODE_COUNT
+	};
+
+	struct sSettings
+	{
+		sSettings();
+		unsigned int	targetsPerType;
+		unsigned int	patchParts;		// per channel
+		unsigned int	budgetMB;
+	};
+
+	// runs every mode in a child process of program, which must take --bench-memory-mode
+	static int Run(const sSettings &settings, const QString &program);
+	static int RunMode(const sSettings &settings, EnumMode mode);
+
+	static const char* GetModeName(EnumMode mode);
+	static bool GetModeForName(const char *name, EnumMode &mode);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,99 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "OscBlockView.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscBlockView::OscBlockView(QWidget *parent)
+	: QWidget(parent, Qt::Window)
+{
+	setWindowTitle("Send Block");
+
+	QGridLayout *layout = new QGridLayout(this);
+
+	m_Text = new QTextEdit(this);
+	m_Text->setAcceptRichText(false);
+	m_Text->setLineWrapMode(QTextEdit::NoWrap);
+	QFont fnt("Monospace");
+	fnt.setStyleHint(QFont::TypeWriter);
+	m_Text->setFont(fnt);
+	m_Text->setToolTip("One command per line, like /eos/sub/1=0.75\nBlank lines and lines starting with # are skipped");
+	layout->addWidget(m_Text, 0, 0, 1, 2);
+
+	QPushButton *button = new QPushButton("Load...", this);
+	connect(button, SIGNAL(clicked(bool)), this, SLOT(onLoadClicked(bool)));
+	layout->addWidget(button, 1, 0);
+
+	m_Send = new QPushButton("Send", this);
+	connect(m_Send, SIGNAL(clicked(bool)), this, SLOT(onSendClicked(bool)));
+	layout->addWidget(m_Send, 1, 1);
+
+	m_Result = new QLabel(this);
+	QPalette resultPal( m_Result->palette() );
+	resultPal.setColor(QPalette::WindowText, MUTED_COLOR);
+	m_Result->setPalette(resultPal);
+	m_Result->setWordWrap(true);
+	layout->addWidget(m_Result, 2, 0, 1, 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscBlockView::SetSendEnabled(bool enabled)
+{
+	m_Send->setEnabled(enabled);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscBlockView::SetResult(const QString &text)
+{
+	m_Result->setText(text);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscBlockView::onLoadClicked(bool /*checked*/)
+{
+	QString path = QFileDialog::getOpenFileName(this, "Load Commands", m_Path);
+	if( path.isEmpty() )
+		return;
+
+	QFile file(path);
+	if( !file.open(QIODevice::ReadOnly|QIODevice::Text) )
+	{
+		SetResult( QString("Unable to open %1: %2").arg(path).arg(file.errorString()) );
+		return;
+	}
+
+	m_Path = path;
+	m_Text->setPlainText( QString::fromUtf8(file.readAll()) );
+	SetResult( QString("Loaded %1").arg(path) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscBlockView::onSendClicked(bool /*checked*/)
+{
+	emit sendRequested( m_Text->toPlainText().split('\n') );
+}
+
+////////////////////////////////////////////////////////////////////////////////
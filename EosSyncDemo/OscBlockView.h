@@ -0,0 +1,67 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef OSC_BLOCK_VIEW_H
+#define OSC_BLOCK_VIEW_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A block of OSC commands, pasted or loaded from a file, sent all at once.
+// One command per line in the Send box's format; blank lines and lines
+// starting with '#' are skipped. Over UDP the block goes as bundles of up to
+// a datagram each; over TCP it goes as one bundle on the console link, and
+// is refused while the link is down. How the block went out, or why it
+// didn't, is reported with SetResult(), and per bundle timing goes to the log.
+class OscBlockView
+	: public QWidget
+{
+	Q_OBJECT
+
+public:
+	OscBlockView(QWidget *parent);
+
+	virtual void SetSendEnabled(bool enabled);
+	virtual void SetResult(const QString &text);
+
+	virtual QSize sizeHint() const {return QSize(520,420);}
+
+signals:
+	void sendRequested(const QStringList &lines);
+
+private slots:
+	void onLoadClicked(bool checked);
+	void onSendClicked(bool checked);
+
+protected:
+	QTextEdit		*m_Text;
+	QPushButton		*m_Send;
+	QLabel			*m_Result;
+	QString			m_Path;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
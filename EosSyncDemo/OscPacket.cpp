@@ -0,0 +1,390 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "OscPacket.h"
+#include <stdio.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define BUNDLE_TAG		"#bundle"
+#define BUNDLE_TAG_SIZE	8		// including terminator
+#define BUNDLE_HEADER	16		// tag + time tag
+
+////////////////////////////////////////////////////////////////////////////////
+
+static quint32 ReadUInt32(const char *data)
+{
+	const unsigned char *p = reinterpret_cast<const unsigned char*>(data);
+	return ((static_cast<quint32>(p[0])<<24) | (static_cast<quint32>(p[1])<<16) | (static_cast<quint32>(p[2])<<8) | static_cast<quint32>(p[3]));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static quint64 ReadUInt64(const char *data)
+{
+	return ((static_cast<quint64>(ReadUInt32(data))<<32) | ReadUInt32(data+4));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscPacket::Stream::Stream()
+	: m_Pos(0)
+	, m_Corrupt(false)
+	, m_SkipOversize(false)
+	, m_Skip(0)
+	, m_Skipped(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscPacket::Stream::Append(const char *data, int size)
+{
+	if( m_Corrupt )
+		return;
+
+	// the rest of an oversized packet being skipped
+	if(m_Skip != 0)
+	{
+		quint32 n = qMin(m_Skip, static_cast<quint32>(size));
+		m_Skip -= n;
+		data += n;
+		size -= static_cast<int>(n);
+		if(size == 0)
+			return;
+	}
+
+	// drop what has already been consumed before growing
+	if(m_Pos != 0)
+	{
+		m_Buffer.remove(0, m_Pos);
+		m_Pos = 0;
+	}
+
+	m_Buffer.append(data, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscPacket::Stream::Next(QByteArray &packet)
+{
+	if( m_Corrupt )
+		return false;
+
+	int available = (m_Buffer.size() - m_Pos);
+	if(available < 4)
+		return false;
+
+	quint32 size = ReadUInt32(m_Buffer.constData() + m_Pos);
+	if(size > MAX_PACKET_SIZE)
+	{
+		if( !m_SkipOversize )
+		{
+			m_Corrupt = true;
+			m_Buffer.clear();
+			m_Pos = 0;
+			return false;
+		}
+
+		// the length still says where the next packet starts
+		m_Skipped++;
+		quint32 buffered = static_cast<quint32>(available - 4);
+		if(size <= buffered)
+		{
+			m_Pos += (4 + static_cast<int>(size));
+			return Next(packet);
+		}
+
+		m_Skip = (size - buffered);
+		m_Buffer.clear();
+		m_Pos = 0;
+		return false;
+	}
+
+	if(available < static_cast<int>(4+size))
+		return false;
+
+	packet = m_Buffer.mid(m_Pos+4, static_cast<int>(size));
+	m_Pos += (4 + static_cast<int>(size));
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscPacket::Stream::Clear()
+{
+	m_Buffer.clear();
+	m_Pos = 0;
+	m_Corrupt = false;
+	m_Skip = 0;
+	m_Skipped = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscPacket::Boundary::Boundary()
+	: m_HeaderLen(0)
+	, m_Remaining(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscPacket::Boundary::Consume(const char *data, int size)
+{
+	while(size > 0)
+	{
+		if(m_Remaining != 0)
+		{
+			quint32 n = qMin(m_Remaining, static_cast<quint32>(size));
+			m_Remaining -= n;
+			data += n;
+			size -= static_cast<int>(n);
+			continue;
+		}
+
+		m_Header[m_HeaderLen++] = *data++;
+		size--;
+		if(m_HeaderLen == 4)
+		{
+			m_Remaining = ReadUInt32(m_Header);
+			m_HeaderLen = 0;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscPacket::Boundary::Clear()
+{
+	m_HeaderLen = 0;
+	m_Remaining = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscPacket::AppendFrame(const char *packet, int size, QByteArray &out)
+{
+	char header[4];
+	header[0] = static_cast<char>((size >> 24) & 0xff);
+	header[1] = static_cast<char>((size >> 16) & 0xff);
+	header[2] = static_cast<char>((size >> 8) & 0xff);
+	header[3] = static_cast<char>(size & 0xff);
+	out.append(header, 4);
+	out.append(packet, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscPacket::IsBundle(const char *packet, int size)
+{
+	return (size>=BUNDLE_HEADER && memcmp(packet,BUNDLE_TAG,BUNDLE_TAG_SIZE)==0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// "#bundle", then the time tag 1 for immediately
+static const char sBundleHeader[BUNDLE_HEADER] = {'#','b','u','n','d','l','e','\0', 0,0,0,0, 0,0,0,1};
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscPacket::BuildBundles(const std::vector<QByteArray> &messages, int maxSize, std::vector<QByteArray> &bundles, std::vector<size_t> &counts)
+{
+	QByteArray bundle;
+	size_t count = 0;
+	for(std::vector<QByteArray>::const_iterator i=messages.begin(); i!=messages.end(); i++)
+	{
+		const QByteArray &message = *i;
+		bool bare = (BUNDLE_HEADER+4+message.size() > maxSize);
+		if(count!=0 && (bare || bundle.size()+4+message.size()>maxSize))
+		{
+			bundles.push_back(bundle);
+			counts.push_back(count);
+			count = 0;
+		}
+
+		if( bare )
+		{
+			bundles.push_back(message);
+			counts.push_back(1);
+			continue;
+		}
+
+		if(count == 0)
+		{
+			bundle.clear();
+			bundle.reserve(maxSize);
+			bundle.append(sBundleHeader, BUNDLE_HEADER);
+		}
+
+		// each element is preceded by its size, like TCP framing
+		AppendFrame(message.constData(), message.size(), bundle);
+		count++;
+	}
+
+	if(count != 0)
+	{
+		bundles.push_back(bundle);
+		counts.push_back(count);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscPacket::BuildBundle(const std::vector<QByteArray> &messages, QByteArray &bundle)
+{
+	int size = BUNDLE_HEADER;
+	for(std::vector<QByteArray>::const_iterator i=messages.begin(); i!=messages.end(); i++)
+		size += (4 + i->size());
+
+	bundle.clear();
+	bundle.reserve(size);
+	bundle.append(sBundleHeader, BUNDLE_HEADER);
+	for(std::vector<QByteArray>::const_iterator i=messages.begin(); i!=messages.end(); i++)
+		AppendFrame(i->constData(), i->size(), bundle);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscPacket::GetAddress(const char *packet, int size, const char *&address, int &addressLen)
+{
+	if(size<4 || packet[0]!='/')
+		return false;
+
+	const char *end = static_cast<const char*>( memchr(packet,0,size) );
+	if( !end )
+		return false;
+
+	address = packet;
+	addressLen = static_cast<int>(end - packet);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int OscPacket::GetPaddedStringSize(const char *data, int size)
+{
+	const char *end = static_cast<const char*>( memchr(data,0,size) );
+	if( !end )
+		return -1;
+
+	int padded = ((static_cast<int>(end - data) + 4) & ~3);
+	return ((padded <= size) ? padded : -1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscPacket::GetArgsText(const char *packet, int size, std::string &str)
+{
+	if(size<4 || packet[0]!='/')
+		return false;
+
+	int pos = GetPaddedStringSize(packet, size);
+	if(pos < 0)
+		return false;
+
+	str.clear();
+
+	// no type tags, address only
+	if(pos>=size || packet[pos]!=',')
+		return true;
+
+	const char *tags = (packet + pos + 1);
+	int tagsSize = GetPaddedStringSize(packet+pos, size-pos);
+	if(tagsSize < 0)
+		return false;
+	pos += tagsSize;
+
+	char buf[64];
+	for(const char *tag=tags; *tag; tag++)
+	{
+		if(tag != tags)
+			str.append(", ");
+
+		switch( *tag )
+		{
+			case 'i':
+				if(pos+4 > size)
+					return false;
+				sprintf(buf, "%d", static_cast<int>(ReadUInt32(packet+pos)));
+				str.append(buf);
+				pos += 4;
+				break;
+
+			case 'f':
+				{
+					if(pos+4 > size)
+						return false;
+					quint32 bits = ReadUInt32(packet+pos);
+					float f;
+					memcpy(&f, &bits, sizeof(f));
+					sprintf(buf, "%g", f);
+					str.append(buf);
+					pos += 4;
+				}
+				break;
+
+			case 'h':
+				if(pos+8 > size)
+					return false;
+				sprintf(buf, "%lld", static_cast<long long>(ReadUInt64(packet+pos)));
+				str.append(buf);
+				pos += 8;
+				break;
+
+			case 'd':
+				{
+					if(pos+8 > size)
+						return false;
+					quint64 bits = ReadUInt64(packet+pos);
+					double d;
+					memcpy(&d, &bits, sizeof(d));
+					sprintf(buf, "%.17g", d);
+					str.append(buf);
+					pos += 8;
+				}
+				break;
+
+			case 's':
+			case 'S':
+				{
+					int stringSize = GetPaddedStringSize(packet+pos, size-pos);
+					if(stringSize < 0)
+						return false;
+					str.append(packet + pos);
+					pos += stringSize;
+				}
+				break;
+
+			case 'T':	str.append("1");	break;
+			case 'F':	str.append("0");	break;
+			case 'N':
+			case 'I':	break;
+
+			default:
+				return false;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,110 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef OSC_PACKET_H
+#define OSC_PACKET_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Minimal OSC helpers for code that sees raw packets outside of EosSyncLib:
+// OSC 1.0 TCP framing (big endian int32 length before each packet), reading
+// a packet's address without copying it, and a message's arguments as text.
+class OscPacket
+{
+public:
+	enum EnumConstants
+	{
+		MAX_PACKET_SIZE	= 1024*1024
+	};
+
+	// splits a TCP byte stream into packets
+	class Stream
+	{
+	public:
+		Stream();
+
+		virtual void Append(const char *data, int size);
+		virtual bool Next(QByteArray &packet);
+		virtual bool IsCorrupt() const {return m_Corrupt;}
+		virtual void Clear();
+
+		// skip packets over MAX_PACKET_SIZE by their length rather than giving up on the stream
+		virtual void SetSkipOversize(bool skip) {m_SkipOversize = skip;}
+		virtual unsigned int GetSkipped() const {return m_Skipped;}
+
+	protected:
+		QByteArray		m_Buffer;
+		int				m_Pos;
+		bool			m_Corrupt;	// length out of range, framing is lost
+		bool			m_SkipOversize;
+		quint32			m_Skip;		// bytes of an oversized packet still to come
+		unsigned int	m_Skipped;
+	};
+
+	// follows a TCP byte stream that is passed along untouched, to know when
+	// it sits between packets and another packet can be written into it
+	class Boundary
+	{
+	public:
+		Boundary();
+
+		virtual void Consume(const char *data, int size);
+		virtual bool IsAtBoundary() const {return (m_HeaderLen==0 && m_Remaining==0);}
+		virtual void Clear();
+
+	protected:
+		char	m_Header[4];
+		int		m_HeaderLen;
+		quint32	m_Remaining;	// bytes of the current packet still to come
+	};
+
+	static void AppendFrame(const char *packet, int size, QByteArray &out);
+	static bool IsBundle(const char *packet, int size);
+
+	// packs messages in order into bundles of at most maxSize bytes, to be
+	// handled immediately; a message too big to share a bundle goes out bare.
+	// counts has the number of messages in each
+	static void BuildBundles(const std::vector<QByteArray> &messages, int maxSize, std::vector<QByteArray> &bundles, std::vector<size_t> &counts);
+
+	// all of them in one bundle however large, for a stream where size
+	// doesn't matter
+	static void BuildBundle(const std::vector<QByteArray> &messages, QByteArray &bundle);
+
+	// points into the packet, false if it is not a message
+	static bool GetAddress(const char *packet, int size, const char *&address, int &addressLen);
+
+	// a message's arguments for display, separated by ", ", strings as sent
+	static bool GetArgsText(const char *packet, int size, std::string &text);
+
+protected:
+	static int GetPaddedStringSize(const char *data, int size);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
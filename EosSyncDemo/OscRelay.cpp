@@ -0,0 +1,552 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "OscRelay.h"
+#include "MainWindow.h"
+#include "ChangeStats.h"
+#include "LiveState.h"
+#include "OscRoutes.h"
+#include <string.h>
+#include <time.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define OUT_PREFIX				"/eos/out/"
+#define OUT_PREFIX_LEN			9
+#define UDP_CLIENT_TIMEOUT_MS	60000
+#define MAX_UDP_DATAGRAM		65507
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscRelay::sSettings::sSettings()
+	: consolePort(0)
+	, clientTcpPort(0)
+	, clientUdpPort(0)
+	, clientBufferSize(256*1024)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscRelay::OscRelay()
+	: m_SyncThread(0)
+	, m_ChangeStats(0)
+	, m_LiveState(0)
+	, m_RelayPort(0)
+	, m_Listening(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscRelay::~OscRelay()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscRelay::Start(EosSyncLibThread &syncThread, ChangeStats &changeStats, LiveState &liveState, const sSettings &settings, unsigned short &relayPort, QString &error)
+{
+	Stop();
+
+	m_SyncThread = &syncThread;
+	m_ChangeStats = &changeStats;
+	m_LiveState = &liveState;
+	m_Settings = settings;
+	m_RelayPort = 0;
+	m_Listening = false;
+	m_Error.clear();
+
+	// wait for run() to report whether it could listen
+	m_StartMutex.lock();
+	start();
+	m_StartWait.wait(&m_StartMutex);
+	bool listening = m_Listening;
+	relayPort = m_RelayPort;
+	error = m_Error;
+	m_StartMutex.unlock();
+
+	if( !listening )
+		wait();
+
+	return listening;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelay::Stop()
+{
+	// quit() is lost if it lands before exec() has started, so keep asking
+	while( isRunning() )
+	{
+		quit();
+		wait(50);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelay::run()
+{
+	OscRelayWorker worker(*m_SyncThread, *m_ChangeStats, *m_LiveState, m_Settings);
+	unsigned short relayPort = 0;
+	QString error;
+	bool listening = worker.Listen(relayPort, error);
+
+	m_StartMutex.lock();
+	m_Listening = listening;
+	m_RelayPort = relayPort;
+	m_Error = error;
+	m_StartWait.wakeAll();
+	m_StartMutex.unlock();
+
+	if( listening )
+		exec();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscRelayWorker::OscRelayWorker(EosSyncLibThread &syncThread, ChangeStats &changeStats, LiveState &liveState, const OscRelay::sSettings &settings)
+	: m_SyncThread(syncThread)
+	, m_ChangeStats(changeStats)
+	, m_LiveState(liveState)
+	, m_Settings(settings)
+	, m_LibServer(0)
+	, m_Lib(0)
+	, m_Console(0)
+	, m_ConsoleSkipped(0)
+	, m_ClientServer(0)
+	, m_Udp(0)
+	, m_UdpExpireTimer(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscRelayWorker::~OscRelayWorker()
+{
+	for(TCP_CLIENTS::const_iterator i=m_TcpClients.begin(); i!=m_TcpClients.end(); i++)
+		delete *i;
+	m_TcpClients.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscRelayWorker::Listen(unsigned short &relayPort, QString &error)
+{
+	m_LibServer = new QTcpServer(this);
+	m_LibServer->setMaxPendingConnections(1);
+	connect(m_LibServer, SIGNAL(newConnection()), this, SLOT(onLibConnection()));
+	if( !m_LibServer->listen(QHostAddress::LocalHost,0) )
+	{
+		error = m_LibServer->errorString();
+		return false;
+	}
+	relayPort = m_LibServer->serverPort();
+
+	if(m_Settings.clientTcpPort != 0)
+	{
+		m_ClientServer = new QTcpServer(this);
+		connect(m_ClientServer, SIGNAL(newConnection()), this, SLOT(onClientConnection()));
+		if( !m_ClientServer->listen(QHostAddress::LocalHost,m_Settings.clientTcpPort) )
+		{
+			error = QString("TCP port %1: %2").arg(m_Settings.clientTcpPort).arg( m_ClientServer->errorString() );
+			return false;
+		}
+		Log( QString("OSC proxy accepting TCP clients on port %1").arg(m_Settings.clientTcpPort) );
+	}
+
+	if(m_Settings.clientUdpPort != 0)
+	{
+		m_Udp = new QUdpSocket(this);
+		connect(m_Udp, SIGNAL(readyRead()), this, SLOT(onUdpReadyRead()));
+		if( !m_Udp->bind(QHostAddress::LocalHost,m_Settings.clientUdpPort) )
+		{
+			error = QString("UDP port %1: %2").arg(m_Settings.clientUdpPort).arg( m_Udp->errorString() );
+			return false;
+		}
+
+		m_UdpExpireTimer = new QTimer(this);
+		connect(m_UdpExpireTimer, SIGNAL(timeout()), this, SLOT(onExpireUdpClients()));
+		m_UdpExpireTimer->start(UDP_CLIENT_TIMEOUT_MS/4);
+		Log( QString("OSC proxy accepting UDP clients on port %1").arg(m_Settings.clientUdpPort) );
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onLibConnection()
+{
+	while( m_LibServer->hasPendingConnections() )
+	{
+		QTcpSocket *socket = m_LibServer->nextPendingConnection();
+		if( !socket )
+			continue;
+
+		// only one EosSyncLib connection at a time
+		if( m_Lib )
+		{
+			socket->abort();
+			socket->deleteLater();
+			continue;
+		}
+
+		m_Lib = socket;
+		m_Lib->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connect(m_Lib, SIGNAL(readyRead()), this, SLOT(onLibReadyRead()));
+		connect(m_Lib, SIGNAL(disconnected()), this, SLOT(onLibDisconnected()));
+
+		m_ConsolePending.clear();
+		m_LibBoundary.Clear();
+		m_ClientFrames.clear();
+		m_ConsoleStream.Clear();
+		m_ConsoleStream.SetSkipOversize(true);
+		m_ConsoleSkipped = 0;
+		m_Console = new QTcpSocket(this);
+		m_Console->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connect(m_Console, SIGNAL(connected()), this, SLOT(onConsoleConnected()));
+		connect(m_Console, SIGNAL(readyRead()), this, SLOT(onConsoleReadyRead()));
+		connect(m_Console, SIGNAL(disconnected()), this, SLOT(onConsoleDisconnected()));
+		connect(m_Console, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(onConsoleDisconnected()));
+		m_Console->connectToHost(m_Settings.consoleIp, m_Settings.consolePort);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onLibReadyRead()
+{
+	if( !m_Lib )
+		return;
+
+	QByteArray data( m_Lib->readAll() );
+	m_LibBoundary.Consume(data.constData(), data.size());
+	WriteConsole(data);
+
+	if(!m_ClientFrames.isEmpty() && m_LibBoundary.IsAtBoundary())
+	{
+		WriteConsole(m_ClientFrames);
+		m_ClientFrames.clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::WriteConsole(const QByteArray &data)
+{
+	if(m_Console && m_Console->state()==QAbstractSocket::ConnectedState)
+		m_Console->write(data);
+	else
+		m_ConsolePending.append(data);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onLibDisconnected()
+{
+	if( m_Lib )
+	{
+		m_Lib->deleteLater();
+		m_Lib = 0;
+	}
+
+	CloseConsole();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onConsoleConnected()
+{
+	if(m_Console && !m_ConsolePending.isEmpty())
+	{
+		m_Console->write(m_ConsolePending);
+		m_ConsolePending.clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onConsoleReadyRead()
+{
+	if( !m_Console )
+		return;
+
+	qint64 arrivalNS = m_ChangeStats.Now();
+	QByteArray data( m_Console->readAll() );
+	if( m_Lib )
+		m_Lib->write(data);
+
+	m_ConsoleStream.Append(data.constData(), data.size());
+	while( m_ConsoleStream.Next(m_Packet) )
+		OnConsolePacket(m_Packet, arrivalNS);
+
+	if(m_ConsoleStream.GetSkipped() != m_ConsoleSkipped)
+	{
+		m_ConsoleSkipped = m_ConsoleStream.GetSkipped();
+		Log( QString("OSC proxy skipped a console packet over %1 bytes, not copied to clients").arg(OscPacket::MAX_PACKET_SIZE) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onConsoleDisconnected()
+{
+	CloseConsole();
+
+	// EosSyncLib sees the console go away and reconnects through us
+	if( m_Lib )
+		m_Lib->disconnectFromHost();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::CloseConsole()
+{
+	if( m_Console )
+	{
+		m_Console->disconnect(this);
+		m_Console->abort();
+		m_Console->deleteLater();
+		m_Console = 0;
+	}
+
+	m_ConsolePending.clear();
+	m_ClientFrames.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::OnConsolePacket(const QByteArray &packet, qint64 arrivalNS)
+{
+	const char *data = packet.constData();
+	int size = packet.size();
+	if( !OscPacket::IsBundle(data,size) )
+	{
+		const char *address = 0;
+		int addressLen = 0;
+		if(!OscPacket::GetAddress(data,size,address,addressLen) || addressLen<OUT_PREFIX_LEN || strncmp(address,OUT_PREFIX,OUT_PREFIX_LEN)!=0)
+			return;
+
+		OscRoutes::sRoute route;
+		if( OscRoutes::Get().Route(address,addressLen,route) )
+			m_ChangeStats.OnArrival(route.type, arrivalNS);
+		else if( LatencyProbe::IsReplyAddress(address,addressLen) )
+			m_SyncThread.GetRelayProbe().OnReply(data, size);
+		else if( m_LiveState.IsEnabled() )
+			m_LiveState.OnMessage(address, addressLen, data, size, arrivalNS);
+	}
+
+	if(m_TcpClients.empty() && m_UdpClients.empty())
+		return;
+
+	if( !m_TcpClients.empty() )
+	{
+		m_Frame.clear();
+		OscPacket::AppendFrame(data, size, m_Frame);
+
+		for(TCP_CLIENTS::const_iterator i=m_TcpClients.begin(); i!=m_TcpClients.end(); i++)
+		{
+			sTcpClient *client = *i;
+			if(client->socket->bytesToWrite()+m_Frame.size() > static_cast<qint64>(m_Settings.clientBufferSize))
+			{
+				if(client->dropped++ == 0)
+					Log( QString("OSC proxy client %1:%2 is not keeping up, dropping packets").arg(client->socket->peerAddress().toString()).arg(client->socket->peerPort()) );
+				continue;
+			}
+
+			if(client->dropped != 0)
+			{
+				Log( QString("OSC proxy client %1:%2 caught up, %3 packets dropped").arg(client->socket->peerAddress().toString()).arg(client->socket->peerPort()).arg(client->dropped) );
+				client->dropped = 0;
+			}
+
+			client->socket->write(m_Frame);
+		}
+	}
+
+	if(m_Udp && size<=MAX_UDP_DATAGRAM)
+	{
+		for(UDP_CLIENTS::iterator i=m_UdpClients.begin(); i!=m_UdpClients.end(); i++)
+		{
+			if(m_Udp->writeDatagram(data,size,i->address,i->port) < 0)
+				i->dropped++;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::SendCommand(const char *packet, int size)
+{
+	if( !m_Console )
+		return;
+
+	// framed as is, so blobs and any string survive; held while EosSyncLib is mid packet
+	OscPacket::AppendFrame(packet, size, m_ClientFrames);
+	if( m_LibBoundary.IsAtBoundary() )
+	{
+		WriteConsole(m_ClientFrames);
+		m_ClientFrames.clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onClientConnection()
+{
+	while( m_ClientServer->hasPendingConnections() )
+	{
+		QTcpSocket *socket = m_ClientServer->nextPendingConnection();
+		if( !socket )
+			continue;
+
+		socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connect(socket, SIGNAL(readyRead()), this, SLOT(onClientReadyRead()));
+		connect(socket, SIGNAL(disconnected()), this, SLOT(onClientDisconnected()));
+
+		sTcpClient *client = new sTcpClient();
+		client->socket = socket;
+		client->dropped = 0;
+		m_TcpClients.push_back(client);
+
+		Log( QString("OSC proxy client %1:%2 connected (TCP)").arg(socket->peerAddress().toString()).arg(socket->peerPort()) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onClientReadyRead()
+{
+	sTcpClient *client = FindTcpClient( sender() );
+	if( !client )
+		return;
+
+	QByteArray data( client->socket->readAll() );
+	client->stream.Append(data.constData(), data.size());
+	while( client->stream.Next(m_Packet) )
+		SendCommand(m_Packet.constData(), m_Packet.size());
+
+	if( client->stream.IsCorrupt() )
+	{
+		Log( QString("OSC proxy client %1:%2 sent a bad frame, disconnecting").arg(client->socket->peerAddress().toString()).arg(client->socket->peerPort()) );
+		client->socket->abort();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onClientDisconnected()
+{
+	QObject *socket = sender();
+	for(TCP_CLIENTS::iterator i=m_TcpClients.begin(); i!=m_TcpClients.end(); i++)
+	{
+		sTcpClient *client = *i;
+		if(client->socket == socket)
+		{
+			Log( QString("OSC proxy client %1:%2 disconnected").arg(client->socket->peerAddress().toString()).arg(client->socket->peerPort()) );
+			client->socket->deleteLater();
+			delete client;
+			m_TcpClients.erase(i);
+			break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscRelayWorker::sTcpClient* OscRelayWorker::FindTcpClient(QObject *socket)
+{
+	for(TCP_CLIENTS::const_iterator i=m_TcpClients.begin(); i!=m_TcpClients.end(); i++)
+	{
+		if((*i)->socket == socket)
+			return *i;
+	}
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onUdpReadyRead()
+{
+	while( m_Udp->hasPendingDatagrams() )
+	{
+		qint64 size = m_Udp->pendingDatagramSize();
+		m_Packet.resize( static_cast<int>(size>0 ? size : 0) );
+		QHostAddress address;
+		quint16 port = 0;
+		size = m_Udp->readDatagram(m_Packet.data(), m_Packet.size(), &address, &port);
+		if(size < 0)
+			continue;
+
+		UDP_CLIENTS::iterator i = m_UdpClients.begin();
+		for(; i!=m_UdpClients.end(); i++)
+		{
+			if(i->address==address && i->port==port)
+				break;
+		}
+
+		if(i == m_UdpClients.end())
+		{
+			m_UdpClients.push_back( sUdpClient() );
+			i = --m_UdpClients.end();
+			i->address = address;
+			i->port = port;
+			i->dropped = 0;
+			Log( QString("OSC proxy client %1:%2 connected (UDP)").arg(address.toString()).arg(port) );
+		}
+		i->lastSeen.start();
+
+		if(size > 0)
+			SendCommand(m_Packet.constData(), static_cast<int>(size));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::onExpireUdpClients()
+{
+	for(UDP_CLIENTS::iterator i=m_UdpClients.begin(); i!=m_UdpClients.end(); )
+	{
+		if( i->lastSeen.hasExpired(UDP_CLIENT_TIMEOUT_MS) )
+		{
+			Log( QString("OSC proxy client %1:%2 timed out (UDP)").arg(i->address.toString()).arg(i->port) );
+			i = m_UdpClients.erase(i);
+		}
+		else
+			i++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscRelayWorker::Log(const QString &text)
+{
+	EosLog::sLogMsg msg;
+	msg.type = EosLog::LOG_MSG_TYPE_INFO;
+	msg.timestamp = time(0);
+	msg.text = text.toUtf8().constData();
+	m_SyncThread.GetLogQueue().Push(msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////
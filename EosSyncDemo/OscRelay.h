@@ -0,0 +1,171 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef OSC_RELAY_H
+#define OSC_RELAY_H
+
+#ifndef OSC_PACKET_H
+#include "OscPacket.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <list>
+
+class EosSyncLibThread;
+class ChangeStats;
+class LiveState;
+class OscRelayWorker;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Sits between EosSyncLib and the console so other tools can share the one
+// console connection. EosSyncLib connects to the relay on loopback, and the
+// relay opens the real connection to the console and passes bytes through
+// untouched in both directions.
+//
+// Inbound /eos/out/ packets are also copied to any number of local clients,
+// over TCP (OSC 1.0 length framing) or UDP (one packet per datagram; a UDP
+// client registers by sending anything). Every client has its own bounded
+// send buffer, and packets for a client that is full are dropped and counted
+// rather than held, so one slow client never stalls the console link or the
+// other clients. Commands from clients go to the console byte for byte as
+// they were framed, written in between EosSyncLib's own packets so neither is
+// split; they are dropped while there is no console connection.
+//
+// The relay is also the app's tap on console traffic: arrival times of
+// routed /eos/out/ packets are recorded in ChangeStats even with no clients,
+// and high rate playback addresses update LiveState while it is enabled. A
+// console packet too large to tap is skipped by its length, so the tap stays
+// in step with the stream EosSyncLib is reading.
+class OscRelay
+	: public QThread
+{
+public:
+	struct sSettings
+	{
+		sSettings();
+		QString			consoleIp;
+		unsigned short	consolePort;
+		unsigned short	clientTcpPort;		// 0 for none
+		unsigned short	clientUdpPort;		// 0 for none
+		unsigned int	clientBufferSize;	// bytes queued per client before dropping
+	};
+
+	OscRelay();
+	virtual ~OscRelay();
+
+	// returns the loopback port EosSyncLib should connect to
+	virtual bool Start(EosSyncLibThread &syncThread, ChangeStats &changeStats, LiveState &liveState, const sSettings &settings, unsigned short &relayPort, QString &error);
+	virtual void Stop();
+
+protected:
+	EosSyncLibThread	*m_SyncThread;
+	ChangeStats			*m_ChangeStats;
+	LiveState			*m_LiveState;
+	sSettings			m_Settings;
+	unsigned short		m_RelayPort;
+	QString				m_Error;
+	bool				m_Listening;
+	QMutex				m_StartMutex;
+	QWaitCondition		m_StartWait;
+
+	virtual void run();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class OscRelayWorker
+	: public QObject
+{
+	Q_OBJECT
+
+public:
+	OscRelayWorker(EosSyncLibThread &syncThread, ChangeStats &changeStats, LiveState &liveState, const OscRelay::sSettings &settings);
+	virtual ~OscRelayWorker();
+
+	virtual bool Listen(unsigned short &relayPort, QString &error);
+
+private slots:
+	void onLibConnection();
+	void onLibReadyRead();
+	void onLibDisconnected();
+	void onConsoleConnected();
+	void onConsoleReadyRead();
+	void onConsoleDisconnected();
+	void onClientConnection();
+	void onClientReadyRead();
+	void onClientDisconnected();
+	void onUdpReadyRead();
+	void onExpireUdpClients();
+
+private:
+	struct sTcpClient
+	{
+		QTcpSocket			*socket;
+		OscPacket::Stream	stream;
+		unsigned int		dropped;	// packets dropped in the current overflow
+	};
+
+	struct sUdpClient
+	{
+		QHostAddress	address;
+		quint16			port;
+		QElapsedTimer	lastSeen;
+		unsigned int	dropped;
+	};
+
+	typedef std::list<sTcpClient*> TCP_CLIENTS;
+	typedef std::list<sUdpClient> UDP_CLIENTS;
+
+	EosSyncLibThread		&m_SyncThread;
+	ChangeStats				&m_ChangeStats;
+	LiveState				&m_LiveState;
+	OscRelay::sSettings		m_Settings;
+	QTcpServer				*m_LibServer;
+	QTcpSocket				*m_Lib;
+	QTcpSocket				*m_Console;
+	QByteArray				m_ConsolePending;	// from EosSyncLib before the console connected
+	OscPacket::Boundary		m_LibBoundary;
+	QByteArray				m_ClientFrames;		// waiting for EosSyncLib to finish a packet
+	OscPacket::Stream		m_ConsoleStream;
+	unsigned int			m_ConsoleSkipped;
+	QByteArray				m_Packet;
+	QByteArray				m_Frame;
+	QTcpServer				*m_ClientServer;
+	TCP_CLIENTS				m_TcpClients;
+	QUdpSocket				*m_Udp;
+	UDP_CLIENTS				m_UdpClients;
+	QTimer					*m_UdpExpireTimer;
+
+	virtual void OnConsolePacket(const QByteArray &packet, qint64 arrivalNS);
+	virtual void SendCommand(const char *packet, int size);
+	virtual void WriteConsole(const QByteArray &data);
+	virtual void CloseConsole();
+	virtual sTcpClient* FindTcpClient(QObject *socket);
+	virtual void Log(const QString &text);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
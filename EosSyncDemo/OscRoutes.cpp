@@ -0,0 +1,306 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "OscRoutes.h"
+#include "QtInclude.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define OUT_PREFIX			"/eos/out/"
+#define OUT_PREFIX_LEN		9
+#define GET_SEGMENT			"get/"
+#define GET_SEGMENT_LEN		4
+#define NOTIFY_SEGMENT		"notify/"
+#define NOTIFY_SEGMENT_LEN	7
+#define MAX_MULTIPLIER		64
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool SlotLess(const char *a, int aLen, const char *b, int bLen)
+{
+	int n = memcmp(a, b, (aLen<bLen) ? aLen : bLen);
+	return ((n != 0) ? (n < 0) : (aLen < bLen));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscRoutes::OscRoutes()
+	: m_NumSlots(0)
+	, m_Multiplier(0)
+{
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		sSlot &slot = m_Sorted[i];
+		slot.type = static_cast<EosTarget::EnumEosTargetType>(i);
+		slot.name = EosTarget::GetNameForTargetType(slot.type);
+		slot.len = static_cast<int>( strlen(slot.name) );
+	}
+
+	// insertion sort by name for the fallback binary search
+	for(int i=1; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		sSlot slot = m_Sorted[i];
+		int j = i;
+		for(; j>0 && SlotLess(slot.name,slot.len,m_Sorted[j-1].name,m_Sorted[j-1].len); j--)
+			m_Sorted[j] = m_Sorted[j-1];
+		m_Sorted[j] = slot;
+	}
+
+	// smallest table, then smallest multiplier, that has no collisions
+	for(unsigned int numSlots=EosTarget::EOS_TARGET_COUNT; numSlots<=MAX_SLOTS && m_Multiplier==0; numSlots++)
+	{
+		for(unsigned int multiplier=1; multiplier<=MAX_MULTIPLIER; multiplier++)
+		{
+			if( Build(numSlots,multiplier) )
+				break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const OscRoutes& OscRoutes::Get()
+{
+	static OscRoutes sRoutes;
+	return sRoutes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscRoutes::Build(unsigned int numSlots, unsigned int multiplier)
+{
+	memset(m_Slots, 0, sizeof(m_Slots));
+
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		const sSlot &slot = m_Sorted[i];
+		if(slot.len == 0)
+			continue;
+
+		sSlot &dst = m_Slots[ Hash(slot.name,slot.len,multiplier,numSlots) ];
+		if( dst.name )
+			return false;
+		dst = slot;
+	}
+
+	m_NumSlots = numSlots;
+	m_Multiplier = multiplier;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int OscRoutes::Hash(const char *segment, int len, unsigned int multiplier, unsigned int numSlots)
+{
+	const unsigned char *s = reinterpret_cast<const unsigned char*>(segment);
+	unsigned int h = (static_cast<unsigned int>(len) + s[0]*multiplier + s[len/2]*multiplier*multiplier + s[len-1]*multiplier*multiplier*multiplier);
+	return (h % numSlots);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const OscRoutes::sSlot* OscRoutes::Find(const char *segment, int len) const
+{
+	if(len <= 0)
+		return 0;
+
+	if(m_Multiplier != 0)
+	{
+		const sSlot &slot = m_Slots[ Hash(segment,len,m_Multiplier,m_NumSlots) ];
+		if(slot.len==len && memcmp(slot.name,segment,len)==0)
+			return &slot;
+		return 0;
+	}
+
+	int lo = 0;
+	int hi = EosTarget::EOS_TARGET_COUNT;
+	while(lo < hi)
+	{
+		int mid = (lo + (hi - lo)/2);
+		const sSlot &slot = m_Sorted[mid];
+		if( SlotLess(slot.name,slot.len,segment,len) )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if(lo<EosTarget::EOS_TARGET_COUNT && m_Sorted[lo].len==len && memcmp(m_Sorted[lo].name,segment,len)==0)
+		return &m_Sorted[lo];
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscRoutes::Route(const char *address, int len, sRoute &route) const
+{
+	if(len<=OUT_PREFIX_LEN || memcmp(address,OUT_PREFIX,OUT_PREFIX_LEN)!=0)
+		return false;
+
+	const char *p = (address + OUT_PREFIX_LEN);
+	const char *end = (address + len);
+
+	if(p[0]=='g' && end-p>GET_SEGMENT_LEN && memcmp(p,GET_SEGMENT,GET_SEGMENT_LEN)==0)
+	{
+		route.kind = ROUTE_GET;
+		p += GET_SEGMENT_LEN;
+	}
+	else if(p[0]=='n' && end-p>NOTIFY_SEGMENT_LEN && memcmp(p,NOTIFY_SEGMENT,NOTIFY_SEGMENT_LEN)==0)
+	{
+		route.kind = ROUTE_NOTIFY;
+		p += NOTIFY_SEGMENT_LEN;
+	}
+	else
+		return false;
+
+	const char *segmentEnd = static_cast<const char*>( memchr(p,'/',end-p) );
+	if( !segmentEnd )
+		segmentEnd = end;
+
+	const sSlot *slot = Find(p, static_cast<int>(segmentEnd - p));
+	if( !slot )
+		return false;
+
+	route.type = slot->type;
+	route.rest = segmentEnd;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscRoutes::RouteBySplitting(const char *address, sRoute &route)
+{
+	std::vector<std::string> segments;
+	std::string segment;
+	for(const char *p=address; ; p++)
+	{
+		if(*p=='/' || *p==0)
+		{
+			if( !segment.empty() )
+				segments.push_back(segment);
+			segment.clear();
+			if(*p == 0)
+				break;
+		}
+		else
+			segment.push_back(*p);
+	}
+
+	if(segments.size()<4 || segments[0]!="eos" || segments[1]!="out")
+		return false;
+
+	if(segments[2] == "get")
+		route.kind = ROUTE_GET;
+	else if(segments[2] == "notify")
+		route.kind = ROUTE_NOTIFY;
+	else
+		return false;
+
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		EosTarget::EnumEosTargetType type = static_cast<EosTarget::EnumEosTargetType>(i);
+		if(segments[3] == EosTarget::GetNameForTargetType(type))
+		{
+			route.type = type;
+			route.rest = (address + OUT_PREFIX_LEN + segments[2].size() + 1 + segments[3].size());
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int OscRoutes::Benchmark(unsigned int iterations)
+{
+	const OscRoutes &routes = Get();
+
+	// one get and one notify address per type, plus traffic that isn't routed
+	std::vector<std::string> addresses;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		std::string name( EosTarget::GetNameForTargetType(static_cast<EosTarget::EnumEosTargetType>(i)) );
+		addresses.push_back("/eos/out/get/" + name + "/1/0/list/0/12");
+		addresses.push_back("/eos/out/notify/" + name + "/list/0/12");
+	}
+	addresses.push_back("/eos/out/active/chan");
+	addresses.push_back("/eos/out/pending/cue/1/2");
+	addresses.push_back("/eos/out/cmd");
+	addresses.push_back("/eos/out/get/unknown/1");
+
+	printf("OSC route table: %u slots for %d target types, %s\n", routes.m_NumSlots, EosTarget::EOS_TARGET_COUNT,
+		routes.IsPerfect() ? QString("perfect hash, multiplier %1").arg(routes.m_Multiplier).toUtf8().constData() : "binary search fallback");
+
+	// both must agree before timing means anything
+	unsigned int mismatches = 0;
+	for(size_t i=0; i<addresses.size(); i++)
+	{
+		sRoute a, b;
+		bool aOk = routes.Route(addresses[i].c_str(), static_cast<int>(addresses[i].size()), a);
+		bool bOk = RouteBySplitting(addresses[i].c_str(), b);
+		if(aOk!=bOk || (aOk && (a.kind!=b.kind || a.type!=b.type || a.rest!=b.rest)))
+		{
+			printf("  mismatch: %s\n", addresses[i].c_str());
+			mismatches++;
+		}
+	}
+
+	unsigned int checksum = 0;
+	QElapsedTimer timer;
+	timer.start();
+	for(unsigned int n=0; n<iterations; n++)
+	{
+		for(size_t i=0; i<addresses.size(); i++)
+		{
+			sRoute route;
+			if( routes.Route(addresses[i].c_str(),static_cast<int>(addresses[i].size()),route) )
+				checksum += route.type;
+		}
+	}
+	qint64 tableNS = timer.nsecsElapsed();
+
+	timer.start();
+	for(unsigned int n=0; n<iterations; n++)
+	{
+		for(size_t i=0; i<addresses.size(); i++)
+		{
+			sRoute route;
+			if( RouteBySplitting(addresses[i].c_str(),route) )
+				checksum -= route.type;
+		}
+	}
+	qint64 splitNS = timer.nsecsElapsed();
+
+	double count = (static_cast<double>(iterations) * addresses.size());
+	if(count < 1)
+		count = 1;
+	printf("  %.0f routes each (checksum %u)\n", count, checksum);
+	printf("  table:     %8.1f ns/route\n", tableNS/count);
+	printf("  splitting: %8.1f ns/route (baseline written for this comparison)\n", splitNS/count);
+
+	return ((mismatches == 0) ? 0 : 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
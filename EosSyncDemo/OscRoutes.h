@@ -0,0 +1,102 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef OSC_ROUTES_H
+#define OSC_ROUTES_H
+
+#ifndef EOS_SYNC_LIB_H
+#include "EosSyncLib.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Maps inbound /eos/out/get/<type>/... and /eos/out/notify/<type>/...
+// addresses to their target type without splitting the address.
+//
+// The type names come from EosTarget::GetNameForTargetType(), so the table
+// is built once at startup rather than at compile time. Construction picks a
+// multiplier and table size that give every name its own slot, which makes a
+// lookup one hash of the segment's length and end characters plus a single
+// compare. Call Get() once from main() before any other thread uses it.
+//
+// EosSyncLib routes its own traffic internally and doesn't use this; its only
+// user is the OSC relay's tap on console traffic, which had no router before.
+class OscRoutes
+{
+public:
+	enum EnumRouteKind
+	{
+		ROUTE_GET,		// /eos/out/get/<type>/...
+		ROUTE_NOTIFY,	// /eos/out/notify/<type>/...
+
+		ROUTE_COUNT
+	};
+
+	struct sRoute
+	{
+		EnumRouteKind					kind;
+		EosTarget::EnumEosTargetType	type;
+		const char						*rest;		// after "<type>", "" or "/..."
+	};
+
+	static const OscRoutes& Get();
+
+	virtual ~OscRoutes() {}
+
+	virtual bool Route(const char *address, int len, sRoute &route) const;
+	virtual bool IsPerfect() const {return (m_Multiplier != 0);}
+
+	// naive split and compare version of Route(), written only as a baseline
+	// for Benchmark(); no code path in the app ever routed this way
+	static bool RouteBySplitting(const char *address, sRoute &route);
+
+	// headless micro-benchmark against RouteBySplitting(), prints results to stdout
+	static int Benchmark(unsigned int iterations);
+
+protected:
+	enum EnumConstants
+	{
+		MAX_SLOTS	= 256
+	};
+
+	struct sSlot
+	{
+		const char						*name;
+		int								len;
+		EosTarget::EnumEosTargetType	type;
+	};
+
+	sSlot			m_Slots[MAX_SLOTS];
+	unsigned int	m_NumSlots;
+	unsigned int	m_Multiplier;		// 0 if no perfect hash was found
+	sSlot			m_Sorted[EosTarget::EOS_TARGET_COUNT];	// fallback, by name
+
+	OscRoutes();
+
+	virtual bool Build(unsigned int numSlots, unsigned int multiplier);
+	virtual const sSlot* Find(const char *segment, int len) const;
+
+	static unsigned int Hash(const char *segment, int len, unsigned int multiplier, unsigned int numSlots);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,264 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "OscScheduler.h"
+#include "MainWindow.h"
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define NS_PER_MS		Q_INT64_C(1000000)
+#define SPIN_NS			NS_PER_MS		// spin rather than sleep this close to an offset
+#define MAX_SLEEP_MS	50				// so Stop() is never kept waiting long
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct sCommandByOffset
+{
+	bool operator()(const OscScheduler::sCommand &a, const OscScheduler::sCommand &b) const {return (a.offsetNS < b.offsetNS);}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscScheduler::OscScheduler()
+	: m_SyncThread(0)
+	, m_Run(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OscScheduler::~OscScheduler()
+{
+	Stop();
+	Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscScheduler::Clear()
+{
+	for(COMMANDS::const_iterator i=m_Commands.begin(); i!=m_Commands.end(); i++)
+		delete i->packet;
+	m_Commands.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscScheduler::ParseOffset(const QString &str, qint64 prevNS, qint64 &ns)
+{
+	QString s(str);
+	bool relative = s.startsWith('+');
+	if( relative )
+		s.remove(0, 1);
+
+	double scale = 1000000000.0;
+	if( s.endsWith("ms",Qt::CaseInsensitive) )
+	{
+		s.chop(2);
+		scale = 1000000.0;
+	}
+	else if( s.endsWith('s',Qt::CaseInsensitive) )
+		s.chop(1);
+
+	bool ok = false;
+	double value = s.toDouble(&ok);
+	if(!ok || value<0)
+		return false;
+
+	ns = static_cast<qint64>(value*scale + 0.5);
+	if( relative )
+		ns += prevNS;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OscScheduler::Load(const QString &path, QString &error)
+{
+	Stop();
+	Clear();
+
+	QFile file(path);
+	if( !file.open(QIODevice::ReadOnly | QIODevice::Text) )
+	{
+		error = file.errorString();
+		return false;
+	}
+
+	QTextStream stream(&file);
+	qint64 prevNS = 0;
+	int line = 0;
+	while( !stream.atEnd() )
+	{
+		line++;
+		QString text( stream.readLine().trimmed() );
+		if(text.isEmpty() || text.startsWith('#'))
+			continue;
+
+		int split = 0;
+		while(split<text.size() && !text[split].isSpace())
+			split++;
+		sCommand cmd;
+		cmd.line = line;
+		if(split>=text.size() || !ParseOffset(text.left(split),prevNS,cmd.offsetNS))
+		{
+			error = QString("line %1: expected an offset and an OSC string").arg(line);
+			Clear();
+			return false;
+		}
+
+		cmd.str = text.mid(split).trimmed().toUtf8().constData();
+		cmd.packet = OSCPacketWriter::CreatePacketWriterForString( cmd.str.c_str() );
+		if( !cmd.packet )
+		{
+			error = QString("line %1: invalid OSC string").arg(line);
+			Clear();
+			return false;
+		}
+
+		cmd.releasedNS = -1;
+		cmd.sentNS = -1;
+		m_Commands.push_back(cmd);
+		prevNS = cmd.offsetNS;
+	}
+
+	if( m_Commands.empty() )
+	{
+		error = "no commands";
+		return false;
+	}
+
+	// lines may be written out of order, equal offsets keep theirs
+	std::stable_sort(m_Commands.begin(), m_Commands.end(), sCommandByOffset());
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscScheduler::Start(EosSyncLibThread &syncThread)
+{
+	Stop();
+
+	m_SyncThread = &syncThread;
+	for(COMMANDS::iterator i=m_Commands.begin(); i!=m_Commands.end(); i++)
+		i->releasedNS = i->sentNS = -1;
+	m_Run = true;
+	start(QThread::TimeCriticalPriority);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscScheduler::Stop()
+{
+	m_Run = false;
+	wait();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscScheduler::run()
+{
+	QElapsedTimer clock;
+	clock.start();
+
+	for(COMMANDS::iterator i=m_Commands.begin(); m_Run && i!=m_Commands.end(); i++)
+	{
+		sCommand &cmd = *i;
+		for(;;)
+		{
+			qint64 remainingNS = (cmd.offsetNS - clock.nsecsElapsed());
+			if(remainingNS<=0 || !m_Run)
+				break;
+
+			// sleep whole milliseconds while at least one is left before the spin
+			qint64 ms = ((remainingNS - SPIN_NS) / NS_PER_MS);
+			if(ms >= 1)
+				msleep( static_cast<unsigned long>(qMin<qint64>(ms,MAX_SLEEP_MS)) );
+			else
+				yieldCurrentThread();
+		}
+
+		if( !m_Run )
+			break;
+
+		cmd.releasedNS = clock.nsecsElapsed();
+		m_SyncThread->SendNow(*cmd.packet);
+		cmd.sentNS = clock.nsecsElapsed();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 OscScheduler::GetPercentile(const std::vector<qint64> &sorted, double p)
+{
+	if( sorted.empty() )
+		return 0;
+
+	size_t i = static_cast<size_t>(p*(sorted.size()-1) + 0.5);
+	return sorted[qMin(i,sorted.size()-1)];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OscScheduler::GetReport(QStringList &summary, QStringList &details) const
+{
+	summary.clear();
+	details.clear();
+
+	std::vector<qint64> jitter;
+	std::vector<qint64> send;
+	jitter.reserve( m_Commands.size() );
+	send.reserve( m_Commands.size() );
+	for(COMMANDS::const_iterator i=m_Commands.begin(); i!=m_Commands.end(); i++)
+	{
+		const sCommand &cmd = *i;
+		if(cmd.releasedNS < 0)
+			continue;
+
+		qint64 jitterNS = (cmd.releasedNS - cmd.offsetNS);
+		qint64 sendNS = (cmd.sentNS - cmd.releasedNS);
+		jitter.push_back(jitterNS);
+		send.push_back(sendNS);
+		details << QString("Script line %1 at %2 ms, released +%3 us, sent +%4 us: %5")
+			.arg(cmd.line)
+			.arg(cmd.offsetNS/1000000.0, 0, 'f', 3)
+			.arg(jitterNS/1000.0, 0, 'f', 1)
+			.arg((jitterNS+sendNS)/1000.0, 0, 'f', 1)
+			.arg( QString::fromUtf8(cmd.str.c_str()) );
+	}
+
+	summary << QString("Script sent %1 of %2 commands").arg(jitter.size()).arg(m_Commands.size());
+	if( jitter.empty() )
+		return;
+
+	std::sort(jitter.begin(), jitter.end());
+	std::sort(send.begin(), send.end());
+	summary << QString("Script release jitter p50/p99/max %1/%2/%3 us, hand-off p50/p99/max %4/%5/%6 us")
+		.arg(GetPercentile(jitter,0.5)/1000.0, 0, 'f', 1)
+		.arg(GetPercentile(jitter,0.99)/1000.0, 0, 'f', 1)
+		.arg(jitter.back()/1000.0, 0, 'f', 1)
+		.arg(GetPercentile(send,0.5)/1000.0, 0, 'f', 1)
+		.arg(GetPercentile(send,0.99)/1000.0, 0, 'f', 1)
+		.arg(send.back()/1000.0, 0, 'f', 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,102 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef OSC_SCHEDULER_H
+#define OSC_SCHEDULER_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <string>
+#include <vector>
+
+class EosSyncLibThread;
+class OSCPacketWriter;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fires a script of OSC commands at fixed offsets from the start.
+//
+// Each script line is an offset and an OSC string in the Send box's format:
+//
+//	0		/eos/key/go_0
+//	1.5		/eos/sub/1=0.75
+//	+250ms	/eos/sub/1=0
+//
+// Offsets are seconds, or milliseconds with an "ms" suffix, and a leading '+'
+// makes one relative to the line before. Blank lines and lines starting with
+// '#' are skipped. Every packet is built when the script is loaded, and a
+// dedicated thread sleeps until about a millisecond short of each offset and
+// spins the rest of the way on a QElapsedTimer. A due packet goes out with
+// EosSyncLibThread::SendNow() rather than through the sync thread's send
+// queue, so it never waits out the sync thread's idle sleep, and on the
+// console link while that is up, so it never waits for the EosSyncLib lock.
+//
+// With the link down it goes to EosSyncLib directly, and then does wait for
+// the lock, which EosSyncLib::Tick() on the sync thread and the UI tick both
+// hold. How late each command was released, and how long it then took to
+// hand over, are kept for the report.
+class OscScheduler
+	: public QThread
+{
+public:
+	struct sCommand
+	{
+		int					line;
+		qint64				offsetNS;
+		std::string			str;
+		OSCPacketWriter		*packet;
+		qint64				releasedNS;	// -1 if not sent
+		qint64				sentNS;
+	};
+
+	typedef std::vector<sCommand> COMMANDS;
+
+	OscScheduler();
+	virtual ~OscScheduler();
+
+	// UI thread, before Start()
+	virtual bool Load(const QString &path, QString &error);
+	virtual size_t GetCommandCount() const {return m_Commands.size();}
+
+	virtual void Start(EosSyncLibThread &syncThread);
+	virtual void Stop();
+
+	// once finished
+	virtual void GetReport(QStringList &summary, QStringList &details) const;
+
+protected:
+	EosSyncLibThread	*m_SyncThread;
+	COMMANDS			m_Commands;
+	volatile bool		m_Run;
+
+	virtual void run();
+	virtual void Clear();
+
+	static bool ParseOffset(const QString &str, qint64 prevNS, qint64 &ns);
+	static qint64 GetPercentile(const std::vector<qint64> &sorted, double p);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
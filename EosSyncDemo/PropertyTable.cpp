@@ -0,0 +1,914 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "PropertyTable.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// type holding both a and b, without parsing anything
+static PropertyTable::EnumColumnType WidenType(PropertyTable::EnumColumnType a, PropertyTable::EnumColumnType b)
+{
+	if(a==b || b==PropertyTable::COLUMN_NONE)
+		return a;
+	if(a == PropertyTable::COLUMN_NONE)
+		return b;
+	if((a==PropertyTable::COLUMN_INT && b==PropertyTable::COLUMN_FLOAT) || (a==PropertyTable::COLUMN_FLOAT && b==PropertyTable::COLUMN_INT))
+		return PropertyTable::COLUMN_FLOAT;
+	return PropertyTable::COLUMN_STRING;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTable::sTable::Clear()
+{
+	listIds.clear();
+	numbers.clear();
+	numberText.clear();
+	parts.clear();
+	columns.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PropertyTable::PropertyTable()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTable::Clear()
+{
+	m_Lists.clear();
+	m_Table.Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTable::Swap(PropertyTable &other)
+{
+	m_Lists.swap(other.m_Lists);
+	m_Table.listIds.swap(other.m_Table.listIds);
+	m_Table.numbers.swap(other.m_Table.numbers);
+	m_Table.numberText.swap(other.m_Table.numberText);
+	m_Table.parts.swap(other.m_Table.parts);
+	m_Table.columns.swap(other.m_Table.columns);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PropertyTable::Update(EosTarget::EnumEosTargetType type, const ShowSnapshot::sTargetType &targetType)
+{
+	const ShowSnapshot::TARGET_LISTS &lists = targetType.lists;
+	bool changed = false;
+
+	for(LIST_TABLES::iterator i=m_Lists.begin(); i!=m_Lists.end(); )
+	{
+		if(lists.find(i->first) == lists.end())
+		{
+			m_Lists.erase(i++);
+			changed = true;
+		}
+		else
+			i++;
+	}
+
+	LIST_JOBS jobs;
+	for(ShowSnapshot::TARGET_LISTS::const_iterator i=lists.begin(); i!=lists.end(); i++)
+	{
+		int listId = i->first;
+
+		// same lists the text view shows
+		if(type==EosTarget::EOS_TARGET_CUE && listId<=0 && lists.size()>1)
+		{
+			if( m_Lists.erase(listId) )
+				changed = true;
+			continue;
+		}
+
+		LIST_TABLES::const_iterator found = m_Lists.find(listId);
+		if(found!=m_Lists.end() && found->second.source==i->second)
+			continue;
+
+		sListJob job;
+		job.listId = listId;
+		job.targetList = i->second;
+		jobs.push_back(job);
+	}
+
+	if(jobs.isEmpty() && !changed)
+		return false;
+
+	if(jobs.size() > 1)
+		QtConcurrent::blockingMap(jobs, &PropertyTable::ParseList);
+	else if( !jobs.isEmpty() )
+		ParseList( jobs.front() );
+
+	for(LIST_JOBS::iterator i=jobs.begin(); i!=jobs.end(); i++)
+	{
+		sTable *table = new sTable();
+		table->listIds.swap(i->table.listIds);
+		table->numbers.swap(i->table.numbers);
+		table->numberText.swap(i->table.numberText);
+		table->parts.swap(i->table.parts);
+		table->columns.swap(i->table.columns);
+
+		sListTable &listTable = m_Lists[i->listId];
+		listTable.source = i->targetList;
+		listTable.table = TABLE_PTR(table);
+	}
+
+	Combine();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTable::Combine()
+{
+	m_Table.Clear();
+
+	// every column any list has, in group then property order
+	typedef std::pair<std::string, int> COLUMN_KEY;
+	typedef std::map<COLUMN_KEY, EnumColumnType> COLUMN_TYPES;
+	COLUMN_TYPES columnTypes;
+	size_t numRows = 0;
+	for(LIST_TABLES::const_iterator i=m_Lists.begin(); i!=m_Lists.end(); i++)
+	{
+		const sTable &list = *(i->second.table);
+		numRows += list.GetRowCount();
+		for(COLUMNS::const_iterator j=list.columns.begin(); j!=list.columns.end(); j++)
+		{
+			EnumColumnType &type = columnTypes[ COLUMN_KEY(j->group,j->prop) ];
+			type = WidenType(type, j->type);
+		}
+	}
+
+	m_Table.listIds.reserve(numRows);
+	m_Table.numbers.reserve(numRows);
+	m_Table.numberText.reserve(numRows);
+	m_Table.parts.reserve(numRows);
+
+	typedef std::map<COLUMN_KEY, size_t> COLUMN_INDEXES;
+	COLUMN_INDEXES columnIndexes;
+	m_Table.columns.resize( columnTypes.size() );
+	size_t index = 0;
+	for(COLUMN_TYPES::const_iterator i=columnTypes.begin(); i!=columnTypes.end(); i++, index++)
+	{
+		sColumn &column = m_Table.columns[index];
+		column.group = i->first.first;
+		column.prop = i->first.second;
+		column.name = column.group.empty()
+			? QString::number(column.prop + 1)
+			: QString("%1 %2").arg( QString::fromUtf8(column.group.c_str()) ).arg(column.prop + 1);
+		column.present.resize(numRows, false);
+		Widen(column, i->second);
+		columnIndexes[i->first] = index;
+	}
+
+	size_t rowBase = 0;
+	for(LIST_TABLES::const_iterator i=m_Lists.begin(); i!=m_Lists.end(); i++)
+	{
+		const sTable &list = *(i->second.table);
+		m_Table.listIds.insert(m_Table.listIds.end(), list.listIds.begin(), list.listIds.end());
+		m_Table.numbers.insert(m_Table.numbers.end(), list.numbers.begin(), list.numbers.end());
+		m_Table.numberText.insert(m_Table.numberText.end(), list.numberText.begin(), list.numberText.end());
+		m_Table.parts.insert(m_Table.parts.end(), list.parts.begin(), list.parts.end());
+
+		for(COLUMNS::const_iterator j=list.columns.begin(); j!=list.columns.end(); j++)
+		{
+			sColumn &dst = m_Table.columns[ columnIndexes[COLUMN_KEY(j->group,j->prop)] ];
+
+			sColumn widened;
+			const sColumn *src = &(*j);
+			if(src->type != dst.type)
+			{
+				widened = *src;
+				Widen(widened, dst.type);
+				src = &widened;
+			}
+
+			std::copy(src->present.begin(), src->present.end(), dst.present.begin()+rowBase);
+			switch( dst.type )
+			{
+				case COLUMN_BOOL:
+				case COLUMN_INT:
+					std::copy(src->ints.begin(), src->ints.end(), dst.ints.begin()+rowBase);
+					break;
+
+				case COLUMN_FLOAT:
+					std::copy(src->floats.begin(), src->floats.end(), dst.floats.begin()+rowBase);
+					break;
+
+				case COLUMN_STRING:
+					std::copy(src->strings.begin(), src->strings.end(), dst.strings.begin()+rowBase);
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		rowBase += list.GetRowCount();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTable::Widen(sColumn &column, EnumColumnType type)
+{
+	if(column.type == type)
+		return;
+
+	size_t numRows = column.present.size();
+	switch( type )
+	{
+		case COLUMN_BOOL:
+		case COLUMN_INT:
+			column.ints.resize(numRows, 0);
+			break;
+
+		case COLUMN_FLOAT:
+			column.floats.resize(numRows, 0);
+			for(size_t i=0; i<column.ints.size(); i++)
+				column.floats[i] = static_cast<double>(column.ints[i]);
+			break;
+
+		case COLUMN_STRING:
+			column.strings.resize(numRows);
+			for(size_t i=0; i<numRows; i++)
+			{
+				if( column.present[i] )
+					column.strings[i] = GetText(column, i);
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	if(type != COLUMN_BOOL && type != COLUMN_INT)
+		std::vector<qint64>().swap(column.ints);
+	if(type != COLUMN_FLOAT)
+		std::vector<double>().swap(column.floats);
+	column.type = type;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTable::ParseList(sListJob &job)
+{
+	// runs on a pool thread, so only reentrant calls in here
+	sTable &table = job.table;
+	table.Clear();
+
+	const ShowSnapshot::TARGETS &targets = job.targetList->targets;
+	size_t numTargets = targets.size();
+	table.listIds.reserve(numTargets);
+	table.numbers.reserve(numTargets);
+	table.numberText.reserve(numTargets);
+	table.parts.reserve(numTargets);
+
+	// values are only located on the first pass, and parsed once on the second
+	typedef std::pair<std::string, int> COLUMN_KEY;
+	typedef std::map<COLUMN_KEY, size_t> COLUMN_INDEXES;
+	typedef std::vector<const std::string*> RAW_VALUES;
+	COLUMN_INDEXES columnIndexes;
+	std::vector<RAW_VALUES> raw;
+
+	// the snapshot already has one target per part, in number/part order
+	for(ShowSnapshot::TARGETS::const_iterator i=targets.begin(); i!=targets.end(); i++)
+	{
+		size_t row = table.numbers.size();
+		table.listIds.push_back(job.listId);
+		table.numbers.push_back(i->numberValue);
+		table.numberText.push_back( QString::fromUtf8(i->number.c_str()) );
+		table.parts.push_back(i->part);
+
+		for(ShowSnapshot::PROP_GROUPS::const_iterator k=i->propGroups.begin(); k!=i->propGroups.end(); k++)
+		{
+			int prop = 0;
+			for(std::vector<std::string>::const_iterator l=k->values.begin(); l!=k->values.end(); l++, prop++)
+			{
+				if( l->empty() )
+					continue;
+
+				COLUMN_KEY key(k->name, prop);
+				COLUMN_INDEXES::const_iterator found = columnIndexes.find(key);
+				size_t index = 0;
+				if(found == columnIndexes.end())
+				{
+					index = raw.size();
+					columnIndexes[key] = index;
+					raw.push_back( RAW_VALUES() );
+				}
+				else
+					index = found->second;
+
+				RAW_VALUES &values = raw[index];
+				if(values.size() <= row)
+					values.resize(row+1, 0);
+				values[row] = &(*l);
+			}
+		}
+	}
+
+	size_t numRows = table.GetRowCount();
+	std::vector<qint64> ints;
+	std::vector<double> floats;
+	table.columns.resize( columnIndexes.size() );
+	size_t columnIndex = 0;
+	for(COLUMN_INDEXES::const_iterator i=columnIndexes.begin(); i!=columnIndexes.end(); i++, columnIndex++)
+	{
+		sColumn &column = table.columns[columnIndex];
+		column.group = i->first.first;
+		column.prop = i->first.second;
+		column.present.resize(numRows, false);
+
+		RAW_VALUES &values = raw[i->second];
+		values.resize(numRows, 0);
+		ints.assign(numRows, 0);
+		floats.assign(numRows, 0);
+
+		EnumColumnType type = COLUMN_NONE;
+		for(size_t row=0; row<numRows; row++)
+		{
+			if( !values[row] )
+				continue;
+
+			column.present[row] = true;
+			if(type != COLUMN_STRING)
+				type = WidenType(type, GetValueType(*values[row],ints[row],floats[row]));
+		}
+
+		column.type = type;
+		switch( type )
+		{
+			case COLUMN_BOOL:
+			case COLUMN_INT:
+				column.ints.swap(ints);
+				break;
+
+			case COLUMN_FLOAT:
+				column.floats.swap(floats);
+				break;
+
+			case COLUMN_STRING:
+				column.strings.resize(numRows);
+				for(size_t row=0; row<numRows; row++)
+				{
+					if( values[row] )
+						column.strings[row] = QString::fromUtf8( values[row]->c_str() );
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PropertyTable::EnumColumnType PropertyTable::GetValueType(const std::string &value, qint64 &n, double &f)
+{
+	const char *str = value.c_str();
+	if(value.empty())
+		return COLUMN_STRING;
+
+	if(qstricmp(str,"true")==0 || qstricmp(str,"false")==0)
+	{
+		n = ((str[0]=='t' || str[0]=='T') ? 1 : 0);
+		f = static_cast<double>(n);
+		return COLUMN_BOOL;
+	}
+
+	// no leading space, hex, inf or nan
+	char c = str[0];
+	if(!(c>='0' && c<='9') && c!='-' && c!='+' && c!='.')
+		return COLUMN_STRING;
+	for(const char *p=str; *p; p++)
+	{
+		if(*p=='x' || *p=='X' || *p=='n' || *p=='N' || *p=='i' || *p=='I')
+			return COLUMN_STRING;
+	}
+
+	char *end = 0;
+	errno = 0;
+	long long ll = strtoll(str, &end, 10);
+	if(errno==0 && end && *end==0)
+	{
+		n = static_cast<qint64>(ll);
+		f = static_cast<double>(n);
+		return COLUMN_INT;
+	}
+
+	end = 0;
+	errno = 0;
+	double d = strtod(str, &end);
+	if(errno==0 && end && *end==0)
+	{
+		f = d;
+		return COLUMN_FLOAT;
+	}
+
+	return COLUMN_STRING;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QString PropertyTable::GetText(const sColumn &column, size_t row)
+{
+	if(row>=column.present.size() || !column.present[row])
+		return QString();
+
+	switch( column.type )
+	{
+		case COLUMN_BOOL:	return QString(column.ints[row] ? "true" : "false");
+		case COLUMN_INT:	return QString::number(column.ints[row]);
+		case COLUMN_FLOAT:	return QString::number(column.floats[row], 'g', 12);
+		case COLUMN_STRING:	return column.strings[row];
+		default:			break;
+	}
+
+	return QString();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* PropertyTable::GetColumnTypeName(EnumColumnType type)
+{
+	switch( type )
+	{
+		case COLUMN_BOOL:	return "bool";
+		case COLUMN_INT:	return "int";
+		case COLUMN_FLOAT:	return "float";
+		case COLUMN_STRING:	return "string";
+		default:			break;
+	}
+
+	return "none";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// orders rows by one column's typed values; rows without a value go last either way
+class PropertyRowLess
+{
+public:
+	PropertyRowLess(const PropertyTable::sTable &table, int column, bool descending)
+		: m_Table(table)
+		, m_Column(column)
+		, m_Descending(descending)
+	{
+	}
+
+	bool operator()(int a, int b) const
+	{
+		switch( m_Column )
+		{
+			case PropertyTableModel::FIXED_COLUMN_LIST:
+				return Less(m_Table.listIds[a], m_Table.listIds[b]);
+
+			case PropertyTableModel::FIXED_COLUMN_NUMBER:
+				if(m_Table.numbers[a] != m_Table.numbers[b])
+					return Less(m_Table.numbers[a], m_Table.numbers[b]);
+				return Less(m_Table.parts[a], m_Table.parts[b]);
+
+			case PropertyTableModel::FIXED_COLUMN_PART:
+				return Less(m_Table.parts[a], m_Table.parts[b]);
+		}
+
+		const PropertyTable::sColumn &column = m_Table.columns[m_Column - PropertyTableModel::FIXED_COLUMN_COUNT];
+		bool hasA = column.present[a];
+		bool hasB = column.present[b];
+		if(!hasA || !hasB)
+			return (hasA && !hasB);
+
+		switch( column.type )
+		{
+			case PropertyTable::COLUMN_BOOL:
+			case PropertyTable::COLUMN_INT:
+				return Less(column.ints[a], column.ints[b]);
+
+			case PropertyTable::COLUMN_FLOAT:
+				return Less(column.floats[a], column.floats[b]);
+
+			case PropertyTable::COLUMN_STRING:
+				{
+					int cmp = column.strings[a].compare(column.strings[b], Qt::CaseInsensitive);
+					return (m_Descending ? (cmp>0) : (cmp<0));
+				}
+
+			default:
+				break;
+		}
+
+		return false;
+	}
+
+private:
+	const PropertyTable::sTable	&m_Table;
+	int							m_Column;
+	bool						m_Descending;
+
+	template<class T> bool Less(const T &a, const T &b) const {return (m_Descending ? (b<a) : (a<b));}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+PropertyTableModel::PropertyTableModel(QObject *parent)
+	: QAbstractTableModel(parent)
+	, m_Table(0)
+	, m_SortColumn(-1)
+	, m_SortOrder(Qt::AscendingOrder)
+	, m_FilterOk(true)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTableModel::SetTable(const PropertyTable::sTable *table)
+{
+	beginResetModel();
+	m_Table = table;
+	if(m_SortColumn >= columnCount())
+		m_SortColumn = -1;
+	ParseFilter(m_FilterText);	// column names may have changed
+	Rebuild();
+	endResetModel();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PropertyTableModel::SetFilter(const QString &filter)
+{
+	beginResetModel();
+	bool ok = ParseFilter(filter);
+	Rebuild();
+	endResetModel();
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PropertyTableModel::ParseFilter(const QString &filter)
+{
+	m_FilterText = filter;
+
+	// "text", or "column op value" with op one of = == != < <= > >=
+	sFilter f;
+	QString trimmed( filter.trimmed() );
+	bool ok = true;
+	if( !trimmed.isEmpty() )
+	{
+		int opPos = -1;
+		for(int i=0; i<trimmed.size() && opPos<0; i++)
+		{
+			QChar c( trimmed.at(i) );
+			if(c=='<' || c=='>' || c=='=' || c=='!')
+				opPos = i;
+		}
+
+		if(opPos > 0)
+		{
+			QString name( trimmed.left(opPos).trimmed() );
+			QString op( trimmed.mid(opPos,2) );
+			int opLen = 2;
+			if(op == "<=")		f.op = FILTER_LE;
+			else if(op == ">=")	f.op = FILTER_GE;
+			else if(op == "!=")	f.op = FILTER_NE;
+			else if(op == "==")	f.op = FILTER_EQ;
+			else
+			{
+				opLen = 1;
+				QChar c( trimmed.at(opPos) );
+				if(c == '<')		f.op = FILTER_LT;
+				else if(c == '>')	f.op = FILTER_GT;
+				else if(c == '=')	f.op = FILTER_EQ;
+				else				f.op = FILTER_NONE;
+			}
+
+			for(int i=0; i<columnCount() && f.column<0; i++)
+			{
+				if(GetColumnName(i).compare(name,Qt::CaseInsensitive) == 0)
+					f.column = i;
+			}
+
+			f.text = trimmed.mid(opPos + opLen).trimmed();
+			if(f.text.compare("true",Qt::CaseInsensitive) == 0)
+			{
+				f.number = 1;
+				f.isNumber = true;
+			}
+			else if(f.text.compare("false",Qt::CaseInsensitive) == 0)
+			{
+				f.number = 0;
+				f.isNumber = true;
+			}
+			else
+				f.number = f.text.toDouble(&f.isNumber);
+
+			if(f.op==FILTER_NONE || f.column<0)
+			{
+				f.op = FILTER_NONE;
+				ok = false;
+			}
+		}
+		else
+		{
+			f.op = FILTER_TEXT;
+			f.text = trimmed;
+		}
+	}
+
+	m_Filter = f;
+	m_FilterOk = ok;
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTableModel::Rebuild()
+{
+	m_Rows.clear();
+	if( !m_Table )
+		return;
+
+	size_t numRows = m_Table->GetRowCount();
+	m_Rows.reserve(numRows);
+	for(size_t i=0; i<numRows; i++)
+	{
+		if( Matches(i) )
+			m_Rows.push_back( static_cast<int>(i) );
+	}
+
+	if(m_SortColumn >= 0)
+		std::stable_sort(m_Rows.begin(), m_Rows.end(), PropertyRowLess(*m_Table,m_SortColumn,m_SortOrder==Qt::DescendingOrder));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PropertyTableModel::Matches(size_t row) const
+{
+	switch( m_Filter.op )
+	{
+		case FILTER_NONE:
+			return true;
+
+		case FILTER_TEXT:
+			if( m_Table->numberText[row].contains(m_Filter.text,Qt::CaseInsensitive) )
+				return true;
+			for(PropertyTable::COLUMNS::const_iterator i=m_Table->columns.begin(); i!=m_Table->columns.end(); i++)
+			{
+				if(i->type==PropertyTable::COLUMN_STRING && i->present[row] && i->strings[row].contains(m_Filter.text,Qt::CaseInsensitive))
+					return true;
+			}
+			return false;
+
+		default:
+			break;
+	}
+
+	int cmp = 0;
+	double n = 0;
+	if( GetNumber(m_Filter.column,row,n) )
+	{
+		if( !m_Filter.isNumber )
+			return false;
+		cmp = ((n < m_Filter.number) ? -1 : ((n > m_Filter.number) ? 1 : 0));
+	}
+	else
+	{
+		QString text( GetText(m_Filter.column,row) );
+		if( text.isEmpty() )
+			return false;
+		cmp = text.compare(m_Filter.text, Qt::CaseInsensitive);
+	}
+
+	switch( m_Filter.op )
+	{
+		case FILTER_EQ:	return (cmp == 0);
+		case FILTER_NE:	return (cmp != 0);
+		case FILTER_LT:	return (cmp < 0);
+		case FILTER_LE:	return (cmp <= 0);
+		case FILTER_GT:	return (cmp > 0);
+		case FILTER_GE:	return (cmp >= 0);
+		default:		break;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PropertyTableModel::GetNumber(int column, size_t row, double &n) const
+{
+	switch( column )
+	{
+		case FIXED_COLUMN_LIST:		n = m_Table->listIds[row];	return true;
+		case FIXED_COLUMN_NUMBER:	n = m_Table->numbers[row];	return true;
+		case FIXED_COLUMN_PART:		n = m_Table->parts[row];	return true;
+	}
+
+	const PropertyTable::sColumn &c = m_Table->columns[column - FIXED_COLUMN_COUNT];
+	if( !c.present[row] )
+		return false;
+
+	switch( c.type )
+	{
+		case PropertyTable::COLUMN_BOOL:
+		case PropertyTable::COLUMN_INT:
+			n = static_cast<double>(c.ints[row]);
+			return true;
+
+		case PropertyTable::COLUMN_FLOAT:
+			n = c.floats[row];
+			return true;
+
+		default:
+			break;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QString PropertyTableModel::GetText(int column, size_t row) const
+{
+	switch( column )
+	{
+		case FIXED_COLUMN_LIST:		return QString::number(m_Table->listIds[row]);
+		case FIXED_COLUMN_NUMBER:	return m_Table->numberText[row];
+		case FIXED_COLUMN_PART:		return ((m_Table->parts[row] > 0) ? QString::number(m_Table->parts[row]) : QString());
+	}
+
+	return PropertyTable::GetText(m_Table->columns[column - FIXED_COLUMN_COUNT], row);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QString PropertyTableModel::GetColumnName(int column) const
+{
+	switch( column )
+	{
+		case FIXED_COLUMN_LIST:		return "List";
+		case FIXED_COLUMN_NUMBER:	return "Number";
+		case FIXED_COLUMN_PART:		return "Part";
+	}
+
+	return m_Table->columns[column - FIXED_COLUMN_COUNT].name;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int PropertyTableModel::rowCount(const QModelIndex &parent) const
+{
+	return (parent.isValid() ? 0 : static_cast<int>(m_Rows.size()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int PropertyTableModel::columnCount(const QModelIndex &parent) const
+{
+	if(parent.isValid() || !m_Table)
+		return 0;
+	return static_cast<int>(FIXED_COLUMN_COUNT + m_Table->columns.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QVariant PropertyTableModel::data(const QModelIndex &index, int role) const
+{
+	if(!index.isValid() || index.row()>=static_cast<int>(m_Rows.size()) || index.column()>=columnCount())
+		return QVariant();
+
+	size_t row = static_cast<size_t>( m_Rows[index.row()] );
+	if(role == Qt::DisplayRole)
+		return GetText(index.column(), row);
+
+	if(role == Qt::TextAlignmentRole)
+	{
+		double n = 0;
+		if( GetNumber(index.column(),row,n) )
+			return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+	}
+
+	return QVariant();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QVariant PropertyTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if(orientation!=Qt::Horizontal || section<0 || section>=columnCount())
+		return QVariant();
+
+	if(role == Qt::DisplayRole)
+		return GetColumnName(section);
+
+	if(role==Qt::ToolTipRole && section>=FIXED_COLUMN_COUNT)
+		return QString( PropertyTable::GetColumnTypeName(m_Table->columns[section - FIXED_COLUMN_COUNT].type) );
+
+	return QVariant();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTableModel::sort(int column, Qt::SortOrder order)
+{
+	if(column>=columnCount() || (column==m_SortColumn && order==m_SortOrder))
+		return;
+
+	emit layoutAboutToBeChanged();
+	m_SortColumn = column;
+	m_SortOrder = order;
+	Rebuild();
+	emit layoutChanged();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PropertyTableView::PropertyTableView(QWidget *parent)
+	: QWidget(parent)
+{
+	QGridLayout *layout = new QGridLayout(this);
+	layout->setContentsMargins(0, 0, 0, 0);
+
+	m_Filter = new QLineEdit(this);
+	m_Filter->setToolTip("Text to find, or a column test such as \"3 > 50\" or \"Number >= 10\"");
+	connect(m_Filter, SIGNAL(textChanged(const QString&)), this, SLOT(onFilterChanged(const QString&)));
+	layout->addWidget(m_Filter, 0, 0);
+
+	m_Summary = new QLabel(this);
+	layout->addWidget(m_Summary, 0, 1);
+	layout->setColumnStretch(0, 1);
+
+	m_Model = new PropertyTableModel(this);
+
+	m_Table = new QTableView(this);
+	m_Table->setModel(m_Model);
+	m_Table->setSortingEnabled(true);
+	m_Table->setWordWrap(false);
+	m_Table->setSelectionBehavior(QAbstractItemView::SelectRows);
+	m_Table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	m_Table->verticalHeader()->hide();
+	m_Table->verticalHeader()->setDefaultSectionSize(m_Table->fontMetrics().height() + 4);
+	layout->addWidget(m_Table, 1, 0, 1, 2);
+
+	UpdateSummary();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTableView::Update(const PropertyTable &table)
+{
+	m_Model->SetTable( &table.GetTable() );
+	UpdateSummary();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTableView::onFilterChanged(const QString &text)
+{
+	m_Model->SetFilter(text);
+	UpdateSummary();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyTableView::UpdateSummary()
+{
+	bool filterOk = m_Model->GetFilterOk();
+	QPalette pal( m_Summary->palette() );
+	pal.setColor(QPalette::WindowText, filterOk ? MUTED_COLOR : ERROR_COLOR);
+	m_Summary->setPalette(pal);
+
+	if( filterOk )
+		m_Summary->setText( QString("%1 of %2").arg(m_Model->rowCount()).arg(m_Model->GetTotalRows()) );
+	else
+		m_Summary->setText("unknown column");
+}
+
+////////////////////////////////////////////////////////////////////////////////
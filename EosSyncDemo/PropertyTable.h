@@ -0,0 +1,226 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef PROPERTY_TABLE_H
+#define PROPERTY_TABLE_H
+
+#ifndef SHOW_SNAPSHOT_H
+#include "ShowSnapshot.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Typed, column-wise copy of one target type's properties for the details
+// window's table view.
+//
+// Each list is parsed from its ShowSnapshot copy once per generation it changes
+// in, on the thread pool, into one column per property position. A column's type is the narrowest of bool,
+// int, float and string that fits every value in it. Lists that did not
+// change keep their parsed columns, and combining lists for display only
+// widens types (int to float, anything to string) rather than reparsing.
+class PropertyTable
+{
+public:
+	enum EnumColumnType
+	{
+		COLUMN_NONE,	// no values
+		COLUMN_BOOL,
+		COLUMN_INT,
+		COLUMN_FLOAT,
+		COLUMN_STRING
+	};
+
+	struct sColumn
+	{
+		sColumn() : prop(0), type(COLUMN_NONE) {}
+		QString					name;
+		std::string				group;
+		int						prop;		// index within the group
+		EnumColumnType			type;
+		std::vector<bool>		present;
+		std::vector<qint64>		ints;		// COLUMN_BOOL, COLUMN_INT
+		std::vector<double>		floats;		// COLUMN_FLOAT
+		std::vector<QString>	strings;	// COLUMN_STRING
+	};
+
+	typedef std::vector<sColumn> COLUMNS;
+
+	struct sTable
+	{
+		std::vector<int>		listIds;
+		std::vector<double>		numbers;
+		std::vector<QString>	numberText;
+		std::vector<int>		parts;
+		COLUMNS					columns;
+
+		size_t GetRowCount() const {return numbers.size();}
+		void Clear();
+	};
+
+	PropertyTable();
+	virtual ~PropertyTable() {}
+
+	// any thread, on a table nothing else is reading; reparses only the lists
+	// whose snapshot copy isn't the one they were last parsed from
+	virtual bool Update(EosTarget::EnumEosTargetType type, const ShowSnapshot::sTargetType &targetType);
+	virtual void Clear();
+	virtual void CopyLists(const PropertyTable &other) {m_Lists = other.m_Lists;}	// parsed lists are shared, not copied
+	virtual void Swap(PropertyTable &other);
+	virtual const sTable& GetTable() const {return m_Table;}
+
+	static const char* GetColumnTypeName(EnumColumnType type);
+	static QString GetText(const sColumn &column, size_t row);
+
+protected:
+	struct sListJob
+	{
+		int								listId;
+		ShowSnapshot::TARGET_LIST_PTR	targetList;
+		sTable							table;
+	};
+
+	typedef QSharedPointer<const sTable> TABLE_PTR;
+
+	struct sListTable
+	{
+		ShowSnapshot::TARGET_LIST_PTR	source;		// the copy table was parsed from
+		TABLE_PTR						table;
+	};
+
+	typedef QVector<sListJob> LIST_JOBS;
+	typedef std::map<int, sListTable> LIST_TABLES;
+
+	LIST_TABLES	m_Lists;
+	sTable		m_Table;
+
+	virtual void Combine();
+
+	static void ParseList(sListJob &job);
+	static EnumColumnType GetValueType(const std::string &value, qint64 &n, double &f);
+	static void Widen(sColumn &column, EnumColumnType type);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Sorts and filters a PropertyTable without copying it. Rows are an index
+// into the table, so a sort is a stable sort of row numbers comparing the
+// typed values, and a filter is evaluated against numbers rather than text.
+class PropertyTableModel
+	: public QAbstractTableModel
+{
+public:
+	enum EnumFixedColumn
+	{
+		FIXED_COLUMN_LIST,
+		FIXED_COLUMN_NUMBER,
+		FIXED_COLUMN_PART,
+
+		FIXED_COLUMN_COUNT
+	};
+
+	PropertyTableModel(QObject *parent);
+
+	virtual void SetTable(const PropertyTable::sTable *table);
+	virtual bool SetFilter(const QString &filter);
+	virtual bool GetFilterOk() const {return m_FilterOk;}
+	virtual size_t GetTotalRows() const {return (m_Table ? m_Table->GetRowCount() : 0);}
+
+	virtual int rowCount(const QModelIndex &parent=QModelIndex()) const;
+	virtual int columnCount(const QModelIndex &parent=QModelIndex()) const;
+	virtual QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const;
+	virtual QVariant headerData(int section, Qt::Orientation orientation, int role=Qt::DisplayRole) const;
+	virtual void sort(int column, Qt::SortOrder order=Qt::AscendingOrder);
+
+protected:
+	enum EnumFilterOp
+	{
+		FILTER_NONE,
+		FILTER_TEXT,	// any column contains the text
+		FILTER_EQ,
+		FILTER_NE,
+		FILTER_LT,
+		FILTER_LE,
+		FILTER_GT,
+		FILTER_GE
+	};
+
+	struct sFilter
+	{
+		sFilter() : op(FILTER_NONE), column(-1), number(0), isNumber(false) {}
+		EnumFilterOp	op;
+		int				column;
+		QString			text;
+		double			number;
+		bool			isNumber;
+	};
+
+	const PropertyTable::sTable	*m_Table;
+	std::vector<int>			m_Rows;
+	int							m_SortColumn;	// -1 for table order
+	Qt::SortOrder				m_SortOrder;
+	QString						m_FilterText;
+	sFilter						m_Filter;
+	bool						m_FilterOk;		// false if it names an unknown column
+
+	virtual bool ParseFilter(const QString &filter);
+	virtual void Rebuild();
+	virtual bool Matches(size_t row) const;
+	virtual bool GetNumber(int column, size_t row, double &n) const;
+	virtual QString GetText(int column, size_t row) const;
+	virtual QString GetColumnName(int column) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class PropertyTableView
+	: public QWidget
+{
+	Q_OBJECT
+
+public:
+	PropertyTableView(QWidget *parent);
+
+	virtual void Update(const PropertyTable &table);
+
+private slots:
+	void onFilterChanged(const QString &text);
+
+protected:
+	QLineEdit			*m_Filter;
+	QLabel				*m_Summary;
+	QTableView			*m_Table;
+	PropertyTableModel	*m_Model;
+
+	virtual void UpdateSummary();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
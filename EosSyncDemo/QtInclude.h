@@ -34,14 +34,24 @@
 #define BG_COLOR		QColor(40,40,40)
 
 #include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
 #include <QtCore/QTimer>
 #include <QtCore/QThread>
 #include <QtCore/QSettings>
 #include <QtCore/QFile>
 #include <QtCore/QDir>
+#include <QtCore/QProcess>
 #include <QtCore/QTextStream>
 #include <QtCore/QUrl>
+#include <QtCore/QVector>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QSharedMemory>
+#include <QtCore/QAbstractItemModel>
+#include <QtCore/QtConcurrentMap>
+#include <QtCore/QtConcurrentRun>
+#include <QtCore/QFutureWatcher>
 
 #include <QtGui/QApplication>
 #include <QtGui/QWidget>
@@ -52,15 +62,28 @@
 #include <QtGui/QScrollBar>
 #include <QtGui/QLineEdit>
 #include <QtGui/QSpinBox>
+#include <QtGui/QComboBox>
 #include <QtGui/QLabel>
 #include <QtGui/QSplitter>
 #include <QtGui/QScrollArea>
 #include <QtGui/QProgressBar>
 #include <QtGui/QTextEdit>
+#include <QtGui/QTableWidget>
+#include <QtGui/QHeaderView>
+#include <QtGui/QTableView>
+#include <QtGui/QTabWidget>
 #include <QtGui/QSpacerItem>
 #include <QtGui/QDesktopServices>
+#include <QtGui/QFileDialog>
+#include <QtGui/QMenu>
+#include <QtGui/QBoxLayout>
 
 #include <QtNetwork/QNetworkInterface>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtNetwork/QUdpSocket>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
 
 ////////////////////////////////////////////////////////////////////////////////
 
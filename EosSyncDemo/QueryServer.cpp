@@ -0,0 +1,386 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "QueryServer.h"
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define MAX_QUERY_LEN		4096
+#define DEFAULT_QUERY_LIMIT	1000	// rows, when a query doesn't say
+#define MAX_QUERY_LIMIT		100000
+#define PROBE_TIMEOUT_MS	500
+
+////////////////////////////////////////////////////////////////////////////////
+
+// orders targets by number alone, for seeking to from=
+static bool NumberLess(const ShowSnapshot::sTarget &target, double number)
+{
+	return (target.numberValue < number);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QueryServer::QueryServer(const ShowSnapshot &snapshot)
+	: m_Snapshot(snapshot)
+	, m_ClientBufferSize(0)
+	, m_DroppedClients(0)
+	, m_Listening(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QueryServer::~QueryServer()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool QueryServer::Start(const QString &name, unsigned int clientBufferSize, QString &error)
+{
+	Stop();
+
+	m_Name = name;
+	m_ClientBufferSize = clientBufferSize;
+	m_Listening = false;
+	m_Error.clear();
+
+	// wait for run() to report whether it could listen
+	m_StartMutex.lock();
+	start();
+	m_StartWait.wait(&m_StartMutex);
+	bool listening = m_Listening;
+	error = m_Error;
+	m_StartMutex.unlock();
+
+	if( !listening )
+		wait();
+
+	return listening;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryServer::Stop()
+{
+	// quit() is lost if it lands before exec() has started, so keep asking
+	while( isRunning() )
+	{
+		quit();
+		wait(50);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryServer::run()
+{
+	QueryServerWorker worker(m_Snapshot, m_ClientBufferSize, m_DroppedClients);
+	QString error;
+	bool listening = worker.Listen(m_Name, error);
+
+	m_StartMutex.lock();
+	m_Listening = listening;
+	m_Error = error;
+	m_StartWait.wakeAll();
+	m_StartMutex.unlock();
+
+	if( listening )
+		exec();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryServer::Query(const ShowSnapshot &snapshot, const QByteArray &line, QByteArray &response)
+{
+	QStringList tokens( QString::fromUtf8(line.constData(),line.size()).trimmed().split(' ',QString::SkipEmptyParts) );
+	if( tokens.isEmpty() )
+		return;
+
+	const QString &cmd = tokens.front();
+
+	if(cmd == "types")
+	{
+		for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		{
+			EosTarget::EnumEosTargetType type = static_cast<EosTarget::EnumEosTargetType>(i);
+			ShowSnapshot::TARGET_TYPE_PTR targetType = snapshot.GetTargetType(type);
+			response.append( EosTarget::GetNameForTargetType(type) );
+			response.append( QString("\t%1\t%2\t%3\n")
+				.arg(targetType ? targetType->generation : 0)
+				.arg(targetType ? targetType->numLists : 0)
+				.arg(targetType ? targetType->numTargets : 0).toUtf8() );
+		}
+		response.append(".\n");
+		return;
+	}
+
+	EosTarget::EnumEosTargetType type;
+	if( !ShowSnapshot::GetTargetTypeForName(cmd,type) )
+	{
+		response.append( QString("! unknown target type \"%1\"\n.\n").arg(cmd).toUtf8() );
+		return;
+	}
+
+	bool hasList = false;
+	int listId = 0;
+	bool hasFrom = false;
+	double from = 0;
+	bool hasTo = false;
+	double to = 0;
+	bool hasGroup = false;
+	std::string group;
+	std::string value;
+	int limit = DEFAULT_QUERY_LIMIT;
+
+	for(int i=1; i<tokens.size(); i++)
+	{
+		const QString &token = tokens[i];
+		int eq = token.indexOf('=');
+		QString key( token.left(eq) );
+		QString val( token.mid(eq+1) );
+		bool ok = false;
+		if(key == "list")
+		{
+			listId = val.toInt(&ok);
+			hasList = ok;
+		}
+		else if(key == "from")
+		{
+			from = val.toDouble(&ok);
+			hasFrom = ok;
+		}
+		else if(key == "to")
+		{
+			to = val.toDouble(&ok);
+			hasTo = ok;
+		}
+		else if(key == "group")
+		{
+			hasGroup = true;
+			group = val.toUtf8().constData();
+			ok = true;
+		}
+		else if(key == "value")
+		{
+			value = val.toUtf8().constData();
+			ok = true;
+		}
+		else if(key == "limit")
+		{
+			limit = val.toInt(&ok);
+			ok = (ok && limit>0 && limit<=MAX_QUERY_LIMIT);
+		}
+
+		if(eq<=0 || !ok)
+		{
+			response.append( QString("! bad option \"%1\"\n.\n").arg(token).toUtf8() );
+			return;
+		}
+	}
+
+	ShowSnapshot::TARGET_TYPE_PTR targetType = snapshot.LoadTargetType( snapshot.GetTargetType(type) );
+	if( targetType )
+	{
+		const char *typeName = EosTarget::GetNameForTargetType(type);
+		int count = 0;
+
+		const ShowSnapshot::TARGET_LISTS &lists = targetType->lists;
+		for(ShowSnapshot::TARGET_LISTS::const_iterator i=lists.begin(); i!=lists.end() && count!=limit; i++)
+		{
+			if(hasList && i->first!=listId)
+				continue;
+
+			QByteArray listStr( QByteArray::number(i->first) );
+			// targets are in number order, so a range is a seek and an early out
+			const ShowSnapshot::TARGETS &targets = i->second->targets;
+			ShowSnapshot::TARGETS::const_iterator j = (hasFrom ? std::lower_bound(targets.begin(),targets.end(),from,NumberLess) : targets.begin());
+			for(; j!=targets.end() && count!=limit; j++)
+			{
+				const ShowSnapshot::sTarget &target = *j;
+				if(hasTo && target.numberValue>to)
+					break;
+
+				for(ShowSnapshot::PROP_GROUPS::const_iterator k=target.propGroups.begin(); k!=target.propGroups.end() && count!=limit; k++)
+				{
+					const ShowSnapshot::sPropGroup &propGroup = *k;
+					if(hasGroup && propGroup.name!=group)
+						continue;
+
+					if( !value.empty() )
+					{
+						bool found = false;
+						for(std::vector<std::string>::const_iterator l=propGroup.values.begin(); !found && l!=propGroup.values.end(); l++)
+							found = (l->find(value) != std::string::npos);
+						if( !found )
+							continue;
+					}
+
+					response.append(typeName);
+					response.append('\t');
+					response.append(listStr);
+					response.append('\t');
+					AppendField(target.number, response);
+					response.append('\t');
+					response.append( QByteArray::number(target.part) );
+					response.append('\t');
+					AppendField(propGroup.name, response);
+					for(std::vector<std::string>::const_iterator l=propGroup.values.begin(); l!=propGroup.values.end(); l++)
+					{
+						response.append('\t');
+						AppendField(*l, response);
+					}
+					response.append('\n');
+					count++;
+				}
+			}
+		}
+	}
+
+	response.append(".\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryServer::AppendField(const std::string &str, QByteArray &response)
+{
+	// keep rows and fields intact
+	int start = response.size();
+	response.append(str.c_str(), static_cast<int>(str.size()));
+	for(int i=start; i<response.size(); i++)
+	{
+		char c = response[i];
+		if(c=='\t' || c=='\n' || c=='\r')
+			response[i] = ' ';
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QueryServerWorker::QueryServerWorker(const ShowSnapshot &snapshot, unsigned int clientBufferSize, QAtomicInt &droppedClients)
+	: m_Snapshot(snapshot)
+	, m_ClientBufferSize(clientBufferSize)
+	, m_DroppedClients(droppedClients)
+	, m_Server(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool QueryServerWorker::Listen(const QString &name, QString &error)
+{
+	if( !m_Server )
+	{
+		m_Server = new QLocalServer(this);
+		connect(m_Server, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+	}
+
+	if( m_Server->listen(name) )
+		return true;
+
+	// a socket left behind by a run that crashed can go, one another instance is serving can't
+	if(m_Server->serverError()==QAbstractSocket::AddressInUseError && !IsServing(name))
+	{
+		QLocalServer::removeServer(name);
+		if( m_Server->listen(name) )
+			return true;
+	}
+
+	error = m_Server->errorString();
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool QueryServerWorker::IsServing(const QString &name)
+{
+	QLocalSocket probe;
+	probe.connectToServer(name);
+	bool serving = probe.waitForConnected(PROBE_TIMEOUT_MS);
+	probe.abort();
+	return serving;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryServerWorker::onNewConnection()
+{
+	while( m_Server->hasPendingConnections() )
+	{
+		QLocalSocket *socket = m_Server->nextPendingConnection();
+		if( socket )
+		{
+			connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+			connect(socket, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryServerWorker::onReadyRead()
+{
+	QLocalSocket *socket = qobject_cast<QLocalSocket*>( sender() );
+	if( !socket )
+		return;
+
+	// no more answers once a client has the cap's worth waiting unread; it
+	// goes, rather than be sent part of one
+	QByteArray response;
+	bool full = false;
+	while( socket->canReadLine() )
+	{
+		if(socket->bytesToWrite()+response.size() > static_cast<qint64>(m_ClientBufferSize))
+		{
+			full = true;
+			break;
+		}
+
+		QByteArray line( socket->readLine() );
+		QueryServer::Query(m_Snapshot, line, response);
+	}
+
+	if( full )
+	{
+		m_DroppedClients.ref();
+		socket->abort();
+		return;
+	}
+
+	if( !response.isEmpty() )
+		socket->write(response);
+
+	// no newline in sight, not a client we understand
+	if(!socket->canReadLine() && socket->bytesAvailable()>MAX_QUERY_LEN)
+		socket->abort();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryServerWorker::onDisconnected()
+{
+	QObject *socket = sender();
+	if( socket )
+		socket->deleteLater();
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,106 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#ifndef SHOW_SNAPSHOT_H
+#include "ShowSnapshot.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Answers show data queries from other local processes over a QLocalServer
+// (a Unix domain socket, or a named pipe on Windows). One query per line:
+//
+//   types
+//   <target type> [list=<n>] [from=<number>] [to=<number>] [group=<name>] [value=<text>] [limit=<n>]
+//
+// Each query is answered with tab separated rows followed by a "." line.
+// Rows are <type> <list> <number> <part> <group> <values...>; errors are a
+// single "! <message>" row. A query returns at most 1000 rows unless it asks
+// for up to 100000 with limit=. All queries received together are answered in
+// one write. Queries are served from ShowSnapshot, never from EosSyncLib.
+//
+// Answers a client hasn't read yet are bounded by clientBufferSize, plus at
+// most the one answer that crosses it. A client that lets more pile up is
+// disconnected rather than sent part of an answer, and counted.
+class QueryServer
+	: public QThread
+{
+public:
+	QueryServer(const ShowSnapshot &snapshot);
+	virtual ~QueryServer();
+
+	virtual bool Start(const QString &name, unsigned int clientBufferSize, QString &error);
+	virtual void Stop();
+	virtual unsigned int GetDroppedClients() const {return static_cast<unsigned int>(static_cast<int>(m_DroppedClients));}
+
+	static void Query(const ShowSnapshot &snapshot, const QByteArray &line, QByteArray &response);
+
+protected:
+	const ShowSnapshot	&m_Snapshot;
+	QString				m_Name;
+	unsigned int		m_ClientBufferSize;
+	QAtomicInt			m_DroppedClients;
+	QString				m_Error;
+	bool				m_Listening;
+	QMutex				m_StartMutex;
+	QWaitCondition		m_StartWait;
+
+	virtual void run();
+
+	static void AppendField(const std::string &str, QByteArray &response);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class QueryServerWorker
+	: public QObject
+{
+	Q_OBJECT
+
+public:
+	QueryServerWorker(const ShowSnapshot &snapshot, unsigned int clientBufferSize, QAtomicInt &droppedClients);
+
+	virtual bool Listen(const QString &name, QString &error);
+
+	static bool IsServing(const QString &name);
+
+private slots:
+	void onNewConnection();
+	void onReadyRead();
+	void onDisconnected();
+
+private:
+	const ShowSnapshot	&m_Snapshot;
+	unsigned int		m_ClientBufferSize;
+	QAtomicInt			&m_DroppedClients;
+	QLocalServer		*m_Server;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,651 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SharedSnapshot.h"
+#include <string.h>
+
+#ifdef WIN32
+#include <intrin.h>
+#pragma intrinsic(_ReadWriteBarrier)
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define ALIGN8(x)			((static_cast<quint32>(x) + 7) & ~7u)
+#define BEGIN_READ_TRIES	64
+
+////////////////////////////////////////////////////////////////////////////////
+
+SharedSnapshot::SharedSnapshot()
+	: m_Header(0)
+	, m_Overflow(0)
+	, m_ChangeHub(0)
+	, m_Subscription(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SharedSnapshot::~SharedSnapshot()
+{
+	Unsubscribe();
+	Destroy();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SharedSnapshot::Subscribe(ChangeHub &changeHub)
+{
+	Unsubscribe();
+	m_ChangeHub = &changeHub;
+	m_Subscription = changeHub.Subscribe();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SharedSnapshot::Unsubscribe()
+{
+	if( m_ChangeHub )
+	{
+		m_ChangeHub->Unsubscribe(m_Subscription);
+		m_ChangeHub = 0;
+		m_Subscription = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SharedSnapshot::Create(const QString &key, unsigned int sizeMB, QString &error)
+{
+	Destroy();
+
+	unsigned int headerSize = ALIGN8( sizeof(sHeader) );
+	unsigned int size = (sizeMB * 1024 * 1024);
+	if(size < headerSize+BANKS*ALIGN8(sizeof(sBank)))
+	{
+		error = QString("%1 MB is too small").arg(sizeMB);
+		return false;
+	}
+
+	m_Memory.setKey(key);
+	if( !m_Memory.create(size) )
+	{
+		// a crashed run can leave the segment behind on Unix, attaching and
+		// detaching again releases it if nobody else is using it
+		if(m_Memory.error() == QSharedMemory::AlreadyExists)
+		{
+			if( m_Memory.attach() )
+				m_Memory.detach();
+		}
+
+		if( !m_Memory.create(size) )
+		{
+			error = m_Memory.errorString();
+			return false;
+		}
+	}
+
+	char *base = static_cast<char*>( m_Memory.data() );
+	memset(base, 0, m_Memory.size());
+
+	m_Header = reinterpret_cast<sHeader*>(base);
+	m_Header->version = VERSION;
+	m_Header->typeCount = EosTarget::EOS_TARGET_COUNT;
+	m_Header->bankSize = ((m_Memory.size() - headerSize) / BANKS) & ~7u;
+	m_Header->activeBank = 0;
+	Barrier();
+	m_Header->magic = MAGIC;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SharedSnapshot::Destroy()
+{
+	if( m_Header )
+	{
+		m_Header->magic = 0;
+		m_Header = 0;
+	}
+
+	if( m_Memory.isAttached() )
+		m_Memory.detach();
+
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		m_Published[i].clear();
+		m_Blocks[i].clear();
+	}
+	m_Overflow = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int SharedSnapshot::Publish(const ShowSnapshot &snapshot)
+{
+	if( !m_Header )
+		return 0;
+
+	// the lists named since the last publish; after a gap, or unsubscribed,
+	// every list of a changed type is serialized again
+	ChangeHub::LIST_IDS changedLists[EosTarget::EOS_TARGET_COUNT];
+	bool complete = false;
+	if( m_ChangeHub )
+	{
+		ChangeHub::BATCHES batches;
+		complete = m_ChangeHub->Take(m_Subscription, batches);
+		if( complete )
+			ChangeHub::GetChangedLists(batches, changedLists);
+	}
+
+	ShowSnapshot::TARGET_TYPE_PTR targetTypes[EosTarget::EOS_TARGET_COUNT];
+	bool changed = false;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		targetTypes[i] = snapshot.GetTargetType( static_cast<EosTarget::EnumEosTargetType>(i) );
+		const ShowSnapshot::TARGET_TYPE_PTR &targetType = targetTypes[i];
+		if(targetType == m_Published[i])
+			continue;
+
+		// spilling or restoring a type swaps the pointer but not the generation,
+		// and its blocks already hold the content
+		if(targetType && m_Published[i] && targetType->generation==m_Published[i]->generation)
+			continue;
+
+		changed = true;
+		LIST_BLOCKS &blocks = m_Blocks[i];
+		if( !targetType )
+		{
+			blocks.clear();
+			continue;
+		}
+
+		bool whole = (!complete || !m_Published[i]);
+		const ChangeHub::LIST_IDS &listIds = changedLists[i];
+		if(!whole && listIds.empty())
+			continue;
+
+		// a type spilled by the memory budget is read back only to serialize
+		// its changed lists, and released again once they are
+		ShowSnapshot::TARGET_TYPE_PTR loaded = snapshot.LoadTargetType(targetType);
+		const ShowSnapshot::TARGET_LISTS &lists = loaded->lists;
+		if( whole )
+		{
+			blocks.clear();
+			for(ShowSnapshot::TARGET_LISTS::const_iterator j=lists.begin(); j!=lists.end(); j++)
+				BuildBlock(*(j->second), blocks[j->first]);
+		}
+		else
+		{
+			for(ChangeHub::LIST_IDS::const_iterator j=listIds.begin(); j!=listIds.end(); j++)
+			{
+				ShowSnapshot::TARGET_LISTS::const_iterator list = lists.find(*j);
+				if(list == lists.end())
+					blocks.erase(*j);
+				else
+					BuildBlock(*(list->second), blocks[*j]);
+			}
+		}
+	}
+
+	if( !changed )
+		return m_Overflow;
+
+	sTypeSize sizes[EosTarget::EOS_TARGET_COUNT];
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		GetTypeSize(i, sizes[i]);
+
+	// the last byte of a bank is never written, so a torn read of a string
+	// still finds a terminator before running off the end
+	unsigned int bankSize = (m_Header->bankSize - 1);
+
+	// lay out every type, dropping the largest ones until the rest fit
+	bool excluded[EosTarget::EOS_TARGET_COUNT];
+	memset(excluded, 0, sizeof(excluded));
+	unsigned int numExcluded = 0;
+	quint32 targetsOffset, groupsOffset, valuesOffset, stringsOffset, used;
+	for(;;)
+	{
+		sTypeSize total;
+		memset(&total, 0, sizeof(total));
+		total.strings = 1;	// the empty string every pool starts with
+		for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		{
+			if(targetTypes[i] && !excluded[i])
+			{
+				total.targets += sizes[i].targets;
+				total.groups += sizes[i].groups;
+				total.values += sizes[i].values;
+				total.strings += sizes[i].strings;
+			}
+		}
+
+		targetsOffset = ALIGN8( sizeof(sBank) );
+		groupsOffset = ALIGN8( targetsOffset + total.targets*sizeof(sTargetEntry) );
+		valuesOffset = ALIGN8( groupsOffset + total.groups*sizeof(sGroupEntry) );
+		stringsOffset = ALIGN8( valuesOffset + total.values*sizeof(quint32) );
+		used = static_cast<quint32>(stringsOffset + total.strings);
+		if(used <= bankSize)
+			break;
+
+		int largest = -1;
+		for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		{
+			if(targetTypes[i] && !excluded[i] && sizes[i].targets!=0 && (largest<0 || sizes[i].targets>sizes[largest].targets))
+				largest = i;
+		}
+		if(largest < 0)
+		{
+			// not even an empty bank fits, so nothing is published; count every
+			// type as overflowed so the unchanged path keeps reporting it
+			m_Overflow = 0;
+			for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+			{
+				if( targetTypes[i] )
+					m_Overflow++;
+			}
+			return m_Overflow;
+		}
+		excluded[largest] = true;
+		numExcluded++;
+	}
+
+	// write the idle bank
+	quint32 bankIndex = ((m_Header->activeBank + 1) % BANKS);
+	char *base = static_cast<char*>( m_Memory.data() );
+	char *bankBase = (base + GetBankOffset(bankIndex,m_Header->bankSize));
+	sBank *bank = reinterpret_cast<sBank*>(bankBase);
+
+	bank->seq++;
+	Barrier();
+
+	bank->generation = (m_Header->generation + 1);
+	bank->used = used;
+	bank->targetsOffset = targetsOffset;
+	bank->groupsOffset = groupsOffset;
+	bank->valuesOffset = valuesOffset;
+	bank->stringsOffset = stringsOffset;
+	bankBase[stringsOffset] = '\0';
+
+	sTypeSize cursor;
+	memset(&cursor, 0, sizeof(cursor));
+	cursor.strings = 1;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		sTypeEntry entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.firstTarget = static_cast<quint32>(cursor.targets);
+		if( targetTypes[i] )
+		{
+			entry.generation = targetTypes[i]->generation;
+			if( excluded[i] )
+				entry.flags = TYPE_FLAG_OVERFLOW;
+			else
+			{
+				const LIST_BLOCKS &blocks = m_Blocks[i];
+				entry.numLists = static_cast<quint32>( blocks.size() );
+				entry.numTargets = static_cast<quint32>( sizes[i].targets );
+				for(LIST_BLOCKS::const_iterator j=blocks.begin(); j!=blocks.end(); j++)
+					WriteBlock(j->second, bankBase, *bank, cursor);
+			}
+		}
+		bank->types[i] = entry;
+	}
+
+	Barrier();
+	bank->seq++;
+
+	// flip readers over to it
+	Barrier();
+	m_Header->activeBank = bankIndex;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		m_Header->typeGenerations[i] = bank->types[i].generation;
+	m_Header->generation = bank->generation;
+
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		m_Published[i] = targetTypes[i];
+
+	m_Overflow = numExcluded;
+	return numExcluded;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+quint32 SharedSnapshot::AddString(const std::string &str, sListBlock &block)
+{
+	STRING_OFFSETS::const_iterator i = m_StringOffsets.find(str);
+	if(i != m_StringOffsets.end())
+		return i->second;
+
+	quint32 offset = static_cast<quint32>( block.strings.size() );
+	block.strings.append(str.c_str(), static_cast<int>(str.size()));
+	block.strings.append('\0');
+	m_StringOffsets[str] = offset;
+	return offset;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SharedSnapshot::BuildBlock(const ShowSnapshot::sTargetList &targetList, sListBlock &block)
+{
+	block.targets.clear();
+	block.groups.clear();
+	block.values.clear();
+	block.strings.clear();
+	m_StringOffsets.clear();
+
+	const ShowSnapshot::TARGETS &targets = targetList.targets;
+	block.targets.reserve( targets.size() );
+	for(ShowSnapshot::TARGETS::const_iterator i=targets.begin(); i!=targets.end(); i++)
+	{
+		const ShowSnapshot::sTarget &target = *i;
+
+		sTargetEntry t;
+		memset(&t, 0, sizeof(t));
+		t.numberValue = target.numberValue;
+		t.timestamp = static_cast<qint64>(target.timestamp);
+		t.listId = targetList.listId;
+		t.part = target.part;
+		t.number = AddString(target.number, block);
+		t.firstGroup = static_cast<quint32>( block.groups.size() );
+		t.numGroups = static_cast<quint32>( target.propGroups.size() );
+
+		for(ShowSnapshot::PROP_GROUPS::const_iterator j=target.propGroups.begin(); j!=target.propGroups.end(); j++)
+		{
+			sGroupEntry g;
+			g.name = AddString(j->name, block);
+			g.firstValue = static_cast<quint32>( block.values.size() );
+			g.numValues = static_cast<quint32>( j->values.size() );
+			for(std::vector<std::string>::const_iterator k=j->values.begin(); k!=j->values.end(); k++)
+				block.values.push_back( AddString(*k,block) );
+			block.groups.push_back(g);
+		}
+
+		block.targets.push_back(t);
+	}
+
+	m_StringOffsets.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SharedSnapshot::GetTypeSize(int type, sTypeSize &size) const
+{
+	memset(&size, 0, sizeof(size));
+	const LIST_BLOCKS &blocks = m_Blocks[type];
+	for(LIST_BLOCKS::const_iterator i=blocks.begin(); i!=blocks.end(); i++)
+	{
+		const sListBlock &block = i->second;
+		size.targets += block.targets.size();
+		size.groups += block.groups.size();
+		size.values += block.values.size();
+		size.strings += block.strings.size();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SharedSnapshot::WriteBlock(const sListBlock &block, char *bankBase, const sBank &bank, sTypeSize &cursor)
+{
+	// block offsets become bank offsets by adding where each part lands
+	quint32 firstGroup = static_cast<quint32>(cursor.groups);
+	quint32 firstValue = static_cast<quint32>(cursor.values);
+	quint32 firstString = static_cast<quint32>(cursor.strings);
+
+	sTargetEntry *targets = (reinterpret_cast<sTargetEntry*>(bankBase + bank.targetsOffset) + cursor.targets);
+	for(size_t i=0; i<block.targets.size(); i++)
+	{
+		sTargetEntry t = block.targets[i];
+		t.number += firstString;
+		t.firstGroup += firstGroup;
+		targets[i] = t;
+	}
+
+	sGroupEntry *groups = (reinterpret_cast<sGroupEntry*>(bankBase + bank.groupsOffset) + cursor.groups);
+	for(size_t i=0; i<block.groups.size(); i++)
+	{
+		sGroupEntry g = block.groups[i];
+		g.name += firstString;
+		g.firstValue += firstValue;
+		groups[i] = g;
+	}
+
+	quint32 *values = (reinterpret_cast<quint32*>(bankBase + bank.valuesOffset) + cursor.values);
+	for(size_t i=0; i<block.values.size(); i++)
+		values[i] = (block.values[i] + firstString);
+
+	memcpy(bankBase+bank.stringsOffset+firstString, block.strings.constData(), block.strings.size());
+
+	cursor.targets += block.targets.size();
+	cursor.groups += block.groups.size();
+	cursor.values += block.values.size();
+	cursor.strings += block.strings.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int SharedSnapshot::GetBankOffset(unsigned int bank, unsigned int bankSize)
+{
+	return (ALIGN8(sizeof(sHeader)) + bank*bankSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SharedSnapshot::Barrier()
+{
+#ifdef WIN32
+	// x86 keeps loads and stores in order, just stop the compiler reordering them
+	_ReadWriteBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const SharedSnapshot::sTypeEntry* SharedSnapshotReader::sView::GetType(EosTarget::EnumEosTargetType type) const
+{
+	if(type>=0 && type<EosTarget::EOS_TARGET_COUNT)
+		return &bank->types[type];
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Everything below may be looking at a bank that is being rewritten, so all
+// offsets are range checked; EndRead() decides whether the result is valid.
+
+const SharedSnapshot::sTargetEntry* SharedSnapshotReader::sView::GetTargets(const SharedSnapshot::sTypeEntry &type) const
+{
+	quint64 end = (bank->targetsOffset + (static_cast<quint64>(type.firstTarget) + type.numTargets)*sizeof(SharedSnapshot::sTargetEntry));
+	if(end > bank->used)
+		return 0;
+	const char *base = reinterpret_cast<const char*>(bank);
+	return (reinterpret_cast<const SharedSnapshot::sTargetEntry*>(base + bank->targetsOffset) + type.firstTarget);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const SharedSnapshot::sGroupEntry* SharedSnapshotReader::sView::GetGroups(const SharedSnapshot::sTargetEntry &target) const
+{
+	quint64 end = (bank->groupsOffset + (static_cast<quint64>(target.firstGroup) + target.numGroups)*sizeof(SharedSnapshot::sGroupEntry));
+	if(end > bank->used)
+		return 0;
+	const char *base = reinterpret_cast<const char*>(bank);
+	return (reinterpret_cast<const SharedSnapshot::sGroupEntry*>(base + bank->groupsOffset) + target.firstGroup);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* SharedSnapshotReader::sView::GetValue(const SharedSnapshot::sGroupEntry &group, quint32 index) const
+{
+	if(index >= group.numValues)
+		return "";
+	quint64 end = (bank->valuesOffset + (static_cast<quint64>(group.firstValue) + index + 1)*sizeof(quint32));
+	if(end > bank->used)
+		return "";
+	const char *base = reinterpret_cast<const char*>(bank);
+	return GetString( reinterpret_cast<const quint32*>(base + bank->valuesOffset)[group.firstValue + index] );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* SharedSnapshotReader::sView::GetString(quint32 offset) const
+{
+	if(static_cast<quint64>(bank->stringsOffset)+offset >= bank->used)
+		return "";
+	return (reinterpret_cast<const char*>(bank) + bank->stringsOffset + offset);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SharedSnapshotReader::SharedSnapshotReader()
+	: m_Header(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SharedSnapshotReader::~SharedSnapshotReader()
+{
+	Detach();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SharedSnapshotReader::Attach(const QString &key, QString &error)
+{
+	Detach();
+
+	m_Memory.setKey(key);
+	if( !m_Memory.attach(QSharedMemory::ReadOnly) )
+	{
+		error = m_Memory.errorString();
+		return false;
+	}
+
+	const SharedSnapshot::sHeader *header = static_cast<const SharedSnapshot::sHeader*>( m_Memory.constData() );
+	if(static_cast<size_t>(m_Memory.size()) < sizeof(SharedSnapshot::sHeader) || header->magic!=SharedSnapshot::MAGIC)
+		error = "not a show data snapshot";
+	else if(header->version!=SharedSnapshot::VERSION || header->typeCount!=EosTarget::EOS_TARGET_COUNT)
+		error = QString("unsupported snapshot version %1").arg(header->version);
+	else if(static_cast<unsigned int>(m_Memory.size()) < SharedSnapshot::GetBankOffset(SharedSnapshot::BANKS,header->bankSize))
+		error = "truncated snapshot";
+	else
+	{
+		SharedSnapshot::Barrier();
+		m_Header = header;
+		return true;
+	}
+
+	m_Memory.detach();
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SharedSnapshotReader::Detach()
+{
+	m_Header = 0;
+	if( m_Memory.isAttached() )
+		m_Memory.detach();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+quint32 SharedSnapshotReader::GetGeneration() const
+{
+	return (m_Header ? m_Header->generation : 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+quint32 SharedSnapshotReader::GetTypeGeneration(EosTarget::EnumEosTargetType type) const
+{
+	if(m_Header && type>=0 && type<EosTarget::EOS_TARGET_COUNT)
+		return m_Header->typeGenerations[type];
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SharedSnapshotReader::BeginRead(sView &view) const
+{
+	if(!m_Header || m_Header->magic!=SharedSnapshot::MAGIC)
+		return false;
+
+	const char *base = static_cast<const char*>( m_Memory.constData() );
+	for(int i=0; i<BEGIN_READ_TRIES; i++)
+	{
+		quint32 bankIndex = (m_Header->activeBank % SharedSnapshot::BANKS);
+		SharedSnapshot::Barrier();
+		view.bank = reinterpret_cast<const SharedSnapshot::sBank*>(base + SharedSnapshot::GetBankOffset(bankIndex,m_Header->bankSize));
+		view.seq = view.bank->seq;
+		SharedSnapshot::Barrier();
+		if((view.seq & 1) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SharedSnapshotReader::EndRead(const sView &view) const
+{
+	SharedSnapshot::Barrier();
+	return (view.bank->seq == view.seq);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SharedSnapshotReader::FindTarget(const sView &view, const SharedSnapshot::sTypeEntry &type, int listId, double numberValue, int part, const SharedSnapshot::sTargetEntry *&target)
+{
+	const SharedSnapshot::sTargetEntry *targets = view.GetTargets(type);
+	if( !targets )
+		return false;
+
+	// index is sorted by list, number, part
+	quint32 lo = 0;
+	quint32 hi = type.numTargets;
+	while(lo < hi)
+	{
+		quint32 mid = (lo + (hi - lo)/2);
+		const SharedSnapshot::sTargetEntry &t = targets[mid];
+		bool less = (t.listId != listId)
+			? (t.listId < listId)
+			: ((t.numberValue != numberValue) ? (t.numberValue < numberValue) : (t.part < part));
+		if( less )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if(lo<type.numTargets && targets[lo].listId==listId && targets[lo].numberValue==numberValue && targets[lo].part==part)
+	{
+		target = &targets[lo];
+		return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,229 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef SHARED_SNAPSHOT_H
+#define SHARED_SNAPSHOT_H
+
+#ifndef SHOW_SNAPSHOT_H
+#include "ShowSnapshot.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Publishes ShowSnapshot into a QSharedMemory segment that any number of local
+// processes can read in place, without locks and without talking to this one.
+//
+// The segment is a header followed by two banks. The writer fills the idle
+// bank, then flips the header over to it. Each bank carries its own sequence
+// number that is odd while it is being written, so a reader that was lapped
+// by two publishes sees the number change and retries (a seqlock). Readers
+// never block the writer.
+//
+// Inside a bank, each target type has a generation counter and a range in a
+// compact target index sorted by list, number and part. Targets point at
+// property groups, groups point at value string offsets, and all strings are
+// NUL terminated UTF-8 in a shared pool. Every offset is relative to the bank.
+//
+// Each list is serialized once into a block of its own, with offsets relative
+// to the block, and a publish copies the blocks into the bank, rebasing the
+// offsets. Subscribed to the snapshot's ChangeHub, only the lists the change
+// batches name are serialized again; after missed batches, every list of a
+// changed type is.
+class SharedSnapshot
+{
+public:
+	enum EnumConstants
+	{
+		MAGIC	= 0x53534f45,	// "EOSS"
+		VERSION	= 1,
+		BANKS	= 2
+	};
+
+	enum EnumTypeFlags
+	{
+		TYPE_FLAG_OVERFLOW	= 0x01	// did not fit, published empty
+	};
+
+	struct sTypeEntry
+	{
+		quint32	generation;		// ShowSnapshot generation of this type
+		quint32	flags;
+		quint32	numLists;
+		quint32	firstTarget;
+		quint32	numTargets;
+		quint32	reserved;
+	};
+
+	struct sTargetEntry
+	{
+		double	numberValue;
+		qint64	timestamp;
+		qint32	listId;
+		qint32	part;
+		quint32	number;			// string offset
+		quint32	firstGroup;
+		quint32	numGroups;
+		quint32	reserved;
+	};
+
+	struct sGroupEntry
+	{
+		quint32	name;			// string offset
+		quint32	firstValue;
+		quint32	numValues;
+	};
+
+	struct sBank
+	{
+		volatile quint32	seq;			// odd while being written
+		quint32				generation;
+		quint32				used;
+		quint32				targetsOffset;
+		quint32				groupsOffset;
+		quint32				valuesOffset;	// quint32 string offsets
+		quint32				stringsOffset;
+		quint32				reserved;
+		sTypeEntry			types[EosTarget::EOS_TARGET_COUNT];
+	};
+
+	struct sHeader
+	{
+		quint32				magic;
+		quint32				version;
+		quint32				typeCount;
+		quint32				bankSize;
+		volatile quint32	activeBank;
+		volatile quint32	generation;		// bumped on every publish
+		volatile quint32	typeGenerations[EosTarget::EOS_TARGET_COUNT];
+	};
+
+	SharedSnapshot();
+	virtual ~SharedSnapshot();
+
+	virtual bool Create(const QString &key, unsigned int sizeMB, QString &error);
+	virtual void Destroy();
+	virtual bool IsCreated() const {return m_Header!=0;}
+	virtual void Subscribe(ChangeHub &changeHub);
+	virtual void Unsubscribe();
+
+	// republishes when any target type's generation moved since the last call
+	// returns the number of target types that did not fit
+	virtual unsigned int Publish(const ShowSnapshot &snapshot);
+
+	static unsigned int GetBankOffset(unsigned int bank, unsigned int bankSize);
+	static void Barrier();
+
+protected:
+	typedef std::map<std::string, quint32> STRING_OFFSETS;
+
+	struct sListBlock
+	{
+		std::vector<sTargetEntry>	targets;	// firstGroup and string offsets relative to the block
+		std::vector<sGroupEntry>	groups;		// firstValue and string offsets relative to the block
+		std::vector<quint32>		values;		// string offsets relative to the block
+		QByteArray					strings;
+	};
+
+	typedef std::map<int, sListBlock> LIST_BLOCKS;
+
+	struct sTypeSize
+	{
+		size_t	targets;
+		size_t	groups;
+		size_t	values;
+		size_t	strings;
+	};
+
+	QSharedMemory					m_Memory;
+	sHeader							*m_Header;
+	ShowSnapshot::TARGET_TYPE_PTR	m_Published[EosTarget::EOS_TARGET_COUNT];
+	LIST_BLOCKS						m_Blocks[EosTarget::EOS_TARGET_COUNT];
+	unsigned int					m_Overflow;
+	STRING_OFFSETS					m_StringOffsets;	// of the block being built
+	ChangeHub						*m_ChangeHub;
+	int								m_Subscription;
+
+	virtual quint32 AddString(const std::string &str, sListBlock &block);
+	virtual void BuildBlock(const ShowSnapshot::sTargetList &targetList, sListBlock &block);
+	virtual void GetTypeSize(int type, sTypeSize &size) const;
+	virtual void WriteBlock(const sListBlock &block, char *bankBase, const sBank &bank, sTypeSize &cursor);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Reader side of SharedSnapshot, for use in other processes.
+//
+//   SharedSnapshotReader::sView view;
+//   do
+//   {
+//       if( !reader.BeginRead(view) ) break;
+//       ...read through view...
+//   }
+//   while( !reader.EndRead(view) );
+//
+// Anything read between BeginRead and a successful EndRead is consistent;
+// if EndRead fails the bank was reused underneath the reader, start over.
+class SharedSnapshotReader
+{
+public:
+	struct sView
+	{
+		const SharedSnapshot::sBank	*bank;
+		quint32						seq;
+
+		const SharedSnapshot::sTypeEntry* GetType(EosTarget::EnumEosTargetType type) const;
+		const SharedSnapshot::sTargetEntry* GetTargets(const SharedSnapshot::sTypeEntry &type) const;
+		const SharedSnapshot::sGroupEntry* GetGroups(const SharedSnapshot::sTargetEntry &target) const;
+		const char* GetValue(const SharedSnapshot::sGroupEntry &group, quint32 index) const;
+		const char* GetString(quint32 offset) const;
+	};
+
+	SharedSnapshotReader();
+	virtual ~SharedSnapshotReader();
+
+	virtual bool Attach(const QString &key, QString &error);
+	virtual void Detach();
+
+	// cheap change checks, no need to begin a read
+	virtual quint32 GetGeneration() const;
+	virtual quint32 GetTypeGeneration(EosTarget::EnumEosTargetType type) const;
+
+	virtual bool BeginRead(sView &view) const;
+	virtual bool EndRead(const sView &view) const;
+
+	// index lookup within one list, false if not found
+	static bool FindTarget(const sView &view, const SharedSnapshot::sTypeEntry &type, int listId, double numberValue, int part, const SharedSnapshot::sTargetEntry *&target);
+
+protected:
+	QSharedMemory					m_Memory;
+	const SharedSnapshot::sHeader	*m_Header;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,355 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SharedSnapshotBench.h"
+#include "SharedSnapshot.h"
+#include <stdio.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define SHARED_BENCH_LIST_ID		1
+#define SHARED_BENCH_ROUND_GROUP	"Round"
+#define SHARED_BENCH_LABEL_GROUP	"Label"
+#define SHARED_BENCH_OVERFLOW_MB	1
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a ShowSnapshot filled directly, one list per type; every target carries the
+// round it was filled in as its timestamp and as its first group's value
+class SharedBenchSnapshot
+	: public ShowSnapshot
+{
+public:
+	virtual void Fill(unsigned int targetsPerType, unsigned int round)
+	{
+		for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+			FillType(static_cast<EosTarget::EnumEosTargetType>(i), targetsPerType, round);
+	}
+
+	virtual void FillType(EosTarget::EnumEosTargetType type, unsigned int numTargets, unsigned int round)
+	{
+		char roundStr[16];
+		sprintf(roundStr, "%u", round);
+
+		sTargetList *targetList = new sTargetList();
+		targetList->listId = SHARED_BENCH_LIST_ID;
+		targetList->generation = round;
+		targetList->timestamp = static_cast<time_t>(round);
+		targetList->targets.resize(numTargets);
+		for(unsigned int i=0; i<numTargets; i++)
+		{
+			char str[32];
+			sTarget &target = targetList->targets[i];
+			sprintf(str, "%u", i+1);
+			target.number = str;
+			target.numberValue = (i + 1);
+			target.part = 0;
+			target.generation = round;
+			target.timestamp = static_cast<time_t>(round);
+			target.propGroups.resize(2);
+			target.propGroups[0].name = SHARED_BENCH_ROUND_GROUP;
+			target.propGroups[0].values.push_back(roundStr);
+			sprintf(str, "Target %u", i+1);
+			target.propGroups[1].name = SHARED_BENCH_LABEL_GROUP;
+			target.propGroups[1].values.push_back(str);
+		}
+
+		sTargetType *targetType = new sTargetType();
+		targetType->type = type;
+		targetType->generation = round;
+		targetType->numTargets = numTargets;
+		targetType->numLists = 1;
+		targetType->spilled = false;
+		targetType->lists[SHARED_BENCH_LIST_ID] = TARGET_LIST_PTR(targetList);
+		SetTargetType(type, TARGET_TYPE_PTR(targetType));
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// republishes a new round until the time is up
+class SharedBenchWriter
+	: public QThread
+{
+public:
+	SharedBenchWriter(SharedSnapshot &shared, unsigned int targetsPerType, unsigned int firstRound, unsigned int seconds)
+		: m_Shared(shared)
+		, m_TargetsPerType(targetsPerType)
+		, m_Round(firstRound)
+		, m_Seconds(seconds)
+		, m_Publishes(0)
+	{
+	}
+
+	// after wait()
+	virtual unsigned int GetPublishes() const {return m_Publishes;}
+
+protected:
+	SharedSnapshot			&m_Shared;
+	SharedBenchSnapshot		m_Snapshot;
+	unsigned int			m_TargetsPerType;
+	unsigned int			m_Round;
+	unsigned int			m_Seconds;
+	unsigned int			m_Publishes;
+
+	virtual void run()
+	{
+		QElapsedTimer timer;
+		timer.start();
+		while( !timer.hasExpired(m_Seconds*1000) )
+		{
+			m_Snapshot.Fill(m_TargetsPerType, m_Round++);
+			m_Shared.Publish(m_Snapshot);
+			m_Publishes++;
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// false if the view is not one whole round as SharedBenchSnapshot fills it;
+// the view may be torn, so this must not trust anything it reads
+static bool CheckSharedRead(const SharedSnapshotReader::sView &view, unsigned int targetsPerType, unsigned int &round)
+{
+	char expected[32];
+	bool first = true;
+	round = 0;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		const SharedSnapshot::sTypeEntry *type = view.GetType( static_cast<EosTarget::EnumEosTargetType>(i) );
+		if(!type || type->flags!=0 || type->numLists!=1 || type->numTargets!=targetsPerType)
+			return false;
+
+		const SharedSnapshot::sTargetEntry *targets = view.GetTargets(*type);
+		if( !targets )
+			return false;
+
+		if( first )
+		{
+			round = type->generation;
+			first = false;
+		}
+		else if(type->generation != round)
+			return false;
+
+		for(unsigned int j=0; j<targetsPerType; j++)
+		{
+			const SharedSnapshot::sTargetEntry &target = targets[j];
+			if(target.timestamp!=static_cast<qint64>(round) || target.listId!=SHARED_BENCH_LIST_ID || target.part!=0 || target.numberValue!=(j+1) || target.numGroups!=2)
+				return false;
+
+			sprintf(expected, "%u", j+1);
+			if(strcmp(view.GetString(target.number),expected) != 0)
+				return false;
+
+			const SharedSnapshot::sGroupEntry *groups = view.GetGroups(target);
+			if( !groups )
+				return false;
+
+			sprintf(expected, "%u", round);
+			if(strcmp(view.GetString(groups[0].name),SHARED_BENCH_ROUND_GROUP)!=0 || strcmp(view.GetValue(groups[0],0),expected)!=0)
+				return false;
+
+			sprintf(expected, "Target %u", j+1);
+			if(strcmp(view.GetString(groups[1].name),SHARED_BENCH_LABEL_GROUP)!=0 || strcmp(view.GetValue(groups[1],0),expected)!=0)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// every target is found by its list, number and part
+static bool CheckSharedLookups(const SharedSnapshotReader::sView &view, unsigned int targetsPerType)
+{
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		const SharedSnapshot::sTypeEntry *type = view.GetType( static_cast<EosTarget::EnumEosTargetType>(i) );
+		const SharedSnapshot::sTargetEntry *targets = (type ? view.GetTargets(*type) : 0);
+		if( !targets )
+			return false;
+
+		for(unsigned int j=0; j<targetsPerType; j++)
+		{
+			const SharedSnapshot::sTargetEntry *target = 0;
+			if(!SharedSnapshotReader::FindTarget(view,*type,SHARED_BENCH_LIST_ID,j+1,0,target) || target!=&targets[j])
+				return false;
+		}
+
+		const SharedSnapshot::sTargetEntry *target = 0;
+		if( SharedSnapshotReader::FindTarget(view,*type,SHARED_BENCH_LIST_ID,targetsPerType+1,0,target) )
+			return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void PrintSharedStep(const char *name, bool ok, const QString &detail)
+{
+	printf("  %-10s %-4s %s\n", name, ok ? "ok" : "FAIL", detail.toUtf8().constData());
+	fflush(stdout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SharedSnapshotBench::sSettings::sSettings()
+	: targetsPerType(1000)
+	, seconds(5)
+	, sizeMB(64)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int SharedSnapshotBench::Run(const sSettings &settings)
+{
+	// a key of its own, so a running app's segment is left alone
+	QString key = QString("EosSyncDemoBench%1").arg( QCoreApplication::applicationPid() );
+
+	printf("Shared snapshot, %u targets per type in %u MB, %u s of concurrent publishes\n", settings.targetsPerType, settings.sizeMB, settings.seconds);
+	fflush(stdout);
+
+	QString error;
+	SharedSnapshot shared;
+	SharedSnapshotReader reader;
+	if(!shared.Create(key,settings.sizeMB,error) || !reader.Attach(key,error))
+	{
+		printf("unable to share memory: %s\n", error.toUtf8().constData());
+		return 1;
+	}
+
+	int result = 0;
+
+	// round trip
+	unsigned int round = 1;
+	SharedBenchSnapshot snapshot;
+	snapshot.Fill(settings.targetsPerType, round);
+	unsigned int overflow = shared.Publish(snapshot);
+	SharedSnapshotReader::sView view;
+	unsigned int readRound = 0;
+	bool ok = (overflow==0 && reader.BeginRead(view) && CheckSharedRead(view,settings.targetsPerType,readRound) && CheckSharedLookups(view,settings.targetsPerType) && reader.EndRead(view) && readRound==round);
+	if(overflow != 0)
+		PrintSharedStep("round trip", false, QString("%1 types did not fit, raise the size").arg(overflow));
+	else
+		PrintSharedStep("round trip", ok, QString("generation %1").arg(reader.GetGeneration()));
+	if( !ok )
+	{
+		reader.Detach();
+		shared.Destroy();
+		return 1;
+	}
+
+	// lapped: the first publish fills the idle bank, the second the one being read
+	ok = reader.BeginRead(view);
+	snapshot.Fill(settings.targetsPerType, ++round);
+	shared.Publish(snapshot);
+	snapshot.Fill(settings.targetsPerType, ++round);
+	shared.Publish(snapshot);
+	ok = (ok && !reader.EndRead(view));
+	if( ok )
+		ok = (reader.BeginRead(view) && CheckSharedRead(view,settings.targetsPerType,readRound) && reader.EndRead(view) && readRound==round);
+	PrintSharedStep("lapped", ok, "EndRead() failed after two publishes, the retry read the latest");
+	if( !ok )
+		result = 1;
+
+	// concurrent
+	SharedBenchWriter writer(shared, settings.targetsPerType, round+1, settings.seconds);
+	writer.start();
+	unsigned int reads = 0;
+	unsigned int retries = 0;
+	unsigned int caught = 0;
+	unsigned int busy = 0;
+	unsigned int accepted = 0;	// torn reads EndRead() let through
+	unsigned int backwards = 0;
+	unsigned int lastRound = round;
+	while( writer.isRunning() )
+	{
+		if( !reader.BeginRead(view) )
+		{
+			busy++;
+			continue;
+		}
+
+		bool whole = CheckSharedRead(view, settings.targetsPerType, readRound);
+		if( reader.EndRead(view) )
+		{
+			reads++;
+			if( !whole )
+				accepted++;
+			else
+			{
+				if(readRound < lastRound)
+					backwards++;
+				lastRound = readRound;
+			}
+		}
+		else
+		{
+			retries++;
+			if( !whole )
+				caught++;
+		}
+	}
+	writer.wait();
+	ok = (accepted==0 && backwards==0 && reads!=0);
+	PrintSharedStep("concurrent", ok, QString("%1 publishes, %2 reads, %3 retries (%4 caught a torn read), %5 busy, %6 torn reads accepted, %7 went backwards")
+		.arg(writer.GetPublishes()).arg(reads).arg(retries).arg(caught).arg(busy).arg(accepted).arg(backwards));
+	if( !ok )
+		result = 1;
+
+	reader.Detach();
+	shared.Destroy();
+
+	// overflow: one type needs more than a whole bank, the rest fit
+	QString overflowKey = QString("%1Overflow").arg(key);
+	SharedSnapshot small;
+	if(!small.Create(overflowKey,SHARED_BENCH_OVERFLOW_MB,error) || !reader.Attach(overflowKey,error))
+	{
+		PrintSharedStep("overflow", false, QString("unable to share memory: %1").arg(error));
+		return 1;
+	}
+
+	unsigned int largeTargets = static_cast<unsigned int>(SHARED_BENCH_OVERFLOW_MB*1024*1024/sizeof(SharedSnapshot::sTargetEntry) + 1);
+	SharedBenchSnapshot large;
+	large.Fill(1, 1);
+	large.FillType(static_cast<EosTarget::EnumEosTargetType>(0), largeTargets, 1);
+	overflow = small.Publish(large);
+	unsigned int unchanged = small.Publish(large);
+	ok = (overflow==1 && unchanged==overflow && reader.BeginRead(view));
+	if( ok )
+	{
+		const SharedSnapshot::sTypeEntry *type = view.GetType( static_cast<EosTarget::EnumEosTargetType>(0) );
+		ok = (type && (type->flags & SharedSnapshot::TYPE_FLAG_OVERFLOW)!=0 && type->numTargets==0 && reader.EndRead(view));
+	}
+	PrintSharedStep("overflow", ok, QString("%1 targets in %2 MB, %3 types published empty, %4 on republish").arg(largeTargets).arg(SHARED_BENCH_OVERFLOW_MB).arg(overflow).arg(unchanged));
+	if( !ok )
+		result = 1;
+
+	reader.Detach();
+	small.Destroy();
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,61 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef SHARED_SNAPSHOT_BENCH_H
+#define SHARED_SNAPSHOT_BENCH_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Headless check of SharedSnapshot against its reader, no console needed.
+//
+// A synthetic show is published into a segment of its own and read back
+// through SharedSnapshotReader, in four steps:
+//	round trip	every target, group and value reads back as published, and
+//				FindTarget() finds each one
+//	lapped		a read begun before two publishes fails EndRead(), the
+//				seqlock retry a reader must make
+//	concurrent	a writer thread republishes for a while and the reader keeps
+//				reading; every target carries the round it was published in,
+//				so an accepted read that mixes rounds is caught
+//	overflow	a type too large for the segment is published empty and the
+//				count stays put when nothing changed since
+// Prints each step and returns non-zero if any failed.
+class SharedSnapshotBench
+{
+public:
+	struct sSettings
+	{
+		sSettings();
+		unsigned int	targetsPerType;
+		unsigned int	seconds;		// of concurrent publishes
+		unsigned int	sizeMB;
+	};
+
+	static int Run(const sSettings &settings);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
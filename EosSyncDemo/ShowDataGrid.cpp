@@ -19,15 +19,23 @@
 // THE SOFTWARE.
 
 #include "ShowDataGrid.h"
+#include "ChangeStats.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
 ShowDataDetails::ShowDataDetails(QWidget *parent)
 	: QWidget(parent, Qt::Window)
-	, m_TargetType(EosTarget::EOS_TARGET_COUNT)
 	, m_Dirty(true)
+	, m_TargetType(EosTarget::EOS_TARGET_COUNT)
+	, m_Serial(0)
+	, m_Render(0)
+	, m_Find(false)
+	, m_FindListId(0)
+	, m_FindPart(0)
 {
-	m_Text = new QTextEdit(this);
+	m_Tabs = new QTabWidget(this);
+
+	m_Text = new QTextEdit(m_Tabs);
 	m_Text->setAcceptRichText(false);
 	m_Text->setReadOnly(true);
 	m_Text->setWordWrapMode(QTextOption::NoWrap);
@@ -35,6 +43,20 @@ ShowDataDetails::ShowDataDetails(QWidget *parent)
 	QFont fnt("Monospace");
 	fnt.setStyleHint(QFont::TypeWriter);
 	m_Text->setFont(fnt);
+	m_Tabs->addTab(m_Text, "Text");
+
+	m_PropertyTable = new PropertyTableView(m_Tabs);
+	m_Tabs->addTab(m_PropertyTable, "Table");
+
+	connect(&m_RenderWatcher, SIGNAL(finished()), this, SLOT(onRenderFinished()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowDataDetails::~ShowDataDetails()
+{
+	m_RenderWatcher.waitForFinished();
+	delete m_Render;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -42,6 +64,19 @@ ShowDataDetails::ShowDataDetails(QWidget *parent)
 void ShowDataDetails::Clear()
 {
 	m_Text->clear();
+	m_Properties.Clear();
+	m_PropertyTable->Update(m_Properties);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataDetails::SetDirty()
+{
+	Clear();
+	m_Rendered.clear();
+	m_Texts.clear();
+	m_Serial++;
+	m_Dirty = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -57,126 +92,260 @@ void ShowDataDetails::SetTargetType(unsigned int targetType)
 	}
 }
 
+
 ////////////////////////////////////////////////////////////////////////////////
 
-void ShowDataDetails::Update(const EosSyncData::TARGETLIST_DATA &targetListData)
+bool ShowDataDetails::Update(const ShowSnapshot &snapshot)
 {
-	if( !m_Dirty )
-	{
-		bool anyTargetListDirty = false;
-		for(EosSyncData::TARGETLIST_DATA::const_iterator i=targetListData.begin(); i!=targetListData.end(); i++)
-		{
-			if( i->second->GetStatus().GetDirty() )
-			{
-				anyTargetListDirty = true;
-				break;
-			}
-		}
+	if(m_TargetType >= EosTarget::EOS_TARGET_COUNT)
+		return false;
+
+	// one render at a time; the next tick picks up whatever arrived meanwhile
+	if( m_Render )
+		return false;
+
+	EosTarget::EnumEosTargetType type = static_cast<EosTarget::EnumEosTargetType>(m_TargetType);
+	ShowSnapshot::TARGET_TYPE_PTR targetType = snapshot.GetTargetType(type);
+	if(!targetType || (!m_Dirty && targetType==m_Rendered))
+		return false;
+
+	// the snapshot budget keeps the viewed type resident, so this is only ever a brief catch up
+	if( targetType->spilled )
+		targetType = snapshot.LoadTargetType(targetType);
+
+	m_Render = new sRender();
+	m_Render->serial = m_Serial;
+	m_Render->type = type;
+	m_Render->targetType = targetType;
+	m_Render->texts = m_Texts;
+	m_Render->properties.CopyLists(m_Properties);
+	m_Render->propertiesChanged = false;
+	m_Rendered = targetType;
+	m_RenderWatcher.setFuture( QtConcurrent::run(&ShowDataDetails::Render,m_Render) );
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataDetails::WaitForRender()
+{
+	// for callers without an event loop to deliver finished()
+	m_RenderWatcher.waitForFinished();
+	ApplyRender();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataDetails::onRenderFinished()
+{
+	ApplyRender();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataDetails::ApplyRender()
+{
+	if(!m_Render || m_RenderWatcher.isRunning())
+		return;
+
+	sRender *render = m_Render;
+	m_Render = 0;
 
-		if( !anyTargetListDirty )
-			return;
+	// the type changed or the window reopened since it started
+	if(render->serial != m_Serial)
+	{
+		delete render;
+		return;
 	}
 
-	QString text;
-	QString qStr;
-	std::string stdStr;
-	for(EosSyncData::TARGETLIST_DATA::const_iterator i=targetListData.begin(); i!=targetListData.end(); i++)
+	m_Texts.swap(render->texts);
+	m_Text->setPlainText(render->text);
+	if( render->propertiesChanged )
 	{
-		EosTarget::EnumEosTargetType type = static_cast<EosTarget::EnumEosTargetType>(m_TargetType);
+		m_Properties.Swap(render->properties);
+		m_PropertyTable->Update(m_Properties);
+	}
+	delete render;
+
+	m_Dirty = false;
+
+	if( m_Find )
+		ApplyFind();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataDetails::ShowTarget(int listId, const QString &number, int part)
+{
+	m_Find = true;
+	m_FindListId = listId;
+	m_FindNumber = number;
+	m_FindPart = part;
+
+	// otherwise once the pending render is done
+	if( !m_Dirty )
+		ApplyFind();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataDetails::ApplyFind()
+{
+	m_Find = false;
+
+	// the list's heading, then the target's own heading after it, as RenderTargetList() writes them
+	EosTarget::EnumEosTargetType type = static_cast<EosTarget::EnumEosTargetType>(m_TargetType);
+	QString heading( EosTarget::GetNameForTargetType(type) );
+	if(type==EosTarget::EOS_TARGET_CUE && m_FindListId>0)
+		heading.append( QString(" list %1").arg(m_FindListId) );
+	heading.append(" (");
+
+	QTextDocument *doc = m_Text->document();
+	QTextCursor cursor = doc->find(heading);
+	if( cursor.isNull() )
+		cursor = QTextCursor(doc);
+
+	QString target(m_FindNumber);
+	if(m_FindPart > 0)
+		target.append( QString("/%1").arg(m_FindPart) );
+	cursor = doc->find(QString("[ %1 ]").arg(target), cursor);
+	if( cursor.isNull() )
+		return;
+
+	m_Tabs->setCurrentWidget(m_Text);
+	m_Text->setTextCursor(cursor);
+	m_Text->ensureCursorVisible();
+	raise();
+	activateWindow();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataDetails::Render(sRender *render)
+{
+	// runs on a pool thread, and only reads the immutable snapshot copy
+	EosTarget::EnumEosTargetType type = render->type;
+	const ShowSnapshot::TARGET_LISTS &lists = render->targetType->lists;
 
+	LIST_TEXTS texts;
+	LIST_JOBS jobs;
+	for(ShowSnapshot::TARGET_LISTS::const_iterator i=lists.begin(); i!=lists.end(); i++)
+	{
 		int listId = i->first;
-		if(type==EosTarget::EOS_TARGET_CUE && listId<=0 && targetListData.size()>1)
+		if(type==EosTarget::EOS_TARGET_CUE && listId<=0 && lists.size()>1)
 			continue;
 
-		const EosTargetList *targetList = i->second;
-		const EosTargetList::TARGETS &targets = targetList->GetTargets();		
+		sListText &listText = texts[listId];
+		listText.list = i->second;
+
+		// the same copy as last time means the same text
+		LIST_TEXTS::const_iterator prev = render->texts.find(listId);
+		if(prev!=render->texts.end() && prev->second.list==i->second)
+			listText.text = prev->second.text;
+		else
+		{
+			sListJob job;
+			job.type = type;
+			job.listId = listId;
+			job.list = i->second;
+			jobs.push_back(job);
+		}
+	}
 
-		qStr = EosTarget::GetNameForTargetType(type);
-		if(type==EosTarget::EOS_TARGET_CUE && listId>0)
-			qStr.append( QString(" list %1").arg(listId) );
+	// changed lists across the pool, this thread taking a share of them too,
+	// then back into list order
+	if(jobs.size() > 1)
+		QtConcurrent::blockingMap(jobs, &ShowDataDetails::RenderListJob);
+	else if( !jobs.empty() )
+		RenderListJob( jobs.front() );
+	for(LIST_JOBS::iterator i=jobs.begin(); i!=jobs.end(); i++)
+		texts[i->listId].text.swap(i->text);
+
+	int len = 0;
+	for(LIST_TEXTS::const_iterator i=texts.begin(); i!=texts.end(); i++)
+		len += (i->second.text.size() + 1);
+
+	QString &text = render->text;
+	text.reserve(len);
+	for(LIST_TEXTS::const_iterator i=texts.begin(); i!=texts.end(); i++)
+	{
 		if( !text.isEmpty() )
 			text.append("\n");
-		text.append(qStr);
-		ShowDataGrid::TimestampToStr(targetList->GetStatus().GetTimestamp(), qStr);
-		text.append( QString(" (%1)").arg(qStr) );
-		text.append("\n\n");
+		text.append(i->second.text);
+	}
 
-		// for all targets
-		for(EosTargetList::TARGETS::const_iterator j=targets.begin(); j!=targets.end(); j++)
-		{
-			// for all parts
-			const EosTarget::sDecimalNumber &targetNumber = j->first;
-			const EosTargetList::PARTS &parts = j->second.list;
+	render->texts.swap(texts);
 
-			for(EosTargetList::PARTS::const_iterator k=parts.begin(); k!=parts.end(); k++)
-			{
-				// for all property groups
-				int partNumber = k->first;
-				const EosTarget *target = k->second;
-				const EosTarget::PROP_GROUPS &propGroups = target->GetPropGroups();
-
-				EosTarget::GetStringFromNumber(targetNumber, stdStr);
-				if( stdStr.c_str() )
-					qStr = QString::fromUtf8( stdStr.c_str() );
-				else
-					qStr.clear();
-				if(partNumber > 0)
-					qStr.append( QString("/%1").arg(partNumber) );
-				text.append( QString("[ %1 ]").arg(qStr) );
-				ShowDataGrid::TimestampToStr(target->GetStatus().GetTimestamp(), qStr);
-				text.append( QString(" (%1)\n").arg(qStr) );
-
-				for(EosTarget::PROP_GROUPS::const_iterator k=propGroups.begin(); k!=propGroups.end(); k++)
-				{
-					// for all properties
-					const std::string &propGroupName = k->first;
-					const EosTarget::PROPS &props = k->second.props;
+	// typed columns only reparse the lists that changed
+	render->propertiesChanged = render->properties.Update(type, *(render->targetType));
+}
 
-					bool subGroup = !propGroupName.empty();
-					if( subGroup )
-					{
-						if( propGroupName.c_str() )
-							qStr = QString::fromUtf8( propGroupName.c_str() );
-						else
-							qStr.clear();
-						text.append( QString("\t[ %1 ]\n").arg(qStr) );
-					}
+////////////////////////////////////////////////////////////////////////////////
 
-					qStr.clear();
-					for(EosTarget::PROPS::const_iterator l=props.begin(); l!=props.end(); l++)
-					{
-						const std::string &value = l->value;
-						if( !qStr.isEmpty() )
-							qStr.append(", ");
-						QString strVal;
-						if( value.c_str() )
-							strVal = QString::fromUtf8( value.c_str() );
-						qStr.append( QString("\"%1\"").arg(strVal) );
-					}
+void ShowDataDetails::RenderListJob(sListJob &job)
+{
+	RenderTargetList(job.type, *(job.list), job.text);
+}
 
-					if( !qStr.isEmpty() )
-					{
-						text.append("\t");
-						if( subGroup )
-							text.append("\t");
-						text.append(qStr);
-						text.append("\n");
-					}
-				}
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataDetails::RenderTargetList(EosTarget::EnumEosTargetType type, const ShowSnapshot::sTargetList &targetList, QString &text)
+{
+	QString qStr;
+
+	qStr = EosTarget::GetNameForTargetType(type);
+	if(type==EosTarget::EOS_TARGET_CUE && targetList.listId>0)
+		qStr.append( QString(" list %1").arg(targetList.listId) );
+	text.append(qStr);
+	ShowDataGrid::TimestampToStr(targetList.timestamp, qStr);
+	text.append( QString(" (%1)").arg(qStr) );
+	text.append("\n\n");
+
+	// for all targets, already one per part in number/part order
+	for(ShowSnapshot::TARGETS::const_iterator i=targetList.targets.begin(); i!=targetList.targets.end(); i++)
+	{
+		const ShowSnapshot::sTarget &target = *i;
+
+		qStr = QString::fromUtf8( target.number.c_str() );
+		if(target.part > 0)
+			qStr.append( QString("/%1").arg(target.part) );
+		text.append( QString("[ %1 ]").arg(qStr) );
+		ShowDataGrid::TimestampToStr(target.timestamp, qStr);
+		text.append( QString(" (%1)\n").arg(qStr) );
+
+		// for all property groups
+		for(ShowSnapshot::PROP_GROUPS::const_iterator j=target.propGroups.begin(); j!=target.propGroups.end(); j++)
+		{
+			bool subGroup = !j->name.empty();
+			if( subGroup )
+				text.append( QString("\t[ %1 ]\n").arg(QString::fromUtf8(j->name.c_str())) );
+
+			// for all properties
+			qStr.clear();
+			for(std::vector<std::string>::const_iterator k=j->values.begin(); k!=j->values.end(); k++)
+			{
+				if( !qStr.isEmpty() )
+					qStr.append(", ");
+				qStr.append( QString("\"%1\"").arg(QString::fromUtf8(k->c_str())) );
+			}
+
+			if( !qStr.isEmpty() )
+			{
+				text.append("\t");
+				if( subGroup )
+					text.append("\t");
+				text.append(qStr);
+				text.append("\n");
 			}
 		}
 	}
-
-	m_Text->setPlainText(text);
-
-	m_Dirty = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void ShowDataDetails::resizeEvent(QResizeEvent *e)
 {
-	m_Text->setGeometry(0, 0, width(), height());
+	m_Tabs->setGeometry(0, 0, width(), height());
 	QWidget::resizeEvent(e);
 }
 
@@ -201,7 +370,9 @@ void TargetButton::onClicked(bool /*checked*/)
 ShowDataGrid::ShowDataGrid(QWidget *parent)
 	: QWidget(parent)
 	, m_Details(0)
+	, m_ChangeStats(0)
 {
+
 	QGridLayout *layout = new QGridLayout(this);
 	layout->addItem(new QSpacerItem(1,1,QSizePolicy::MinimumExpanding,QSizePolicy::MinimumExpanding), 0, 0);
 
@@ -237,14 +408,18 @@ ShowDataGrid::ShowDataGrid(QWidget *parent)
 		group.timestamp->setPalette(timestampPal);
 		layout->addWidget(group.timestamp, row, 4);
 
+		group.rate = new QLabel(this);
+		group.rate->setPalette(labelPal);
+		layout->addWidget(group.rate, row, 5);
+
 		group.button = new TargetButton(i, "+", this);
 		QSize buttonSize( group.button->sizeHint() );
 		group.button->setFixedSize(buttonSize.height(), buttonSize.height());		
 		connect(group.button, SIGNAL(targetClicked(unsigned int)), this, SLOT(onTargetClicked(unsigned int)));
-		layout->addWidget(group.button, row, 5);
+		layout->addWidget(group.button, row, 6);
 	}
 
-	layout->addItem(new QSpacerItem(1,1,QSizePolicy::MinimumExpanding,QSizePolicy::MinimumExpanding), EosTarget::EOS_TARGET_COUNT+1, 6);
+	layout->addItem(new QSpacerItem(1,1,QSizePolicy::MinimumExpanding,QSizePolicy::MinimumExpanding), EosTarget::EOS_TARGET_COUNT+1, 7);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -255,11 +430,10 @@ void ShowDataGrid::Update(EosSyncLib &eosSyncLib)
 
 	bool refresh = syncData.GetStatus().GetDirty();
 
-	if(!refresh && m_Details && m_Details->isVisible() && m_Details->GetDirty())
-		refresh = true;	// details window needs refresh
-
 	if( refresh )
 	{
+		qint64 now = (m_ChangeStats ? m_ChangeStats->Now() : 0);
+
 		const EosSyncData::SHOW_DATA &showData = syncData.GetShowData();
 		for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
 		{
@@ -276,6 +450,7 @@ void ShowDataGrid::Update(EosSyncLib &eosSyncLib)
 			size_t totalTargets = 0;
 			bool gotMostRecentTimestamp = false;
 			time_t mostRecentTimestamp = 0;
+			unsigned int dirtyLists = 0;
 
 			EosSyncData::SHOW_DATA::const_iterator j = showData.find(type);
 			if(j != showData.end())
@@ -294,7 +469,8 @@ void ShowDataGrid::Update(EosSyncLib &eosSyncLib)
 					initialSyncTotalCompleted += (initialSyncInfo.complete ? initialSyncInfo.count : targetList->GetNumTargets());
 
 					const EosSyncStatus &status = targetList->GetStatus();
-					status.GetTimestamp();
+					if( status.GetDirty() )
+						dirtyLists++;
 					switch( status.GetValue() )
 					{
 						case EosSyncStatus::SYNC_STATUS_RUNNING:
@@ -313,17 +489,18 @@ void ShowDataGrid::Update(EosSyncLib &eosSyncLib)
 						gotMostRecentTimestamp = true;
 					}
 				}
-
-				if(	m_Details &&
-					m_Details->isVisible() &&
-					m_Details->GetTargetType()==static_cast<unsigned int>(type) )
-				{
-					m_Details->Update(targetListData);
-				}
 			}
 			else
 				initialSyncComplete = false;
 
+			ChangeStats::sTypeStats stats;
+			if( m_ChangeStats )
+			{
+				if(dirtyLists != 0)
+					m_ChangeStats->OnApplied(type, now, dirtyLists);
+				m_ChangeStats->GetTypeStats(type, stats);
+			}
+
 			// determine color
 			if( targetTypeRunning )
 			{
@@ -357,8 +534,10 @@ void ShowDataGrid::Update(EosSyncLib &eosSyncLib)
 			group.count->setPalette(labelPal);
 			group.count->setText( QString::number(totalTargets) );
 
-			// timestamp
-			if( gotMostRecentTimestamp )
+			// timestamp, of the tick this session saw it change in
+			if(stats.lastAppliedNS != 0)
+				group.timestamp->setText( m_ChangeStats->ToDateTime(stats.lastAppliedNS).toString("h:mm:ss.zzz") );
+			else if( gotMostRecentTimestamp )
 			{
 				QString str;
 				TimestampToStr(mostRecentTimestamp, str);
@@ -372,6 +551,60 @@ void ShowDataGrid::Update(EosSyncLib &eosSyncLib)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ShowDataGrid::UpdateDetails(const ShowSnapshot &snapshot)
+{
+	if(m_Details && m_Details->isVisible())
+		m_Details->Update(snapshot);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataGrid::SetChangeStats(ChangeStats *changeStats, unsigned int tickMS)
+{
+	m_ChangeStats = changeStats;
+
+	QString timestampTip( QString("when the UI first saw the change, up to %1 ms after it was applied").arg(tickMS) );
+	QString rateTip( QString("changes per second, and time from arrival to the UI seeing it, in %1 ms steps").arg(tickMS) );
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		m_WidgetGroups[i].timestamp->setToolTip(timestampTip);
+		m_WidgetGroups[i].rate->setToolTip(rateTip);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowDataGrid::UpdateRates()
+{
+	// rates decay without any new data, so these refresh on their own clock
+	if(!m_ChangeStats || (m_RateTimer.isValid() && !m_RateTimer.hasExpired(500)))
+		return;
+
+	m_RateTimer.start();
+
+	QString str;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		ChangeStats::sTypeStats stats;
+		m_ChangeStats->GetTypeStats(static_cast<EosTarget::EnumEosTargetType>(i), stats);
+		if(stats.lastArrivalNS==0 && stats.lastAppliedNS==0)
+		{
+			m_WidgetGroups[i].rate->clear();
+			continue;
+		}
+
+		QString text( QString("%1/s").arg(stats.ratePerSecond, 0, 'f', (stats.ratePerSecond<10) ? 1 : 0) );
+		if(stats.lastLatencyNS >= 0)
+		{
+			ChangeStats::FormatLatency(stats.lastLatencyNS, str);
+			text.append( QString("  %1").arg(str) );
+		}
+		m_WidgetGroups[i].rate->setText(text);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ShowDataGrid::onTargetClicked(unsigned int targetType)
 {
 	if( !m_Details )
@@ -388,13 +621,36 @@ void ShowDataGrid::onTargetClicked(unsigned int targetType)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ShowDataGrid::ShowTarget(unsigned int targetType, int listId, const QString &number, int part)
+{
+	if(targetType >= EosTarget::EOS_TARGET_COUNT)
+		return;
+
+	onTargetClicked(targetType);
+	m_Details->ShowTarget(listId, number, part);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowDataGrid::GetDetailsTargetType(unsigned int &targetType) const
+{
+	if(!m_Details || !m_Details->isVisible())
+		return false;
+
+	targetType = m_Details->GetTargetType();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ShowDataGrid::TimestampToStr(const time_t &timestamp, QString &str)
 {
-	tm *t = localtime( &timestamp );
+	// QDateTime rather than localtime(), so this is safe to call from the details render threads
+	QTime t( QDateTime::fromTime_t(static_cast<uint>(timestamp)).time() );
 	str = QString("%1:%2:%3")
-		.arg(t->tm_hour, 2)
-		.arg(t->tm_min, 2, 10, QChar('0'))
-		.arg(t->tm_sec, 2, 10, QChar('0'));
+		.arg(t.hour(), 2)
+		.arg(t.minute(), 2, 10, QChar('0'))
+		.arg(t.second(), 2, 10, QChar('0'));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -30,31 +30,105 @@
 #include "QtInclude.h"
 #endif
 
+#ifndef PROPERTY_TABLE_H
+#include "PropertyTable.h"
+#endif
+
+#ifndef SHOW_SNAPSHOT_H
+#include "ShowSnapshot.h"
+#endif
+
+#include <map>
+#include <vector>
 #include <time.h>
 
+class ChangeStats;
+
 ////////////////////////////////////////////////////////////////////////////////
 
+// Text and table views of one target type, rendered from ShowSnapshot on the
+// thread pool. Update() only starts a render when the snapshot has a new
+// generation of the type; the render formats the changed lists in parallel
+// and joins them in list order, and both views are swapped in when it
+// finishes. Lists whose snapshot copy didn't change keep the text and parsed
+// columns they had.
 class ShowDataDetails
 	: public QWidget
 {
+	Q_OBJECT
+
 public:
 	ShowDataDetails(QWidget *parent);
+	virtual ~ShowDataDetails();
 
 	virtual void Clear();
 	virtual bool GetDirty() const {return m_Dirty;}
-	virtual void SetDirty() {Clear(); m_Dirty=true;}
+	virtual void SetDirty();
 	virtual unsigned int GetTargetType() const {return m_TargetType;}
 	virtual void SetTargetType(unsigned int targetType);
-	virtual void Update(const EosSyncData::TARGETLIST_DATA &targetListData);
+	// UI thread, with EosSyncLib unlocked; returns false if there was nothing to render
+	virtual bool Update(const ShowSnapshot &snapshot);
+	virtual void WaitForRender();
+	virtual void ShowTarget(int listId, const QString &number, int part);
 
 	virtual QSize sizeHint() const {return QSize(600,480);}
 
+private slots:
+	void onRenderFinished();
+
 protected:
+	struct sListText
+	{
+		ShowSnapshot::TARGET_LIST_PTR	list;	// the copy text was rendered from
+		QString							text;
+	};
+
+	typedef std::map<int, sListText> LIST_TEXTS;
+
+	struct sListJob
+	{
+		EosTarget::EnumEosTargetType	type;
+		int								listId;
+		ShowSnapshot::TARGET_LIST_PTR	list;
+		QString							text;
+	};
+
+	typedef std::vector<sListJob> LIST_JOBS;
+
+	struct sRender
+	{
+		unsigned int					serial;
+		EosTarget::EnumEosTargetType	type;
+		ShowSnapshot::TARGET_TYPE_PTR	targetType;
+		LIST_TEXTS						texts;		// last render's going in, this one's coming out
+		QString							text;
+		PropertyTable					properties;	// likewise
+		bool							propertiesChanged;
+	};
+
+	QTabWidget		*m_Tabs;
 	QTextEdit		*m_Text;
-	bool			m_Dirty;
+	PropertyTable	m_Properties;
+	PropertyTableView	*m_PropertyTable;
+	bool			m_Dirty;		// nothing rendered for this type yet
 	unsigned int	m_TargetType;
+	unsigned int	m_Serial;		// bumped by SetDirty(), so stale renders are dropped
+	ShowSnapshot::TARGET_TYPE_PTR	m_Rendered;
+	LIST_TEXTS		m_Texts;
+	sRender			*m_Render;		// in flight
+	QFutureWatcher<void>	m_RenderWatcher;
+	bool			m_Find;			// scroll to a target once rendered
+	int				m_FindListId;
+	QString			m_FindNumber;
+	int				m_FindPart;
 
 	virtual void resizeEvent(QResizeEvent *e);
+	virtual void ApplyRender();
+	virtual void ApplyFind();
+
+	static void Render(sRender *render);
+	static void RenderListJob(sListJob &job);
+	static void RenderTargetList(EosTarget::EnumEosTargetType type, const ShowSnapshot::sTargetList &targetList, QString &text);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -88,6 +162,13 @@ public:
 	ShowDataGrid(QWidget *parent);
 
 	virtual void Update(EosSyncLib &eosSyncLib);
+	// with EosSyncLib unlocked, after the snapshot has been updated
+	virtual void UpdateDetails(const ShowSnapshot &snapshot);
+	// changes are only seen once per UI tick, so that is as precise as applied times get
+	virtual void SetChangeStats(ChangeStats *changeStats, unsigned int tickMS);
+	virtual void UpdateRates();
+	virtual void ShowTarget(unsigned int targetType, int listId, const QString &number, int part);
+	virtual bool GetDetailsTargetType(unsigned int &targetType) const;
 
 	static void TimestampToStr(const time_t &timestamp, QString &str);
 
@@ -101,11 +182,14 @@ protected:
 		QProgressBar	*progress;
 		QLabel			*count;
 		QLabel			*timestamp;
+		QLabel			*rate;
 		TargetButton	*button;
 	};
 
 	sWidgetGroup	m_WidgetGroups[EosTarget::EOS_TARGET_COUNT];
 	ShowDataDetails	*m_Details;
+	ChangeStats		*m_ChangeStats;
+	QElapsedTimer	m_RateTimer;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
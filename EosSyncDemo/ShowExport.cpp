@@ -0,0 +1,599 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "ShowExport.h"
+#include "MainWindow.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <climits>
+#include <deque>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define EXPORT_CHUNK_SIZE		(64*1024)
+#define EXPORT_MAX_CHUNKS		16		// queued for the writer, so about 1 MB at most
+#define EXPORT_TICK_MS			60
+#define EXPORT_CSV_HEADER		"type,list,number,part,group,index,value\n"
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ShowExportWriter
+	: public QThread
+{
+public:
+	ShowExportWriter()
+		: m_Bytes(0)
+		, m_Failed(false)
+		, m_Done(false)
+	{
+	}
+
+	virtual ~ShowExportWriter()
+	{
+		Finish();
+	}
+
+	// UI thread, before start()
+	virtual bool Open(const QString &path, QString &error)
+	{
+		m_File.setFileName(path);
+		if( !m_File.open(QIODevice::WriteOnly|QIODevice::Truncate) )
+		{
+			error = m_File.errorString();
+			return false;
+		}
+		return true;
+	}
+
+	// export thread; blocks while the queue is full, false once writing failed
+	virtual bool Push(const QByteArray &chunk)
+	{
+		m_Mutex.lock();
+		while(!m_Failed && m_Chunks.size()>=EXPORT_MAX_CHUNKS)
+			m_Wait.wait(&m_Mutex);
+		bool ok = !m_Failed;
+		if( ok )
+		{
+			m_Chunks.push_back(chunk);
+			m_Wait.wakeAll();
+		}
+		m_Mutex.unlock();
+		return ok;
+	}
+
+	// drains the queue, then closes the file
+	virtual bool Finish()
+	{
+		m_Mutex.lock();
+		m_Done = true;
+		m_Wait.wakeAll();
+		m_Mutex.unlock();
+		wait();
+
+		if( m_File.isOpen() )
+		{
+			if(!m_File.flush() && !m_Failed)
+			{
+				m_Failed = true;
+				m_Error = m_File.errorString();
+			}
+			m_File.close();
+		}
+		return !m_Failed;
+	}
+
+	virtual void Remove()
+	{
+		if( !m_File.isOpen() )
+			m_File.remove();
+	}
+
+	virtual qint64 GetBytes() const {return m_Bytes;}
+	virtual const QString& GetError() const {return m_Error;}
+
+protected:
+	typedef std::deque<QByteArray> CHUNKS;
+
+	QFile				m_File;
+	QMutex				m_Mutex;
+	QWaitCondition		m_Wait;
+	CHUNKS				m_Chunks;
+	volatile qint64		m_Bytes;
+	bool				m_Failed;
+	bool				m_Done;
+	QString				m_Error;
+
+	virtual void run()
+	{
+		for(;;)
+		{
+			m_Mutex.lock();
+			while(m_Chunks.empty() && !m_Done)
+				m_Wait.wait(&m_Mutex);
+			if( m_Chunks.empty() )
+			{
+				m_Mutex.unlock();
+				break;
+			}
+			QByteArray chunk( m_Chunks.front() );
+			m_Chunks.pop_front();
+			m_Wait.wakeAll();
+			m_Mutex.unlock();
+
+			if(m_File.write(chunk) != chunk.size())
+			{
+				m_Mutex.lock();
+				m_Failed = true;
+				m_Error = m_File.errorString();
+				m_Chunks.clear();
+				m_Wait.wakeAll();
+				m_Mutex.unlock();
+				break;
+			}
+			m_Bytes += chunk.size();
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowExport::sProgress::sProgress()
+	: targets(0)
+	, bytes(0)
+	, elapsedMS(0)
+	, done(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowExport::sCursor::sCursor()
+	: listId(0)
+	, inList(false)
+	, done(false)
+	, number()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowExport::ShowExport()
+	: m_SyncThread(0)
+	, m_Format(FORMAT_JSONL)
+	, m_Writer(0)
+	, m_Run(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowExport::~ShowExport()
+{
+	Cancel();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowExport::EnumFormat ShowExport::GetFormatForPath(const QString &path)
+{
+	return (path.endsWith(".csv",Qt::CaseInsensitive) ? FORMAT_CSV : FORMAT_JSONL);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowExport::Start(EosSyncLibThread &syncThread, const QString &path, EnumFormat format, QString &error)
+{
+	Cancel();
+
+	ShowExportWriter *writer = new ShowExportWriter();
+	if( !writer->Open(path,error) )
+	{
+		delete writer;
+		return false;
+	}
+
+	m_SyncThread = &syncThread;
+	m_Path = path;
+	m_Format = format;
+	m_Writer = writer;
+	m_Progress = sProgress();
+	m_Timer.start();
+	m_Run = true;
+	m_Writer->start();
+	start();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowExport::Cancel()
+{
+	m_Run = false;
+	wait();
+
+	if( m_Writer )
+	{
+		// a cancelled or failed export leaves no file behind
+		bool ok = (m_Progress.done && m_Progress.error.isEmpty());
+		m_Writer->Finish();
+		if( !ok )
+			m_Writer->Remove();
+		delete m_Writer;
+		m_Writer = 0;
+	}
+
+	m_SyncThread = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowExport::GetProgress(sProgress &progress) const
+{
+	m_Mutex.lock();
+	progress = m_Progress;
+	if( !progress.done )
+	{
+		progress.bytes = (m_Writer ? m_Writer->GetBytes() : 0);
+		progress.elapsedMS = m_Timer.elapsed();
+	}
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowExport::run()
+{
+	QByteArray chunk;
+	chunk.reserve(EXPORT_CHUNK_SIZE + 4096);
+	if(m_Format == FORMAT_CSV)
+		chunk.append(EXPORT_CSV_HEADER);
+
+	// one slice reused throughout, so its capacity is only ever one slice's
+	QString error;
+	ShowSnapshot::sTargetList slice;
+	bool ok = true;
+	for(int i=0; ok && m_Run && i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		EosTarget::EnumEosTargetType type = static_cast<EosTarget::EnumEosTargetType>(i);
+		const char *typeName = EosTarget::GetNameForTargetType(type);
+		sCursor cursor;
+		while(ok && m_Run && CopySlice(type,cursor,slice))
+			ok = ExportSlice(typeName, slice, chunk);
+	}
+
+	if(m_Run && error.isEmpty() && !Flush(chunk))
+		error = m_Writer->GetError();
+	if(m_Run && error.isEmpty() && !m_Writer->Finish())
+		error = m_Writer->GetError();
+	if(error.isEmpty() && !m_Writer->GetError().isEmpty())
+		error = m_Writer->GetError();
+
+	if( m_Run )
+		Finish(error);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowExport::CopySlice(EosTarget::EnumEosTargetType type, sCursor &cursor, ShowSnapshot::sTargetList &slice)
+{
+	// false once the type has no more lists; lists and targets are found again
+	// by key each time, so any that come or go in between are simply met or missed
+	bool found = false;
+	slice.targets.clear();
+	if( cursor.done )
+		return false;
+
+	EosSyncLib *eosSyncLib = m_SyncThread->LockEosSyncLib();
+	if( eosSyncLib )
+	{
+		const EosSyncData::SHOW_DATA &showData = eosSyncLib->GetData().GetShowData();
+		EosSyncData::SHOW_DATA::const_iterator i = showData.find(type);
+		if(i != showData.end())
+		{
+			EosSyncData::TARGETLIST_DATA::const_iterator j = i->second.lower_bound(cursor.listId);
+			if(j != i->second.end())
+			{
+				found = true;
+				if(j->first != cursor.listId)
+					cursor.inList = false;
+
+				const EosTargetList &targetList = *(j->second);
+				slice.listId = j->first;
+				slice.generation = 0;
+				slice.timestamp = targetList.GetStatus().GetTimestamp();
+
+				const EosTargetList::TARGETS &targets = targetList.GetTargets();
+				EosTargetList::TARGETS::const_iterator k = (cursor.inList ? targets.lower_bound(cursor.number) : targets.begin());
+				std::string numberStr;
+				for(unsigned int count=0; k!=targets.end() && count<SLICE_TARGETS; k++, count++)
+				{
+					EosTarget::GetStringFromNumber(k->first, numberStr);
+					double numberValue = atof( numberStr.c_str() );
+
+					const EosTargetList::PARTS &parts = k->second.list;
+					for(EosTargetList::PARTS::const_iterator l=parts.begin(); l!=parts.end(); l++)
+					{
+						slice.targets.push_back( ShowSnapshot::sTarget() );
+						ShowSnapshot::BuildTarget(numberStr, numberValue, l->first, *(l->second), 0, slice.targets.back());
+					}
+				}
+
+				if(k != targets.end())
+				{
+					cursor.listId = j->first;
+					cursor.inList = true;
+					cursor.number = k->first;
+				}
+				else if(j->first < INT_MAX)
+				{
+					cursor.listId = (j->first + 1);
+					cursor.inList = false;
+				}
+				else
+					cursor.done = true;
+			}
+		}
+	}
+	m_SyncThread->UnlockEosSyncLib();
+
+	return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowExport::ExportSlice(const char *typeName, const ShowSnapshot::sTargetList &slice, QByteArray &chunk)
+{
+	const ShowSnapshot::TARGETS &targets = slice.targets;
+	for(ShowSnapshot::TARGETS::const_iterator i=targets.begin(); i!=targets.end(); i++)
+	{
+		if( !m_Run )
+			return false;
+
+		AppendTarget(typeName, slice.listId, *i, chunk);
+		if(chunk.size() >= EXPORT_CHUNK_SIZE)
+		{
+			if( !Flush(chunk) )
+				return false;
+		}
+	}
+
+	m_Mutex.lock();
+	m_Progress.targets += targets.size();
+	m_Mutex.unlock();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowExport::AppendTarget(const char *typeName, int listId, const ShowSnapshot::sTarget &target, QByteArray &chunk) const
+{
+	if(m_Format == FORMAT_CSV)
+	{
+		// the leading columns are the same on every row of the target
+		QByteArray key(typeName);
+		key.append(',');
+		key.append( QByteArray::number(listId) );
+		key.append(',');
+		AppendCsvField(target.number, key);
+		key.append(',');
+		key.append( QByteArray::number(target.part) );
+		key.append(',');
+
+		bool any = false;
+		for(ShowSnapshot::PROP_GROUPS::const_iterator i=target.propGroups.begin(); i!=target.propGroups.end(); i++)
+		{
+			for(size_t j=0; j<i->values.size(); j++)
+			{
+				chunk.append(key);
+				AppendCsvField(i->name, chunk);
+				chunk.append(',');
+				chunk.append( QByteArray::number(static_cast<uint>(j)) );
+				chunk.append(',');
+				AppendCsvField(i->values[j], chunk);
+				chunk.append('\n');
+				any = true;
+			}
+		}
+
+		// a target with no values still gets a row
+		if( !any )
+		{
+			chunk.append(key);
+			chunk.append(",,\n");
+		}
+		return;
+	}
+
+	chunk.append("{\"type\":\"");
+	chunk.append(typeName);
+	chunk.append("\",\"list\":");
+	chunk.append( QByteArray::number(listId) );
+	chunk.append(",\"number\":");
+	AppendJsonString(target.number, chunk);
+	chunk.append(",\"part\":");
+	chunk.append( QByteArray::number(target.part) );
+	chunk.append(",\"timestamp\":");
+	chunk.append( QByteArray::number(static_cast<qint64>(target.timestamp)) );
+	chunk.append(",\"groups\":{");
+	for(ShowSnapshot::PROP_GROUPS::const_iterator i=target.propGroups.begin(); i!=target.propGroups.end(); i++)
+	{
+		if(i != target.propGroups.begin())
+			chunk.append(',');
+		AppendJsonString(i->name, chunk);
+		chunk.append(":[");
+		for(size_t j=0; j<i->values.size(); j++)
+		{
+			if(j != 0)
+				chunk.append(',');
+			AppendJsonString(i->values[j], chunk);
+		}
+		chunk.append(']');
+	}
+	chunk.append("}}\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowExport::Flush(QByteArray &chunk)
+{
+	if( chunk.isEmpty() )
+		return true;
+
+	// the writer gets its own copy, this one keeps its capacity
+	bool ok = m_Writer->Push( QByteArray(chunk.constData(),chunk.size()) );
+	chunk.resize(0);
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowExport::Finish(const QString &error)
+{
+	m_Mutex.lock();
+	m_Progress.bytes = m_Writer->GetBytes();
+	m_Progress.elapsedMS = m_Timer.elapsed();
+	m_Progress.error = error;
+	m_Progress.done = true;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowExport::AppendJsonString(const std::string &str, QByteArray &out)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	out.append('"');
+	for(std::string::const_iterator i=str.begin(); i!=str.end(); i++)
+	{
+		unsigned char c = static_cast<unsigned char>(*i);
+		switch( c )
+		{
+			case '"':	out.append("\\\""); break;
+			case '\\':	out.append("\\\\"); break;
+			case '\n':	out.append("\\n"); break;
+			case '\r':	out.append("\\r"); break;
+			case '\t':	out.append("\\t"); break;
+			default:
+				if(c < 0x20)
+				{
+					out.append("\\u00");
+					out.append(hex[c >> 4]);
+					out.append(hex[c & 0xf]);
+				}
+				else
+					out.append( static_cast<char>(c) );	// UTF-8 passes through
+				break;
+		}
+	}
+	out.append('"');
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowExport::AppendCsvField(const std::string &str, QByteArray &out)
+{
+	if(str.find_first_of(",\"\r\n") == std::string::npos)
+	{
+		out.append(str.c_str(), static_cast<int>(str.size()));
+		return;
+	}
+
+	out.append('"');
+	for(std::string::const_iterator i=str.begin(); i!=str.end(); i++)
+	{
+		if(*i == '"')
+			out.append('"');
+		out.append(*i);
+	}
+	out.append('"');
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int ShowExport::Run(const QString &path, const QString &ip, unsigned short port, unsigned int timeoutSeconds)
+{
+	EosSyncLibThread syncThread;
+
+	printf("Connecting to %s:%u\n", ip.toUtf8().constData(), static_cast<unsigned int>(port));
+	fflush(stdout);
+	syncThread.Start(ip, port);
+
+	// same as the UI tick, until the initial sync is in
+	QElapsedTimer timer;
+	timer.start();
+	bool complete = false;
+	while(!complete && !timer.hasExpired(static_cast<qint64>(timeoutSeconds)*1000))
+	{
+		EosSyncLib *eosSyncLib = syncThread.LockEosSyncLib();
+		if( eosSyncLib )
+		{
+			complete = (eosSyncLib->IsConnected() && eosSyncLib->GetData().GetStatus().GetValue()==EosSyncStatus::SYNC_STATUS_COMPLETE);
+			eosSyncLib->ClearDirty();
+			syncThread.UnlockEosSyncLib();
+		}
+
+		EosLog::LOG_Q logQ;
+		syncThread.GetLogQueue().Pop(logQ, LogQueue::DEFAULT_CAPACITY);
+
+		if( !complete )
+			QThread::msleep(EXPORT_TICK_MS);
+	}
+
+	if( !complete )
+	{
+		syncThread.Stop();
+		printf("initial sync not complete after %u s\n", timeoutSeconds);
+		return 1;
+	}
+
+	printf("Synced in %.1f s, exporting to %s\n", timer.elapsed()/1000.0, path.toUtf8().constData());
+	fflush(stdout);
+
+	ShowExport showExport;
+	QString error;
+	if( !showExport.Start(syncThread,path,GetFormatForPath(path),error) )
+	{
+		syncThread.Stop();
+		printf("unable to open %s: %s\n", path.toUtf8().constData(), error.toUtf8().constData());
+		return 1;
+	}
+
+	// the sync keeps running, so the export sees the show as it is now
+	showExport.wait();
+	syncThread.Stop();
+
+	sProgress progress;
+	showExport.GetProgress(progress);
+	if( !progress.error.isEmpty() )
+	{
+		printf("export failed: %s\n", progress.error.toUtf8().constData());
+		return 1;
+	}
+
+	printf("Exported %u targets, %.1f MB in %.2f s\n",
+		static_cast<unsigned int>(progress.targets),
+		progress.bytes / (1024.0*1024.0),
+		progress.elapsedMS / 1000.0);
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
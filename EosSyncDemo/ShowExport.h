@@ -0,0 +1,130 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef SHOW_EXPORT_H
+#define SHOW_EXPORT_H
+
+#ifndef SHOW_SNAPSHOT_H
+#include "ShowSnapshot.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+class ShowExportWriter;
+class EosSyncLibThread;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Streams the show EosSyncLib holds to a file, one target type after another.
+//
+// JSON Lines has one object per target, with its property groups as arrays
+// of values. CSV has one row per property value, under a fixed header of
+// type, list, number, part, group, index and value, so every target type
+// fits the one table. The export thread copies the show out of EosSyncData
+// a slice at a time, at most one list and SLICE_TARGETS target numbers,
+// under a lock of its own; it writes the slice and lets it go before
+// copying the next. However large a target type is, only one slice is held
+// and the sync thread and UI never wait on more than one slice's copy.
+// Each target is consistent in itself, but slices are taken at different
+// moments, so a list that changes during the export can be written partly
+// as it was and partly as it became.
+//
+// Rows are formatted on the export thread into fixed size chunks, and a
+// separate writer thread writes them out. At most a few chunks are queued
+// between the two, so memory stays flat however big the show is and
+// formatting never waits on a disk write unless the queue is full.
+class ShowExport
+	: public QThread
+{
+public:
+	enum EnumFormat
+	{
+		FORMAT_JSONL,
+		FORMAT_CSV
+	};
+
+	enum EnumConstants
+	{
+		SLICE_TARGETS	= 256		// target numbers copied per lock hold
+	};
+
+	struct sProgress
+	{
+		sProgress();
+		size_t		targets;
+		qint64		bytes;
+		qint64		elapsedMS;
+		bool		done;
+		QString		error;		// empty if ok
+	};
+
+	ShowExport();
+	virtual ~ShowExport();
+
+	// UI thread; the sync thread must outlive the export
+	virtual bool Start(EosSyncLibThread &syncThread, const QString &path, EnumFormat format, QString &error);
+	virtual void Cancel();
+	virtual void GetProgress(sProgress &progress) const;
+	virtual const QString& GetPath() const {return m_Path;}
+
+	// by extension, JSON Lines unless it's .csv
+	static EnumFormat GetFormatForPath(const QString &path);
+
+	// headless: connect, wait for the initial sync, export
+	static int Run(const QString &path, const QString &ip, unsigned short port, unsigned int timeoutSeconds);
+
+protected:
+	// where the next slice starts
+	struct sCursor
+	{
+		sCursor();
+		int								listId;
+		bool							inList;		// false starts at the first list from listId
+		bool							done;
+		EosTargetList::TARGETS::key_type	number;		// first one still to copy, when inList
+	};
+
+	EosSyncLibThread				*m_SyncThread;
+	QString							m_Path;
+	EnumFormat						m_Format;
+	ShowExportWriter				*m_Writer;
+	volatile bool					m_Run;
+	mutable QMutex					m_Mutex;
+	sProgress						m_Progress;
+	QElapsedTimer					m_Timer;
+
+	virtual void run();
+	virtual bool CopySlice(EosTarget::EnumEosTargetType type, sCursor &cursor, ShowSnapshot::sTargetList &slice);
+	virtual bool ExportSlice(const char *typeName, const ShowSnapshot::sTargetList &slice, QByteArray &chunk);
+	virtual void AppendTarget(const char *typeName, int listId, const ShowSnapshot::sTarget &target, QByteArray &chunk) const;
+	virtual bool Flush(QByteArray &chunk);
+	virtual void Finish(const QString &error);
+
+	static void AppendJsonString(const std::string &str, QByteArray &out);
+	static void AppendCsvField(const std::string &str, QByteArray &out);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
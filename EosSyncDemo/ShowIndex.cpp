@@ -0,0 +1,550 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "ShowIndex.h"
+#include <algorithm>
+#include <iterator>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define SEARCH_MAX_RESULTS	500
+
+////////////////////////////////////////////////////////////////////////////////
+
+static inline unsigned char ToLower(unsigned char c)
+{
+	return ((c>='A' && c<='Z') ? static_cast<unsigned char>(c + ('a'-'A')) : c);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static inline bool IsTokenChar(unsigned char c)
+{
+	// anything non-ASCII is kept whole, so UTF-8 words index as they are
+	return ((c>='a' && c<='z') || (c>='A' && c<='Z') || (c>='0' && c<='9') || c>=0x80);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static inline bool IsDigit(unsigned char c)
+{
+	return (c>='0' && c<='9');
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// case-insensitive, a against at most bLen chars of b
+static inline int CompareToken(const char *a, size_t aLen, const char *b, size_t bLen)
+{
+	size_t n = qMin(aLen, bLen);
+	for(size_t i=0; i<n; i++)
+	{
+		unsigned char ca = ToLower( static_cast<unsigned char>(a[i]) );
+		unsigned char cb = ToLower( static_cast<unsigned char>(b[i]) );
+		if(ca != cb)
+			return ((ca < cb) ? -1 : 1);
+	}
+
+	return ((aLen == bLen) ? 0 : ((aLen < bLen) ? -1 : 1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct sPostingOrder
+{
+	template<class T>
+	bool operator()(const T &a, const T &b) const
+	{
+		int c = CompareToken(a.token, a.tokenLen, b.token, b.tokenLen);
+		return ((c != 0) ? (c < 0) : (a.target < b.target));
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct sPostingBeforeWord
+{
+	// true while the posting sorts before every token the word prefixes
+	template<class T>
+	bool operator()(const T &posting, const std::string &word) const
+	{
+		return (CompareToken(posting.token, qMin<size_t>(posting.tokenLen,word.size()), word.c_str(), word.size()) < 0);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowIndex::ShowIndex()
+	: m_PostingCount(0)
+	, m_ChangeHub(0)
+	, m_Subscription(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowIndex::~ShowIndex()
+{
+	Unsubscribe();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowIndex::Subscribe(ChangeHub &changeHub)
+{
+	Unsubscribe();
+	m_ChangeHub = &changeHub;
+	m_Subscription = changeHub.Subscribe();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowIndex::Unsubscribe()
+{
+	if( m_ChangeHub )
+	{
+		m_ChangeHub->Unsubscribe(m_Subscription);
+		m_ChangeHub = 0;
+		m_Subscription = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowIndex::Clear()
+{
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		m_Types[i].targetType.clear();
+		m_Types[i].lists.clear();
+	}
+	m_PostingCount = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowIndex::Update(const ShowSnapshot &snapshot)
+{
+	// the lists named since the last update; after a gap, or unsubscribed,
+	// every list of a changed type is compared instead
+	ChangeHub::LIST_IDS changedLists[EosTarget::EOS_TARGET_COUNT];
+	bool complete = false;
+	if( m_ChangeHub )
+	{
+		ChangeHub::BATCHES batches;
+		complete = m_ChangeHub->Take(m_Subscription, batches);
+		if( complete )
+			ChangeHub::GetChangedLists(batches, changedLists);
+	}
+
+	bool changed = false;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		ShowSnapshot::TARGET_TYPE_PTR targetType = snapshot.GetTargetType( static_cast<EosTarget::EnumEosTargetType>(i) );
+		sTypeIndex &typeIndex = m_Types[i];
+		if(targetType.data() == typeIndex.targetType.data())
+			continue;
+
+		// spilling or restoring republishes the same generation, and every
+		// indexed list holds on to the copy it was built from, so it stays
+		// searchable without reading the type back
+		if(targetType && typeIndex.targetType && targetType->generation==typeIndex.targetType->generation)
+		{
+			typeIndex.targetType = targetType;
+			continue;
+		}
+
+		if(complete && typeIndex.targetType && targetType)
+		{
+			const ChangeHub::LIST_IDS &listIds = changedLists[i];
+			if( !listIds.empty() )
+				IndexLists(typeIndex, *snapshot.LoadTargetType(targetType), listIds);
+		}
+		else if( targetType )
+			IndexType(typeIndex, *snapshot.LoadTargetType(targetType));
+		else
+		{
+			for(LIST_INDEXES::const_iterator j=typeIndex.lists.begin(); j!=typeIndex.lists.end(); j++)
+				m_PostingCount -= j->second.postings.size();
+			typeIndex.lists.clear();
+		}
+
+		typeIndex.targetType = targetType;
+		changed = true;
+	}
+
+	return changed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowIndex::IndexType(sTypeIndex &typeIndex, const ShowSnapshot::sTargetType &targetType)
+{
+	// lists the snapshot shared with its previous generation keep their postings
+	LIST_INDEXES lists;
+	for(ShowSnapshot::TARGET_LISTS::const_iterator i=targetType.lists.begin(); i!=targetType.lists.end(); i++)
+	{
+		sListIndex &listIndex = lists[i->first];
+		LIST_INDEXES::iterator prev = typeIndex.lists.find(i->first);
+		if(prev!=typeIndex.lists.end() && prev->second.list.data()==i->second.data())
+		{
+			listIndex.list = prev->second.list;
+			listIndex.postings.swap(prev->second.postings);
+		}
+		else
+		{
+			listIndex.list = i->second;
+			IndexList(listIndex);
+		}
+	}
+
+	for(LIST_INDEXES::const_iterator i=typeIndex.lists.begin(); i!=typeIndex.lists.end(); i++)
+		m_PostingCount -= i->second.postings.size();
+	for(LIST_INDEXES::const_iterator i=lists.begin(); i!=lists.end(); i++)
+		m_PostingCount += i->second.postings.size();
+
+	typeIndex.lists.swap(lists);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowIndex::IndexLists(sTypeIndex &typeIndex, const ShowSnapshot::sTargetType &targetType, const ChangeHub::LIST_IDS &listIds)
+{
+	// only the named lists, every other list's postings are left as they are
+	for(ChangeHub::LIST_IDS::const_iterator i=listIds.begin(); i!=listIds.end(); i++)
+	{
+		ShowSnapshot::TARGET_LISTS::const_iterator list = targetType.lists.find(*i);
+		LIST_INDEXES::iterator prev = typeIndex.lists.find(*i);
+		if(list == targetType.lists.end())
+		{
+			if(prev != typeIndex.lists.end())
+			{
+				m_PostingCount -= prev->second.postings.size();
+				typeIndex.lists.erase(prev);
+			}
+			continue;
+		}
+
+		sListIndex &listIndex = ((prev != typeIndex.lists.end()) ? prev->second : typeIndex.lists[*i]);
+		if(listIndex.list.data() == list->second.data())
+			continue;
+
+		m_PostingCount -= listIndex.postings.size();
+		listIndex.list = list->second;
+		IndexList(listIndex);
+		m_PostingCount += listIndex.postings.size();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowIndex::IndexList(sListIndex &listIndex)
+{
+	POSTINGS &postings = listIndex.postings;
+	postings.clear();
+
+	const ShowSnapshot::TARGETS &targets = listIndex.list->targets;
+	for(size_t i=0; i<targets.size(); i++)
+	{
+		const ShowSnapshot::sTarget &target = targets[i];
+		quint32 t = static_cast<quint32>(i);
+		AddTokens(target.number, t, -1, 0, postings);
+
+		for(size_t j=0; j<target.propGroups.size(); j++)
+		{
+			const std::vector<std::string> &values = target.propGroups[j].values;
+			for(size_t k=0; k<values.size(); k++)
+				AddTokens(values[k], t, static_cast<qint32>(j), static_cast<qint32>(k), postings);
+		}
+	}
+
+	std::sort(postings.begin(), postings.end(), sPostingOrder());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowIndex::AddTokens(const std::string &text, quint32 target, qint32 group, qint32 prop, POSTINGS &postings)
+{
+	const char *str = text.c_str();
+	size_t len = text.size();
+	size_t i = 0;
+	while(i < len)
+	{
+		while(i<len && !IsTokenChar(static_cast<unsigned char>(str[i])))
+			i++;
+
+		size_t start = i;
+		for(; i<len; i++)
+		{
+			unsigned char c = static_cast<unsigned char>(str[i]);
+			if( IsTokenChar(c) )
+				continue;
+
+			// keep decimal numbers like 12.5 as one token
+			if(c=='.' && i>start && i+1<len && IsDigit(static_cast<unsigned char>(str[i-1])) && IsDigit(static_cast<unsigned char>(str[i+1])))
+				continue;
+
+			break;
+		}
+
+		if(i > start)
+		{
+			sPosting posting;
+			posting.token = (str + start);
+			posting.tokenLen = static_cast<quint32>(i - start);
+			posting.target = target;
+			posting.group = group;
+			posting.prop = prop;
+			postings.push_back(posting);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowIndex::GetWords(const QString &query, std::vector<std::string> &words)
+{
+	// the query is split exactly like the values, then lowered
+	words.clear();
+	std::string q( query.toUtf8().constData() );
+	POSTINGS postings;
+	AddTokens(q, 0, 0, 0, postings);
+	for(POSTINGS::const_iterator i=postings.begin(); i!=postings.end(); i++)
+	{
+		std::string word(i->token, i->tokenLen);
+		for(size_t j=0; j<word.size(); j++)
+			word[j] = static_cast<char>( ToLower(static_cast<unsigned char>(word[j])) );
+		words.push_back(word);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowIndex::SearchList(const sListIndex &listIndex, const std::vector<std::string> &words, std::vector<quint32> &targets, std::vector<const sPosting*> &firstMatch) const
+{
+	targets.clear();
+	firstMatch.clear();
+
+	const POSTINGS &postings = listIndex.postings;
+	std::vector<quint32> matched;
+	std::vector<quint32> both;
+	std::vector< std::pair<quint32,const sPosting*> > first;
+	for(size_t w=0; w<words.size(); w++)
+	{
+		const std::string &word = words[w];
+		matched.clear();
+		POSTINGS::const_iterator i = std::lower_bound(postings.begin(), postings.end(), word, sPostingBeforeWord());
+		for(; i!=postings.end() && i->tokenLen>=word.size() && CompareToken(i->token,word.size(),word.c_str(),word.size())==0; i++)
+		{
+			matched.push_back(i->target);
+			if(w == 0)
+				first.push_back( std::make_pair(i->target,&(*i)) );
+		}
+
+		std::sort(matched.begin(), matched.end());
+		matched.erase(std::unique(matched.begin(),matched.end()), matched.end());
+
+		if(w == 0)
+			targets.swap(matched);
+		else
+		{
+			both.clear();
+			std::set_intersection(targets.begin(), targets.end(), matched.begin(), matched.end(), std::back_inserter(both));
+			targets.swap(both);
+		}
+
+		if( targets.empty() )
+			return;
+	}
+
+	// where each remaining target first matched, for showing the hit
+	std::sort(first.begin(), first.end());
+	firstMatch.reserve( targets.size() );
+	std::vector< std::pair<quint32,const sPosting*> >::const_iterator f = first.begin();
+	for(std::vector<quint32>::const_iterator i=targets.begin(); i!=targets.end(); i++)
+	{
+		while(f!=first.end() && f->first<*i)
+			f++;
+		firstMatch.push_back((f!=first.end() && f->first==*i) ? f->second : 0);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t ShowIndex::Search(const QString &query, size_t max, HITS &hits) const
+{
+	hits.clear();
+
+	std::vector<std::string> words;
+	GetWords(query, words);
+	if( words.empty() )
+		return 0;
+
+	size_t count = 0;
+	std::vector<quint32> targets;
+	std::vector<const sPosting*> firstMatch;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		const sTypeIndex &typeIndex = m_Types[i];
+		for(LIST_INDEXES::const_iterator j=typeIndex.lists.begin(); j!=typeIndex.lists.end(); j++)
+		{
+			const sListIndex &listIndex = j->second;
+			SearchList(listIndex, words, targets, firstMatch);
+			count += targets.size();
+
+			for(size_t k=0; k<targets.size() && hits.size()<max; k++)
+			{
+				const ShowSnapshot::sTarget &target = listIndex.list->targets[ targets[k] ];
+				hits.push_back( sHit() );
+				sHit &hit = hits.back();
+				hit.type = static_cast<EosTarget::EnumEosTargetType>(i);
+				hit.listId = j->first;
+				hit.number = target.number;
+				hit.part = target.part;
+
+				const sPosting *posting = firstMatch[k];
+				if(posting && posting->group>=0)
+				{
+					const ShowSnapshot::sPropGroup &group = target.propGroups[posting->group];
+					hit.group = group.name;
+					hit.value = group.values[posting->prop];
+				}
+			}
+		}
+	}
+
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowSearchView::ShowSearchView(QWidget *parent, ChangeHub &changeHub)
+	: QWidget(parent, Qt::Window)
+{
+	setWindowTitle("Search");
+	m_Index.Subscribe(changeHub);
+
+	QGridLayout *layout = new QGridLayout(this);
+
+	m_Query = new QLineEdit(this);
+	connect(m_Query, SIGNAL(textChanged(const QString&)), this, SLOT(onQueryChanged(const QString&)));
+	layout->addWidget(m_Query, 0, 0);
+
+	m_Summary = new QLabel(this);
+	QPalette summaryPal( m_Summary->palette() );
+	summaryPal.setColor(QPalette::WindowText, MUTED_COLOR);
+	m_Summary->setPalette(summaryPal);
+	layout->addWidget(m_Summary, 1, 0);
+
+	m_Results = new QListWidget(this);
+	connect(m_Results, SIGNAL(itemActivated(QListWidgetItem*)), this, SLOT(onResultActivated(QListWidgetItem*)));
+	layout->addWidget(m_Results, 2, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSearchView::Update(const ShowSnapshot &snapshot)
+{
+	if( !isVisible() )
+		return;
+
+	if( m_Index.Update(snapshot) )
+		Search();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSearchView::hideEvent(QHideEvent *event)
+{
+	// closed rather than minimized, so nothing holds on to the show;
+	// reopening indexes it afresh
+	if( !event->spontaneous() )
+	{
+		m_Index.Clear();
+		m_Hits.clear();
+		m_Results->clear();
+	}
+	QWidget::hideEvent(event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSearchView::onQueryChanged(const QString& /*text*/)
+{
+	Search();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSearchView::Search()
+{
+	QElapsedTimer timer;
+	timer.start();
+	size_t count = m_Index.Search(m_Query->text(), SEARCH_MAX_RESULTS, m_Hits);
+	double ms = (timer.nsecsElapsed() / 1000000.0);
+
+	m_Results->setUpdatesEnabled(false);
+	m_Results->clear();
+	for(size_t i=0; i<m_Hits.size(); i++)
+	{
+		const ShowIndex::sHit &hit = m_Hits[i];
+		QString text( EosTarget::GetNameForTargetType(hit.type) );
+		if(hit.type==EosTarget::EOS_TARGET_CUE && hit.listId>0)
+			text.append( QString(" %1/").arg(hit.listId) );
+		else
+			text.append(" ");
+		text.append( QString::fromUtf8(hit.number.c_str()) );
+		if(hit.part > 0)
+			text.append( QString(" part %1").arg(hit.part) );
+		if( !hit.value.empty() )
+		{
+			text.append("  ");
+			if( !hit.group.empty() )
+				text.append( QString("[%1] ").arg(QString::fromUtf8(hit.group.c_str())) );
+			text.append( QString("\"%1\"").arg(QString::fromUtf8(hit.value.c_str())) );
+		}
+
+		QListWidgetItem *item = new QListWidgetItem(text, m_Results);
+		item->setData(Qt::UserRole, static_cast<int>(i));
+	}
+	m_Results->setUpdatesEnabled(true);
+
+	if( m_Query->text().trimmed().isEmpty() )
+		m_Summary->setText( QString("%1 words indexed").arg(m_Index.GetPostingCount()) );
+	else if(count > m_Hits.size())
+		m_Summary->setText( QString("%1 matches, first %2 shown (%3 ms)").arg(count).arg(m_Hits.size()).arg(ms, 0, 'f', 2) );
+	else
+		m_Summary->setText( QString("%1 matches (%2 ms)").arg(count).arg(ms, 0, 'f', 2) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSearchView::onResultActivated(QListWidgetItem *item)
+{
+	int i = item->data(Qt::UserRole).toInt();
+	if(i>=0 && i<static_cast<int>(m_Hits.size()))
+	{
+		const ShowIndex::sHit &hit = m_Hits[i];
+		emit targetSelected(static_cast<unsigned int>(hit.type), hit.listId, QString::fromUtf8(hit.number.c_str()), hit.part);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
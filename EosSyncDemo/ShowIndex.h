@@ -0,0 +1,153 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef SHOW_INDEX_H
+#define SHOW_INDEX_H
+
+#ifndef SHOW_SNAPSHOT_H
+#include "ShowSnapshot.h"
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Inverted index over target numbers, labels and property values.
+//
+// Indexed per target list from ShowSnapshot, and a list is only reindexed
+// when the snapshot holds a new copy of it. Subscribed to the snapshot's
+// ChangeHub, an update only looks at the lists the change batches name, so
+// keeping up with a show costs in proportion to what changed; after missed
+// batches, every list of a changed type is compared instead. Postings point
+// into the snapshot's own immutable strings rather than copying tokens, and
+// each list's postings are kept sorted case-insensitively, so every query
+// word is a binary search per list for the words it prefixes. A target
+// matches when every word of the query prefixes one of its tokens.
+class ShowIndex
+{
+public:
+	struct sHit
+	{
+		EosTarget::EnumEosTargetType	type;
+		int								listId;
+		std::string						number;
+		int								part;
+		std::string						group;	// where the first query word matched
+		std::string						value;
+	};
+
+	typedef std::vector<sHit> HITS;
+
+	ShowIndex();
+	virtual ~ShowIndex();
+
+	virtual void Subscribe(ChangeHub &changeHub);
+	virtual void Unsubscribe();
+
+	// returns true if anything was reindexed
+	virtual bool Update(const ShowSnapshot &snapshot);
+	virtual void Clear();
+
+	// returns the number of matching targets, of which up to max are in hits
+	virtual size_t Search(const QString &query, size_t max, HITS &hits) const;
+
+	virtual size_t GetPostingCount() const {return m_PostingCount;}
+
+protected:
+	struct sPosting
+	{
+		const char		*token;		// into the indexed list, not terminated
+		quint32			tokenLen;
+		quint32			target;
+		qint32			group;		// -1 for the target number
+		qint32			prop;
+	};
+
+	typedef std::vector<sPosting> POSTINGS;
+
+	struct sListIndex
+	{
+		ShowSnapshot::TARGET_LIST_PTR	list;		// keeps the tokens alive
+		POSTINGS						postings;	// by token, then target
+	};
+
+	typedef std::map<int,sListIndex> LIST_INDEXES;
+
+	struct sTypeIndex
+	{
+		ShowSnapshot::TARGET_TYPE_PTR	targetType;		// as published, maybe a spilled stub
+		LIST_INDEXES					lists;
+	};
+
+	sTypeIndex	m_Types[EosTarget::EOS_TARGET_COUNT];
+	size_t		m_PostingCount;
+	ChangeHub	*m_ChangeHub;
+	int			m_Subscription;
+
+	virtual void IndexType(sTypeIndex &typeIndex, const ShowSnapshot::sTargetType &targetType);
+	virtual void IndexLists(sTypeIndex &typeIndex, const ShowSnapshot::sTargetType &targetType, const ChangeHub::LIST_IDS &listIds);
+
+	virtual void SearchList(const sListIndex &listIndex, const std::vector<std::string> &words, std::vector<quint32> &targets, std::vector<const sPosting*> &firstMatch) const;
+
+	static void IndexList(sListIndex &listIndex);
+	static void AddTokens(const std::string &text, quint32 target, qint32 group, qint32 prop, POSTINGS &postings);
+	static void GetWords(const QString &query, std::vector<std::string> &words);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ShowSearchView
+	: public QWidget
+{
+	Q_OBJECT
+
+public:
+	ShowSearchView(QWidget *parent, ChangeHub &changeHub);
+
+	// UI thread, after the snapshot changed
+	virtual void Update(const ShowSnapshot &snapshot);
+
+	virtual QSize sizeHint() const {return QSize(560,420);}
+
+signals:
+	void targetSelected(unsigned int targetType, int listId, const QString &number, int part);
+
+private slots:
+	void onQueryChanged(const QString &text);
+	void onResultActivated(QListWidgetItem *item);
+
+protected:
+	ShowIndex			m_Index;
+	QLineEdit			*m_Query;
+	QLabel				*m_Summary;
+	QListWidget			*m_Results;
+	ShowIndex::HITS		m_Hits;
+
+	virtual void Search();
+	virtual void hideEvent(QHideEvent *event);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,538 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ShowSnapshot.h"
+#include "SnapshotStore.h"
+#include <stdlib.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowSnapshot::ShowSnapshot()
+	: m_Generation(0)
+	, m_Store(0)
+	, m_ChangeHub(0)
+{
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		m_Tracked[i] = true;
+		m_ResidentBytes[i] = 0;
+		m_ResidentGeneration[i] = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowSnapshot::Update(const EosSyncData &syncData)
+{
+	bool anyChanged = false;
+
+	// only this thread ever bumps m_Generation, so it can read it unlocked
+	unsigned int generation = (m_Generation + 1);
+	ChangeHub::sBatch *batch = (m_ChangeHub ? new ChangeHub::sBatch() : 0);
+
+	const EosSyncData::SHOW_DATA &showData = syncData.GetShowData();
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		EosTarget::EnumEosTargetType type = static_cast<EosTarget::EnumEosTargetType>(i);
+
+		// only this thread ever replaces m_TargetTypes, so it can read them unlocked
+		TARGET_TYPE_PTR prev = m_TargetTypes[i];
+
+		if( !m_Tracked[i] )
+		{
+			// dropped, so batch subscribers see its lists go away
+			if( prev )
+			{
+				if( batch )
+				{
+					prev = LoadTargetType(prev);
+					for(TARGET_LISTS::const_iterator k=prev->lists.begin(); k!=prev->lists.end(); k++)
+						AddListChange(*batch, type, k->first, true);
+				}
+
+				SetTargetType(type, TARGET_TYPE_PTR());
+				m_ResidentGeneration[i] = 0;
+				anyChanged = true;
+			}
+			continue;
+		}
+
+		EosSyncData::SHOW_DATA::const_iterator j = showData.find(type);
+		if(j == showData.end())
+		{
+			if(prev && prev->numLists!=0)
+			{
+				if( batch )
+				{
+					prev = LoadTargetType(prev);
+					for(TARGET_LISTS::const_iterator k=prev->lists.begin(); k!=prev->lists.end(); k++)
+						AddListChange(*batch, type, k->first, true);
+				}
+
+				sTargetType *targetType = new sTargetType();
+				targetType->type = type;
+				targetType->generation = (prev->generation + 1);
+				targetType->numTargets = 0;
+				targetType->numLists = 0;
+				targetType->spilled = false;
+				SetTargetType(type, TARGET_TYPE_PTR(targetType));
+				anyChanged = true;
+			}
+			continue;
+		}
+
+		const EosSyncData::TARGETLIST_DATA &targetListData = j->second;
+
+		// anything to do? a spilled stub has no list ids, but a new list is always dirty
+		bool changed = (!prev || prev->numLists!=targetListData.size());
+		for(EosSyncData::TARGETLIST_DATA::const_iterator k=targetListData.begin(); !changed && k!=targetListData.end(); k++)
+		{
+			if(k->second->GetStatus().GetDirty() || (!prev->spilled && prev->lists.find(k->first)==prev->lists.end()))
+				changed = true;
+		}
+
+		if( !changed )
+			continue;
+
+		// bring a spilled type back so its clean lists can still be shared
+		if(prev && prev->spilled)
+			prev = LoadTargetType(prev);
+
+		// rebuild dirty lists, share the rest with the previous generation
+		sTargetType *targetType = new sTargetType();
+		targetType->type = type;
+		targetType->generation = (prev ? (prev->generation + 1) : 1);
+		targetType->numTargets = 0;
+		for(EosSyncData::TARGETLIST_DATA::const_iterator k=targetListData.begin(); k!=targetListData.end(); k++)
+		{
+			TARGET_LIST_PTR targetList;
+			const sTargetList *prevList = 0;
+			if( prev )
+			{
+				TARGET_LISTS::const_iterator l = prev->lists.find(k->first);
+				if(l != prev->lists.end())
+				{
+					prevList = l->second.data();
+					if( !k->second->GetStatus().GetDirty() )
+						targetList = l->second;
+				}
+			}
+
+			if( !targetList )
+			{
+				ChangeHub::sListChange *listChange = (batch ? &AddListChange(*batch,type,k->first,false) : 0);
+				targetList = BuildTargetList(k->first, *(k->second), generation, prevList, listChange);
+				if(listChange && listChange->targets.empty() && prevList)
+					batch->lists.pop_back();	// rebuilt, but nothing in it differs
+			}
+
+			targetType->numTargets += targetList->targets.size();
+			targetType->lists[k->first] = targetList;
+		}
+		targetType->numLists = targetType->lists.size();
+		targetType->spilled = false;
+
+		if(batch && prev)
+		{
+			for(TARGET_LISTS::const_iterator k=prev->lists.begin(); k!=prev->lists.end(); k++)
+			{
+				if(targetType->lists.find(k->first) == targetType->lists.end())
+					AddListChange(*batch, type, k->first, true);
+			}
+		}
+
+		SetTargetType(type, TARGET_TYPE_PTR(targetType));
+		anyChanged = true;
+	}
+
+	if( anyChanged )
+	{
+		m_Mutex.lock();
+		m_Generation = generation;
+		m_Mutex.unlock();
+
+		if( batch )
+		{
+			batch->generation = generation;
+			m_ChangeHub->Publish(batch);
+			batch = 0;
+		}
+	}
+
+	delete batch;
+	return anyChanged;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSnapshot::Clear()
+{
+	m_Mutex.lock();
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		m_TargetTypes[i].clear();
+	m_Generation++;
+	m_Mutex.unlock();
+
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		m_ResidentGeneration[i] = 0;
+
+	if( m_ChangeHub )
+		m_ChangeHub->Reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSnapshot::SetTargetType(EosTarget::EnumEosTargetType type, const TARGET_TYPE_PTR &targetType)
+{
+	m_Mutex.lock();
+	m_TargetTypes[type] = targetType;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSnapshot::SetTracked(EosTarget::EnumEosTargetType type, bool tracked)
+{
+	if(type>=0 && type<EosTarget::EOS_TARGET_COUNT)
+		m_Tracked[type] = tracked;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowSnapshot::GetTracked(EosTarget::EnumEosTargetType type) const
+{
+	return (type>=0 && type<EosTarget::EOS_TARGET_COUNT && m_Tracked[type]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowSnapshot::Spill(EosTarget::EnumEosTargetType type, qint64 &storedBytes)
+{
+	if(!m_Store || type<0 || type>=EosTarget::EOS_TARGET_COUNT)
+		return false;
+
+	TARGET_TYPE_PTR prev = m_TargetTypes[type];
+	if(!prev || prev->spilled || prev->numLists==0)
+		return false;
+
+	if( !m_Store->Write(*prev,storedBytes) )
+		return false;
+
+	// the content is unchanged, so neither generation moves
+	sTargetType *stub = new sTargetType();
+	stub->type = type;
+	stub->generation = prev->generation;
+	stub->numTargets = prev->numTargets;
+	stub->numLists = prev->numLists;
+	stub->spilled = true;
+	SetTargetType(type, TARGET_TYPE_PTR(stub));
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowSnapshot::Restore(EosTarget::EnumEosTargetType type)
+{
+	if(type<0 || type>=EosTarget::EOS_TARGET_COUNT)
+		return false;
+
+	TARGET_TYPE_PTR prev = m_TargetTypes[type];
+	if(!prev || !prev->spilled)
+		return false;
+
+	TARGET_TYPE_PTR targetType = LoadTargetType(prev);
+	if(!targetType || targetType->spilled)
+		return false;
+
+	SetTargetType(type, targetType);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t ShowSnapshot::GetResidentBytes(EosTarget::EnumEosTargetType type)
+{
+	if(type<0 || type>=EosTarget::EOS_TARGET_COUNT)
+		return 0;
+
+	const TARGET_TYPE_PTR &targetType = m_TargetTypes[type];
+	if(!targetType || targetType->spilled)
+		return 0;
+
+	if(m_ResidentGeneration[type] != targetType->generation)
+	{
+		m_ResidentBytes[type] = EstimateBytes(*targetType);
+		m_ResidentGeneration[type] = targetType->generation;
+	}
+
+	return m_ResidentBytes[type];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSnapshot::SpillToBudget(size_t budget, unsigned int keep, SPILLS &spills)
+{
+	// the largest type other than keep goes first, until under budget
+	for(;;)
+	{
+		size_t total = 0;
+		size_t largestBytes = 0;
+		int largest = -1;
+		for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		{
+			size_t bytes = GetResidentBytes( static_cast<EosTarget::EnumEosTargetType>(i) );
+			total += bytes;
+			if(static_cast<unsigned int>(i)!=keep && bytes>largestBytes)
+			{
+				largest = i;
+				largestBytes = bytes;
+			}
+		}
+
+		if(total<=budget || largest<0)
+			return;
+
+		sSpill spill;
+		spill.type = static_cast<EosTarget::EnumEosTargetType>(largest);
+		spill.residentBytes = largestBytes;
+		spill.storedBytes = 0;
+		spill.ok = Spill(spill.type, spill.storedBytes);
+		spills.push_back(spill);
+		if( !spill.ok )
+			return;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowSnapshot::TARGET_TYPE_PTR ShowSnapshot::LoadTargetType(const TARGET_TYPE_PTR &targetType) const
+{
+	if(!targetType || !targetType->spilled || !m_Store)
+		return targetType;
+
+	TARGET_TYPE_PTR loaded = m_Store->Read(targetType->type, targetType->generation);
+	return (loaded ? loaded : targetType);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowSnapshot::TARGET_TYPE_PTR ShowSnapshot::GetTargetType(EosTarget::EnumEosTargetType type) const
+{
+	TARGET_TYPE_PTR targetType;
+	if(type>=0 && type<EosTarget::EOS_TARGET_COUNT)
+	{
+		m_Mutex.lock();
+		targetType = m_TargetTypes[type];
+		m_Mutex.unlock();
+	}
+	return targetType;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int ShowSnapshot::GetGeneration() const
+{
+	m_Mutex.lock();
+	unsigned int generation = m_Generation;
+	m_Mutex.unlock();
+	return generation;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowSnapshot::GetTargetTypeForName(const QString &name, EosTarget::EnumEosTargetType &type)
+{
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		EosTarget::EnumEosTargetType t = static_cast<EosTarget::EnumEosTargetType>(i);
+		if(name.compare(EosTarget::GetNameForTargetType(t),Qt::CaseInsensitive) == 0)
+		{
+			type = t;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSnapshot::BuildTarget(const std::string &number, double numberValue, int part, const EosTarget &target, unsigned int generation, sTarget &t)
+{
+	t.number = number;
+	t.numberValue = numberValue;
+	t.part = part;
+	t.generation = generation;
+	t.timestamp = target.GetStatus().GetTimestamp();
+
+	const EosTarget::PROP_GROUPS &propGroups = target.GetPropGroups();
+	t.propGroups.clear();
+	t.propGroups.reserve( propGroups.size() );
+	for(EosTarget::PROP_GROUPS::const_iterator i=propGroups.begin(); i!=propGroups.end(); i++)
+	{
+		t.propGroups.push_back( sPropGroup() );
+		sPropGroup &propGroup = t.propGroups.back();
+		propGroup.name = i->first;
+
+		const EosTarget::PROPS &props = i->second.props;
+		propGroup.values.reserve( props.size() );
+		for(EosTarget::PROPS::const_iterator j=props.begin(); j!=props.end(); j++)
+			propGroup.values.push_back(j->value);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowSnapshot::TARGET_LIST_PTR ShowSnapshot::BuildTargetList(int listId, const EosTargetList &targetList, unsigned int generation, const sTargetList *prev, ChangeHub::sListChange *change)
+{
+	sTargetList *list = new sTargetList();
+	list->listId = listId;
+	list->generation = generation;
+	list->timestamp = targetList.GetStatus().GetTimestamp();
+
+	const EosTargetList::TARGETS &targets = targetList.GetTargets();
+	list->targets.reserve( targetList.GetNumTargets() );
+
+	// both sides are in number/part order, so matching up with the previous
+	// build is a merge; untouched targets keep their generation
+	static const TARGETS sNone;
+	const TARGETS &prevTargets = (prev ? prev->targets : sNone);
+	TARGETS::const_iterator p = prevTargets.begin();
+
+	std::string numberStr;
+	for(EosTargetList::TARGETS::const_iterator i=targets.begin(); i!=targets.end(); i++)
+	{
+		EosTarget::GetStringFromNumber(i->first, numberStr);
+		double numberValue = atof( numberStr.c_str() );
+
+		const EosTargetList::PARTS &parts = i->second.list;
+		for(EosTargetList::PARTS::const_iterator j=parts.begin(); j!=parts.end(); j++)
+		{
+			list->targets.push_back( sTarget() );
+			sTarget &t = list->targets.back();
+			BuildTarget(numberStr, numberValue, j->first, *(j->second), generation, t);
+
+			for(; p!=prevTargets.end() && TargetLess(*p,t); p++)
+			{
+				if( change )
+					AddTargetChange(*change, *p, ChangeHub::TARGET_REMOVED);
+			}
+
+			if(p!=prevTargets.end() && !TargetLess(t,*p))
+			{
+				if(p->timestamp==t.timestamp && SameContent(*p,t))
+					t.generation = p->generation;
+				else if( change )
+					AddTargetChange(*change, t, ChangeHub::TARGET_CHANGED);
+				p++;
+			}
+			else if( change )
+				AddTargetChange(*change, t, ChangeHub::TARGET_ADDED);
+		}
+	}
+
+	for(; p!=prevTargets.end(); p++)
+	{
+		if( change )
+			AddTargetChange(*change, *p, ChangeHub::TARGET_REMOVED);
+	}
+
+	return TARGET_LIST_PTR(list);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowSnapshot::TargetLess(const sTarget &a, const sTarget &b)
+{
+	if(a.numberValue != b.numberValue)
+		return (a.numberValue < b.numberValue);
+	return (a.part < b.part);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ShowSnapshot::SameContent(const sTarget &a, const sTarget &b)
+{
+	if(a.propGroups.size() != b.propGroups.size())
+		return false;
+
+	for(size_t i=0; i<a.propGroups.size(); i++)
+	{
+		const sPropGroup &groupA = a.propGroups[i];
+		const sPropGroup &groupB = b.propGroups[i];
+		if(groupA.name!=groupB.name || groupA.values!=groupB.values)
+			return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ChangeHub::sListChange& ShowSnapshot::AddListChange(ChangeHub::sBatch &batch, EosTarget::EnumEosTargetType type, int listId, bool removed)
+{
+	batch.lists.push_back( ChangeHub::sListChange() );
+	ChangeHub::sListChange &change = batch.lists.back();
+	change.type = type;
+	change.listId = listId;
+	change.removed = removed;
+	return change;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ShowSnapshot::AddTargetChange(ChangeHub::sListChange &change, const sTarget &target, ChangeHub::EnumTargetChange kind)
+{
+	change.targets.push_back( ChangeHub::sTargetChange() );
+	ChangeHub::sTargetChange &targetChange = change.targets.back();
+	targetChange.number = target.number;
+	targetChange.numberValue = target.numberValue;
+	targetChange.part = target.part;
+	targetChange.kind = kind;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t ShowSnapshot::EstimateBytes(const sTargetType &targetType)
+{
+	// heap footprint, counting string buffers beyond the small string optimization
+	size_t bytes = sizeof(sTargetType);
+	for(TARGET_LISTS::const_iterator i=targetType.lists.begin(); i!=targetType.lists.end(); i++)
+	{
+		const sTargetList &list = *(i->second);
+		bytes += (sizeof(sTargetList) + 64);
+		bytes += (list.targets.capacity() * sizeof(sTarget));
+		for(TARGETS::const_iterator j=list.targets.begin(); j!=list.targets.end(); j++)
+		{
+			bytes += j->number.capacity();
+			bytes += (j->propGroups.capacity() * sizeof(sPropGroup));
+			for(PROP_GROUPS::const_iterator k=j->propGroups.begin(); k!=j->propGroups.end(); k++)
+			{
+				bytes += k->name.capacity();
+				bytes += (k->values.capacity() * sizeof(std::string));
+				for(std::vector<std::string>::const_iterator l=k->values.begin(); l!=k->values.end(); l++)
+					bytes += l->capacity();
+			}
+		}
+	}
+	return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
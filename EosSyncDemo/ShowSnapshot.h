@@ -0,0 +1,167 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef SHOW_SNAPSHOT_H
+#define SHOW_SNAPSHOT_H
+
+#ifndef EOS_SYNC_LIB_H
+#include "EosSyncLib.h"
+#endif
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#ifndef CHANGE_HUB_H
+#include "ChangeHub.h"
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+#include <time.h>
+
+class SnapshotStore;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Read-only copy of EosSyncData for consumers on other threads.
+// Update() runs on the UI thread while EosSyncLib is locked and rebuilds only
+// the target lists that changed; each published target type is immutable and
+// shared, so readers never touch the EosSyncLib lock.
+//
+// The snapshot, each target type, each list and each target carry the
+// generation they last changed in, and with a ChangeHub attached every
+// generation's changed lists and targets are published to its subscribers.
+//
+// Only tracked target types are copied. An untracked type is dropped and reads
+// as null, so a consumer that needs one type doesn't pay for the whole show;
+// tracking it again rebuilds it from EosSyncData on the next Update().
+//
+// With a SnapshotStore attached, a target type nobody is viewing can be
+// spilled to disk to keep the copy within a memory budget. The budget is for
+// this copy alone; EosSyncData still holds the whole show. A spilled type is
+// published as a stub with the same generation and counts but no lists, and
+// consumers that need the targets go through LoadTargetType().
+class ShowSnapshot
+{
+public:
+	struct sPropGroup
+	{
+		std::string					name;
+		std::vector<std::string>	values;
+	};
+
+	typedef std::vector<sPropGroup> PROP_GROUPS;
+
+	struct sTarget
+	{
+		std::string		number;		// as displayed, "12.5"
+		double			numberValue;
+		int				part;
+		unsigned int	generation;	// snapshot generation it last changed in
+		time_t			timestamp;
+		PROP_GROUPS		propGroups;
+	};
+
+	typedef std::vector<sTarget> TARGETS;	// in number/part order
+
+	struct sTargetList
+	{
+		int				listId;
+		unsigned int	generation;		// snapshot generation it was built in
+		time_t			timestamp;
+		TARGETS	targets;
+	};
+
+	typedef QSharedPointer<const sTargetList> TARGET_LIST_PTR;
+	typedef std::map<int, TARGET_LIST_PTR> TARGET_LISTS;
+
+	struct sTargetType
+	{
+		EosTarget::EnumEosTargetType	type;
+		unsigned int					generation;		// bumped on every change to this type
+		size_t							numTargets;
+		size_t							numLists;
+		bool							spilled;		// lists are in the store, see LoadTargetType()
+		TARGET_LISTS					lists;
+	};
+
+	typedef QSharedPointer<const sTargetType> TARGET_TYPE_PTR;
+
+	struct sSpill
+	{
+		EosTarget::EnumEosTargetType	type;
+		size_t							residentBytes;
+		qint64							storedBytes;
+		bool							ok;				// false stops SpillToBudget(), still over budget
+	};
+
+	typedef std::vector<sSpill> SPILLS;
+
+	ShowSnapshot();
+	virtual ~ShowSnapshot() {}
+
+	// UI thread, with EosSyncLib locked and before ClearDirty()
+	virtual bool Update(const EosSyncData &syncData);
+	virtual void Clear();
+
+	// UI thread
+	virtual void SetStore(SnapshotStore *store) {m_Store = store;}
+	virtual void SetChangeHub(ChangeHub *changeHub) {m_ChangeHub = changeHub;}
+	virtual void SetTracked(EosTarget::EnumEosTargetType type, bool tracked);
+	virtual bool GetTracked(EosTarget::EnumEosTargetType type) const;
+	virtual bool Spill(EosTarget::EnumEosTargetType type, qint64 &storedBytes);
+	virtual bool Restore(EosTarget::EnumEosTargetType type);
+	virtual size_t GetResidentBytes(EosTarget::EnumEosTargetType type);
+	virtual void SpillToBudget(size_t budget, unsigned int keep, SPILLS &spills);
+
+	// any thread
+	virtual TARGET_TYPE_PTR GetTargetType(EosTarget::EnumEosTargetType type) const;
+	virtual TARGET_TYPE_PTR LoadTargetType(const TARGET_TYPE_PTR &targetType) const;
+	virtual unsigned int GetGeneration() const;
+
+	static bool GetTargetTypeForName(const QString &name, EosTarget::EnumEosTargetType &type);
+	static void BuildTarget(const std::string &number, double numberValue, int part, const EosTarget &target, unsigned int generation, sTarget &t);
+	static TARGET_LIST_PTR BuildTargetList(int listId, const EosTargetList &targetList, unsigned int generation, const sTargetList *prev, ChangeHub::sListChange *change);
+	static bool TargetLess(const sTarget &a, const sTarget &b);
+	static bool SameContent(const sTarget &a, const sTarget &b);
+	static size_t EstimateBytes(const sTargetType &targetType);
+
+protected:
+	mutable QMutex	m_Mutex;
+	TARGET_TYPE_PTR	m_TargetTypes[EosTarget::EOS_TARGET_COUNT];
+	unsigned int	m_Generation;
+	SnapshotStore	*m_Store;
+	ChangeHub		*m_ChangeHub;
+	bool			m_Tracked[EosTarget::EOS_TARGET_COUNT];		// everything until told otherwise
+	size_t			m_ResidentBytes[EosTarget::EOS_TARGET_COUNT];
+	unsigned int	m_ResidentGeneration[EosTarget::EOS_TARGET_COUNT];	// of m_ResidentBytes, 0 if none
+
+	virtual void SetTargetType(EosTarget::EnumEosTargetType type, const TARGET_TYPE_PTR &targetType);
+
+	static ChangeHub::sListChange& AddListChange(ChangeHub::sBatch &batch, EosTarget::EnumEosTargetType type, int listId, bool removed);
+	static void AddTargetChange(ChangeHub::sListChange &change, const sTarget &target, ChangeHub::EnumTargetChange kind);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,315 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "SnapshotStore.h"
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define STORE_MAGIC		0x45535331	// "ESS1"
+#define STORE_COMPRESS	1			// favor speed, the text compresses well regardless
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void WriteU32(QByteArray &buf, quint32 n)
+{
+	buf.append( reinterpret_cast<const char*>(&n), sizeof(n) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void WriteString(QByteArray &buf, const std::string &str)
+{
+	WriteU32(buf, static_cast<quint32>(str.size()));
+	buf.append(str.data(), static_cast<int>(str.size()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class StoreReader
+{
+public:
+	StoreReader(const QByteArray &buf)
+		: m_Data(buf.constData())
+		, m_Size(buf.size())
+		, m_Pos(0)
+		, m_Ok(true)
+	{
+	}
+
+	bool IsOk() const {return m_Ok;}
+
+	quint32 U32()
+	{
+		quint32 n = 0;
+		if( Need(sizeof(n)) )
+		{
+			memcpy(&n, m_Data+m_Pos, sizeof(n));
+			m_Pos += sizeof(n);
+		}
+		return n;
+	}
+
+	qint64 I64()
+	{
+		qint64 n = 0;
+		if( Need(sizeof(n)) )
+		{
+			memcpy(&n, m_Data+m_Pos, sizeof(n));
+			m_Pos += sizeof(n);
+		}
+		return n;
+	}
+
+	double Double()
+	{
+		double d = 0;
+		if( Need(sizeof(d)) )
+		{
+			memcpy(&d, m_Data+m_Pos, sizeof(d));
+			m_Pos += sizeof(d);
+		}
+		return d;
+	}
+
+	void String(std::string &str)
+	{
+		quint32 len = U32();
+		if( Need(len) )
+		{
+			str.assign(m_Data+m_Pos, len);
+			m_Pos += static_cast<int>(len);
+		}
+	}
+
+protected:
+	const char	*m_Data;
+	int			m_Size;
+	int			m_Pos;
+	bool		m_Ok;
+
+	bool Need(quint32 n)
+	{
+		if(m_Ok && n>static_cast<quint32>(m_Size-m_Pos))
+			m_Ok = false;
+		return m_Ok;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+SnapshotStore::SnapshotStore()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SnapshotStore::~SnapshotStore()
+{
+	Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SnapshotStore::Open(QString &error)
+{
+	Close();
+
+	QString name( QString("EosSyncDemo-%1").arg(QCoreApplication::applicationPid()) );
+	QDir dir( QDir::temp() );
+	if(!dir.mkpath(name) || !dir.cd(name))
+	{
+		error = QString("unable to create %1").arg(dir.filePath(name));
+		return false;
+	}
+
+	m_Mutex.lock();
+	m_Path = dir.absolutePath();
+	m_Mutex.unlock();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SnapshotStore::Close()
+{
+	m_Mutex.lock();
+	if( !m_Path.isEmpty() )
+	{
+		QDir dir(m_Path);
+		for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+			dir.remove( GetFileName(static_cast<EosTarget::EnumEosTargetType>(i)) );
+		QString name( dir.dirName() );
+		if( dir.cdUp() )
+			dir.rmdir(name);
+		m_Path.clear();
+	}
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QString SnapshotStore::GetFileName(EosTarget::EnumEosTargetType type) const
+{
+	return QString("type%1.bin").arg(static_cast<int>(type));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SnapshotStore::Write(const ShowSnapshot::sTargetType &targetType, qint64 &bytes)
+{
+	QByteArray buf;
+	WriteU32(buf, STORE_MAGIC);
+	WriteU32(buf, static_cast<quint32>(targetType.type));
+	WriteU32(buf, targetType.generation);
+	WriteU32(buf, static_cast<quint32>(targetType.lists.size()));
+	for(ShowSnapshot::TARGET_LISTS::const_iterator i=targetType.lists.begin(); i!=targetType.lists.end(); i++)
+	{
+		const ShowSnapshot::sTargetList &list = *(i->second);
+		WriteU32(buf, static_cast<quint32>(list.listId));
+		WriteU32(buf, list.generation);
+		qint64 timestamp = static_cast<qint64>(list.timestamp);
+		buf.append(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+		WriteU32(buf, static_cast<quint32>(list.targets.size()));
+		for(ShowSnapshot::TARGETS::const_iterator j=list.targets.begin(); j!=list.targets.end(); j++)
+		{
+			const ShowSnapshot::sTarget &target = *j;
+			WriteString(buf, target.number);
+			buf.append(reinterpret_cast<const char*>(&target.numberValue), sizeof(target.numberValue));
+			WriteU32(buf, static_cast<quint32>(target.part));
+			WriteU32(buf, target.generation);
+			timestamp = static_cast<qint64>(target.timestamp);
+			buf.append(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+			WriteU32(buf, static_cast<quint32>(target.propGroups.size()));
+			for(ShowSnapshot::PROP_GROUPS::const_iterator k=target.propGroups.begin(); k!=target.propGroups.end(); k++)
+			{
+				WriteString(buf, k->name);
+				WriteU32(buf, static_cast<quint32>(k->values.size()));
+				for(std::vector<std::string>::const_iterator l=k->values.begin(); l!=k->values.end(); l++)
+					WriteString(buf, *l);
+			}
+		}
+	}
+
+	QByteArray compressed( qCompress(buf,STORE_COMPRESS) );
+	buf.clear();
+
+	QMutexLocker locker(&m_Mutex);
+	if( m_Path.isEmpty() )
+		return false;
+
+	// written aside and renamed, so a reader never sees half a file
+	QDir dir(m_Path);
+	QString name( GetFileName(targetType.type) );
+	QString tmpName(name + ".tmp");
+	QFile file( dir.filePath(tmpName) );
+	if( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+		return false;
+	bool ok = (file.write(compressed) == compressed.size());
+	file.close();
+	dir.remove(name);
+	if(!ok || !dir.rename(tmpName,name))
+	{
+		dir.remove(tmpName);
+		return false;
+	}
+
+	bytes = compressed.size();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ShowSnapshot::TARGET_TYPE_PTR SnapshotStore::Read(EosTarget::EnumEosTargetType type, unsigned int generation) const
+{
+	QByteArray compressed;
+	{
+		QMutexLocker locker(&m_Mutex);
+		if( m_Path.isEmpty() )
+			return ShowSnapshot::TARGET_TYPE_PTR();
+
+		QFile file( QDir(m_Path).filePath(GetFileName(type)) );
+		if( !file.open(QIODevice::ReadOnly) )
+			return ShowSnapshot::TARGET_TYPE_PTR();
+		compressed = file.readAll();
+	}
+
+	QByteArray buf( qUncompress(compressed) );
+	compressed.clear();
+
+	StoreReader reader(buf);
+	if(reader.U32()!=STORE_MAGIC || reader.U32()!=static_cast<quint32>(type) || reader.U32()!=generation)
+		return ShowSnapshot::TARGET_TYPE_PTR();
+
+	ShowSnapshot::sTargetType *targetType = new ShowSnapshot::sTargetType();
+	targetType->type = type;
+	targetType->generation = generation;
+	targetType->numTargets = 0;
+	targetType->spilled = false;
+
+	quint32 numLists = reader.U32();
+	for(quint32 i=0; reader.IsOk() && i<numLists; i++)
+	{
+		ShowSnapshot::sTargetList *list = new ShowSnapshot::sTargetList();
+		list->listId = static_cast<int>( reader.U32() );
+		list->generation = reader.U32();
+		list->timestamp = static_cast<time_t>( reader.I64() );
+		quint32 numTargets = reader.U32();
+		if( reader.IsOk() )
+			list->targets.resize(numTargets);
+		for(quint32 j=0; reader.IsOk() && j<numTargets; j++)
+		{
+			ShowSnapshot::sTarget &target = list->targets[j];
+			reader.String(target.number);
+			target.numberValue = reader.Double();
+			target.part = static_cast<int>( reader.U32() );
+			target.generation = reader.U32();
+			target.timestamp = static_cast<time_t>( reader.I64() );
+			quint32 numGroups = reader.U32();
+			if( reader.IsOk() )
+				target.propGroups.resize(numGroups);
+			for(quint32 k=0; reader.IsOk() && k<numGroups; k++)
+			{
+				ShowSnapshot::sPropGroup &group = target.propGroups[k];
+				reader.String(group.name);
+				quint32 numValues = reader.U32();
+				if( reader.IsOk() )
+					group.values.resize(numValues);
+				for(quint32 l=0; reader.IsOk() && l<numValues; l++)
+					reader.String(group.values[l]);
+			}
+		}
+
+		targetType->numTargets += list->targets.size();
+		targetType->lists[list->listId] = ShowSnapshot::TARGET_LIST_PTR(list);
+	}
+	targetType->numLists = targetType->lists.size();
+
+	if( !reader.IsOk() )
+	{
+		delete targetType;
+		return ShowSnapshot::TARGET_TYPE_PTR();
+	}
+
+	return ShowSnapshot::TARGET_TYPE_PTR(targetType);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,57 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef SNAPSHOT_STORE_H
+#define SNAPSHOT_STORE_H
+
+#ifndef SHOW_SNAPSHOT_H
+#include "ShowSnapshot.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// On-disk home for target types ShowSnapshot has spilled to stay within its
+// memory budget. Each type is one file in a private temporary directory,
+// written as a flat record stream and compressed, and replaced whenever the
+// type is spilled again. Reads may come from any thread.
+class SnapshotStore
+{
+public:
+	SnapshotStore();
+	virtual ~SnapshotStore();
+
+	virtual bool Open(QString &error);
+	virtual void Close();
+
+	virtual bool Write(const ShowSnapshot::sTargetType &targetType, qint64 &bytes);
+	virtual ShowSnapshot::TARGET_TYPE_PTR Read(EosTarget::EnumEosTargetType type, unsigned int generation) const;
+
+protected:
+	QString			m_Path;
+	mutable QMutex	m_Mutex;
+
+	virtual QString GetFileName(EosTarget::EnumEosTargetType type) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,323 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "SoakTest.h"
+#include "MainWindow.h"
+#include "ChangeJournal.h"
+#include "StandInConsole.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#include <tlhelp32.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <malloc.h>
+#include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define SOAK_EVENTS_MS			10		// between event loop passes; MainWindow's own timer ticks it
+#define SOAK_JOURNAL_CAPACITY	4096
+#define SOAK_STOP_GRACE_MS		250		// for sockets closed by Stop() to go away
+#define SOAK_SETTING_JOURNAL_CAPACITY	"JournalCapacity"	// MainWindow's SETTING_JOURNAL_CAPACITY
+#define BYTES_PER_MB			(1024.0*1024.0)
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void RunEvents(unsigned int ms)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while( !timer.hasExpired(ms) )
+	{
+		QCoreApplication::processEvents(QEventLoop::AllEvents, SOAK_EVENTS_MS);
+		QThread::msleep(SOAK_EVENTS_MS);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t GetTargetCount(const ShowSnapshot &snapshot)
+{
+	size_t count = 0;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		ShowSnapshot::TARGET_TYPE_PTR targetType = snapshot.GetTargetType( static_cast<EosTarget::EnumEosTargetType>(i) );
+		if( targetType )
+			count += targetType->numTargets;
+	}
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void PrintSample(unsigned int cycle, const SoakTest::sSample &sample, size_t targets, size_t journal)
+{
+	printf("  cycle %u: rss %.1f MB, heap %.1f MB in %lld blocks, %d threads, %d handles, %u targets, %u journaled\n",
+		cycle,
+		sample.rssBytes / BYTES_PER_MB,
+		sample.heapBytes / BYTES_PER_MB,
+		static_cast<long long>(sample.heapBlocks),
+		sample.threads,
+		sample.fds,
+		static_cast<unsigned int>(targets),
+		static_cast<unsigned int>(journal));
+	fflush(stdout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool CheckGrowth(const char *name, double growth, double max, const char *units)
+{
+	if(growth <= max)
+		return true;
+
+	printf("FAIL: %s grew %.1f%s since the baseline, limit %.1f%s\n", name, growth, units, max, units);
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SoakTest::sSettings::sSettings()
+	: minutes(60)
+	, cycleSeconds(20)
+	, burstMS(500)
+	, burstSize(8)
+	, targetsPerType(200)
+	, warmupCycles(2)
+	, maxRssGrowthMB(32)
+	, maxHeapGrowthMB(16)
+	, maxThreadGrowth(2)
+	, maxFdGrowth(8)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SoakTest::sSample::sSample()
+	: rssBytes(-1)
+	, heapBytes(-1)
+	, heapBlocks(-1)
+	, threads(-1)
+	, fds(-1)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SoakTest::GetSample(sSample &sample)
+{
+	sample = sSample();
+
+#ifdef WIN32
+	HANDLE process = GetCurrentProcess();
+	PROCESS_MEMORY_COUNTERS counters;
+	if( GetProcessMemoryInfo(process,&counters,sizeof(counters)) )
+		sample.rssBytes = static_cast<qint64>(counters.WorkingSetSize);
+
+	DWORD handles = 0;
+	if( GetProcessHandleCount(process,&handles) )
+		sample.fds = static_cast<int>(handles);
+
+	HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+	if(snapshot != INVALID_HANDLE_VALUE)
+	{
+		DWORD pid = GetCurrentProcessId();
+		THREADENTRY32 entry;
+		entry.dwSize = sizeof(entry);
+		sample.threads = 0;
+		for(BOOL ok=Thread32First(snapshot,&entry); ok; ok=Thread32Next(snapshot,&entry))
+		{
+			if(entry.th32OwnerProcessID == pid)
+				sample.threads++;
+		}
+		CloseHandle(snapshot);
+	}
+
+	HANDLE heap = GetProcessHeap();
+	if( HeapLock(heap) )
+	{
+		PROCESS_HEAP_ENTRY entry;
+		entry.lpData = 0;
+		sample.heapBytes = 0;
+		sample.heapBlocks = 0;
+		while( HeapWalk(heap,&entry) )
+		{
+			if((entry.wFlags & PROCESS_HEAP_ENTRY_BUSY) != 0)
+			{
+				sample.heapBytes += entry.cbData;
+				sample.heapBlocks++;
+			}
+		}
+		HeapUnlock(heap);
+	}
+#elif defined(__APPLE__)
+	mach_task_basic_info_data_t info;
+	mach_msg_type_number_t infoCount = MACH_TASK_BASIC_INFO_COUNT;
+	if(task_info(mach_task_self(),MACH_TASK_BASIC_INFO,reinterpret_cast<task_info_t>(&info),&infoCount) == KERN_SUCCESS)
+		sample.rssBytes = static_cast<qint64>(info.resident_size);
+
+	thread_act_array_t threads = 0;
+	mach_msg_type_number_t threadCount = 0;
+	if(task_threads(mach_task_self(),&threads,&threadCount) == KERN_SUCCESS)
+	{
+		sample.threads = static_cast<int>(threadCount);
+		for(mach_msg_type_number_t i=0; i<threadCount; i++)
+			mach_port_deallocate(mach_task_self(), threads[i]);
+		vm_deallocate(mach_task_self(), reinterpret_cast<vm_address_t>(threads), threadCount*sizeof(thread_act_t));
+	}
+
+	sample.fds = 0;
+	int maxFds = getdtablesize();
+	for(int fd=0; fd<maxFds; fd++)
+	{
+		if(fcntl(fd,F_GETFD) != -1)
+			sample.fds++;
+	}
+
+	malloc_statistics_t stats;
+	malloc_zone_statistics(0, &stats);
+	sample.heapBytes = static_cast<qint64>(stats.size_in_use);
+	sample.heapBlocks = static_cast<qint64>(stats.blocks_in_use);
+#else
+	QFile statm("/proc/self/statm");
+	if( statm.open(QIODevice::ReadOnly) )
+	{
+		QList<QByteArray> fields( statm.readAll().split(' ') );
+		if(fields.size() > 1)
+			sample.rssBytes = (fields[1].toLongLong() * sysconf(_SC_PAGESIZE));
+	}
+
+	// the . and .. entries are filtered out
+	sample.threads = QDir("/proc/self/task").entryList(QDir::Dirs|QDir::NoDotAndDotDot).size();
+	sample.fds = QDir("/proc/self/fd").entryList(QDir::AllEntries|QDir::System|QDir::NoDotAndDotDot).size();
+
+	// glibc has no count of blocks in use, so heapBlocks stays -1
+#if defined(__GLIBC__) && (__GLIBC__>2 || (__GLIBC__==2 && __GLIBC_MINOR__>=33))
+	struct mallinfo2 info = mallinfo2();
+	sample.heapBytes = static_cast<qint64>(info.uordblks + info.hblkhd);
+#else
+	struct mallinfo info = mallinfo();
+	sample.heapBytes = (static_cast<qint64>(static_cast<unsigned int>(info.uordblks)) + static_cast<unsigned int>(info.hblkhd));
+#endif
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int SoakTest::Run(const sSettings &settings)
+{
+	StandInConsole::sSettings consoleSettings;
+	consoleSettings.targetsPerType = settings.targetsPerType;
+	consoleSettings.burstMS = settings.burstMS;
+	consoleSettings.burstSize = settings.burstSize;
+	StandInConsole console(consoleSettings);
+	unsigned short port = 0;
+	if( !console.Listen(port) )
+	{
+		printf("stand-in console unable to listen on loopback\n");
+		return 1;
+	}
+
+	unsigned int cycleSeconds = qMax(1u, settings.cycleSeconds);
+	unsigned int cycles = qMax(qMax(1u,settings.warmupCycles)+1, (settings.minutes*60) / cycleSeconds);
+	printf("Soaking for %u cycles of %u s against a loopback stand-in console, %u targets per type, %u changes every %u ms\n",
+		cycles, cycleSeconds, settings.targetsPerType, settings.burstSize, settings.burstMS);
+	printf("Limits after %u warm-up cycles: rss +%.1f MB, heap +%.1f MB, threads +%d, handles +%d\n",
+		settings.warmupCycles, settings.maxRssGrowthMB, settings.maxHeapGrowthMB, settings.maxThreadGrowth, settings.maxFdGrowth);
+	fflush(stdout);
+
+	// a private settings file, so the soak neither reads nor changes the
+	// operator's; everything at its defaults but the journal, so every type
+	// is snapshotted and diffed the way a journaling UI would
+	QString settingsName( QString("EosSyncDemo.soak.%1").arg(QCoreApplication::applicationPid()) );
+	QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, QDir::temp().filePath(settingsName));
+	QString settingsPath;
+	{
+		QSettings soakSettings(QSettings::IniFormat, QSettings::UserScope, "ETC", "EosSyncDemo");
+		soakSettings.setValue(SOAK_SETTING_JOURNAL_CAPACITY, SOAK_JOURNAL_CAPACITY);
+		settingsPath = soakSettings.fileName();
+	}
+
+	// never shown, but connected and ticked by its own timer exactly as on screen
+	MainWindow *window = new MainWindow(0, 0, QSettings::IniFormat);
+
+	unsigned int baselineCycle = qMax(1u, settings.warmupCycles);
+	sSample baseline;
+	bool ok = true;
+	unsigned int emptyCycles = 0;
+	for(unsigned int cycle=1; ok && cycle<=cycles; cycle++)
+	{
+		// through the same Connect()/Disconnect() as the Sync button
+		window->Connect("127.0.0.1", port);
+		RunEvents(cycleSeconds * 1000);
+
+		size_t targets = GetTargetCount( window->GetShowSnapshot() );
+		const ChangeJournal *journal = window->GetChangeJournal();
+		size_t journaled = (journal ? journal->GetCount() : 0);
+		window->Disconnect();
+		RunEvents(SOAK_STOP_GRACE_MS);
+
+		if(targets == 0)
+			emptyCycles++;
+
+		sSample sample;
+		GetSample(sample);
+		PrintSample(cycle, sample, targets, journaled);
+
+		if(cycle == baselineCycle)
+			baseline = sample;
+		else if(cycle > baselineCycle)
+		{
+			if(baseline.rssBytes>=0 && sample.rssBytes>=0)
+				ok &= CheckGrowth("rss", (sample.rssBytes - baseline.rssBytes)/BYTES_PER_MB, settings.maxRssGrowthMB, " MB");
+			if(baseline.heapBytes>=0 && sample.heapBytes>=0)
+				ok &= CheckGrowth("heap", (sample.heapBytes - baseline.heapBytes)/BYTES_PER_MB, settings.maxHeapGrowthMB, " MB");
+			if(baseline.threads>=0 && sample.threads>=0)
+				ok &= CheckGrowth("threads", sample.threads - baseline.threads, settings.maxThreadGrowth, "");
+			if(baseline.fds>=0 && sample.fds>=0)
+				ok &= CheckGrowth("handles", sample.fds - baseline.fds, settings.maxFdGrowth, "");
+		}
+	}
+
+	delete window;
+	console.Stop();
+
+	QFile::remove(settingsPath);
+	QDir(QDir::temp().filePath(settingsName)).rmdir("ETC");
+	QDir::temp().rmdir(settingsName);
+
+	if(emptyCycles != 0)
+		printf("warning: nothing synced in %u cycles, the stand-in console may not match this EosSyncLib\n", emptyCycles);
+	printf(ok ? "PASS\n" : "FAIL\n");
+	return (ok ? 0 : 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
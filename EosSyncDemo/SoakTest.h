@@ -0,0 +1,76 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef SOAK_TEST_H
+#define SOAK_TEST_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Headless long-running check for leaks across connections.
+//
+// A stand-in console on loopback serves a synthetic show and keeps changing
+// it in bursts. The soak creates a MainWindow, never shown and with settings
+// of its own, and repeatedly connects it to the console through the same
+// Connect() and Disconnect() as the Sync button, with its own timer ticking
+// it in between, so leaks anywhere on that path show up. After every cycle the
+// process is sampled for resident memory, heap in use, threads and open
+// descriptors. The samples after a couple of warm-up cycles are the
+// baseline, and the run fails as soon as any of them grows past its limit.
+class SoakTest
+{
+public:
+	struct sSettings
+	{
+		sSettings();
+		unsigned int	minutes;
+		unsigned int	cycleSeconds;		// connected time per cycle
+		unsigned int	burstMS;			// between change bursts
+		unsigned int	burstSize;			// targets changed per burst
+		unsigned int	targetsPerType;
+		unsigned int	warmupCycles;		// before the baseline sample
+		double			maxRssGrowthMB;
+		double			maxHeapGrowthMB;
+		int				maxThreadGrowth;
+		int				maxFdGrowth;
+	};
+
+	struct sSample
+	{
+		sSample();
+		qint64	rssBytes;		// -1 where unavailable
+		qint64	heapBytes;
+		qint64	heapBlocks;
+		int		threads;
+		int		fds;			// handles on Windows
+	};
+
+	static int Run(const sSettings &settings);
+	static void GetSample(sSample &sample);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
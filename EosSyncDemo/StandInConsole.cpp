@@ -0,0 +1,374 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "StandInConsole.h"
+#include "EosSyncLib.h"
+#include "OscPacket.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define STAND_IN_CONSOLE_VERSION	"3.1.0"
+
+////////////////////////////////////////////////////////////////////////////////
+
+StandInConsole::sSettings::sSettings()
+	: targetsPerType(200)
+	, patchParts(1)
+	, cueLists(0)
+	, propertiesPerTarget(0)
+	, burstMS(0)
+	, burstSize(8)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+StandInConsole::StandInConsole(const sSettings &settings)
+	: m_Settings(settings)
+	, m_Port(0)
+	, m_Run(true)
+	, m_Version(1)
+	, m_NextChange(0)
+	, m_RequestedChanges(0)
+	, m_Connections(0)
+	, m_PacketsSent(0)
+{
+	m_Settings.patchParts = qMax(1u, m_Settings.patchParts);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+StandInConsole::~StandInConsole()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool StandInConsole::Listen(unsigned short &port)
+{
+	m_StartMutex.lock();
+	start();
+	m_StartWait.wait(&m_StartMutex);
+	port = m_Port;
+	m_StartMutex.unlock();
+	return (port != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StandInConsole::Stop()
+{
+	m_Run = false;
+	wait();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StandInConsole::RequestChanges(unsigned int count)
+{
+	m_ChangeMutex.lock();
+	m_RequestedChanges += count;
+	m_ChangeMutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int StandInConsole::GetCount(const std::string &typeName) const
+{
+	if(typeName == "cuelist")
+		return m_Settings.cueLists;
+	if(typeName == "cue")
+		return ((m_Settings.cueLists==0) ? 0 : m_Settings.targetsPerType);
+	if(typeName == "patch")
+		return (m_Settings.targetsPerType * m_Settings.patchParts);
+	return m_Settings.targetsPerType;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QString StandInConsole::GetListPath(const std::string &typeName, unsigned int listId) const
+{
+	// cues are addressed by cue list, /eos/.../cue/<list>/...
+	QString path( QString::fromStdString(typeName) );
+	if(typeName == "cue")
+		path.append( QString("/%1").arg(listId) );
+	return path;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StandInConsole::Reply(const std::string &str, QByteArray &out)
+{
+	OSCPacketWriter *packet = OSCPacketWriter::CreatePacketWriterForString( str.c_str() );
+	if( packet )
+	{
+		size_t size = 0;
+		char *data = packet->Create(size);
+		if( data )
+		{
+			OscPacket::AppendFrame(data, static_cast<int>(size), out);
+			m_PacketsSent++;
+			delete[] data;
+		}
+		delete packet;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StandInConsole::ReplyTarget(const std::string &typeName, unsigned int listId, unsigned int index, QByteArray &out)
+{
+	unsigned int count = GetCount(typeName);
+	if(index >= count)
+		return;
+	if(typeName=="cue" && (listId==0 || listId>m_Settings.cueLists))
+		return;
+
+	// patch lists every part of a channel, everything else is part 0
+	unsigned int number = (index + 1);
+	int part = 0;
+	if(typeName == "patch")
+	{
+		number = ((index / m_Settings.patchParts) + 1);
+		part = static_cast<int>((index % m_Settings.patchParts) + 1);
+	}
+
+	VERSIONS::const_iterator i = m_Labels.find(number);
+	unsigned int labelVersion = ((i==m_Labels.end()) ? 0 : i->second);
+	QString path( GetListPath(typeName,listId) );
+	QString reply( QString("/eos/out/get/%1/%2/%3/list/%4/%5=%6,%1 %2 v%7")
+		.arg(path)
+		.arg(number)
+		.arg(part)
+		.arg(index)
+		.arg(count)
+		.arg(QString("stand-in-%1-%2-%3").arg(path).arg(number).arg(part))
+		.arg(labelVersion) );
+	for(unsigned int i=0; i<m_Settings.propertiesPerTarget; i++)
+		reply.append( QString(",property %1").arg(i+1) );
+	Reply(reply.toStdString(), out);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StandInConsole::OnCommand(const QByteArray &packet, QByteArray &out)
+{
+	const char *address = 0;
+	int addressLen = 0;
+	if( !OscPacket::GetAddress(packet.constData(),packet.size(),address,addressLen) )
+		return;
+
+	std::string path(address, static_cast<size_t>(addressLen));
+	if(path == "/eos/ping")
+	{
+		// echoed back as sent, the way round trip probes are matched
+		std::string args;
+		if(OscPacket::GetArgsText(packet.constData(),packet.size(),args) && !args.empty())
+			Reply("/eos/out/ping=" + args, out);
+		else
+			Reply("/eos/out/ping", out);
+		return;
+	}
+
+	// /eos/get/version, /eos/get/<type>/count, /eos/get/<type>/index/<i>, /eos/get/<type>/<number>
+	static const std::string getPrefix("/eos/get/");
+	if(path.compare(0,getPrefix.size(),getPrefix) != 0)
+		return;
+
+	QStringList parts( QString::fromStdString(path.substr(getPrefix.size())).split('/', QString::SkipEmptyParts) );
+	if( parts.isEmpty() )
+		return;
+
+	std::string typeName( parts[0].toStdString() );
+	if(parts.size()==1 && typeName=="version")
+	{
+		Reply("/eos/out/get/version=" STAND_IN_CONSOLE_VERSION, out);
+		return;
+	}
+
+	// cue requests name their cue list next
+	unsigned int listId = 0;
+	if(typeName == "cue")
+	{
+		if(parts.size() < 2)
+			return;
+		listId = parts[1].toUInt();
+		parts.removeAt(1);
+	}
+
+	if(parts.size()==2 && parts[1]=="count")
+	{
+		bool listExists = (typeName!="cue" || (listId!=0 && listId<=m_Settings.cueLists));
+		unsigned int count = (listExists ? GetCount(typeName) : 0);
+		Reply(QString("/eos/out/get/%1/count=%2").arg(GetListPath(typeName,listId)).arg(count).toStdString(), out);
+	}
+	else if(parts.size()==3 && parts[1]=="index")
+		ReplyTarget(typeName, listId, parts[2].toUInt(), out);
+	else if(parts.size() >= 2)
+	{
+		unsigned int number = parts[1].toUInt();
+		if(number != 0)
+		{
+			unsigned int numParts = ((typeName=="patch") ? m_Settings.patchParts : 1);
+			for(unsigned int i=0; i<numParts; i++)
+				ReplyTarget(typeName, listId, (number-1)*numParts + i, out);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StandInConsole::ChangeBurst(unsigned int count, QByteArray &out)
+{
+	if(m_Settings.targetsPerType==0 || count==0)
+		return;
+
+	// relabel the next few targets of every served type, then say so
+	count = qMin(count, m_Settings.targetsPerType);
+	QString numbers;
+	for(unsigned int i=0; i<count; i++)
+	{
+		unsigned int number = ((m_NextChange++ % m_Settings.targetsPerType) + 1);
+		m_Labels[number]++;
+		if( !numbers.isEmpty() )
+			numbers.append(',');
+		numbers.append( QString::number(number) );
+	}
+
+	m_Version++;
+	for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+	{
+		std::string typeName( EosTarget::GetNameForTargetType(static_cast<EosTarget::EnumEosTargetType>(i)) );
+		if(GetCount(typeName)==0 || typeName=="cuelist")
+			continue;
+
+		// every cue list has the same cue numbers
+		unsigned int firstList = ((typeName=="cue") ? 1 : 0);
+		unsigned int lastList = ((typeName=="cue") ? m_Settings.cueLists : 0);
+		for(unsigned int listId=firstList; listId<=lastList; listId++)
+			Reply(QString("/eos/out/notify/%1/list/0/1=%2,%3").arg(GetListPath(typeName,listId)).arg(m_Version).arg(numbers).toStdString(), out);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StandInConsole::run()
+{
+	QTcpServer server;
+	bool ok = server.listen(QHostAddress::LocalHost, 0);
+
+	m_StartMutex.lock();
+	m_Port = (ok ? server.serverPort() : 0);
+	m_StartWait.wakeAll();
+	m_StartMutex.unlock();
+
+	if( !ok )
+		return;
+
+	CONNECTIONS connections;
+	QByteArray packet;
+	QByteArray out;
+	QElapsedTimer burstTimer;
+	while( m_Run )
+	{
+		for(CONNECTIONS::iterator i=connections.begin(); i!=connections.end(); )
+		{
+			if((*i)->tcp->state() != QAbstractSocket::ConnectedState)
+			{
+				delete (*i)->tcp;
+				delete *i;
+				i = connections.erase(i);
+			}
+			else
+				i++;
+		}
+
+		if( server.waitForNewConnection(connections.empty() ? 1 : 0) )
+		{
+			while( server.hasPendingConnections() )
+			{
+				sConnection *connection = new sConnection;
+				connection->tcp = server.nextPendingConnection();
+				connections.push_back(connection);
+				m_Connections++;
+			}
+			burstTimer.start();
+		}
+
+		if( connections.empty() )
+			continue;
+
+		// each connection gets its own replies
+		bool idle = true;
+		for(CONNECTIONS::const_iterator i=connections.begin(); i!=connections.end(); i++)
+		{
+			sConnection *connection = *i;
+			if( !connection->tcp->waitForReadyRead(0) )
+				continue;
+
+			idle = false;
+			out.clear();
+			QByteArray data( connection->tcp->readAll() );
+			connection->stream.Append(data.constData(), data.size());
+			while( connection->stream.Next(packet) )
+				OnCommand(packet, out);
+			if( !out.isEmpty() )
+			{
+				connection->tcp->write(out);
+				connection->tcp->flush();
+			}
+		}
+
+		// change notifications go to everyone
+		out.clear();
+		unsigned int changes = 0;
+		if(m_Settings.burstMS!=0 && burstTimer.hasExpired(m_Settings.burstMS))
+		{
+			changes = m_Settings.burstSize;
+			burstTimer.start();
+		}
+		m_ChangeMutex.lock();
+		changes += m_RequestedChanges;
+		m_RequestedChanges = 0;
+		m_ChangeMutex.unlock();
+		ChangeBurst(changes, out);
+
+		if( !out.isEmpty() )
+		{
+			for(CONNECTIONS::const_iterator i=connections.begin(); i!=connections.end(); i++)
+			{
+				(*i)->tcp->write(out);
+				(*i)->tcp->flush();
+			}
+		}
+		else if( idle )
+			msleep(1);
+	}
+
+	for(CONNECTIONS::const_iterator i=connections.begin(); i!=connections.end(); i++)
+	{
+		delete (*i)->tcp;
+		delete *i;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,112 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef STAND_IN_CONSOLE_H
+#define STAND_IN_CONSOLE_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#ifndef OSC_PACKET_H
+#include "OscPacket.h"
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Loopback console for the headless tools, with just enough of the show
+// data protocol to keep EosSyncLib busy: version, per type counts, targets
+// by index or number, ping echo, and list notifications for the targets a
+// change burst relabels. Every type is served from one synthetic list of
+// the same numbers, patch with several parts per channel, except cues,
+// which have a set number of cue lists of that many cues each (none by
+// default). Every target can carry extra properties past its label.
+// Any number of connections, over TCP with OSC 1.0 framing; each gets the
+// replies to its own requests, and change notifications go to all.
+class StandInConsole
+	: public QThread
+{
+public:
+	struct sSettings
+	{
+		sSettings();
+		unsigned int	targetsPerType;
+		unsigned int	patchParts;		// per channel
+		unsigned int	cueLists;		// each with targetsPerType cues
+		unsigned int	propertiesPerTarget;	// past the label
+		unsigned int	burstMS;		// between automatic change bursts, 0 for none
+		unsigned int	burstSize;		// targets relabeled per automatic burst
+	};
+
+	StandInConsole(const sSettings &settings);
+	virtual ~StandInConsole();
+
+	virtual bool Listen(unsigned short &port);
+	virtual void Stop();
+
+	// any thread; relabels count targets of every type at the next chance
+	virtual void RequestChanges(unsigned int count);
+
+	// any thread
+	virtual unsigned int GetConnections() const {return m_Connections;}
+	virtual unsigned int GetPacketsSent() const {return m_PacketsSent;}
+
+protected:
+	typedef std::map<unsigned int,unsigned int> VERSIONS;	// target number to label version
+
+	struct sConnection
+	{
+		QTcpSocket			*tcp;
+		OscPacket::Stream	stream;
+	};
+
+	typedef std::vector<sConnection*> CONNECTIONS;
+
+	sSettings				m_Settings;
+	unsigned short			m_Port;
+	volatile bool			m_Run;
+	QMutex					m_StartMutex;
+	QWaitCondition			m_StartWait;
+	VERSIONS				m_Labels;
+	unsigned int			m_Version;
+	unsigned int			m_NextChange;
+	QMutex					m_ChangeMutex;
+	unsigned int			m_RequestedChanges;
+	volatile unsigned int	m_Connections;
+	volatile unsigned int	m_PacketsSent;
+
+	virtual void run();
+	virtual unsigned int GetCount(const std::string &typeName) const;
+	virtual QString GetListPath(const std::string &typeName, unsigned int listId) const;
+	virtual void Reply(const std::string &str, QByteArray &out);
+	virtual void ReplyTarget(const std::string &typeName, unsigned int listId, unsigned int index, QByteArray &out);
+	virtual void OnCommand(const QByteArray &packet, QByteArray &out);
+	virtual void ChangeBurst(unsigned int count, QByteArray &out);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
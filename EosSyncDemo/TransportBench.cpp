@@ -0,0 +1,375 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+#include "TransportBench.h"
+#include "MainWindow.h"
+#include "StandInConsole.h"
+#include "OscPacket.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define NS_PER_MS					Q_INT64_C(1000000)
+#define TRANSPORT_BENCH_PREFIX		"/bench/transport/"
+#define TRANSPORT_BENCH_TARGETS		20		// per type, just enough for a quick initial sync
+#define TRANSPORT_BENCH_SYNC_TIMEOUT_MS	30000
+#define RECEIVE_GRACE_MS			2000	// after the last send, for retransmits under shaping
+#define TRANSPORT_TCP_LINK			0
+#define TRANSPORT_TCP_LIB			1
+#define TRANSPORT_UDP				2
+#define TRANSPORT_COUNT				3
+
+////////////////////////////////////////////////////////////////////////////////
+
+// every thread reads the one clock, so arrival minus send time is meaningful
+static QElapsedTimer sBenchClock;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool ReadCommand(const QByteArray &packet, quint32 &seq)
+{
+	// /bench/transport/<seq>
+	const char *address = 0;
+	int addressLen = 0;
+	if( !OscPacket::GetAddress(packet.constData(),packet.size(),address,addressLen) )
+		return false;
+
+	static const int prefixLen = (sizeof(TRANSPORT_BENCH_PREFIX) - 1);
+	if(addressLen<=prefixLen || strncmp(address,TRANSPORT_BENCH_PREFIX,prefixLen)!=0)
+		return false;
+
+	bool ok = false;
+	seq = QByteArray(address+prefixLen, addressLen-prefixLen).toUInt(&ok);
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool OnArrival(const QByteArray &packet, std::vector<qint64> &arrivals)
+{
+	qint64 ns = sBenchClock.nsecsElapsed();
+	quint32 seq = 0;
+	if( !ReadCommand(packet,seq) )
+		return false;
+
+	if(seq<arrivals.size() && arrivals[seq]<0)
+		arrivals[seq] = ns;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the stand-in console, noting when each bench command arrives over TCP
+class TransportBenchConsole
+	: public StandInConsole
+{
+public:
+	TransportBenchConsole(const sSettings &settings, unsigned int count)
+		: StandInConsole(settings)
+		, m_Arrivals(count, -1)
+	{
+	}
+
+	virtual ~TransportBenchConsole()
+	{
+		Stop();
+	}
+
+	// after Stop()
+	virtual const std::vector<qint64>& GetArrivals() const {return m_Arrivals;}
+
+protected:
+	std::vector<qint64>	m_Arrivals;
+
+	virtual void OnCommand(const QByteArray &packet, QByteArray &out)
+	{
+		if( !OnArrival(packet,m_Arrivals) )
+			StandInConsole::OnCommand(packet, out);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// stands in for the console's OSC UDP receive port
+class TransportBenchReceiver
+	: public QThread
+{
+public:
+	TransportBenchReceiver(unsigned int count)
+		: m_Port(0)
+		, m_Run(true)
+		, m_Arrivals(count, -1)
+	{
+	}
+
+	virtual ~TransportBenchReceiver()
+	{
+		Stop();
+	}
+
+	virtual bool Listen(unsigned short &port)
+	{
+		m_StartMutex.lock();
+		start();
+		m_StartWait.wait(&m_StartMutex);
+		port = m_Port;
+		m_StartMutex.unlock();
+		return (port != 0);
+	}
+
+	virtual void Stop()
+	{
+		m_Run = false;
+		wait();
+	}
+
+	// after Stop()
+	virtual const std::vector<qint64>& GetArrivals() const {return m_Arrivals;}
+
+protected:
+	unsigned short		m_Port;
+	volatile bool		m_Run;
+	QMutex				m_StartMutex;
+	QWaitCondition		m_StartWait;
+	std::vector<qint64>	m_Arrivals;
+
+	virtual void run()
+	{
+		QUdpSocket udp;
+		bool ok = udp.bind(QHostAddress::LocalHost, 0);
+
+		m_StartMutex.lock();
+		m_Port = (ok ? udp.localPort() : 0);
+		m_StartWait.wakeAll();
+		m_StartMutex.unlock();
+
+		if( !ok )
+			return;
+
+		QByteArray datagram;
+		while( m_Run )
+		{
+			if( !udp.waitForReadyRead(1) )
+				continue;
+
+			while( udp.hasPendingDatagrams() )
+			{
+				datagram.resize( static_cast<int>(udp.pendingDatagramSize()) );
+				if(udp.readDatagram(datagram.data(),datagram.size()) > 0)
+					OnArrival(datagram, m_Arrivals);
+			}
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void DrainLog(EosSyncLibThread &syncThread)
+{
+	EosLog::LOG_Q logQ;
+	syncThread.GetLogQueue().Pop(logQ, LogQueue::DEFAULT_CAPACITY);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool IsSynced(EosSyncLibThread &syncThread, bool &connected)
+{
+	EosSyncLib *eosSyncLib = syncThread.LockEosSyncLib();
+	connected = eosSyncLib->IsConnected();
+	bool synced = (connected && eosSyncLib->GetData().GetStatus().GetValue()==EosSyncStatus::SYNC_STATUS_COMPLETE);
+	eosSyncLib->ClearDirty();
+	syncThread.UnlockEosSyncLib();
+	return synced;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool RunTransport(const TransportBench::sSettings &settings, unsigned short consolePort, unsigned short udpPort, bool onLink, std::vector<qint64> &sendNS, bool &syncing)
+{
+	// udpPort 0 leaves commands on TCP, as with UdpCommandPort unset, and
+	// onLink picks the console link or EosSyncLib's connection for them
+	EosSyncLibThread syncThread;
+	syncThread.SetUdpTarget("127.0.0.1", udpPort);
+	syncThread.SetCommandsOnLink(onLink);
+	syncThread.Start("127.0.0.1", consolePort);
+
+	// sends start once EosSyncLib has connected, while its initial sync runs,
+	// or after the sync when it isn't what is being measured
+	QElapsedTimer timer;
+	timer.start();
+	bool ready = false;
+	while(!ready && syncThread.isRunning() && !timer.hasExpired(TRANSPORT_BENCH_SYNC_TIMEOUT_MS))
+	{
+		bool connected = false;
+		bool synced = IsSynced(syncThread, connected);
+		ready = ((settings.syncTargetsPerType==0) ? synced : connected);
+		if(onLink && udpPort==0 && !syncThread.IsConsoleLinkConnected())
+			ready = false;
+
+		DrainLog(syncThread);
+		if( !ready )
+			QThread::msleep(10);
+	}
+
+	if( !ready )
+	{
+		syncThread.Stop();
+		return false;
+	}
+
+	// each send time is taken as SendOscString() is called, so it includes
+	// the queue, the sync thread's wakeup and whichever socket is used
+	sendNS.assign(settings.count, -1);
+	qint64 startNS = sBenchClock.nsecsElapsed();
+	for(unsigned int i=0; i<settings.count; i++)
+	{
+		qint64 dueNS = (startNS + i*settings.intervalMS*NS_PER_MS);
+		for(;;)
+		{
+			qint64 remainingNS = (dueNS - sBenchClock.nsecsElapsed());
+			if(remainingNS <= 0)
+				break;
+			if(remainingNS > NS_PER_MS)
+				QThread::msleep(1);
+			else
+				QThread::yieldCurrentThread();
+		}
+
+		sendNS[i] = sBenchClock.nsecsElapsed();
+		syncThread.SendOscString( QString(TRANSPORT_BENCH_PREFIX "%1").arg(i).toStdString() );
+
+		if((i % 64) == 0)
+			DrainLog(syncThread);
+	}
+
+	bool connected = false;
+	syncing = !IsSynced(syncThread, connected);
+
+	QElapsedTimer grace;
+	grace.start();
+	while( !grace.hasExpired(RECEIVE_GRACE_MS) )
+	{
+		DrainLog(syncThread);
+		QThread::msleep(10);
+	}
+
+	syncThread.Stop();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void PrintLatency(const char *name, const std::vector<qint64> &sendNS, const std::vector<qint64> &arrivals)
+{
+	std::vector<qint64> latency;
+	for(size_t i=0; i<arrivals.size() && i<sendNS.size(); i++)
+	{
+		if(arrivals[i]>=0 && sendNS[i]>=0)
+			latency.push_back(arrivals[i] - sendNS[i]);
+	}
+
+	if( latency.empty() )
+	{
+		printf("  %s: nothing delivered\n", name);
+		return;
+	}
+
+	std::sort(latency.begin(), latency.end());
+	printf("  %s: %u/%u delivered, latency p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+		name,
+		static_cast<unsigned int>(latency.size()),
+		static_cast<unsigned int>(arrivals.size()),
+		latency[latency.size()/2] / 1000000.0,
+		latency[((latency.size()-1)*99)/100] / 1000000.0,
+		latency.back() / 1000000.0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TransportBench::sSettings::sSettings()
+	: count(2000)
+	, intervalMS(5)
+	, syncTargetsPerType(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int TransportBench::Run(const sSettings &settings)
+{
+	sBenchClock.start();
+
+	StandInConsole::sSettings consoleSettings;
+	consoleSettings.targetsPerType = ((settings.syncTargetsPerType==0) ? TRANSPORT_BENCH_TARGETS : settings.syncTargetsPerType);
+
+	if(settings.syncTargetsPerType == 0)
+	{
+		printf("Sending %u commands every %u ms with SendOscString() to a loopback stand-in console after its initial sync; loopback is lossless unless shaped\n",
+			settings.count, settings.intervalMS);
+	}
+	else
+	{
+		printf("Sending %u commands every %u ms with SendOscString() to a loopback stand-in console during its initial sync of %u targets per type; loopback is lossless unless shaped\n",
+			settings.count, settings.intervalMS, settings.syncTargetsPerType);
+	}
+	fflush(stdout);
+
+	// a fresh stand-in console for each, so one run's sync and arrivals
+	// don't carry over into the next
+	static const char *names[TRANSPORT_COUNT] = {"TCP, console link", "TCP, EosSyncLib", "UDP"};
+	int result = 0;
+	for(int i=0; i<TRANSPORT_COUNT; i++)
+	{
+		TransportBenchConsole console(consoleSettings, settings.count);
+		unsigned short consolePort = 0;
+		TransportBenchReceiver receiver(settings.count);
+		unsigned short udpPort = 0;
+		if(!console.Listen(consolePort) || !receiver.Listen(udpPort))
+		{
+			printf("stand-in console unable to listen on loopback\n");
+			return 1;
+		}
+
+		std::vector<qint64> sendNS;
+		bool syncing = false;
+		if( !RunTransport(settings,consolePort,(i==TRANSPORT_UDP) ? udpPort : 0,(i!=TRANSPORT_TCP_LIB),sendNS,syncing) )
+		{
+			printf("  %s: %s, the stand-in console may not match this EosSyncLib\n",
+				names[i],
+				(settings.syncTargetsPerType==0) ? "initial sync did not complete" : "did not connect");
+			result = 1;
+			continue;
+		}
+
+		console.Stop();
+		receiver.Stop();
+
+		PrintLatency(names[i], sendNS, (i==TRANSPORT_UDP) ? receiver.GetArrivals() : console.GetArrivals());
+		if(settings.syncTargetsPerType!=0 && !syncing)
+			printf("    the initial sync finished before the last command, raise the target count to cover every send\n");
+		fflush(stdout);
+	}
+
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
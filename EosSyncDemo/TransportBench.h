@@ -0,0 +1,69 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef TRANSPORT_BENCH_H
+#define TRANSPORT_BENCH_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Headless comparison of command latency over each of the app's send
+// paths.
+//
+// The same schedule of small OSC commands is sent three times with
+// EosSyncLibThread::SendOscString() at user priority: over TCP on the
+// console link, over TCP on EosSyncLib's connection, where they wait for
+// the EosSyncLib lock, and with a UDP target, as datagrams. A stand-in
+// console serves both TCP connections and a loopback receiver takes the
+// datagrams, and the report is how late each path delivered its commands.
+//
+// By default the commands go after a quick initial sync. With a sync
+// target count they start as soon as EosSyncLib connects, while a stand-in
+// show of that size is synced, which is when EosSyncLib::Tick() holds the
+// lock longest; the count should be large enough that the sync outlasts
+// the sends, and the report says when it didn't.
+//
+// Nothing is dropped or delayed in process. Loopback is lossless, so on
+// its own this measures only the queueing and wakeup cost of each path;
+// to compare them under loss, shape the loopback interface while it runs
+// (netem on Linux, dummynet on macOS, clumsy on Windows), which gives real
+// TCP retransmits and real UDP drops.
+class TransportBench
+{
+public:
+	struct sSettings
+	{
+		sSettings();
+		unsigned int	count;
+		unsigned int	intervalMS;		// between commands
+		unsigned int	syncTargetsPerType;	// 0 to send after a quick initial sync
+	};
+
+	static int Run(const sSettings &settings);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,379 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "UiBench.h"
+#include "BenchAlloc.h"
+#include "MainWindow.h"
+#include "ShowDataGrid.h"
+#include "StandInConsole.h"
+#include "SoakTest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef Q_WS_X11
+#include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_TICK_MS		20
+#define BENCH_QUIET_MS		300		// no console traffic for this long and the refreshes are in
+#define BENCH_XVFB_ENV		"EOS_SYNC_DEMO_BENCH_XVFB"	// set once restarted under xvfb-run
+#define BENCH_SETTING_LOG_FILE	"LogFile"		// MainWindow's SETTING_LOG_FILE
+
+////////////////////////////////////////////////////////////////////////////////
+
+class UiBenchTimer
+{
+public:
+	UiBenchTimer(const char *name, unsigned int iterations)
+		: m_Name(name)
+		, m_AllocStart(0)
+		, m_Allocs(0)
+	{
+		m_CallNS.reserve(iterations);
+		SoakTest::sSample sample;
+		SoakTest::GetSample(sample);
+		m_HeapBytes = sample.heapBytes;
+	}
+
+	void Begin()
+	{
+		m_AllocStart = BenchAlloc::GetCount();
+		m_Timer.start();
+	}
+
+	void End()
+	{
+		qint64 ns = m_Timer.nsecsElapsed();
+		m_Allocs += (BenchAlloc::GetCount() - m_AllocStart);
+		m_CallNS.push_back(ns);
+	}
+
+	void Print()
+	{
+		if( m_CallNS.empty() )
+			return;
+
+		SoakTest::sSample sample;
+		SoakTest::GetSample(sample);
+		qint64 kept = ((m_HeapBytes>=0 && sample.heapBytes>=0) ? (sample.heapBytes - m_HeapBytes) : -1);
+
+		std::sort(m_CallNS.begin(), m_CallNS.end());
+		qint64 total = 0;
+		for(size_t i=0; i<m_CallNS.size(); i++)
+			total += m_CallNS[i];
+
+		printf("  %-24s %5u calls, mean %9.1f us, p50 %9.1f us, max %9.1f us, %9.1f allocs/call, heap kept %s\n",
+			m_Name,
+			static_cast<unsigned int>(m_CallNS.size()),
+			(total / static_cast<double>(m_CallNS.size())) / 1000.0,
+			m_CallNS[m_CallNS.size()/2] / 1000.0,
+			m_CallNS.back() / 1000.0,
+			m_Allocs / static_cast<double>(m_CallNS.size()),
+			(kept < 0) ? "n/a" : QString("%1 KB").arg(kept/1024.0, 0, 'f', 1).toUtf8().constData());
+		fflush(stdout);
+	}
+
+private:
+	const char				*m_Name;
+	QElapsedTimer			m_Timer;
+	std::vector<qint64>		m_CallNS;
+	qint64					m_HeapBytes;
+	unsigned int			m_AllocStart;
+	quint64					m_Allocs;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool WaitForQuiet(EosSyncLibThread &syncThread, const StandInConsole &console, bool needComplete, unsigned int timeoutSeconds)
+{
+	QElapsedTimer timer;
+	timer.start();
+	QElapsedTimer quiet;
+	quiet.start();
+	unsigned int packets = console.GetPacketsSent();
+	while( !timer.hasExpired(static_cast<qint64>(timeoutSeconds)*1000) )
+	{
+		QThread::msleep(BENCH_TICK_MS);
+
+		// the log isn't what's timed here, just keep it from filling
+		EosLog::LOG_Q logQ;
+		syncThread.GetLogQueue().Pop(logQ, LogQueue::DEFAULT_CAPACITY);
+
+		unsigned int sent = console.GetPacketsSent();
+		if(sent != packets)
+		{
+			packets = sent;
+			quiet.start();
+			continue;
+		}
+
+		if( !quiet.hasExpired(BENCH_QUIET_MS) )
+			continue;
+
+		if( !needComplete )
+			return true;
+
+		EosSyncLib *eosSyncLib = syncThread.LockEosSyncLib();
+		bool complete = (eosSyncLib && eosSyncLib->IsConnected() && eosSyncLib->GetData().GetStatus().GetValue()==EosSyncStatus::SYNC_STATUS_COMPLETE);
+		syncThread.UnlockEosSyncLib();
+		if( complete )
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+UiBench::sSettings::sSettings()
+	: targetsPerType(2000)
+	, cueLists(4)
+	, patchParts(2)
+	, propertiesPerTarget(8)
+	, dirtyPercent(10)
+	, iterations(50)
+	, logMessages(200)
+	, syncTimeoutSeconds(120)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int UiBench::Main(int argc, char *argv[], const sSettings &settings)
+{
+	std::vector<char*> args(argv, argv+argc);
+
+#if defined(Q_WS_QPA)
+	// nothing is shown, so the minimal platform plugin will do
+	static char platformArg[] = "-platform";
+	static char platformName[] = "minimal";
+	if( qgetenv("QT_QPA_PLATFORM").isEmpty() )
+	{
+		args.push_back(platformArg);
+		args.push_back(platformName);
+	}
+#elif defined(Q_WS_X11)
+	if(qgetenv("DISPLAY").isEmpty() && qgetenv(BENCH_XVFB_ENV).isEmpty())
+	{
+		static char xvfbRun[] = "xvfb-run";
+		static char xvfbAuto[] = "-a";
+		std::vector<char*> xvfbArgs;
+		xvfbArgs.push_back(xvfbRun);
+		xvfbArgs.push_back(xvfbAuto);
+		xvfbArgs.insert(xvfbArgs.end(), argv, argv+argc);
+		xvfbArgs.push_back(0);
+		setenv(BENCH_XVFB_ENV, "1", 1);
+		execvp(xvfbRun, &xvfbArgs[0]);
+		printf("no display, and unable to start xvfb-run; install Xvfb or use a QPA build of Qt\n");
+		return 1;
+	}
+#endif
+
+	int appArgc = static_cast<int>( args.size() );
+	args.push_back(0);
+	QApplication app(appArgc, &args[0]);
+	return Run(settings);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int UiBench::Run(const sSettings &settings)
+{
+	unsigned int iterations = qMax(1u, settings.iterations);
+
+	if( !BenchAlloc::Install() )
+		printf("allocations not counted on this platform\n");
+
+	// AddLogQ() needs no show data
+	printf("UI update timings, %u calls each, allocations counted by %s\n", iterations, BenchAlloc::GetScope());
+
+	// a private settings file, so the operator's are neither read nor
+	// changed and nothing optional starts; no log file either, so AddLogQ()
+	// is timed on the list alone and the real log isn't truncated
+	QString settingsName( QString("EosSyncDemo.uibench.%1").arg(QCoreApplication::applicationPid()) );
+	QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, QDir::temp().filePath(settingsName));
+	QString settingsPath;
+	{
+		QSettings benchSettings(QSettings::IniFormat, QSettings::UserScope, "ETC", "EosSyncDemo");
+		benchSettings.setValue(BENCH_SETTING_LOG_FILE, QString());
+		settingsPath = benchSettings.fileName();
+	}
+
+	{
+		MainWindow mainWindow(0, 0, QSettings::IniFormat);
+		EosLog::LOG_Q batch;
+		for(unsigned int i=0; i<settings.logMessages; i++)
+		{
+			EosLog::sLogMsg msg;
+			msg.type = ((i%4 == 0) ? EosLog::LOG_MSG_TYPE_INFO : EosLog::LOG_MSG_TYPE_DEBUG);
+			msg.timestamp = time(0);
+			msg.text = QString("OSC Packet IN TCP 10.101.1.101:3032 /eos/out/get/chan/%1/0/list/%2/%3").arg(i+1).arg(i).arg(settings.logMessages).toUtf8().constData();
+			batch.push_back(msg);
+		}
+
+		UiBenchTimer timer("AddLogQ", iterations);
+		for(unsigned int i=0; i<iterations; i++)
+		{
+			EosLog::LOG_Q logQ(batch);
+			timer.Begin();
+			mainWindow.AddLogQ(logQ);
+			timer.End();
+		}
+		printf("  (%u messages per call)\n", settings.logMessages);
+		timer.Print();
+	}
+
+	QFile::remove(settingsPath);
+	QDir(QDir::temp().filePath(settingsName)).rmdir("ETC");
+	QDir::temp().rmdir(settingsName);
+
+	StandInConsole::sSettings consoleSettings;
+	consoleSettings.targetsPerType = settings.targetsPerType;
+	consoleSettings.cueLists = settings.cueLists;
+	consoleSettings.patchParts = settings.patchParts;
+	consoleSettings.propertiesPerTarget = settings.propertiesPerTarget;
+	StandInConsole console(consoleSettings);
+	unsigned short port = 0;
+	if( !console.Listen(port) )
+	{
+		printf("stand-in console unable to listen on loopback\n");
+		return 1;
+	}
+
+	EosSyncLibThread syncThread;
+	syncThread.Start("127.0.0.1", port);
+
+	printf("Syncing %u targets per type, %u cue lists, %u parts per channel, %u properties per target\n", settings.targetsPerType, settings.cueLists, qMax(1u,settings.patchParts), settings.propertiesPerTarget);
+	fflush(stdout);
+	if( !WaitForQuiet(syncThread,console,/*needComplete*/true,settings.syncTimeoutSeconds) )
+	{
+		printf("initial sync from the stand-in console not complete after %u s\n", settings.syncTimeoutSeconds);
+		syncThread.Stop();
+		return 1;
+	}
+
+	// start clean, then leave just the changed lists dirty
+	EosSyncLib *eosSyncLib = syncThread.LockEosSyncLib();
+	eosSyncLib->ClearDirty();
+	syncThread.UnlockEosSyncLib();
+
+	unsigned int changes = static_cast<unsigned int>(settings.targetsPerType * qBound(0.0,settings.dirtyPercent,100.0) / 100.0 + 0.5);
+	if(changes != 0)
+	{
+		console.RequestChanges(changes);
+		WaitForQuiet(syncThread, console, /*needComplete*/false, settings.syncTimeoutSeconds);
+	}
+	printf("%u targets per type changed since the last tick (%.1f%%)\n", changes, settings.dirtyPercent);
+
+	// the sync thread can't touch EosSyncLib from here on, so every call sees the same state
+	eosSyncLib = syncThread.LockEosSyncLib();
+	const EosSyncData::SHOW_DATA &showData = eosSyncLib->GetData().GetShowData();
+
+	ShowDataGrid grid(0);
+	{
+		UiBenchTimer timer("ShowDataGrid::Update", iterations);
+		for(unsigned int i=0; i<iterations; i++)
+		{
+			timer.Begin();
+			grid.Update(*eosSyncLib);
+			timer.End();
+		}
+		timer.Print();
+	}
+
+	// the type with the most targets, patch unless it's empty
+	EosSyncData::SHOW_DATA::const_iterator largest = showData.end();
+	size_t largestCount = 0;
+	for(EosSyncData::SHOW_DATA::const_iterator i=showData.begin(); i!=showData.end(); i++)
+	{
+		size_t count = 0;
+		for(EosSyncData::TARGETLIST_DATA::const_iterator j=i->second.begin(); j!=i->second.end(); j++)
+			count += j->second->GetNumTargets();
+		if(count > largestCount)
+		{
+			largest = i;
+			largestCount = count;
+		}
+	}
+
+	if(largest != showData.end())
+	{
+		printf("ShowDataDetails on %s, %u targets\n", EosTarget::GetNameForTargetType(largest->first), static_cast<unsigned int>(largestCount));
+
+		// the window renders from a snapshot of just its own type
+		ShowSnapshot snapshot;
+		for(int i=0; i<EosTarget::EOS_TARGET_COUNT; i++)
+		{
+			EosTarget::EnumEosTargetType type = static_cast<EosTarget::EnumEosTargetType>(i);
+			snapshot.SetTracked(type, type==largest->first);
+		}
+		snapshot.Update( eosSyncLib->GetData() );
+
+		ShowDataDetails details(0);
+		details.SetTargetType( static_cast<unsigned int>(largest->first) );
+
+		// opening the window or switching type; start to text and table applied, most of it off this thread
+		{
+			UiBenchTimer timer("ShowDataDetails full", iterations);
+			for(unsigned int i=0; i<iterations; i++)
+			{
+				details.SetDirty();
+				timer.Begin();
+				details.Update(snapshot);
+				details.WaitForRender();
+				timer.End();
+			}
+			timer.Print();
+		}
+
+		// a tick with the window open; the lists are still dirty, so every
+		// snapshot update is a new generation of just those lists
+		{
+			UiBenchTimer snapshotTimer("ShowSnapshot::Update", iterations);
+			UiBenchTimer timer("ShowDataDetails dirty", iterations);
+			for(unsigned int i=0; i<iterations; i++)
+			{
+				snapshotTimer.Begin();
+				snapshot.Update( eosSyncLib->GetData() );
+				snapshotTimer.End();
+
+				timer.Begin();
+				details.Update(snapshot);
+				details.WaitForRender();
+				timer.End();
+			}
+			snapshotTimer.Print();
+			timer.Print();
+		}
+	}
+
+	syncThread.UnlockEosSyncLib();
+	syncThread.Stop();
+	console.Stop();
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
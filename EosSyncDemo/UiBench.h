@@ -0,0 +1,69 @@
+// Copyright (c) 2015 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#ifndef UI_BENCH_H
+#define UI_BENCH_H
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Times the UI's per-tick work in isolation, with no console. Part of the
+// EosSyncDemoBench build only, since it counts allocations through
+// BenchAlloc's process wide allocator hooks.
+//
+// EosSyncLib is synced from a StandInConsole on loopback with a synthetic
+// show (targets per type, cue lists, patch parts and properties per target
+// are all set here), then a set fraction of every type's targets is changed
+// and the refreshes are left dirty. With the sync thread held off by the
+// lock, ShowDataGrid::Update(), ShowSnapshot::Update() for one type, and a
+// ShowDataDetails render from that snapshot through to the text and table
+// being applied are run over and over on that one state, and
+// MainWindow::AddLogQ() on a fixed batch of log messages, with private
+// settings and no log file. Each reports time and allocations per call, and
+// the heap it kept. Allocations are counted on every thread, so the render
+// jobs' are included.
+//
+// The widgets are never shown. Main() runs Qt on the minimal platform where
+// Qt was built for QPA; an X11 build of Qt 4 can't run without a display, so
+// with none set it restarts itself under xvfb-run.
+class UiBench
+{
+public:
+	struct sSettings
+	{
+		sSettings();
+		unsigned int	targetsPerType;
+		unsigned int	cueLists;			// each with targetsPerType cues
+		unsigned int	patchParts;
+		unsigned int	propertiesPerTarget;	// past the label
+		double			dirtyPercent;		// of each type's targets changed before timing
+		unsigned int	iterations;
+		unsigned int	logMessages;		// per AddLogQ() call
+		unsigned int	syncTimeoutSeconds;
+	};
+
+	static int Main(int argc, char *argv[], const sSettings &settings);
+	static int Run(const sSettings &settings);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -20,9 +20,22 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "EosTimer.h"
 #include "QtInclude.h"
 #include "MainWindow.h"
+#include "OscRoutes.h"
+#include "TransportBench.h"
+#include "SoakTest.h"
+#include "ShowExport.h"
+#include "ConsoleDiscovery.h"
+#include "LockBench.h"
+#include "MemoryBench.h"
+#include "SharedSnapshotBench.h"
+
+#ifdef EOS_SYNC_DEMO_BENCH
+#include "UiBench.h"
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -30,6 +43,169 @@ int main(int argc, char* argv[])
 {
 	EosTimer::Init();
 
+	// headless modes
+	for(int i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i],"--bench-routes") == 0)
+		{
+			unsigned long iterations = ((i+1 < argc) ? strtoul(argv[i+1],0,10) : 0);
+			return OscRoutes::Benchmark((iterations==0) ? 100000 : static_cast<unsigned int>(iterations));
+		}
+
+		if(strcmp(argv[i],"--bench-transport") == 0)
+		{
+			// [count] [interval ms] [sync targets per type]
+			TransportBench::sSettings settings;
+			if(i+1 < argc)
+				settings.count = static_cast<unsigned int>( strtoul(argv[i+1],0,10) );
+			if(i+2 < argc)
+				settings.intervalMS = static_cast<unsigned int>( strtoul(argv[i+2],0,10) );
+			if(i+3 < argc)
+				settings.syncTargetsPerType = static_cast<unsigned int>( strtoul(argv[i+3],0,10) );
+			if(settings.count == 0)
+				settings.count = TransportBench::sSettings().count;
+			QCoreApplication app(argc, argv);
+			return TransportBench::Run(settings);
+		}
+
+		if(strcmp(argv[i],"--bench-lock") == 0)
+		{
+			// [seconds per run]
+			LockBench::sSettings settings;
+			if(i+1 < argc)
+				settings.seconds = static_cast<unsigned int>( strtoul(argv[i+1],0,10) );
+			if(settings.seconds == 0)
+				settings.seconds = LockBench::sSettings().seconds;
+			OscRoutes::Get();
+			QCoreApplication app(argc, argv);
+			return LockBench::Run(settings);
+		}
+
+		if(strcmp(argv[i],"--bench-memory") == 0)
+		{
+			// [targets per type] [budget MB]
+			MemoryBench::sSettings settings;
+			if(i+1 < argc)
+				settings.targetsPerType = static_cast<unsigned int>( strtoul(argv[i+1],0,10) );
+			if(i+2 < argc)
+				settings.budgetMB = static_cast<unsigned int>( strtoul(argv[i+2],0,10) );
+			if(settings.targetsPerType == 0)
+				settings.targetsPerType = MemoryBench::sSettings().targetsPerType;
+			QCoreApplication app(argc, argv);
+			return MemoryBench::Run(settings, QCoreApplication::applicationFilePath());
+		}
+
+		if(strcmp(argv[i],"--bench-memory-mode") == 0)
+		{
+			// <mode> <targets per type> <patch parts> <budget MB>, one child of --bench-memory
+			MemoryBench::EnumMode mode = MemoryBench::MODE_COUNT;
+			if(i+4>=argc || !MemoryBench::GetModeForName(argv[i+1],mode))
+			{
+				printf("usage: --bench-memory-mode <library|viewed|whole|budget> <targets per type> <patch parts> <budget MB>\n");
+				return 1;
+			}
+			MemoryBench::sSettings settings;
+			settings.targetsPerType = static_cast<unsigned int>( strtoul(argv[i+2],0,10) );
+			settings.patchParts = static_cast<unsigned int>( strtoul(argv[i+3],0,10) );
+			settings.budgetMB = static_cast<unsigned int>( strtoul(argv[i+4],0,10) );
+			OscRoutes::Get();
+			QCoreApplication app(argc, argv);
+			return MemoryBench::RunMode(settings, mode);
+		}
+
+		if(strcmp(argv[i],"--bench-shared-snapshot") == 0)
+		{
+			// [targets per type] [seconds] [size MB]
+			SharedSnapshotBench::sSettings settings;
+			if(i+1 < argc)
+				settings.targetsPerType = static_cast<unsigned int>( strtoul(argv[i+1],0,10) );
+			if(i+2 < argc)
+				settings.seconds = static_cast<unsigned int>( strtoul(argv[i+2],0,10) );
+			if(i+3 < argc)
+				settings.sizeMB = static_cast<unsigned int>( strtoul(argv[i+3],0,10) );
+			if(settings.targetsPerType == 0)
+				settings.targetsPerType = SharedSnapshotBench::sSettings().targetsPerType;
+			if(settings.seconds == 0)
+				settings.seconds = SharedSnapshotBench::sSettings().seconds;
+			if(settings.sizeMB == 0)
+				settings.sizeMB = SharedSnapshotBench::sSettings().sizeMB;
+			QCoreApplication app(argc, argv);
+			return SharedSnapshotBench::Run(settings);
+		}
+
+		if(strcmp(argv[i],"--soak") == 0)
+		{
+			// [minutes] [cycle seconds]
+			SoakTest::sSettings settings;
+			if(i+1 < argc)
+				settings.minutes = static_cast<unsigned int>( strtoul(argv[i+1],0,10) );
+			if(i+2 < argc)
+				settings.cycleSeconds = static_cast<unsigned int>( strtoul(argv[i+2],0,10) );
+			if(settings.minutes == 0)
+				settings.minutes = SoakTest::sSettings().minutes;
+			if(settings.cycleSeconds == 0)
+				settings.cycleSeconds = SoakTest::sSettings().cycleSeconds;
+			OscRoutes::Get();
+
+			// drives a real MainWindow, never shown, so Qt 4 needs a display; use Xvfb on a build box
+			QApplication app(argc, argv);
+			return SoakTest::Run(settings);
+		}
+
+		if(strcmp(argv[i],"--bench-discovery") == 0)
+		{
+			// [stand-in listeners]
+			unsigned long listeners = ((i+1 < argc) ? strtoul(argv[i+1],0,10) : 0);
+			QCoreApplication app(argc, argv);
+			return ConsoleDiscovery::Benchmark((listeners==0) ? 4 : static_cast<unsigned int>(listeners));
+		}
+
+#ifdef EOS_SYNC_DEMO_BENCH
+		if(strcmp(argv[i],"--bench-ui") == 0)
+		{
+			// [targets per type] [dirty percent] [iterations] [cue lists] [properties per target]
+			UiBench::sSettings settings;
+			if(i+1 < argc)
+				settings.targetsPerType = static_cast<unsigned int>( strtoul(argv[i+1],0,10) );
+			if(i+2 < argc)
+				settings.dirtyPercent = atof(argv[i+2]);
+			if(i+3 < argc)
+				settings.iterations = static_cast<unsigned int>( strtoul(argv[i+3],0,10) );
+			if(i+4 < argc)
+				settings.cueLists = static_cast<unsigned int>( strtoul(argv[i+4],0,10) );
+			if(i+5 < argc)
+				settings.propertiesPerTarget = static_cast<unsigned int>( strtoul(argv[i+5],0,10) );
+			if(settings.targetsPerType == 0)
+				settings.targetsPerType = UiBench::sSettings().targetsPerType;
+			if(settings.iterations == 0)
+				settings.iterations = UiBench::sSettings().iterations;
+			OscRoutes::Get();
+			return UiBench::Main(argc, argv, settings);
+		}
+#endif
+
+		if(strcmp(argv[i],"--export") == 0)
+		{
+			// <file> [ip] [port], JSON Lines unless the file ends in .csv
+			if(i+1 >= argc)
+			{
+				printf("usage: --export <file.jsonl|file.csv> [ip] [port]\n");
+				return 1;
+			}
+			QString path( QString::fromLocal8Bit(argv[i+1]) );
+			QString ip( (i+2 < argc) ? QString::fromLocal8Bit(argv[i+2]) : QString("127.0.0.1") );
+			unsigned long port = ((i+3 < argc) ? strtoul(argv[i+3],0,10) : 0);
+			if(port==0 || port>0xffff)
+				port = EosSyncLib::DEFAULT_PORT;
+			OscRoutes::Get();
+			QCoreApplication app(argc, argv);
+			return ShowExport::Run(path, ip, static_cast<unsigned short>(port), /*timeoutSeconds*/120);
+		}
+	}
+
+	// built before any thread can route through it
+	OscRoutes::Get();
+
 	QApplication app(argc, argv);
 	
 #ifndef WIN32